@@ -0,0 +1,82 @@
+// Formats 2^20 random 64 bit integers 10 times with `std::to_string` and with the library's `append_int`, then sizes
+// and serialises a list of the same integers 10 times.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "torrebis_bencode/torrebis_bencode.h"
+
+namespace bencode = ::torrebis::bencode;
+
+
+namespace {
+    using clock_type = ::std::chrono::steady_clock;
+
+    double elapsed_ms(const clock_type::time_point start) {
+        return ::std::chrono::duration<double, ::std::milli>(clock_type::now() - start).count();
+    }
+
+    // Spread over every number of digits, and both signs.
+    ::std::vector<long long> make_ints() {
+        ::std::mt19937_64 rng(1);
+        ::std::vector<long long> ints(1 << 20);
+        for (long long& i : ints) {
+            const long long magnitude = static_cast<long long>(rng() >> (rng() % 64));
+            i = (rng() & 1) != 0 ? magnitude : -magnitude;
+        }
+        return ints;
+    }
+}
+
+
+int main() {
+    const ::std::vector<long long> ints = make_ints();
+    ::std::string out;
+    out.reserve(32 << 20);
+    ::std::size_t sink = 0;
+
+    clock_type::time_point start = clock_type::now();
+    for (int k = 0; k < 10; ++k) {
+        out.clear();
+        for (const long long i : ints) {
+            out += ::std::to_string(i);
+        }
+        sink += out.size();
+    }
+    ::std::printf("%-16s %8.1f ms\n", "std::to_string", elapsed_ms(start));
+
+    start = clock_type::now();
+    for (int k = 0; k < 10; ++k) {
+        out.clear();
+        for (const long long i : ints) {
+            bencode::helpers::detail::append_int(i, out);
+        }
+        sink += out.size();
+    }
+    ::std::printf("%-16s %8.1f ms\n", "append_int", elapsed_ms(start));
+
+    ::std::string document = "l";
+    for (const long long i : ints) {
+        document += "i" + ::std::to_string(i) + "e";
+    }
+    document += "e";
+    const bencode::data d = bencode::data::load(document);
+
+    start = clock_type::now();
+    for (int k = 0; k < 10; ++k) {
+        sink += d.serialised_size();
+    }
+    ::std::printf("%-16s %8.1f ms\n", "serialised_size", elapsed_ms(start));
+
+    start = clock_type::now();
+    for (int k = 0; k < 10; ++k) {
+        sink += d.serialise().size();
+    }
+    ::std::printf("%-16s %8.1f ms\n", "serialise", elapsed_ms(start));
+
+    ::std::printf("(%zu)\n", sink);
+}
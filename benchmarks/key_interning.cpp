@@ -0,0 +1,94 @@
+// Loads 100000 torrent-like documents (Each with 10 files and a tracker list) into a vector and reports how much heap
+// is still in use afterwards and how many allocations it took, with and without interning dict keys.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "torrebis_bencode/torrebis_bencode.h"
+
+namespace bencode = ::torrebis::bencode;
+
+
+namespace {
+    // Every allocation is prefixed with its size, so that `operator delete` can subtract it.
+    constexpr ::std::size_t header_size = alignof(::std::max_align_t) < sizeof(::std::size_t) ? sizeof(::std::size_t) : alignof(::std::max_align_t);
+
+    ::std::size_t live_bytes = 0;
+    ::std::size_t allocations = 0;
+}
+
+void* operator new(const ::std::size_t size) {
+    char* const p = static_cast<char*>(::std::malloc(size + header_size));
+    if (p == nullptr) {
+        throw ::std::bad_alloc();
+    }
+    *reinterpret_cast<::std::size_t*>(p) = size;
+    live_bytes += size;
+    ++allocations;
+    return p + header_size;
+}
+
+void operator delete(void* const p) noexcept {
+    if (p == nullptr) {
+        return;
+    }
+    char* const block = static_cast<char*>(p) - header_size;
+    live_bytes -= *reinterpret_cast<::std::size_t*>(block);
+    ::std::free(block);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void* const p, ::std::size_t) noexcept { ::operator delete(p); }
+#endif
+
+
+namespace {
+    ::std::string make_torrent(const int n) {
+        ::std::string s =
+            "d8:announce31:http://tracker.example.org:6969"
+            "13:announce-listll31:http://tracker.example.org:6969el28:udp://tracker.example.net:80ee"
+            "7:comment4:test10:created by13:mktorrent 1.1"
+            "4:infod5:filesl";
+        for (int f = 0; f < 10; ++f) {
+            s += "d6:lengthi" + ::std::to_string(1000 + f + n) + "e4:pathl3:dir9:file" + ::std::to_string(10000 + f) + "ee";
+        }
+        return s + "e4:name7:torrent12:piece lengthi262144e6:pieces20:aaaaaaaaaaaaaaaaaaaa7:privatei1eee";
+    }
+
+    template<class Data>
+    void run(const char* const name, const ::std::vector<::std::string>& documents, bencode::key_table* const table) {
+        const ::std::size_t bytes_before = live_bytes;
+        const ::std::size_t allocations_before = allocations;
+        ::std::vector<Data> loaded;
+        loaded.reserve(documents.size());
+        if (table == nullptr) {
+            for (const ::std::string& document : documents) {
+                loaded.push_back(Data::load(document));
+            }
+        } else {
+            const bencode::key_table::scope scope(*table);
+            for (const ::std::string& document : documents) {
+                loaded.push_back(Data::load(document));
+            }
+        }
+        ::std::printf("%-32s %8.1f MB live  %10zu allocations\n", name,
+            static_cast<double>(live_bytes - bytes_before) / 1e6, allocations - allocations_before);
+    }
+}
+
+
+int main() {
+    ::std::vector<::std::string> documents;
+    documents.reserve(100000);
+    for (int i = 0; i < 100000; ++i) {
+        documents.push_back(make_torrent(i));
+    }
+    run<bencode::data>("data (std::string)", documents, nullptr);
+    run<bencode::shared_string_data>("shared_string_data, no table", documents, nullptr);
+    bencode::key_table table;
+    run<bencode::shared_string_data>("shared_string_data + key_table", documents, &table);
+}
@@ -0,0 +1,127 @@
+// Builds the same deeply nested document (9 levels of lists of 3 lists and a dict) by copying finished lists and
+// dicts into their values, the way the decoders used to, and by moving them, then times `load` on its encoding.
+// Prints the best of 5 runs and how many allocations each one makes.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <utility>
+
+#include "torrebis_bencode/torrebis_bencode.h"
+
+namespace bencode = ::torrebis::bencode;
+
+
+namespace {
+    using clock_type = ::std::chrono::steady_clock;
+
+    constexpr int depth = 9;
+
+    ::std::size_t allocations = 0;
+    ::std::size_t sink = 0;
+}
+
+void* operator new(const ::std::size_t size) {
+    ++allocations;
+    void* const p = ::std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw ::std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* const p) noexcept { ::std::free(p); }
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void* const p, ::std::size_t) noexcept { ::std::free(p); }
+#endif
+
+
+namespace {
+    ::std::string make_document(const int d) {
+        if (d == 0) {
+            return "i42e";
+        }
+        ::std::string s = "l";
+        for (int i = 0; i < 3; ++i) {
+            s += make_document(d - 1);
+        }
+        return s + "d1:a" + make_document(d - 1) + "1:b4:spamee";
+    }
+
+    bencode::data build_by_copying(const int d) {
+        if (d == 0) {
+            return bencode::data::make_int(42);
+        }
+        bencode::data::list_type list;
+        for (int i = 0; i < 3; ++i) {
+            const bencode::data item = build_by_copying(d - 1);
+            list.push_back(item);
+        }
+        bencode::data::dict_type dict;
+        const bencode::data a = build_by_copying(d - 1);
+        const bencode::data b = bencode::data::make_str(::std::string("spam"));
+        dict["a"] = a;
+        dict["b"] = b;
+        const bencode::data::dict_type& dict_ref = dict;
+        const bencode::data dict_value = bencode::data::make_dict(dict_ref);
+        list.push_back(dict_value);
+        const bencode::data::list_type& list_ref = list;
+        return bencode::data::make_list(list_ref);
+    }
+
+    bencode::data build_by_moving(const int d) {
+        if (d == 0) {
+            return bencode::data::make_int(42);
+        }
+        bencode::data::list_type list;
+        list.reserve(4);
+        for (int i = 0; i < 3; ++i) {
+            list.push_back(build_by_moving(d - 1));
+        }
+        bencode::data::dict_type dict;
+        dict.emplace_hint(dict.end(), "a", build_by_moving(d - 1));
+        dict.emplace_hint(dict.end(), "b", bencode::data::make_str(::std::string("spam")));
+        list.push_back(bencode::data::make_dict(::std::move(dict)));
+        return bencode::data::make_list(::std::move(list));
+    }
+
+    struct result {
+        const char* name;
+        double best_ms;
+        ::std::size_t allocations;
+    };
+
+    template<class F>
+    void time_once(result& r, const F& f) {
+        const ::std::size_t allocations_before = allocations;
+        const clock_type::time_point start = clock_type::now();
+        const bencode::data d = f();
+        const double ms = ::std::chrono::duration<double, ::std::milli>(clock_type::now() - start).count();
+        r.allocations = allocations - allocations_before;
+        if (r.best_ms == 0 || ms < r.best_ms) {
+            r.best_ms = ms;
+        }
+        sink += d.get_list()->size();
+    }
+}
+
+
+int main() {
+    const ::std::string document = make_document(depth);
+    ::std::printf("%zu byte document\n", document.size());
+    result results[] = { { "build by copying", 0, 0 }, { "build by moving", 0, 0 }, { "load", 0, 0 } };
+    // Interleaved, so that each one sees the heap in the same state
+    for (int attempt = 0; attempt < 5; ++attempt) {
+        time_once(results[0], [] { return build_by_copying(depth); });
+        time_once(results[1], [] { return build_by_moving(depth); });
+        time_once(results[2], [&document] { return bencode::data::load(document); });
+    }
+    for (const result& r : results) {
+        ::std::printf("%-20s %8.1f ms  %9zu allocations\n", r.name, r.best_ms, r.allocations);
+    }
+    ::std::printf("(%zu)\n", sink);
+}
@@ -0,0 +1,82 @@
+// Loads the same document (20000 small dicts, then some long strings) with `load(std::string)`, `load(is)` and
+// `load(is, buffer_size)` for a few buffer sizes, reading the streams from a `std::istringstream`. Prints the best of
+// 7 runs.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "torrebis_bencode/torrebis_bencode.h"
+
+namespace bencode = ::torrebis::bencode;
+
+
+namespace {
+    using clock_type = ::std::chrono::steady_clock;
+
+    ::std::string make_document() {
+        ::std::string s = "l";
+        for (int i = 0; i < 20000; ++i) {
+            s += "d6:lengthi" + ::std::to_string(1000 + i) + "e4:pathl3:dir9:file" + ::std::to_string(10000 + i) + "e5:peersi" + ::std::to_string(i % 97) + "ee";
+        }
+        for (int i = 0; i < 20; ++i) {
+            const ::std::size_t size = 100000 + static_cast<::std::size_t>(i);
+            s += ::std::to_string(size) + ":" + ::std::string(size, 'x');
+        }
+        return s + "e";
+    }
+
+    template<class F>
+    void run(const char* const name, const F& f) {
+        double best = 0;
+        ::std::size_t sink = 0;
+        for (int attempt = 0; attempt < 7; ++attempt) {
+            double ms = 0;
+            sink += f(ms);
+            if (attempt == 0 || ms < best) {
+                best = ms;
+            }
+        }
+        ::std::printf("%-28s %8.2f ms  (%zu)\n", name, best, sink);
+    }
+
+    double elapsed_ms(const clock_type::time_point start) {
+        return ::std::chrono::duration<double, ::std::milli>(clock_type::now() - start).count();
+    }
+}
+
+
+int main() {
+    const ::std::string document = make_document();
+    ::std::printf("%zu byte document\n", document.size());
+
+    run("load(std::string)", [&document](double& ms) {
+        const clock_type::time_point start = clock_type::now();
+        const bencode::data d = bencode::data::load(document);
+        ms = elapsed_ms(start);
+        return d.get_list()->size();
+    });
+
+    // The streams are made before timing, so only decoding is measured
+    run("load(is)", [&document](double& ms) {
+        ::std::istringstream is(document);
+        const clock_type::time_point start = clock_type::now();
+        const bencode::data d = bencode::data::load(is);
+        ms = elapsed_ms(start);
+        return d.get_list()->size();
+    });
+
+    const ::std::size_t buffer_sizes[] = { 4096, bencode::data::default_stream_buffer_size, 1024 * 1024 };
+    for (const ::std::size_t buffer_size : buffer_sizes) {
+        const ::std::string name = "load(is, " + ::std::to_string(buffer_size) + ")";
+        run(name.c_str(), [&document, buffer_size](double& ms) {
+            ::std::istringstream is(document);
+            const clock_type::time_point start = clock_type::now();
+            const bencode::data d = bencode::data::load(is, buffer_size);
+            ms = elapsed_ms(start);
+            return d.get_list()->size();
+        });
+    }
+}
@@ -0,0 +1,96 @@
+// Walks a list of 20000 dicts 20 times, copying every value it visits (Like code that holds on to what it visits),
+// for each reference counting policy. Prints the best of 7 runs.
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "torrebis_bencode/torrebis_bencode.h"
+
+namespace bencode = ::torrebis::bencode;
+
+
+namespace {
+    ::std::string make_document() {
+        ::std::string s = "l";
+        for (int i = 0; i < 20000; ++i) {
+            s += "d1:ai" + ::std::to_string(i) + "e1:bl";
+            for (int j = 0; j < 8; ++j) {
+                s += "20:abcdefghijklmnopqrst";
+            }
+            s += "e1:cd1:xi1e1:y3:abcee";
+        }
+        return s + "e";
+    }
+
+    long walk(const bencode::data& d) {
+        if (d.is_int()) {
+            return static_cast<long>(*d.get_int());
+        }
+        if (d.is_str()) {
+            return static_cast<long>(d.get_str()->size());
+        }
+        long n = 0;
+        if (d.is_list()) {
+            for (const bencode::data& item : *d.get_list()) {
+                const bencode::data copy = item;
+                n += walk(copy);
+            }
+        } else {
+            for (const auto& item : *d.get_dict()) {
+                const bencode::data copy = item.second;
+                n += walk(copy);
+            }
+        }
+        return n;
+    }
+
+    template<class CompactData>
+    long walk(const CompactData& d) {
+        if (d.is_int()) {
+            return static_cast<long>(d.get_int());
+        }
+        if (d.is_str()) {
+            return static_cast<long>(d.get_str().size());
+        }
+        long n = 0;
+        if (d.is_list()) {
+            for (const CompactData& item : *d.get_list()) {
+                const CompactData copy = item;
+                n += walk(copy);
+            }
+        } else {
+            for (const auto& item : *d.get_dict()) {
+                const CompactData copy = item.second;
+                n += walk(copy);
+            }
+        }
+        return n;
+    }
+
+    template<class Data>
+    void run(const char* const name, const ::std::string& document) {
+        const Data d = Data::load(document);
+        long sink = 0;
+        double best = 0;
+        for (int attempt = 0; attempt < 7; ++attempt) {
+            const auto start = ::std::chrono::steady_clock::now();
+            for (int i = 0; i < 20; ++i) {
+                sink += walk(d);
+            }
+            const double ms = ::std::chrono::duration<double, ::std::milli>(::std::chrono::steady_clock::now() - start).count();
+            if (attempt == 0 || ms < best) {
+                best = ms;
+            }
+        }
+        ::std::printf("%-20s %8.1f ms  (%ld)\n", name, best, sink);
+    }
+}
+
+
+int main() {
+    const ::std::string document = make_document();
+    run<bencode::data>("data", document);
+    run<bencode::compact_data>("compact_data", document);
+    run<bencode::local_compact_data>("local_compact_data", document);
+}
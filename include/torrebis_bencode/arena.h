@@ -0,0 +1,251 @@
+#ifndef TORREBIS_BENCODE_ARENA_H_
+#define TORREBIS_BENCODE_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "torrebis_bencode/helpers.h"
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * A monotonic arena. Allocating bumps a pointer through a chunk of memory, deallocating does nothing, and all of
+     * it is given back at once by `reset()` or the destructor. Everything allocated in an arena must be destroyed
+     * before it is reset.
+     *
+     * Not thread safe. Use one arena per thread.
+     */
+    class arena final {
+    private:
+        struct chunk {
+            chunk* previous;
+            ::std::size_t size;  // Usable bytes after this header
+        };
+
+        static constexpr ::std::size_t header_size = (sizeof(chunk) + alignof(::std::max_align_t) - 1) & ~(alignof(::std::max_align_t) - 1);
+
+        chunk* chunks_;  // The chunk being allocated from, or nullptr
+        chunk* spare_;  // A chunk kept by `reset()` for when the caller supplied buffer fills up again, or nullptr
+        char* buffer_;  // The caller supplied buffer, used before any chunks
+        ::std::size_t buffer_size_;
+        char* pos_;
+        char* end_;
+        ::std::size_t next_chunk_size_;
+        ::std::size_t bytes_used_;
+
+        static char* chunk_data(chunk* const c) noexcept { return reinterpret_cast<char*>(c) + header_size; }
+
+        // Aligns `pos_` to `align`, returning nullptr if `size` bytes don't fit after that.
+        void* bump(const ::std::size_t size, const ::std::size_t align) noexcept {
+            if (pos_ == nullptr) {
+                return nullptr;
+            }
+            const ::std::uintptr_t pos = reinterpret_cast<::std::uintptr_t>(pos_);
+            const ::std::size_t padding = (align - (pos & (align - 1))) & (align - 1);
+            if (padding > static_cast<::std::size_t>(end_ - pos_) || size > static_cast<::std::size_t>(end_ - pos_) - padding) {
+                return nullptr;
+            }
+            char* const result = pos_ + padding;
+            pos_ = result + size;
+            bytes_used_ += padding + size;
+            return result;
+        }
+
+        void use_chunk(chunk* const c) noexcept {
+            c->previous = chunks_;
+            chunks_ = c;
+            pos_ = chunk_data(c);
+            end_ = pos_ + c->size;
+        }
+
+        void add_chunk(const ::std::size_t at_least) {
+            constexpr ::std::size_t max_size = static_cast<::std::size_t>(-1);
+            ::std::size_t size = next_chunk_size_;
+            while (size < at_least) {
+                size = size > max_size / 2 ? at_least : size * 2;
+            }
+            if (size > max_size - header_size) {
+                throw ::std::bad_alloc();
+            }
+            chunk* const c = static_cast<chunk*>(::operator new(header_size + size));
+            c->size = size;
+            use_chunk(c);
+            next_chunk_size_ = size > max_size / 2 ? size : size * 2;
+        }
+
+        void free_spare() noexcept {
+            if (spare_ != nullptr) {
+                ::operator delete(spare_);
+                spare_ = nullptr;
+            }
+        }
+
+        static arena*& current_ref() noexcept {
+            static thread_local arena* current = nullptr;
+            return current;
+        }
+
+    public:
+        static constexpr ::std::size_t default_chunk_size = 4096;
+
+        explicit arena(const ::std::size_t first_chunk_size = default_chunk_size) noexcept :
+            chunks_(nullptr), spare_(nullptr), buffer_(nullptr), buffer_size_(0), pos_(nullptr), end_(nullptr),
+            next_chunk_size_(first_chunk_size == 0 ? 1 : first_chunk_size), bytes_used_(0) {}
+
+        // Allocates from `buffer` first, then from the heap once it is full. `buffer` must outlive the arena.
+        arena(void* const buffer, const ::std::size_t size, const ::std::size_t next_chunk_size = default_chunk_size) noexcept :
+            chunks_(nullptr), spare_(nullptr), buffer_(static_cast<char*>(buffer)), buffer_size_(size), pos_(buffer_), end_(buffer_ + size),
+            next_chunk_size_(next_chunk_size == 0 ? 1 : next_chunk_size), bytes_used_(0) {}
+
+        arena(const arena&) = delete;
+        arena& operator=(const arena&) = delete;
+
+        ~arena() noexcept { release(); }
+
+        // Never returns nullptr. Throws `std::bad_alloc` if the heap is out of memory or `size` is too big.
+        void* allocate(const ::std::size_t size, const ::std::size_t align = alignof(::std::max_align_t)) {
+            void* result = bump(size, align);
+            if (result != nullptr) {
+                return result;
+            }
+            if (spare_ != nullptr) {
+                chunk* const c = spare_;
+                spare_ = nullptr;
+                use_chunk(c);
+                result = bump(size, align);
+                if (result != nullptr) {
+                    return result;
+                }
+            }
+            if (size > static_cast<::std::size_t>(-1) - align) {
+                throw ::std::bad_alloc();
+            }
+            add_chunk(size + align);
+            result = bump(size, align);
+            if (result == nullptr) {
+                throw ::std::bad_alloc();
+            }
+            return result;
+        }
+
+        /*
+         * Makes all of the memory available again. The most recent (largest) chunk is kept, so an arena that is reset
+         * between documents of about the same size stops allocating from the heap. With a caller supplied buffer,
+         * the buffer is used first again and the kept chunk once it is full.
+         */
+        void reset() noexcept {
+            // Chunks only ever grow, so the newest is the largest. `spare_` is only set when there are no chunks.
+            chunk* const keep = chunks_ != nullptr ? chunks_ : spare_;
+            while (chunks_ != nullptr) {
+                chunk* const previous = chunks_->previous;
+                if (chunks_ != keep) {
+                    ::operator delete(chunks_);
+                }
+                chunks_ = previous;
+            }
+            spare_ = nullptr;
+            if (buffer_ != nullptr) {
+                spare_ = keep;
+                pos_ = buffer_;
+                end_ = buffer_ + buffer_size_;
+            } else if (keep != nullptr) {
+                use_chunk(keep);
+            }
+            bytes_used_ = 0;
+        }
+
+        // Gives all of the memory back to the heap.
+        void release() noexcept {
+            free_spare();
+            while (chunks_ != nullptr) {
+                chunk* const previous = chunks_->previous;
+                ::operator delete(chunks_);
+                chunks_ = previous;
+            }
+            pos_ = buffer_;
+            end_ = buffer_ == nullptr ? nullptr : buffer_ + buffer_size_;
+            bytes_used_ = 0;
+        }
+
+        // How many bytes have been allocated since the last reset, including alignment padding.
+        ::std::size_t bytes_used() const noexcept { return bytes_used_; }
+
+        // The arena of the innermost `scope` on this thread, or nullptr.
+        static arena* current() noexcept { return current_ref(); }
+
+        /*
+         * While a scope is alive, `arena_allocator`s that are default constructed on this thread allocate from its
+         * arena. Scopes can be nested.
+         */
+        class scope final {
+        private:
+            arena* previous_;
+        public:
+            explicit scope(arena& a) noexcept : previous_(current_ref()) { current_ref() = &a; }
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+            ~scope() noexcept { current_ref() = previous_; }
+        };
+    };
+
+    /*
+     * An allocator that allocates from an `arena`. A default constructed allocator uses `arena::current()`, so it can
+     * be the `Allocator` of `basic_data`, which default constructs its allocators. With no arena it uses the heap.
+     */
+    template<typename T>
+    class arena_allocator {
+    private:
+        arena* arena_;
+
+        template<typename U>
+        friend class arena_allocator;
+    public:
+        using value_type = T;
+
+        arena_allocator() noexcept : arena_(arena::current()) {}
+        explicit arena_allocator(arena& a) noexcept : arena_(&a) {}
+        template<typename U>
+        arena_allocator(const arena_allocator<U>& other) noexcept : arena_(other.arena_) {}
+
+        T* allocate(const ::std::size_t n) {
+            if (n > static_cast<::std::size_t>(-1) / sizeof(T)) {
+                throw ::std::bad_alloc();
+            }
+            if (arena_ == nullptr) {
+                return static_cast<T*>(::operator new(n * sizeof(T)));
+            }
+            return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* const p, const ::std::size_t n) noexcept {
+            static_cast<void>(n);
+            if (arena_ == nullptr) {
+                ::operator delete(p);
+            }
+        }
+
+        // The arena this allocates from, or nullptr for the heap.
+        arena* get_arena() const noexcept { return arena_; }
+
+        template<typename U>
+        bool operator==(const arena_allocator<U>& other) const noexcept { return arena_ == other.arena_; }
+        template<typename U>
+        bool operator!=(const arena_allocator<U>& other) const noexcept { return arena_ != other.arena_; }
+    };
+
+    using arena_string = ::std::basic_string<char, ::std::char_traits<char>, arena_allocator<char>>;
+
+    template<typename ValueType, typename...>
+    using arena_vector = ::std::vector<ValueType, arena_allocator<ValueType>>;
+
+    template<typename KeyType, typename ValueType, typename...>
+    using arena_map = ::std::map<KeyType, ValueType, ::std::less<KeyType>, arena_allocator<::std::pair<const KeyType, ValueType>>>;
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_ARENA_H_
@@ -0,0 +1,515 @@
+#ifndef TORREBIS_BENCODE_COMPACT_DATA_H_
+#define TORREBIS_BENCODE_COMPACT_DATA_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "torrebis_bencode/helpers.h"
+#include "torrebis_bencode/str_view.h"
+#include "torrebis_bencode/errors.h"
+#include "torrebis_bencode/readers.h"
+#include "torrebis_bencode/writers.h"
+#include "torrebis_bencode/type_tags.h"
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * How `basic_compact_data` counts references to its heap nodes.
+     *
+     * `atomic_refcount` lets copies of a value be used from different threads, like copies of a `std::shared_ptr`.
+     * `local_refcount` uses a plain integer, so copying and destroying values is cheaper, but every copy of a value
+     * has to stay on the thread that made it.
+     */
+    struct atomic_refcount {
+        using count_type = ::std::atomic<::std::size_t>;
+
+        static void retain(count_type& count) noexcept { count.fetch_add(1, ::std::memory_order_relaxed); }
+        // Whether that was the last reference
+        static bool release(count_type& count) noexcept { return count.fetch_sub(1, ::std::memory_order_acq_rel) == 1; }
+    };
+
+    struct local_refcount {
+        using count_type = ::std::size_t;
+
+        static void retain(count_type& count) noexcept { ++count; }
+        static bool release(count_type& count) noexcept { return --count == 0; }
+    };
+
+    namespace helpers {
+        namespace detail {
+            // The heap part of a `basic_compact_data`, shared between copies of it.
+            template<class T, class RefCount>
+            struct compact_heap_node {
+                typename RefCount::count_type refcount;
+                T value;
+
+                template<class... Args>
+                explicit compact_heap_node(Args&&... args) : refcount(1), value(::std::forward<Args>(args)...) {}
+            };
+
+            // Orders the keys of a `basic_compact_data` dict, and lets them be found by a `str_view` without a copy.
+            struct compact_key_less {
+                using is_transparent = void;
+
+                bool operator()(const ::std::string& a, const ::std::string& b) const noexcept { return a < b; }
+                bool operator()(const ::std::string& a, const str_view b) const noexcept { return str_view(a) < b; }
+                bool operator()(const str_view a, const ::std::string& b) const noexcept { return a < str_view(b); }
+            };
+        }  // namespace torrebis::bencode::helpers::detail  (Private)
+    }  // namespace torrebis::bencode::helpers
+
+    /*
+     * Like `data`, but each value is a 16 byte node. Ints and strings of up to 15 bytes are stored in the node itself,
+     * and only longer strings, lists and dicts are on the heap (with a reference count in the same allocation).
+     *
+     * Copies share their heap part like copies of `data` do, but ints and short strings are copied. How the heap part
+     * is counted is up to `RefCount` (`atomic_refcount` or `local_refcount`).
+     */
+    template<class RefCount>
+    class basic_compact_data final {
+    public:
+        using refcount_policy = RefCount;
+        using int_type = ::std::int64_t;
+        using str_type = str_view;
+        using list_type = ::std::vector<basic_compact_data>;
+        using dict_type = ::std::map<::std::string, basic_compact_data, helpers::detail::compact_key_less>;
+
+        static constexpr ::std::size_t max_inline_str_size = 15;
+    private:
+        enum kind : ::std::uint8_t {
+            UNINITIALISED_KIND = 0,
+            INT_KIND = 1,
+            SHORT_STR_KIND = 2,
+            LONG_STR_KIND = 3,
+            LIST_KIND = 4,
+            DICT_KIND = 5
+        };
+
+        using long_str_node = helpers::detail::compact_heap_node<::std::string, RefCount>;
+        using list_node = helpers::detail::compact_heap_node<list_type, RefCount>;
+        using dict_node = helpers::detail::compact_heap_node<dict_type, RefCount>;
+
+        // An int, the characters of a short string or a pointer to a heap node, depending on the kind.
+        alignas(8) unsigned char storage_[15];
+        // The kind in the low 4 bits, and the size of a short string in the high 4 bits.
+        ::std::uint8_t meta_;
+
+        kind get_kind() const noexcept { return static_cast<kind>(meta_ & 0x0F); }
+        ::std::size_t short_size() const noexcept { return static_cast<::std::size_t>(meta_ >> 4); }
+        bool is_heap() const noexcept { return get_kind() >= LONG_STR_KIND; }
+
+        template<class Node>
+        Node* heap() const noexcept {
+            Node* node;
+            ::std::memcpy(&node, storage_, sizeof(node));
+            return node;
+        }
+
+        template<class Node>
+        void set_heap(const kind k, Node* const node) noexcept {
+            ::std::memcpy(storage_, &node, sizeof(node));
+            meta_ = static_cast<::std::uint8_t>(k);
+        }
+
+        void retain() const noexcept {
+            switch (get_kind()) {
+                case LONG_STR_KIND:
+                    RefCount::retain(heap<long_str_node>()->refcount);
+                    return;
+                case LIST_KIND:
+                    RefCount::retain(heap<list_node>()->refcount);
+                    return;
+                case DICT_KIND:
+                    RefCount::retain(heap<dict_node>()->refcount);
+                    return;
+                default:
+                    return;
+            }
+        }
+
+        template<class Node>
+        void release_node() noexcept {
+            Node* const node = heap<Node>();
+            if (RefCount::release(node->refcount)) {
+                delete node;
+            }
+        }
+
+        void release() noexcept {
+            switch (get_kind()) {
+                case LONG_STR_KIND:
+                    release_node<long_str_node>();
+                    break;
+                case LIST_KIND:
+                    release_node<list_node>();
+                    break;
+                case DICT_KIND:
+                    release_node<dict_node>();
+                    break;
+                default:
+                    break;
+            }
+            meta_ = UNINITIALISED_KIND;
+        }
+
+        static basic_compact_data pointer_bdecode_loop(const char* const begin, ::std::size_t& i, const ::std::size_t size) {
+            if (i >= size) {
+                throw errors::expecting_value_error.copy();
+            }
+            switch (begin[i]) {
+                case 'i':
+                    // int "ixxxe"
+                    ++i;
+                    return make_int(helpers::detail::pointer_read_int<int_type, char>(begin, i, size, 'e', nullptr));
+                case 'l': {
+                    // list "lxxxe"
+                    ++i;
+                    basic_compact_data result = make_list();
+                    list_type& list = *result.get_list();
+                    while (true) {
+                        if (i >= size) {
+                            throw errors::expecting_value_error.copy();
+                        }
+                        if (begin[i] == 'e') {
+                            break;
+                        }
+                        list.push_back(pointer_bdecode_loop(begin, i, size));
+                    }
+                    ++i;
+                    return result;
+                }
+                case 'd': {
+                    // dict "dxxxe"
+                    ++i;
+                    basic_compact_data result = make_dict();
+                    dict_type& dict = *result.get_dict();
+                    const char* last_key_begin = nullptr;
+                    ::std::size_t last_key_size = 0;
+                    while (true) {
+                        if (i >= size) {
+                            throw errors::expecting_value_error.copy();
+                        }
+                        if (begin[i] == 'e') {
+                            break;
+                        }
+                        auto key = helpers::detail::pointer_read_str_fast(begin, i, size, nullptr);
+                        if (last_key_begin != nullptr) {
+                            if (!helpers::detail::key_less_than(last_key_begin, last_key_size, key.first, key.second)) {
+                                throw errors::key_order_error.copy();
+                            }
+                        }
+                        last_key_begin = key.first;
+                        last_key_size = key.second;
+                        // Keys are ascending, so each one goes at the end
+                        dict.emplace_hint(dict.end(), ::std::string(key.first, key.second), pointer_bdecode_loop(begin, i, size));
+                    }
+                    ++i;
+                    return result;
+                }
+                case '0': case '1': case '2':
+                case '3': case '4': case '5':
+                case '6': case '7': case '8':
+                case '9': {
+                    // str "yy:xxxx"
+                    auto str = helpers::detail::pointer_read_str_fast(begin, i, size, nullptr);
+                    return make_str(str.first, str.second);
+                }
+                default:
+                    throw errors::unknown_value_error.copy();
+            }
+        }
+
+        template<class OutputIt>
+        static OutputIt serialise_str(const str_view str, OutputIt out) {
+            out = helpers::detail::copy_int(str.size(), out);
+            *out = ':';
+            return helpers::detail::copy_chars(str, ++out);
+        }
+
+        template<class OutputIt>
+        OutputIt serialise_to_loop(OutputIt out) const {
+            switch (get_kind()) {
+                case INT_KIND:
+                    *out = 'i';
+                    out = helpers::detail::copy_int(get_int(), ++out);
+                    *out = 'e';
+                    return ++out;
+                case SHORT_STR_KIND:
+                case LONG_STR_KIND:
+                    return serialise_str(get_str(), out);
+                case LIST_KIND:
+                    *out = 'l';
+                    ++out;
+                    for (const basic_compact_data& i : *get_list()) {
+                        out = i.serialise_to_loop(out);
+                    }
+                    *out = 'e';
+                    return ++out;
+                case DICT_KIND:
+                    *out = 'd';
+                    ++out;
+                    for (const auto& i : *get_dict()) {
+                        out = serialise_str(str_view(i.first.data(), i.first.size()), out);
+                        out = i.second.serialise_to_loop(out);
+                    }
+                    *out = 'e';
+                    return ++out;
+                default:
+                    return out;
+            }
+        }
+    public:
+        basic_compact_data() noexcept : storage_(), meta_(UNINITIALISED_KIND) {}
+
+        basic_compact_data(const basic_compact_data& other) noexcept : meta_(other.meta_) {
+            ::std::memcpy(storage_, other.storage_, sizeof(storage_));
+            retain();
+        }
+
+        basic_compact_data(basic_compact_data&& other) noexcept : meta_(other.meta_) {
+            ::std::memcpy(storage_, other.storage_, sizeof(storage_));
+            other.meta_ = UNINITIALISED_KIND;
+        }
+
+        basic_compact_data& operator=(basic_compact_data other) noexcept {
+            swap(other);
+            return *this;
+        }
+
+        ~basic_compact_data() noexcept { release(); }
+
+        void swap(basic_compact_data& other) noexcept {
+            unsigned char storage[sizeof(storage_)];
+            ::std::memcpy(storage, storage_, sizeof(storage_));
+            ::std::memcpy(storage_, other.storage_, sizeof(storage_));
+            ::std::memcpy(other.storage_, storage, sizeof(storage_));
+            ::std::swap(meta_, other.meta_);
+        }
+
+        void reset() noexcept { release(); }
+
+        explicit operator bool() const noexcept { return get_kind() != UNINITIALISED_KIND; }
+        bool operator!() const noexcept { return get_kind() == UNINITIALISED_KIND; }
+
+        DataTag get_tag() const noexcept {
+            switch (get_kind()) {
+                case INT_KIND:
+                    return DataTag::INT;
+                case SHORT_STR_KIND:
+                case LONG_STR_KIND:
+                    return DataTag::STR;
+                case LIST_KIND:
+                    return DataTag::LIST;
+                case DICT_KIND:
+                    return DataTag::DICT;
+                default:
+                    return DataTag::UNINITIALISED;
+            }
+        }
+
+        bool is_valid() const noexcept { return get_kind() != UNINITIALISED_KIND; }
+        bool is_str() const noexcept { return get_kind() == SHORT_STR_KIND || get_kind() == LONG_STR_KIND; }
+        bool is_int() const noexcept { return get_kind() == INT_KIND; }
+        bool is_list() const noexcept { return get_kind() == LIST_KIND; }
+        bool is_dict() const noexcept { return get_kind() == DICT_KIND; }
+
+        // Whether the value is stored in the node itself, so copying it doesn't touch the heap.
+        bool is_inline() const noexcept { return !is_heap(); }
+
+        static basic_compact_data make_int(const int_type i) noexcept {
+            basic_compact_data result;
+            ::std::memcpy(result.storage_, &i, sizeof(i));
+            result.meta_ = INT_KIND;
+            return result;
+        }
+
+        static basic_compact_data make_str(const char* const str, const ::std::size_t size) {
+            basic_compact_data result;
+            if (size <= max_inline_str_size) {
+                ::std::memcpy(result.storage_, str, size);
+                result.meta_ = static_cast<::std::uint8_t>(SHORT_STR_KIND | (size << 4));
+            } else {
+                result.set_heap(LONG_STR_KIND, new long_str_node(str, size));
+            }
+            return result;
+        }
+
+        static basic_compact_data make_str(const char* const c_str) { return make_str(c_str, ::std::strlen(c_str)); }
+        static basic_compact_data make_str(const str_type s) { return make_str(s.data(), s.size()); }
+        static basic_compact_data make_str(const ::std::string& s) { return make_str(s.data(), s.size()); }
+
+        static basic_compact_data make_str(::std::string&& s) {
+            if (s.size() <= max_inline_str_size) {
+                return make_str(s.data(), s.size());
+            }
+            basic_compact_data result;
+            result.set_heap(LONG_STR_KIND, new long_str_node(::std::move(s)));
+            return result;
+        }
+
+        static basic_compact_data make_list(list_type l = list_type()) {
+            basic_compact_data result;
+            result.set_heap(LIST_KIND, new list_node(::std::move(l)));
+            return result;
+        }
+
+        static basic_compact_data make_dict(dict_type d = dict_type()) {
+            basic_compact_data result;
+            result.set_heap(DICT_KIND, new dict_node(::std::move(d)));
+            return result;
+        }
+
+        // The value of an int, or 0 if this is not an int.
+        int_type get_int() const noexcept {
+            if (!is_int()) {
+                return 0;
+            }
+            int_type i;
+            ::std::memcpy(&i, storage_, sizeof(i));
+            return i;
+        }
+
+        // The value of a str, or an empty view if this is not a str. Only valid while this is.
+        str_type get_str() const noexcept {
+            switch (get_kind()) {
+                case SHORT_STR_KIND:
+                    return str_type(reinterpret_cast<const char*>(storage_), short_size());
+                case LONG_STR_KIND: {
+                    const ::std::string& s = heap<long_str_node>()->value;
+                    return str_type(s.data(), s.size());
+                }
+                default:
+                    return str_type();
+            }
+        }
+
+        list_type* get_list() noexcept { return is_list() ? &heap<list_node>()->value : nullptr; }
+        const list_type* get_list() const noexcept { return is_list() ? &heap<list_node>()->value : nullptr; }
+        dict_type* get_dict() noexcept { return is_dict() ? &heap<dict_node>()->value : nullptr; }
+        const dict_type* get_dict() const noexcept { return is_dict() ? &heap<dict_node>()->value : nullptr; }
+
+        // The value for `key` in a dict, or nullptr if there isn't one.
+        const basic_compact_data* find(const str_type key) const {
+            const dict_type* const dict = get_dict();
+            if (dict == nullptr) {
+                return nullptr;
+            }
+#ifdef TORREBIS_HAS_HETEROGENEOUS_LOOKUP
+            auto search = dict->find(key);
+#else
+            // Without heterogeneous lookup, reuse one string per thread so that only growing it allocates
+            static thread_local ::std::string scratch;
+            scratch.assign(key.data(), key.size());
+            auto search = dict->find(scratch);
+#endif
+            return search == dict->end() ? nullptr : &search->second;
+        }
+
+        // The item at index `i` of a list, or nullptr if there isn't one.
+        const basic_compact_data* at(const ::std::size_t i) const noexcept {
+            const list_type* const list = get_list();
+            return list == nullptr || i >= list->size() ? nullptr : &(*list)[i];
+        }
+
+        static basic_compact_data load(const char* const begin, const ::std::size_t size) {
+            ::std::size_t i = 0;
+            basic_compact_data parsed = pointer_bdecode_loop(begin, i, size);
+            if (i != size) {
+                throw errors::early_end_error.copy();
+            }
+            return parsed;
+        }
+
+        template<typename T>
+        static basic_compact_data load(const T* const begin, const ::std::size_t size) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            return load(reinterpret_cast<const char*>(begin), size);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_compact_data load(const ::std::basic_string<T, Rest...>& s) {
+            return load<T>(s.data(), s.size());
+        }
+
+        template<typename T, typename... Rest>
+        static basic_compact_data load(const ::std::vector<T, Rest...>& v) {
+            return load<T>(v.data(), v.size());
+        }
+
+        ::std::size_t serialised_size() const {
+            switch (get_kind()) {
+                case INT_KIND:
+                    return 2 + helpers::detail::int_size(get_int());
+                case SHORT_STR_KIND:
+                case LONG_STR_KIND: {
+                    const ::std::size_t str_size = get_str().size();
+                    return helpers::detail::int_size(str_size) + 1 + str_size;
+                }
+                case LIST_KIND: {
+                    ::std::size_t size = 2;
+                    for (const basic_compact_data& i : *get_list()) {
+                        size += i.serialised_size();
+                    }
+                    return size;
+                }
+                case DICT_KIND: {
+                    ::std::size_t size = 2;
+                    for (const auto& i : *get_dict()) {
+                        size += helpers::detail::int_size(i.first.size()) + 1 + i.first.size() + i.second.serialised_size();
+                    }
+                    return size;
+                }
+                default:
+                    return 0;
+            }
+        }
+
+        void append_serialisation(::std::string& s) const {
+            const ::std::size_t old_size = s.size();
+            s.resize(old_size + serialised_size());
+            serialise_to_loop(&s[0] + old_size);
+        }
+
+        ::std::string serialise() const {
+            ::std::string s;
+            append_serialisation(s);
+            return s;
+        }
+
+        // Writes the encoding to `out`, like `basic_data::serialise_to`.
+        template<class OutputIt>
+        OutputIt serialise_to(OutputIt out) const { return serialise_to_loop(out); }
+
+        // Writes the encoding to the `capacity` chars at `out`, returning how many were written (0 if it doesn't fit).
+        ::std::size_t serialise_to(char* const out, const ::std::size_t capacity) const {
+            const ::std::size_t size = serialised_size();
+            if (size > capacity) {
+                return 0;
+            }
+            serialise_to_loop(out);
+            return size;
+        }
+
+#ifdef TORREBIS_HAS_SPAN
+        template<::std::size_t Extent>
+        ::std::size_t serialise_to(const ::std::span<char, Extent> out) const { return serialise_to(out.data(), out.size()); }
+#endif
+    };
+
+    using compact_data = basic_compact_data<atomic_refcount>;
+    using local_compact_data = basic_compact_data<local_refcount>;
+
+    static_assert(sizeof(compact_data) == 16, "compact_data should be a 16 byte node");
+    static_assert(sizeof(local_compact_data) == 16, "local_compact_data should be a 16 byte node");
+
+    template<class RefCount>
+    void swap(basic_compact_data<RefCount>& a, basic_compact_data<RefCount>& b) noexcept { a.swap(b); }
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_COMPACT_DATA_H_
@@ -0,0 +1,224 @@
+#ifndef TORREBIS_BENCODE_CURSOR_H_
+#define TORREBIS_BENCODE_CURSOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "torrebis_bencode/helpers.h"
+#include "torrebis_bencode/str_view.h"
+#include "torrebis_bencode/errors.h"
+#include "torrebis_bencode/readers.h"
+#include "torrebis_bencode/type_tags.h"
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * A pull parser over a buffer of bencoded data. Tokens are read one at a time, and whole values can be skipped
+     * without being decoded. Strings borrow from the buffer, which must outlive the cursor.
+     *
+     * Only as much of the data as is read is checked. The cursor knows how deep it is, but not whether it is reading
+     * a key or a value, so key order and keys being strings are not checked.
+     */
+    template<typename IntType = ::std::intmax_t>
+    class basic_cursor final {
+    public:
+        using int_type = IntType;
+        using str_type = str_view;
+
+        enum class token : ::std::int8_t {
+            STR = 0,
+            INT = 1,
+            BEGIN_LIST = 2,
+            BEGIN_DICT = 3,
+            END = 4,  // The end of a list or dict
+            NONE = -1  // The end of the buffer
+        };
+    private:
+        const char* begin_;
+        ::std::size_t size_;
+        ::std::size_t pos_;
+        ::std::size_t depth_;
+        int_type int_;
+        str_type str_;
+
+    public:
+        basic_cursor() noexcept : begin_(nullptr), size_(0), pos_(0), depth_(0), int_(0), str_() {}
+        basic_cursor(const char* const begin, const ::std::size_t size) noexcept :
+            begin_(begin), size_(size), pos_(0), depth_(0), int_(0), str_() {}
+
+        template<typename T>
+        basic_cursor(const T* const begin, const ::std::size_t size) noexcept :
+            basic_cursor(reinterpret_cast<const char*>(begin), size) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+        }
+
+        template<typename T, typename... Rest>
+        explicit basic_cursor(const ::std::basic_string<T, Rest...>& s) noexcept : basic_cursor(s.data(), s.size()) {}
+
+        template<typename T, typename... Rest>
+        explicit basic_cursor(const ::std::basic_string<T, Rest...>&& s) = delete;
+
+        template<typename T, typename... Rest>
+        explicit basic_cursor(const ::std::vector<T, Rest...>& v) noexcept : basic_cursor(v.data(), v.size()) {}
+
+        template<typename T, typename... Rest>
+        explicit basic_cursor(const ::std::vector<T, Rest...>&& v) = delete;
+
+        // How far into the buffer the cursor is.
+        ::std::size_t position() const noexcept { return pos_; }
+        // How many lists and dicts the cursor is inside of.
+        ::std::size_t depth() const noexcept { return depth_; }
+        bool at_end() const noexcept { return pos_ >= size_; }
+
+        // What the next token is, without reading it.
+        token peek() const noexcept {
+            if (pos_ >= size_) {
+                return token::NONE;
+            }
+            switch (begin_[pos_]) {
+                case 'i': return token::INT;
+                case 'l': return token::BEGIN_LIST;
+                case 'd': return token::BEGIN_DICT;
+                case 'e': return token::END;
+                default: return token::STR;
+            }
+        }
+
+        // The type of the next value, or `DataTag::UNINITIALISED` at the end of a list, dict or the buffer.
+        DataTag peek_tag() const noexcept {
+            const token t = peek();
+            if (t == token::END || t == token::NONE) {
+                return DataTag::UNINITIALISED;
+            }
+            return static_cast<DataTag>(static_cast<::std::int8_t>(t));
+        }
+
+        /*
+         * Reads the next token. After `token::INT` or `token::STR` the value is available from `int_value()` or
+         * `str_value()`. Throws a `decoding_error` if the token is invalid.
+         */
+        token next_token() {
+            const token t = peek();
+            switch (t) {
+                case token::NONE:
+                    if (depth_ != 0) {
+                        throw errors::expecting_value_error.copy();
+                    }
+                    break;
+                case token::INT:
+                    ++pos_;
+                    int_ = helpers::detail::pointer_read_int<int_type, char>(begin_, pos_, size_, 'e', nullptr);
+                    break;
+                case token::STR: {
+                    const char c = begin_[pos_];
+                    if (!('0' <= c && c <= '9')) {
+                        throw errors::unknown_value_error.copy();
+                    }
+                    auto begin_size = helpers::detail::pointer_read_str_fast(begin_, pos_, size_, nullptr);
+                    str_ = str_type(begin_size.first, begin_size.second);
+                    break;
+                }
+                case token::BEGIN_LIST:
+                case token::BEGIN_DICT:
+                    ++pos_;
+                    ++depth_;
+                    break;
+                case token::END:
+                    if (depth_ == 0) {
+                        throw errors::expecting_value_error.copy();
+                    }
+                    ++pos_;
+                    --depth_;
+                    break;
+            }
+            return t;
+        }
+
+        // The last int read by `next_token()`.
+        int_type int_value() const noexcept { return int_; }
+        // The last string read by `next_token()`.
+        str_type str_value() const noexcept { return str_; }
+
+        // Reads an int, throwing a `decoding_error` if the next value is not one.
+        int_type read_int() {
+            if (peek() != token::INT) {
+                throw errors::expecting_int_error.copy();
+            }
+            next_token();
+            return int_;
+        }
+
+        // Reads a string, throwing a `decoding_error` if the next value is not one.
+        str_type read_string_view() {
+            if (peek() != token::STR) {
+                throw errors::expecting_value_error.copy();
+            }
+            next_token();
+            return str_;
+        }
+
+        /*
+         * Skips over the next value, including everything inside it if it is a list or dict.
+         * Strings are jumped over by their length, and ints are not decoded.
+         */
+        void skip_value() {
+            helpers::detail::pointer_skip_value(begin_, pos_, size_);
+        }
+
+        /*
+         * Skips the rest of the list or dict the cursor is in, including its 'e'.
+         */
+        void skip_container() {
+            if (depth_ == 0) {
+                throw errors::expecting_value_error.copy();
+            }
+            while (peek() != token::END) {
+                skip_value();
+            }
+            ++pos_;
+            --depth_;
+        }
+
+        /*
+         * Just after `token::BEGIN_DICT`, or after a value in that dict, moves to the value for `key` and returns true.
+         * Otherwise, skips the rest of the dict and returns false. Stops early if a later key is found, as keys are sorted.
+         */
+        bool find_key(const char* const key, const ::std::size_t key_size) {
+            while (peek() != token::END) {
+                const str_type current = read_string_view();
+                if (current.size() == key_size && ::std::memcmp(current.data(), key, key_size) == 0) {
+                    return true;
+                }
+                if (helpers::detail::key_less_than(key, key_size, current.data(), current.size())) {
+                    skip_value();
+                    skip_container();
+                    return false;
+                }
+                skip_value();
+            }
+            next_token();
+            return false;
+        }
+
+        template<typename T, typename... Rest>
+        bool find_key(const ::std::basic_string<T, Rest...>& key) {
+            return find_key(reinterpret_cast<const char*>(key.data()), key.size());
+        }
+
+        bool find_key(const str_type key) {
+            return find_key(key.data(), key.size());
+        }
+
+        bool find_key(const char* const key) {
+            return find_key(key, ::std::strlen(key));
+        }
+    };
+
+    using cursor = basic_cursor<>;
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_CURSOR_H_
@@ -1,10 +1,14 @@
 #ifndef TORREBIS_BENCODE_DATA_CLASS_H_
 #define TORREBIS_BENCODE_DATA_CLASS_H_
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <map>
 #include <memory>
+#include <initializer_list>
+#include <stdexcept>
+#include <iterator>
 #include <type_traits>
 #include <utility>
 #include <ostream>
@@ -14,9 +18,17 @@
 #endif
 
 #include "torrebis_bencode/helpers.h"
+#include "torrebis_bencode/str_view.h"
 #include "torrebis_bencode/type_tags.h"
 #include "torrebis_bencode/path_el.h"
 #include "torrebis_bencode/errors.h"
+#include "torrebis_bencode/readers.h"
+#include "torrebis_bencode/writers.h"
+#include "torrebis_bencode/gather.h"
+#include "torrebis_bencode/events.h"
+#include "torrebis_bencode/flat_dict.h"
+#include "torrebis_bencode/arena.h"
+#include "torrebis_bencode/key_table.h"
 
 namespace torrebis { namespace bencode {
 
@@ -32,6 +44,103 @@ namespace torrebis { namespace bencode {
 #define TORREBIS_BASIC_DATA_TEMPLATE_TYPE basic_data<TORREBIS_BASIC_DATA_TEMPLATE_TYPE_FORWARD>
 #define TORREBIS_BASIC_DATA_TEMPLATE_FORWARD(basic_data) (basic_data)::StrType, (basic_data)::IntType, (basic_data)::ListType, (basic_data)::dict_is_ordered, (basic_data)::DictType, (basic_data)::Allocator
 
+    // Where a value was encoded in the buffer it was loaded from, as offsets from the start of the buffer.
+    struct source_span {
+        ::std::size_t begin;
+        ::std::size_t end;
+
+        ::std::size_t size() const noexcept { return end - begin; }
+    };
+
+    // Pass to `load` or `load_lazy` to remember where each value was encoded. See `basic_data::raw_span()`.
+    enum RecordSpans {
+        record_spans
+    };
+
+    namespace helpers { namespace detail {
+        // Whether `T` is a range of path elements, rather than a single key.
+        template<class T, class PathEl, class = void>
+        struct is_path_iterable : ::std::false_type {};
+
+        template<class T, class PathEl>
+        struct is_path_iterable<T, PathEl, typename ::std::enable_if<
+            ::std::is_convertible<decltype(*::std::begin(::std::declval<const T&>())), PathEl>::value &&
+            !::std::is_convertible<T, typename PathEl::str_type>::value
+        >::type> : ::std::true_type {};
+
+        // Bookkeeping kept next to a value that needs it. See `basic_data::boxed_flag`.
+        struct node_meta {
+            // The encoding of a lazily loaded list or dict whose items haven't been decoded yet, otherwise nullptr.
+            const char* lazy_begin;
+            ::std::size_t lazy_size;
+            // Where the value was loaded from, if `has_span`.
+            source_span span;
+            bool has_span;
+            // The result of `basic_data::cached_hash()`, if `has_hash`. Forgotten when the value is accessed mutably.
+            bool has_hash;
+            // The result of `basic_data::cached_serialised_size()`, if `has_size`. Forgotten like `hash`.
+            bool has_size;
+            ::std::uint64_t hash;
+            ::std::size_t size;
+            // The list or dict this was an item of when it last remembered its hash or size, which forgets them too.
+            ::std::weak_ptr<node_meta> parent;
+        };
+
+        template<class T, class Alloc, class... Args>
+        T construct_with_allocator_(::std::true_type, const Alloc& alloc, Args&&... args) { return T(::std::forward<Args>(args)..., alloc); }
+
+        template<class T, class Alloc, class... Args>
+        T construct_with_allocator_(::std::false_type, const Alloc&, Args&&... args) { return T(::std::forward<Args>(args)...); }
+
+        // Constructs a `T` from `args`, passing `alloc` after them if `T` takes an allocator that `alloc` converts to.
+        template<class T, class Alloc, class... Args>
+        T construct_with_allocator(const Alloc& alloc, Args&&... args) {
+            return construct_with_allocator_<T>(::std::uses_allocator<T, Alloc>(), alloc, ::std::forward<Args>(args)...);
+        }
+
+        template<class To, class From, class Alloc>
+        To take_str_(From&& s, const Alloc&, ::std::true_type) { return ::std::forward<From>(s); }
+
+        template<class To, class From, class Alloc>
+        To take_str_(From&& s, const Alloc& alloc, ::std::false_type) { return construct_with_allocator<To>(alloc, s.data(), s.size()); }
+
+        // `s` as a `To`, moved if it already is one, otherwise copied with `alloc`.
+        template<class To, class From, class Alloc>
+        To take_str(From&& s, const Alloc& alloc) { return take_str_<To>(::std::forward<From>(s), alloc, is_same_decayed<To, From>()); }
+
+        template<class To, class From, class Alloc>
+        To take_key_(From&& s, const Alloc& alloc, ::std::false_type) { return take_str<To>(::std::forward<From>(s), alloc); }
+
+        template<class To, class From, class Alloc>
+        To take_key_(From&& s, const Alloc&, ::std::true_type) {
+            key_table* const table = key_table::current();
+            const char* const chars = reinterpret_cast<const char*>(s.data());
+            return table == nullptr ? shared_string(chars, s.size()) : table->intern(chars, s.size());
+        }
+
+        // A dict key made like `take_str`, except that `shared_string` keys come from the current `key_table` if there is one.
+        template<class To, class From, class Alloc>
+        To take_key(From&& s, const Alloc& alloc) { return take_key_<To>(::std::forward<From>(s), alloc, is_same_decayed<To, shared_string>()); }
+
+        template<class Alloc, class T>
+        auto allocator_of_(const T& container, int) -> typename ::std::enable_if<
+            ::std::is_convertible<decltype(container.get_allocator()), Alloc>::value, Alloc
+        >::type { return container.get_allocator(); }
+
+        template<class Alloc, class T>
+        Alloc allocator_of_(const T&, long) { return Alloc(); }
+
+        // The allocator of `container` as an `Alloc`, or a default constructed `Alloc` if it can't be converted.
+        template<class Alloc, class T>
+        Alloc allocator_of(const T& container) { return allocator_of_<Alloc>(container, 0); }
+
+        template<class T>
+        struct node_box {
+            T value;
+            node_meta meta;
+        };
+    } }  // namespace torrebis::bencode::helpers::detail
+
     template<class StrType_ = ::std::string,
         class IntType_ = ::std::intmax_t,
         template<typename ValueType, typename...> class ListType_ = ::std::vector,
@@ -41,7 +150,12 @@ namespace torrebis { namespace bencode {
     >
     class basic_data final {
     private:
+        enum : ::std::uint8_t {
+            boxed_flag = 1  // `value_` points to a `helpers::detail::node_box` instead of the value itself
+        };
+
         DataTag tag_;
+        ::std::uint8_t flags_;  // Fits in the padding after `tag_`
         ::std::shared_ptr<void> value_;
     public:
         static constexpr bool dict_is_ordered = dict_is_ordered_;
@@ -65,10 +179,12 @@ namespace torrebis { namespace bencode {
         using const_list_type = const ListType<basic_data>;
         using const_dict_type = const DictType<str_type, basic_data>;
 
-        using str_allocator_type = const Allocator<str_type>;
-        using int_allocator_type = const Allocator<int_type>;
-        using list_allocator_type = const Allocator<list_type>;
-        using dict_allocator_type = const Allocator<dict_type>;
+        // Rebound to allocate each value. Functions that allocate can be given an instance of it.
+        using data_allocator_type = Allocator<basic_data>;
+        using str_allocator_type = Allocator<str_type>;
+        using int_allocator_type = Allocator<int_type>;
+        using list_allocator_type = Allocator<list_type>;
+        using dict_allocator_type = Allocator<dict_type>;
 
         using str_ptr = ::std::shared_ptr<str_type>;
         using int_ptr = ::std::shared_ptr<int_type>;
@@ -123,21 +239,118 @@ namespace torrebis { namespace bencode {
     private:
         template<typename MakeSpecifier>
         basic_data(const MakeSpecifier, tag_to_ptr_t<helpers::detail::make_specifier_to_tag<MakeSpecifier>::value> value) noexcept :
-            tag_(helpers::detail::make_specifier_to_tag<MakeSpecifier>::value), value_(value) {}
+            tag_(helpers::detail::make_specifier_to_tag<MakeSpecifier>::value), flags_(0), value_(value) {}
+
+        basic_data(const DataTag tag, const ::std::uint8_t flags, void_ptr value) noexcept :
+            tag_(tag), flags_(flags), value_(value) {}
+
+        template<DataTag tag>
+        using box_type = helpers::detail::node_box<tag_to_type_t<tag>>;
+
+        // Doesn't copy `value_`, so looking inside the box doesn't touch the reference count.
+        template<DataTag tag>
+        box_type<tag>* get_box() const noexcept {
+            return static_cast<box_type<tag>*>(value_.get());
+        }
+
+        helpers::detail::node_meta* get_meta() const noexcept {
+            if (!(flags_ & boxed_flag)) {
+                return nullptr;
+            }
+            switch (tag_) {
+                case DataTag::STR:
+                    return &get_box<DataTag::STR>()->meta;
+                case DataTag::INT:
+                    return &get_box<DataTag::INT>()->meta;
+                case DataTag::LIST:
+                    return &get_box<DataTag::LIST>()->meta;
+                case DataTag::DICT:
+                    return &get_box<DataTag::DICT>()->meta;
+                default:
+                    return nullptr;
+            }
+        }
+
+        // A pointer to the value itself (not its box), decoding the items of a lazily loaded list or dict first.
+        void_ptr value_ptr() const {
+            if (!(flags_ & boxed_flag)) {
+                return value_;
+            }
+            load_lazy_items();
+            switch (tag_) {
+                case DataTag::STR:
+                    return str_ptr(value_, &get_box<DataTag::STR>()->value);
+                case DataTag::INT:
+                    return int_ptr(value_, &get_box<DataTag::INT>()->value);
+                case DataTag::LIST:
+                    return list_ptr(value_, &get_box<DataTag::LIST>()->value);
+                case DataTag::DICT:
+                    return dict_ptr(value_, &get_box<DataTag::DICT>()->value);
+                default:
+                    return value_;
+            }
+        }
+
+        /*
+         * Makes this forget its cached hash and size, along with every list and dict it was an item of when they were
+         * remembered. Stops at the first that has nothing to forget: a list or dict only remembers while its items do.
+         */
+        void forget_cached() const noexcept {
+            helpers::detail::node_meta* meta = get_meta();
+            ::std::shared_ptr<helpers::detail::node_meta> parent;
+            while (meta != nullptr && (meta->has_hash || meta->has_size)) {
+                meta->has_hash = false;
+                meta->has_size = false;
+                parent = meta->parent.lock();
+                meta = parent.get();
+            }
+        }
+
+        // `value_ptr()` for access that could change the value, so a cached hash or size would be wrong.
+        void_ptr mutable_value_ptr() {
+            forget_cached();
+            return value_ptr();
+        }
+
+        // What `set` does, after making the lists and dicts the old value was in forget their cached hash and size.
+        void replace(basic_data&& value) noexcept {
+            forget_cached();
+            *this = ::std::move(value);
+        }
+
+        template<DataTag tag>
+        static basic_data make_boxed(tag_to_type_t<tag>&& value, const helpers::detail::node_meta& meta, const data_allocator_type& alloc) {
+            using allocator_t = Allocator<box_type<tag>>;
+            return basic_data(tag, boxed_flag, ::std::allocate_shared<box_type<tag>, allocator_t>(allocator_t(alloc), box_type<tag>{ ::std::move(value), meta }));
+        }
 
     public:
-        basic_data() noexcept : tag_(DataTag::UNINITIALISED), value_(nullptr) {}
+        basic_data() noexcept : tag_(DataTag::UNINITIALISED), flags_(0), value_(nullptr) {}
 
-        basic_data(const basic_data& other) noexcept : tag_(other.tag_), value_(other.value_) {}
-        basic_data(const basic_data&& other) noexcept : tag_(other.tag_), value_(other.value_) {}
-        basic_data& operator=(const basic_data& other) noexcept { if (&other != this) { tag_ = other.tag_; value_ = other.value_; }; return *this; }
-        basic_data& operator=(const basic_data&& other) noexcept { tag_ = other.tag_; value_ = other.value_; return *this; }
+        basic_data(const basic_data& other) noexcept : tag_(other.tag_), flags_(other.flags_), value_(other.value_) {}
+        basic_data(basic_data&& other) noexcept : tag_(other.tag_), flags_(other.flags_), value_(::std::move(other.value_)) {
+            other.tag_ = DataTag::UNINITIALISED;
+            other.flags_ = 0;
+        }
+        basic_data& operator=(const basic_data& other) noexcept { if (&other != this) { tag_ = other.tag_; flags_ = other.flags_; value_ = other.value_; }; return *this; }
+        basic_data& operator=(basic_data&& other) noexcept {
+            if (&other != this) {
+                tag_ = other.tag_;
+                flags_ = other.flags_;
+                value_ = ::std::move(other.value_);
+                other.tag_ = DataTag::UNINITIALISED;
+                other.flags_ = 0;
+            }
+            return *this;
+        }
+        // Whether this and `other` are the same value (Not just equal ones). See `equals()`.
         bool operator==(const basic_data& other) const noexcept { return tag_ == other.tag_ && value_ == other.value_; }
         bool operator!=(const basic_data& other) const noexcept { return !operator==(other); }
         void swap(basic_data& other) noexcept {
             DataTag other_tag = other.tag_;
             other.tag_ = tag_;
             tag_ = other_tag;
+            ::std::swap(flags_, other.flags_);
             ::std::swap(value_, other.value_);
         };
         explicit operator bool() const noexcept { return tag_ != DataTag::UNINITIALISED; }
@@ -159,128 +372,119 @@ namespace torrebis { namespace bencode {
         bool is_list() const noexcept { return tag_ == DataTag::LIST; }
         bool is_dict() const noexcept { return tag_ == DataTag::DICT; }
 
+        // Getting a lazily loaded list or dict decodes its items, which can throw.
+
         template<DataTag tag>
-        tag_to_ptr_t<tag> get() noexcept {
+        tag_to_ptr_t<tag> get() {
             return (tag == DataTag::UNINITIALISED || tag == tag_)
-                   ? ::std::static_pointer_cast<tag_to_type_t<tag>>(value_)
+                   ? ::std::static_pointer_cast<tag_to_type_t<tag>>(mutable_value_ptr())
                    : nullptr;
         }
 
         template<DataTag tag>
-        tag_to_const_ptr_t<tag> get() const noexcept {
+        tag_to_const_ptr_t<tag> get() const {
             return (tag == DataTag::UNINITIALISED || tag == tag_)
-                   ? ::std::static_pointer_cast<tag_to_const_type_t<tag>>(value_)
+                   ? ::std::static_pointer_cast<tag_to_const_type_t<tag>>(value_ptr())
                    : nullptr;
         }
 
         template<typename T>
-        ::std::shared_ptr<T> get() noexcept {
+        ::std::shared_ptr<T> get() {
             TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<T, void>::value) {
-                return value_;
+                return mutable_value_ptr();
             }
             if (type_to_tag<T>::value == tag_) {
-                return ::std::static_pointer_cast<T>(value_);
+                return ::std::static_pointer_cast<T>(mutable_value_ptr());
             }
             return nullptr;
         }
 
         template<typename T>
-        const ::std::shared_ptr<const T> get() const noexcept {
+        const ::std::shared_ptr<const T> get() const {
             TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<T, void>::value) {
-                return value_;
+                return value_ptr();
             }
             if (type_to_tag<T>::value == tag_) {
-                return ::std::static_pointer_cast<const T>(value_);
+                return ::std::static_pointer_cast<const T>(value_ptr());
             }
             return nullptr;
         }
 
-        void_ptr get(DataTag tag) noexcept {
-            return (tag == DataTag::UNINITIALISED || tag == tag_) ? value_ : nullptr;
+        void_ptr get(DataTag tag) {
+            return (tag == DataTag::UNINITIALISED || tag == tag_) ? mutable_value_ptr() : nullptr;
         }
-        const_void_ptr get(DataTag tag) const noexcept {
-            return (tag == DataTag::UNINITIALISED || tag == tag_) ? ::std::static_pointer_cast<const void>(value_) : nullptr;
+        const_void_ptr get(DataTag tag) const {
+            return (tag == DataTag::UNINITIALISED || tag == tag_) ? ::std::static_pointer_cast<const void>(value_ptr()) : nullptr;
         }
 
         str_ptr get_str() noexcept { return get<DataTag::STR>(); }
         const_str_ptr get_str() const noexcept { return get<DataTag::STR>(); }
         int_ptr get_int() noexcept { return get<DataTag::INT>(); }
         const_int_ptr get_int() const noexcept { return get<DataTag::INT>(); }
-        list_ptr get_list() noexcept { return get<DataTag::LIST>(); }
-        const_list_ptr get_list() const noexcept { return get<DataTag::LIST>(); }
-        dict_ptr get_dict() noexcept { return get<DataTag::DICT>(); }
-        const_dict_ptr get_dict() const noexcept { return get<DataTag::DICT>(); }
-        void_ptr get_any() noexcept { return get<DataTag::UNINITIALISED>(); }
-        const_void_ptr get_any() const noexcept { return get<DataTag::UNINITIALISED>(); }
+        list_ptr get_list() { return get<DataTag::LIST>(); }
+        const_list_ptr get_list() const { return get<DataTag::LIST>(); }
+        dict_ptr get_dict() { return get<DataTag::DICT>(); }
+        const_dict_ptr get_dict() const { return get<DataTag::DICT>(); }
+        void_ptr get_any() { return get<DataTag::UNINITIALISED>(); }
+        const_void_ptr get_any() const { return get<DataTag::UNINITIALISED>(); }
+
+        /*
+         * Where this value was encoded in the buffer it was loaded from, if it was loaded with `record_spans`,
+         * otherwise nullptr. This is not updated if the value is changed.
+         */
+        const source_span* raw_span() const noexcept {
+            const helpers::detail::node_meta* const meta = get_meta();
+            return meta != nullptr && meta->has_span ? &meta->span : nullptr;
+        }
 
-        template<DataTag tag>
-        void set(const tag_to_type<tag> value) {
-            using allocator_t = tag_to_allocator_t<tag>;
-            value_ = ::std::allocate_shared<tag_to_type_t<tag>, allocator_t>(allocator_t(), value);
+        // Whether this is a lazily loaded list or dict whose items haven't been decoded yet.
+        bool is_lazy() const noexcept {
+            const helpers::detail::node_meta* const meta = get_meta();
+            return meta != nullptr && meta->lazy_begin != nullptr;
         }
 
         template<DataTag tag>
-        void set(const tag_to_ptr<tag> value) noexcept {
-            if (value == nullptr || tag == DataTag::UNINITIALISED) {
-                tag_ = DataTag::UNINITIALISED;
-                value_ = nullptr;
-                return;
-            }
+        void set(const tag_to_type_t<tag>& value) { replace(make<tag>(value)); }
 
-            using type = tag_to_type<tag>;
-            if (tag != tag_) {
-                tag_ = tag;
-                value = nullptr;
-            }
-            ::std::static_pointer_cast<type>(value_) = value;
-        }
+        template<DataTag tag>
+        void set(tag_to_type_t<tag>&& value) { replace(make<tag>(::std::move(value))); }
 
-        void set(const DataTag tag, const ::std::shared_ptr<void> value) noexcept {
-            if (value == nullptr || tag == DataTag::UNINITIALISED) {
-                tag_ = DataTag::UNINITIALISED;
-                value_ = nullptr;
-                return;
-            }
-            if (tag != tag_) {
-                tag_ = tag;
-            }
-            value_ = value;
-        }
+        template<DataTag tag>
+        void set(const tag_to_ptr_t<tag> value) noexcept { replace(make<tag>(value)); }
+
+        void set(const DataTag tag, const ::std::shared_ptr<void> value) noexcept { replace(make(tag, value)); }
 
         template<typename T>
-        void set(T value) { set<type_to_tag<T>::value>(value); }
+        void set(T&& value) { set<type_to_tag<typename helpers::detail::remove_cv_ref<T>::type>::value>(::std::forward<T>(value)); }
 
+        // Constructs the new value in place from `args`.
         template<DataTag tag, typename... Args>
-        void set(Args... args) {
-            using type = tag_to_type<tag>;
-            using allocator_t = tag_to_allocator_t<tag>;
-            value_ = ::std::allocate_shared<type, allocator_t>(allocator_t(), type(args...));
-        }
+        void set(Args&&... args) { replace(make<tag>(::std::forward<Args>(args)...)); }
 
-        void set_str(const str_type s) { set<DataTag::STR>(s); }
+        void set_str(const str_type& s) { set<DataTag::STR>(s); }
+        void set_str(str_type&& s) { set<DataTag::STR>(::std::move(s)); }
         void set_str(const str_ptr s) noexcept { set<DataTag::STR>(s); }
-        template<typename... Args> void set_str(Args... args) { set<DataTag::STR>(args...); }
-        void set_int(const int_type i) { set<DataTag::INT>(i); }
+        template<typename... Args> void set_str(Args&&... args) { set<DataTag::STR>(::std::forward<Args>(args)...); }
+        void set_int(const int_type& i) { set<DataTag::INT>(i); }
         void set_int(const int_ptr i) noexcept { set<DataTag::INT>(i); }
-        template<typename... Args> void set_int(Args... args) { set<DataTag::INT>(args...); }
-        void set_list(const list_type l) { set<DataTag::LIST>(l); }
+        template<typename... Args> void set_int(Args&&... args) { set<DataTag::INT>(::std::forward<Args>(args)...); }
+        void set_list(const list_type& l) { set<DataTag::LIST>(l); }
+        void set_list(list_type&& l) { set<DataTag::LIST>(::std::move(l)); }
         void set_list(const list_ptr l) noexcept { set<DataTag::LIST>(l); }
-        template<typename... Args> void set_list(Args... args) { set<DataTag::LIST>(args...); }
-        void set_dict(const dict_type d) { set<DataTag::DICT>(d); }
+        template<typename... Args> void set_list(Args&&... args) { set<DataTag::LIST>(::std::forward<Args>(args)...); }
+        void set_dict(const dict_type& d) { set<DataTag::DICT>(d); }
+        void set_dict(dict_type&& d) { set<DataTag::DICT>(::std::move(d)); }
         void set_dict(const dict_ptr d) noexcept { set<DataTag::DICT>(d); }
-        template<typename... Args> void set_dict(Args... args) { set<DataTag::DICT>(args...); }
+        template<typename... Args> void set_dict(Args&&... args) { set<DataTag::DICT>(::std::forward<Args>(args)...); }
 
         template<DataTag tag>
-        static basic_data make(const tag_to_type<tag> value) {
-            using allocator_t = tag_to_allocator_t<tag>;
-            return basic_data(
-                helpers::detail::tag_to_make_specifier<tag>::value,
-                ::std::allocate_shared<tag_to_type_t<tag>, allocator_t>(allocator_t(), value)
-            );
-        }
+        static basic_data make(const tag_to_type_t<tag>& value) { return allocate<tag>(data_allocator_type(), value); }
+
+        template<DataTag tag>
+        static basic_data make(tag_to_type_t<tag>&& value) { return allocate<tag>(data_allocator_type(), ::std::move(value)); }
 
         template<DataTag tag>
-        static basic_data make(const tag_to_ptr<tag> value) noexcept {
+        static basic_data make(const tag_to_ptr_t<tag> value) noexcept {
             if (value == nullptr || tag == DataTag::UNINITIALISED) {
                 return basic_data();
             }
@@ -295,383 +499,525 @@ namespace torrebis { namespace bencode {
             if (value == nullptr || tag == DataTag::UNINITIALISED) {
                 return basic_data();
             }
-            switch (tag) {
-                case DataTag::STR:
-                    return basic_data(make_str, value);
-                case DataTag::INT:
-                    return basic_data(make_int, value);
-                case DataTag::LIST:
-                    return basic_data(make_list, value);
-                case DataTag::DICT:
-                    return basic_data(make_dict, value);
-                default:
-                    return basic_data();
-            }
+            return basic_data(tag, 0, value);
         }
 
         template<typename T>
-        static basic_data make(T value) { return make<type_to_tag<T>::value>(value); }
+        static basic_data make(T&& value) { return make<type_to_tag<typename helpers::detail::remove_cv_ref<T>::type>::value>(::std::forward<T>(value)); }
 
+        // Constructs the value in place from `args`.
         template<DataTag tag, typename... Args>
-        static basic_data make(Args... args) {
+        static basic_data make(Args&&... args) { return allocate<tag>(data_allocator_type(), ::std::forward<Args>(args)...); }
+
+    private:
+        template<DataTag tag, typename... Args>
+        static basic_data allocate_(::std::false_type, const data_allocator_type& alloc, Args&&... args) {
             using type = tag_to_type_t<tag>;
             using allocator_t = tag_to_allocator_t<tag>;
             return basic_data(
                 helpers::detail::tag_to_make_specifier<tag>::value,
-                ::std::allocate_shared<type, allocator_t>(allocator_t(), type(args...))
+                ::std::allocate_shared<type, allocator_t>(allocator_t(alloc), ::std::forward<Args>(args)...)
             );
         }
 
-        static basic_data make_str(const str_type s) { return make<DataTag::STR>(s); }
+        // Lists and dicts are boxed, so they have somewhere to remember their hash and serialised size.
+        template<DataTag tag, typename... Args>
+        static basic_data allocate_(::std::true_type, const data_allocator_type& alloc, Args&&... args) {
+            using type = tag_to_type_t<tag>;
+            using allocator_t = tag_to_allocator_t<tag>;
+            // Constructed the way `allocate_shared` would (So a scoped allocator still reaches it), then moved into the box
+            allocator_t value_alloc(alloc);
+            typename ::std::aligned_storage<sizeof(type), alignof(type)>::type storage;
+            type* const value = reinterpret_cast<type*>(&storage);
+            ::std::allocator_traits<allocator_t>::construct(value_alloc, value, ::std::forward<Args>(args)...);
+            struct destroyer {
+                allocator_t& alloc;
+                type* value;
+                ~destroyer() { ::std::allocator_traits<allocator_t>::destroy(alloc, value); }
+            } destroy{ value_alloc, value };
+            return make_boxed<tag>(::std::move(*value), helpers::detail::node_meta(), alloc);
+        }
+
+    public:
+        // Like `make<tag>(args...)`, but the value is allocated with `alloc` (rebound to its type).
+        template<DataTag tag, typename... Args>
+        static basic_data allocate(const data_allocator_type& alloc, Args&&... args) {
+            return allocate_<tag>(::std::integral_constant<bool, tag == DataTag::LIST || tag == DataTag::DICT>(), alloc, ::std::forward<Args>(args)...);
+        }
+
+        static basic_data make_str(const str_type& s) { return make<DataTag::STR>(s); }
+        static basic_data make_str(str_type&& s) { return make<DataTag::STR>(::std::move(s)); }
         static basic_data make_str(const str_ptr s) noexcept { return make<DataTag::STR>(s); }
-        template<typename... Args> static basic_data make_str(Args... args) { return make<DataTag::STR>(args...); }
-        static basic_data make_int(const int_type i) { return make<DataTag::INT>(i); }
+        template<typename... Args> static basic_data make_str(Args&&... args) { return make<DataTag::STR>(::std::forward<Args>(args)...); }
+        static basic_data make_int(const int_type& i) { return make<DataTag::INT>(i); }
         static basic_data make_int(const int_ptr i) noexcept { return make<DataTag::INT>(i); }
-        template<typename... Args> static basic_data make_int(Args... args) { return make<DataTag::INT>(args...); }
-        static basic_data make_list(const list_type l) { return make<DataTag::LIST>(l); }
+        template<typename... Args> static basic_data make_int(Args&&... args) { return make<DataTag::INT>(::std::forward<Args>(args)...); }
+        static basic_data make_list(const list_type& l) { return make<DataTag::LIST>(l); }
+        static basic_data make_list(list_type&& l) { return make<DataTag::LIST>(::std::move(l)); }
         static basic_data make_list(const list_ptr l) noexcept { return make<DataTag::LIST>(l); }
-        template<typename... Args> static basic_data make_list(Args... args) { return make<DataTag::LIST>(args...); }
-        static basic_data make_dict(const dict_type d) { return make<DataTag::DICT>(d); }
+        template<typename... Args> static basic_data make_list(Args&&... args) { return make<DataTag::LIST>(::std::forward<Args>(args)...); }
+        static basic_data make_dict(const dict_type& d) { return make<DataTag::DICT>(d); }
+        static basic_data make_dict(dict_type&& d) { return make<DataTag::DICT>(::std::move(d)); }
         static basic_data make_dict(const dict_ptr d) noexcept { return make<DataTag::DICT>(d); }
-        template<typename... Args> static basic_data make_dict(Args... args) { return make<DataTag::DICT>(args...); }
+        template<typename... Args> static basic_data make_dict(Args&&... args) { return make<DataTag::DICT>(::std::forward<Args>(args)...); }
 
-        void reset() noexcept { tag_ = DataTag::UNINITIALISED; value_ = nullptr; }
+        void reset() noexcept { forget_cached(); tag_ = DataTag::UNINITIALISED; flags_ = 0; value_ = nullptr; }
 
-        ~basic_data() noexcept { tag_ = DataTag::UNINITIALISED; value_ = nullptr; }
+        ~basic_data() noexcept { tag_ = DataTag::UNINITIALISED; flags_ = 0; value_ = nullptr; }
 
         using path_el_type = basic_path_el<str_type>;
 
-        template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
-        const basic_data* get_path(PathEls... path) const {
-            const basic_data* result = this;
-            const path_el_type path_arr[sizeof...(path)] = { path... };
-            for (::std::size_t i = 0; i < sizeof...(path); ++i) {
-                const path_el_type path_i(path_arr[i]);
-                if (path_i.is_key()) {
-                    if (!result->is_dict()) {
-                        return nullptr;
-                    }
-                    dict_type& dict = result->get_dict();
-                    auto search = dict.find(*path_i.get_key());
-                    if (search == dict.end()) {
-                        return nullptr;
-                    }
-                    result = &search->second;
-                } else if (path_i.is_index()) {
-                    if (!result->is_list()) {
-                        return nullptr;
-                    }
-                    list_type& list = result->get_list();
-                    if (path_i.get_index() >= list.size()) {
-                        return nullptr;
-                    }
-                    result = &list.at(path_i.get_index());
-                } else {
+    private:
+        // The item at `el` in `data`, or nullptr if there isn't one.
+        template<class BasicData>
+        static BasicData* path_step(BasicData* const data, const path_el_type& el) {
+            if (el.is_key()) {
+                if (!data->is_dict()) {
                     return nullptr;
                 }
+                auto& dict = *data->get_dict();
+                auto search = dict.find(*el.get_key());
+                if (search == dict.end()) {
+                    return nullptr;
+                }
+                return &search->second;
             }
-            return result;
-        }
-
-        template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
-        basic_data* get_path(PathEls... path) {
-            basic_data* result = this;
-            const path_el_type path_arr[sizeof...(path)] = { path_el_type(path)... };
-            for (::std::size_t i = 0; i < sizeof...(path); ++i) {
-                const path_el_type path_i(path_arr[i]);
-                if (path_i.is_key()) {
-                    if (!result->is_dict()) {
-                        return nullptr;
-                    }
-                    dict_type& dict = *result->get_dict();
-                    auto search = dict.find(*path_i.get_key());
-                    if (search == dict.end()) {
-                        return nullptr;
-                    }
-                    result = &search->second;
-                } else if (path_i.is_index()) {
-                    if (!result->is_list()) {
-                        return nullptr;
-                    }
-                    list_type& list = *result->get_list();
-                    if (path_i.get_index() >= list.size()) {
-                        return nullptr;
-                    }
-                    result = &list.at(path_i.get_index());
-                } else {
+            if (el.is_index()) {
+                if (!data->is_list()) {
+                    return nullptr;
+                }
+                auto& list = *data->get_list();
+                if (el.get_index() >= list.size()) {
                     return nullptr;
                 }
+                return &list[el.get_index()];
             }
-            return result;
+            return nullptr;
         }
 
-        template<class T>  // Where T is an iterable of basic_data::path_el_type
-        const basic_data* get_path(T path) const {
-            const basic_data& result = *this;
+        // Follows as much of `path` as possible, returning how many elements were followed and where that led.
+        template<class BasicData, class T>
+        static ::std::pair<::std::size_t, BasicData*> path_loop(BasicData* result, const T& path) {
+            ::std::size_t i = 0;
             for (const auto& el : path) {
-                path_el_type path_i(el);
-                if (path_i.is_key()) {
-                    if (!result.is_dict()) {
-                        return nullptr;
-                    }
-                    dict_type& dict = *result.get_dict();
-                    auto search = dict.find(*path_i.get_key());
-                    if (search == dict.end()) {
-                        return nullptr;
-                    }
-                    result = search->second;
-                } else if (path_i.is_index()) {
-                    if (!result.is_list()) {
-                        return nullptr;
-                    }
-                    list_type& list = *result.get_list();
-                    if (path_i.get_index() >= list.size()) {
-                        return nullptr;
-                    }
-                    result = list[path_i.get_index()];
-                } else {
-                    return nullptr;
+                BasicData* const next = path_step<BasicData>(result, path_el_type(el));
+                if (next == nullptr) {
+                    break;
                 }
+                result = next;
+                ++i;
             }
-            return &result;
+            return { i, result };
         }
 
         template<class T>
-        basic_data* get_path(T path) {
-            basic_data& result = *this;
-            for (const auto& el : path) {
-                path_el_type path_i(el);
-                if (path_i.is_key()) {
-                    if (!result.is_dict()) {
-                        return nullptr;
-                    }
-                    dict_type& dict = *result.get_dict();
-                    auto search = dict.find(*path_i.get_key());
-                    if (search == dict.end()) {
-                        return nullptr;
-                    }
-                    result = search->second;
-                } else if (path_i.is_index()) {
-                    if (!result.is_list()) {
-                        return nullptr;
-                    }
-                    list_type& list = *result.get_list();
-                    if (path_i.get_index() >= list.size()) {
-                        return nullptr;
-                    }
-                    result = list[path_i.get_index()];
-                } else {
-                    return nullptr;
-                }
-            }
-            return &result;
+        using enable_if_path_iterable = typename ::std::enable_if<helpers::detail::is_path_iterable<T, path_el_type>::value>::type;
+
+    public:
+        template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+        const basic_data* get_path(PathEls... path) const {
+            const ::std::initializer_list<path_el_type> path_list = { path_el_type(path)... };
+            return get_path(path_list);
+        }
+
+        template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+        basic_data* get_path(PathEls... path) {
+            const ::std::initializer_list<path_el_type> path_list = { path_el_type(path)... };
+            return get_path(path_list);
+        }
+
+        template<class T, class = enable_if_path_iterable<T>>  // Where T is an iterable of basic_data::path_el_type
+        const basic_data* get_path(const T& path) const {
+            auto followed = path_loop<const basic_data, T>(this, path);
+            return followed.first == static_cast<::std::size_t>(::std::distance(::std::begin(path), ::std::end(path))) ? followed.second : nullptr;
         }
 
+        template<class T, class = enable_if_path_iterable<T>>
+        basic_data* get_path(const T& path) {
+            auto followed = path_loop<basic_data, T>(this, path);
+            return followed.first == static_cast<::std::size_t>(::std::distance(::std::begin(path), ::std::end(path))) ? followed.second : nullptr;
+        }
+
+        // How many elements of the path could be followed, and the data at the end of them.
+
         template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
         const ::std::pair<const ::std::size_t, const basic_data&> try_path(PathEls... path) const {
-            const basic_data& result = *this;
-            ::std::size_t i = 0;
-            const path_el_type path_arr[sizeof...(path)] = { path... };
-            for (i = 0; i < sizeof...(path); ++i) {
-                const path_el_type path_i(path_arr[i]);
-                if (path_i.is_key()) {
-                    if (!result.is_dict()) {
-                        break;
-                    }
-                    dict_type& dict = *result.get_dict();
-                    auto search = dict.find(*path_i.get_key());
-                    if (search == dict.end()) {
-                        break;
-                    }
-                    result = search->second;
-                } else if (path_i.is_index()) {
-                    if (!result.is_list()) {
-                        break;
-                    }
-                    list_type& list = *result.get_list();
-                    if (path_i.get_index() >= list.size()) {
-                        break;
-                    }
-                    result = list[path_i.get_index()];
-                } else {
-                    break;
-                }
-            }
-            return { i, result };
+            const ::std::initializer_list<path_el_type> path_list = { path_el_type(path)... };
+            return try_path(path_list);
         }
 
         template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
         const ::std::pair<const ::std::size_t, basic_data&> try_path(PathEls... path) {
-            basic_data& result = *this;
-            ::std::size_t i = 0;
-            const path_el_type path_arr[sizeof...(path)] = { path... };
-            for (i = 0; i < sizeof...(path); ++i) {
-                const path_el_type path_i(path_arr[i]);
-                if (path_i.is_key()) {
-                    if (!result.is_dict()) {
-                        break;
-                    }
-                    dict_type& dict = *result.get_dict();
-                    auto search = dict.find(*path_i.get_key());
+            const ::std::initializer_list<path_el_type> path_list = { path_el_type(path)... };
+            return try_path(path_list);
+        }
+
+        template<typename T, class = enable_if_path_iterable<T>>
+        ::std::pair<const ::std::size_t, const basic_data&> try_path(const T& path) const {
+            auto followed = path_loop<const basic_data, T>(this, path);
+            return { followed.first, *followed.second };
+        }
+
+        template<typename T, class = enable_if_path_iterable<T>>
+        ::std::pair<const ::std::size_t, basic_data&> try_path(const T& path) {
+            auto followed = path_loop<basic_data, T>(this, path);
+            return { followed.first, *followed.second };
+        }
+
+        // Copy-on-write editing
+    private:
+        /*
+         * A copy of this with `*value` (or nothing, if `value` is nullptr) at the end of the path from `first` to `last`.
+         * Each list and dict on the path is copied, so it gets new copies of its items that share their values.
+         */
+        template<class Iterator>
+        basic_data with_path_(Iterator first, const Iterator last, const basic_data* const value) const {
+            const path_el_type el(*first);
+            const bool at_end = ++first == last;
+            if (el.is_key() && is_dict()) {
+                dict_type dict = *get_dict();
+                const data_allocator_type alloc = helpers::detail::allocator_of<data_allocator_type>(dict);
+                auto search = dict.find(*el.get_key());
+                if (at_end && value == nullptr) {
                     if (search == dict.end()) {
-                        break;
-                    }
-                    result = search->second;
-                } else if (path_i.is_index()) {
-                    if (!result.is_list()) {
-                        break;
-                    }
-                    list_type& list = *result.get_list();
-                    if (path_i.get_index() >= list.size()) {
-                        break;
+                        throw ::std::out_of_range("basic_data::without_path");
                     }
-                    result = list[path_i.get_index()];
+                    dict.erase(search);
+                } else if (at_end && search == dict.end()) {
+                    dict.emplace(*el.get_key(), *value);
+                } else if (at_end) {
+                    search->second = *value;
+                } else if (search == dict.end()) {
+                    throw ::std::out_of_range(value == nullptr ? "basic_data::without_path" : "basic_data::with_path");
                 } else {
-                    break;
+                    search->second = search->second.with_path_(first, last, value);
                 }
+                return allocate<DataTag::DICT>(alloc, ::std::move(dict));
             }
-            return { i, result };
+            if (el.is_index() && is_list()) {
+                list_type list = *get_list();
+                const data_allocator_type alloc = helpers::detail::allocator_of<data_allocator_type>(list);
+                const ::std::size_t index = el.get_index();
+                if (index >= list.size()) {
+                    throw ::std::out_of_range(value == nullptr ? "basic_data::without_path" : "basic_data::with_path");
+                }
+                auto item = list.begin() + static_cast<typename list_type::difference_type>(index);
+                if (at_end && value == nullptr) {
+                    list.erase(item);
+                } else if (at_end) {
+                    *item = *value;
+                } else {
+                    *item = item->with_path_(first, last, value);
+                }
+                return allocate<DataTag::LIST>(alloc, ::std::move(list));
+            }
+            throw ::std::out_of_range(value == nullptr ? "basic_data::without_path" : "basic_data::with_path");
         }
 
-        template<typename T>
-        ::std::pair<const ::std::size_t, const basic_data&> try_path(T path) const {
-            const basic_data& result = *this;
-            ::std::size_t i = 0;
-            for (auto& el : path) {
-                ++i;
-                path_el_type path_i(el);
-                if (path_i.is_key()) {
-                    if (!result.is_dict()) {
-                        break;
-                    }
-                    dict_type& dict = *result.get_dict();
-                    auto search = dict.find(*path_i.get_key());
-                    if (search == dict.end()) {
-                        break;
+    public:
+        /*
+         * A copy of this with `value` at `path`, leaving this and every copy of it unchanged. Only the lists and dicts on
+         * the path are copied, and their items still share everything below them with this. The last element of the path
+         * can be a key that isn't in its dict yet. Throws `std::out_of_range` if the rest of the path can't be followed.
+         */
+        template<class T, class = enable_if_path_iterable<T>>
+        basic_data with_path(const T& path, const basic_data& value) const {
+            if (::std::begin(path) == ::std::end(path)) {
+                return value;
+            }
+            return with_path_(::std::begin(path), ::std::end(path), &value);
+        }
+
+        basic_data with_path(const ::std::initializer_list<path_el_type> path, const basic_data& value) const {
+            return with_path<::std::initializer_list<path_el_type>>(path, value);
+        }
+
+        // A copy of this without the dict item or list item at `path`, like `with_path`. An empty path gives nothing.
+        template<class T, class = enable_if_path_iterable<T>>
+        basic_data without_path(const T& path) const {
+            if (::std::begin(path) == ::std::end(path)) {
+                return basic_data();
+            }
+            return with_path_(::std::begin(path), ::std::end(path), nullptr);
+        }
+
+        basic_data without_path(const ::std::initializer_list<path_el_type> path) const {
+            return without_path<::std::initializer_list<path_el_type>>(path);
+        }
+
+        // Structural comparison
+    private:
+        // The list or dict a `cached_hash()` or `cached_serialised_size()` walk is in, which its items are linked to.
+        struct cache_parent {
+            ::std::weak_ptr<helpers::detail::node_meta> meta;  // Empty if it isn't boxed
+            bool cacheable;  // Whether changing any item so far would make it forget, so it can remember
+        };
+
+        // Where to link the items of this while remembering its hash or size, or nullptr if they can't be.
+        cache_parent* as_cache_parent(cache_parent& storage) const {
+            helpers::detail::node_meta* const meta = get_meta();
+            if (meta == nullptr || (tag_ != DataTag::LIST && tag_ != DataTag::DICT)) {
+                return nullptr;
+            }
+            storage.meta = ::std::shared_ptr<helpers::detail::node_meta>(value_, meta);
+            storage.cacheable = true;
+            return &storage;
+        }
+
+        /*
+         * Links this item to `parent`, so that changing it makes `parent` forget. `parent` can't remember if this can't
+         * be linked: a list or dict that isn't boxed (Made from a `list_ptr` or `dict_ptr`), or an item of another list
+         * or dict that is still alive.
+         */
+        void link_to(cache_parent* const parent) const noexcept {
+            if (parent == nullptr) {
+                return;
+            }
+            helpers::detail::node_meta* const meta = get_meta();
+            if (meta == nullptr) {
+                if (tag_ == DataTag::LIST || tag_ == DataTag::DICT) {
+                    parent->cacheable = false;
+                }
+                return;
+            }
+            if (!meta->parent.owner_before(parent->meta) && !parent->meta.owner_before(meta->parent)) {
+                return;  // Already linked to it
+            }
+            if (meta->parent.expired()) {
+                meta->parent = parent->meta;
+            } else {
+                parent->cacheable = false;
+            }
+        }
+
+        ::std::uint64_t remember_hash(cache_parent* const parent) const {
+            link_to(parent);
+            helpers::detail::node_meta* const meta = get_meta();
+            if (meta != nullptr && meta->has_hash) {
+                return meta->hash;
+            }
+            cache_parent storage;
+            cache_parent* const self = as_cache_parent(storage);
+            const ::std::uint64_t hash = compute_hash<true>(self);
+            if (meta == nullptr) {
+                return hash;
+            }
+            if (self == nullptr || self->cacheable) {
+                meta->hash = hash;
+                meta->has_hash = true;
+            } else if (parent != nullptr) {
+                parent->cacheable = false;
+            }
+            return hash;
+        }
+
+        template<bool cached>
+        ::std::uint64_t item_hash(cache_parent* const parent) const { return cached ? remember_hash(parent) : hash(); }
+
+        template<bool cached>
+        ::std::uint64_t compute_hash(cache_parent* const self) const {
+            switch (tag_) {
+                case DataTag::INT: {
+                    const int_type& i = *get_int();
+                    TORREBIS_CONSTEXPR_IF (::std::is_integral<int_type>::value) {
+                        return helpers::detail::hash_combine('i', helpers::detail::hash_bytes(&i, sizeof(i)));
                     }
-                    result = search->second;
-                } else if (path_i.is_index()) {
-                    if (!result.is_list()) {
-                        break;
+                    ::std::string s;
+                    helpers::detail::append_int(i, s);
+                    return helpers::detail::hash_combine('i', helpers::detail::hash_bytes(s.data(), s.size()));
+                }
+                case DataTag::STR: {
+                    const str_type& ss = *get_str();
+                    return helpers::detail::hash_combine('s', helpers::detail::hash_bytes(ss.data(), ss.size() * sizeof(*ss.data())));
+                }
+                case DataTag::LIST: {
+                    ::std::uint64_t hash = 'l';
+                    for (const basic_data& i : *get_list()) {
+                        hash = helpers::detail::hash_combine(hash, i.item_hash<cached>(self));
                     }
-                    list_type& list = *result.get_list();
-                    if (path_i.get_index() >= list.size()) {
-                        break;
+                    return hash;
+                }
+                case DataTag::DICT: {
+                    // Summed, so that it doesn't depend on the order of the items
+                    ::std::uint64_t sum = 0;
+                    const auto& dict = *get_dict();
+                    for (const auto& i : dict) {
+                        const ::std::uint64_t key_hash = helpers::detail::hash_bytes(i.first.data(), i.first.size() * sizeof(*i.first.data()));
+                        sum += helpers::detail::hash_combine(key_hash, i.second.template item_hash<cached>(self));
                     }
-                    result = list[path_i.get_index()];
-                } else {
-                    break;
+                    return helpers::detail::hash_combine(helpers::detail::hash_combine('d', dict.size()), sum);
                 }
+                default:
+                    return 0;
             }
-            return { i, result };
         }
 
-        template<typename T>
-        ::std::pair<const ::std::size_t, basic_data&> try_path(T path) {
-            basic_data& result = *this;
-            ::std::size_t i = 0;
-            for (auto& el : path) {
-                ++i;
-                path_el_type path_i(el);
-                if (path_i.is_key()) {
-                    if (!result.is_dict()) {
-                        break;
+    public:
+        /*
+         * Whether this and `other` have the same type and equal values, comparing lists and dicts item by item (Copies of
+         * the same value are equal without looking at their items).
+         */
+        bool equals(const basic_data& other) const {
+            if (tag_ != other.tag_) {
+                return false;
+            }
+            if (value_ == other.value_) {
+                return true;
+            }
+            switch (tag_) {
+                case DataTag::INT:
+                    return *get_int() == *other.get_int();
+                case DataTag::STR:
+                    return *get_str() == *other.get_str();
+                case DataTag::LIST: {
+                    const list_type& a = *get_list();
+                    const list_type& b = *other.get_list();
+                    if (a.size() != b.size()) {
+                        return false;
                     }
-                    dict_type& dict = *result.get_dict();
-                    auto search = dict.find(*path_i.get_key());
-                    if (search == dict.end()) {
-                        break;
+                    auto it = b.begin();
+                    for (const basic_data& i : a) {
+                        if (!i.equals(*it)) {
+                            return false;
+                        }
+                        ++it;
                     }
-                    result = search->second;
-                } else if (path_i.is_index()) {
-                    if (!result.is_list()) {
-                        break;
+                    return true;
+                }
+                case DataTag::DICT: {
+                    const dict_type& a = *get_dict();
+                    const dict_type& b = *other.get_dict();
+                    if (a.size() != b.size()) {
+                        return false;
                     }
-                    list_type& list = *result.get_list();
-                    if (path_i.get_index() >= list.size()) {
-                        break;
+                    TORREBIS_CONSTEXPR_IF (dict_is_ordered) {
+                        auto it = b.begin();
+                        for (const auto& i : a) {
+                            if (!(i.first == it->first) || !i.second.equals(it->second)) {
+                                return false;
+                            }
+                            ++it;
+                        }
+                        return true;
                     }
-                    result = list[path_i.get_index()];
-                } else {
-                    break;
+                    for (const auto& i : a) {
+                        auto search = b.find(i.first);
+                        if (search == b.end() || !i.second.equals(search->second)) {
+                            return false;
+                        }
+                    }
+                    return true;
                 }
+                default:
+                    return true;
             }
-            return { i, result };
         }
 
+        // A hash of the structure and values of this, so values that `equals()` each other have the same hash.
+        ::std::uint64_t hash() const { return compute_hash<false>(nullptr); }
+
+        /*
+         * `hash()`, remembered by this and every list and dict in it, so hashing it again, or hashing something that
+         * contains it, doesn't look at items that haven't changed. See "Comparing and hashing" in the README for what
+         * makes them forget.
+         *
+         * Not thread safe: remembering the hash writes to the value, so it can't be called on the same document (or
+         * copies of it) from different threads at once.
+         */
+        ::std::uint64_t cached_hash() const { return remember_hash(nullptr); }
+
+        // For unordered containers of `basic_data` that compare by value.
+        struct structural_hash {
+            ::std::size_t operator()(const basic_data& data) const { return static_cast<::std::size_t>(data.hash()); }
+        };
+
+        struct structural_equal {
+            bool operator()(const basic_data& a, const basic_data& b) const { return a.equals(b); }
+        };
+
         // Serialisation
     private:
-        template<typename IntType>
-        static ::std::size_t serialised_int_size(IntType i) {
-            if (i == 0) {
-                return 1;
-            }
-            ::std::size_t size = 0;
-            if (i < 0) {
-                i = -i;
-                ++size;
-            }
-            do {
-                i /= 10;
-                ++size;
-            } while (i != 0);
-            return size;
-        }
-
-        template<bool reserve, typename IntType, typename T, typename Traits = ::std::char_traits<T>>
-        static void int_to_string(IntType i, ::std::basic_string<T, Traits>& out_str) {
-            TORREBIS_CONSTEXPR_IF (helpers::detail::is_any<IntType,
-                int, long, long long, unsigned, unsigned long, unsigned long long>::value) {
-                TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<T, char>::value) {
-                    out_str.append(::std::to_string(i));
-                    return;
-                }
-                ::std::string s = ::std::to_string(i);
-                TORREBIS_CONSTEXPR_IF (reserve) {
-                    ::std::size_t reservation = out_str.size() + s.size();
-                    if (out_str.capacity() < reservation) {
-                        out_str.reserve(reservation);
-                    }
-                }
-                for (const char c : s) {
-                    s.push_back(static_cast<T>(c));
+        /*
+         * Calls `f` with each item of `dict` in the order they are encoded in. If `DictType` isn't ordered, that means
+         * sorting pointers to its items by key first. Each pointer is sorted with the first 8 bytes of its key, so most
+         * comparisons don't have to look at the key itself.
+         */
+        template<class Function>
+        static void for_each_sorted_item(const dict_type& dict, Function&& f) {
+            TORREBIS_CONSTEXPR_IF (dict_is_ordered) {
+                for (const auto& i : dict) {
+                    f(i);
                 }
                 return;
             }
-            if (i == 0) {
-                out_str.push_back(static_cast<T>("0"));
-                return;
+            using item_type = typename dict_type::value_type;
+            struct sort_entry {
+                ::std::uint64_t prefix;  // Big endian, so comparing prefixes compares the bytes in order
+                const item_type* item;
+            };
+            ::std::vector<sort_entry> items;
+            items.reserve(dict.size());
+            for (const item_type& i : dict) {
+                const unsigned char* const key = reinterpret_cast<const unsigned char*>(i.first.data());
+                const ::std::size_t prefix_size = ::std::min<::std::size_t>(i.first.size(), 8);
+                ::std::uint64_t prefix = 0;
+                for (::std::size_t j = 0; j < 8; ++j) {
+                    prefix = (prefix << 8) | (j < prefix_size ? key[j] : 0);
+                }
+                items.push_back({ prefix, &i });
             }
-            TORREBIS_CONSTEXPR_IF (reserve) {
-                ::std::size_t reservation = out_str.size() + serialised_int_size<IntType>(i);
-                if (out_str.capacity() < reservation) {
-                    out_str.reserve(reservation);
+            ::std::sort(items.begin(), items.end(), [](const sort_entry& a, const sort_entry& b) {
+                if (a.prefix != b.prefix) {
+                    return a.prefix < b.prefix;
                 }
+                return helpers::detail::key_less_than(a.item->first.data(), a.item->first.size(), b.item->first.data(), b.item->first.size());
+            });
+            for (const sort_entry& i : items) {
+                f(*i.item);
+            }
+        }
+
+        ::std::size_t remember_serialised_size(cache_parent* const parent) const {
+            link_to(parent);
+            helpers::detail::node_meta* const meta = get_meta();
+            if (meta != nullptr && meta->has_size) {
+                return meta->size;
+            }
+            cache_parent storage;
+            cache_parent* const self = is_lazy() ? nullptr : as_cache_parent(storage);
+            const ::std::size_t size = compute_serialised_size<true>(self);
+            if (meta == nullptr) {
+                return size;
             }
-            if (i < 0) {
-                i = -i;
-                out_str.push_back(static_cast<T>('-'));
+            // A lazily loaded list or dict remembers its encoded size, and forgets it when its items are decoded
+            if (self == nullptr || self->cacheable) {
+                meta->size = size;
+                meta->has_size = true;
+            } else if (parent != nullptr) {
+                parent->cacheable = false;
             }
-            do {
-                IntType mod = i % 10;
-                i /= 10;
-                out_str.push_back(static_cast<T>(static_cast<char>('0' + static_cast<int>(mod))));
-            } while (i != 0);
+            return size;
         }
 
-    public:
-        ::std::size_t serialised_size() const {
+        template<bool cached>
+        ::std::size_t item_serialised_size(cache_parent* const parent) const { return cached ? remember_serialised_size(parent) : serialised_size(); }
+
+        template<bool cached>
+        ::std::size_t compute_serialised_size(cache_parent* const self) const {
+            if (is_lazy()) {
+                return get_meta()->lazy_size;
+            }
             switch (get_tag()) {
                 case DataTag::STR: {
                     ::std::size_t str_size = get_str()->size();
-                    return serialised_int_size<::std::size_t>(str_size) + 1 + str_size;
+                    return helpers::detail::int_size<::std::size_t>(str_size) + 1 + str_size;
                 }
                 case DataTag::INT:
-                    return 2 + serialised_int_size<int_type>(*get_int());
+                    return 2 + helpers::detail::int_size<int_type>(*get_int());
                 case DataTag::LIST: {
                     ::std::size_t size = 2;
                     for (const basic_data& i : *get_list()) {
-                        size += i.serialised_size();
+                        size += i.item_serialised_size<cached>(self);
                     }
                     return size;
                 }
@@ -679,7 +1025,7 @@ namespace torrebis { namespace bencode {
                     ::std::size_t size = 2;
                     for (const auto& i : *get_dict()) {
                         ::std::size_t key_size = i.first.size();
-                        size += serialised_int_size<::std::size_t>(key_size) + 1 + key_size + i.second.serialised_size();
+                        size += helpers::detail::int_size<::std::size_t>(key_size) + 1 + key_size + i.second.template item_serialised_size<cached>(self);
                     }
                     return size;
                 }
@@ -688,59 +1034,119 @@ namespace torrebis { namespace bencode {
             }
         }
 
+    public:
+        // How many bytes `serialise()` writes.
+        ::std::size_t serialised_size() const { return compute_serialised_size<false>(nullptr); }
+
+        /*
+         * `serialised_size()`, remembered by this and every list and dict in it, so sizing it again (Or serialising it,
+         * which reserves the remembered size) only looks at items that have changed. See "Serialising" in the README
+         * for what makes them forget.
+         *
+         * Not thread safe, as it writes to the value. `serialise()` and `append_serialisation()` never trust the
+         * remembered size to be right.
+         */
+        ::std::size_t cached_serialised_size() const { return remember_serialised_size(nullptr); }
+
         template<class T = char, class Traits = ::std::char_traits<T>>
         ::std::basic_string<T, Traits> serialise() const {
             ::std::basic_string<T, Traits> s;
-            s.reserve(serialised_size());
             append_serialisation(s);
             return s;
         }
 
     private:
-        template<class T, class Traits>
-        void append_serialisation_loop(::std::basic_string<T, Traits>& s) const {
+        template<class OutputIt>
+        OutputIt serialise_to_loop(OutputIt out) const {
+            if (is_lazy()) {
+                // Untouched since it was loaded, so the original encoding is still right
+                const helpers::detail::node_meta* const meta = get_meta();
+                return helpers::detail::copy_chars(str_view(meta->lazy_begin, meta->lazy_size), out);
+            }
             switch (get_tag()) {
                 case DataTag::STR: {
                     const str_type& ss = *get_str();
-                    int_to_string<false, ::std::size_t, T, Traits>(ss.size(), s);
-                    s.push_back(static_cast<T>(':'));
-                    TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<str_type, ::std::basic_string<T, Traits>>::value) {
-                        s.append(ss);
-                    } else {
-                        for (const auto byte : ss) {
-                            s.push_back(static_cast<T>(static_cast<char>(ss)));
-                        }
+                    out = helpers::detail::copy_int<::std::size_t>(ss.size(), out);
+                    *out = ':';
+                    return helpers::detail::copy_chars(ss, ++out);
+                }
+                case DataTag::INT:
+                    *out = 'i';
+                    out = helpers::detail::copy_int<int_type>(*get_int(), ++out);
+                    *out = 'e';
+                    return ++out;
+                case DataTag::LIST:
+                    *out = 'l';
+                    ++out;
+                    for (const basic_data& i : *get_list()) {
+                        out = i.serialise_to_loop(out);
                     }
+                    *out = 'e';
+                    return ++out;
+                case DataTag::DICT:
+                    *out = 'd';
+                    ++out;
+                    for_each_sorted_item(*get_dict(), [&out](const typename dict_type::value_type& i) {
+                        const str_type& key = i.first;
+                        out = helpers::detail::copy_int<::std::size_t>(key.size(), out);
+                        *out = ':';
+                        out = helpers::detail::copy_chars(key, ++out);
+                        out = i.second.serialise_to_loop(out);
+                    });
+                    *out = 'e';
+                    return ++out;
+                default:
+                    return out;
+            }
+        }
+
+    public:
+        template<class T = char, class Traits = ::std::char_traits<T>>
+        void append_serialisation(::std::basic_string<T, Traits>& s) const {
+            // Only reserves a remembered size: working one out would walk the value twice
+            const helpers::detail::node_meta* const meta = get_meta();
+            if (meta != nullptr && meta->has_size && s.size() + meta->size > s.capacity()) {
+                s.reserve(s.size() + meta->size);
+            }
+            serialise_to_loop(::std::back_inserter(s));
+        }
+
+    private:
+        void append_gather_loop(gather_buffer& out) const {
+            if (is_lazy()) {
+                const helpers::detail::node_meta* const meta = get_meta();
+                out.put_bytes(meta->lazy_begin, meta->lazy_size);
+                return;
+            }
+            switch (get_tag()) {
+                case DataTag::STR: {
+                    const str_type& ss = *get_str();
+                    out.put_int<::std::size_t>(ss.size());
+                    out.put(':');
+                    out.put_str(ss);
                     return;
                 }
                 case DataTag::INT:
-                    s.push_back(static_cast<T>('i'));
-                    int_to_string<false, int_type, T, Traits>(*get_int(), s);
-                    s.push_back(static_cast<T>('e'));
+                    out.put('i');
+                    out.put_int<int_type>(*get_int());
+                    out.put('e');
                     return;
                 case DataTag::LIST:
-                    s.push_back(static_cast<T>('l'));
+                    out.put('l');
                     for (const basic_data& i : *get_list()) {
-                        i.append_serialisation_loop<T, Traits>(s);
+                        i.append_gather_loop(out);
                     }
-                    s.push_back(static_cast<T>('e'));
+                    out.put('e');
                     return;
                 case DataTag::DICT:
-                    s.push_back(static_cast<T>('d'));
-                    for (const auto& i : *get_dict()) {
-                        const str_type& key = i.first;
-                        int_to_string<false, ::std::size_t, T, Traits>(key.size(), s);
-                        s.push_back(static_cast<T>(':'));
-                        TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<str_type, ::std::basic_string<T, Traits>>::value) {
-                            s.append(key);
-                        } else {
-                            for (const auto byte : key) {
-                                s.push_back(static_cast<T>(static_cast<char>(byte)));
-                            }
-                        }
-                        i.second.template append_serialisation_loop<T, Traits>(s);
-                    }
-                    s.push_back(static_cast<T>('e'));
+                    out.put('d');
+                    for_each_sorted_item(*get_dict(), [&out](const typename dict_type::value_type& i) {
+                        out.put_int<::std::size_t>(i.first.size());
+                        out.put(':');
+                        out.put_str(i.first);
+                        i.second.append_gather_loop(out);
+                    });
+                    out.put('e');
                     return;
                 default:
                     return;
@@ -748,37 +1154,66 @@ namespace torrebis { namespace bencode {
         }
 
     public:
-        template<class T = char, class Traits = ::std::char_traits<T>>
-        void append_serialisation(::std::basic_string<T, Traits>& s) const {
-            const ::std::size_t reservation = s.size() + serialised_size();
-            if (reservation > s.capacity()) {
-                s.reserve(reservation);
+        /*
+         * Appends the encoding to `out`, referencing long strings where they are instead of copying them. This must
+         * not be changed or destroyed until `out` has been written.
+         */
+        void append_serialisation(gather_buffer& out) const { append_gather_loop(out); }
+
+        /*
+         * Writes the encoding to `out`, returning the iterator after it. `out` can be any output iterator that can be
+         * assigned `char`s, so for a pointer or array there must be room for `serialised_size()` elements.
+         */
+        template<class OutputIt>
+        OutputIt serialise_to(OutputIt out) const { return serialise_to_loop(out); }
+
+        /*
+         * Writes the encoding to the `capacity` elements at `out`, returning how many were written. If it doesn't fit,
+         * nothing is written and 0 is returned.
+         */
+        template<class T>
+        ::std::size_t serialise_to(T* const out, const ::std::size_t capacity) const {
+            const ::std::size_t size = serialised_size();
+            if (size > capacity) {
+                return 0;
             }
-            append_serialisation_loop<T, Traits>(s);
+            serialise_to_loop(out);
+            return size;
         }
 
+#ifdef TORREBIS_HAS_SPAN
+        // Like `serialise_to(out.data(), out.size())`.
+        template<class T, ::std::size_t Extent>
+        ::std::size_t serialise_to(const ::std::span<T, Extent> out) const { return serialise_to(out.data(), out.size()); }
+#endif
+
         template<class T = char, class Traits = std::char_traits<T>>
         void serialise(::std::basic_ostream<T, Traits>& os) const {
+            if (is_lazy()) {
+                const helpers::detail::node_meta* const meta = get_meta();
+                TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<T, char>::value) {
+                    os.write(reinterpret_cast<const T*>(meta->lazy_begin), static_cast<::std::streamsize>(meta->lazy_size));
+                } else {
+                    for (::std::size_t i = 0; i < meta->lazy_size; ++i) {
+                        os.put(static_cast<T>(meta->lazy_begin[i]));
+                    }
+                }
+                return;
+            }
             switch (get_tag()) {
                 case DataTag::STR: {
                     const str_type& ss = *get_str();
                     ::std::basic_string<T, Traits> size_str;
-                    int_to_string<true, ::std::size_t, T, Traits>(ss.size(), size_str);
+                    helpers::detail::append_int<::std::size_t>(ss.size(), size_str);
                     os.write(size_str.data(), size_str.size());
                     os.put(static_cast<T>(':'));
-                    TORREBIS_CONSTEXPR_IF (helpers::detail::has_char_t<T, str_type>::value) {
-                        os.write(ss.data(), ss.size());
-                    } else {
-                        for (const auto byte : ss) {
-                            os.put(static_cast<T>(static_cast<char>(byte)));
-                        }
-                    }
+                    helpers::detail::write_chars(os, ss);
                     return;
                 }
                 case DataTag::INT: {
                     os.put(static_cast<T>('i'));
                     ::std::basic_string<T, Traits> int_str;
-                    int_to_string<true, int_type, T, Traits>(*get_int(), int_str);
+                    helpers::detail::append_int<int_type>(*get_int(), int_str);
                     os.write(int_str.data(), int_str.size());
                     os.put(static_cast<T>('e'));
                     return;
@@ -792,118 +1227,67 @@ namespace torrebis { namespace bencode {
                     return;
                 case DataTag::DICT:
                     os.put(static_cast<T>('d'));
-                    for (const ::std::pair<const str_type, const basic_data>& i : *get_dict()) {
+                    for_each_sorted_item(*get_dict(), [&os](const typename dict_type::value_type& i) {
                         const str_type& key = i.first;
                         ::std::basic_string<T, Traits> key_size_str;
-                        int_to_string<true, ::std::size_t, T, Traits>(key.size(), key_size_str);
+                        helpers::detail::append_int<::std::size_t>(key.size(), key_size_str);
                         os.write(key_size_str.data(), key_size_str.size());
-                        os.put(static_cast<T>(':'));
-                        TORREBIS_CONSTEXPR_IF (helpers::detail::has_char_t<T, str_type>::value) {
-                            os.write(key.data(), key.size());
-                        } else {
-                            for (const auto byte : key) {
-                                os.put(static_cast<T>(static_cast<char>(byte)));
-                            }
-                        }
-                        i.second.template serialise<T, Traits>(os);
-                    }
-                    os.put(static_cast<T>('e'));
-                    return;
-                default:
-                    return;
-            }
-        }
-
-        // Deserialisation of pointers / arrays
-    private:
-        template<typename IntType, typename T>
-        static IntType pointer_read_int(const T* const begin, ::std::size_t& i, const ::std::size_t size, const char end, const char* const first) {
-            char first_char;
-            if (first == nullptr) {
-                if (i >= size) {
-                    throw errors::expecting_int_error.copy();
-                }
-                first_char = static_cast<char>(begin[i++]);
-            } else {
-                first_char = *first;
-            }
-            if (first_char == '0') {
-                if (i >= size || static_cast<char>(begin[i++]) != end) {
-                    throw errors::expecting_int_error.copy();
-                }
-                return IntType(0);
-            }
-            int sign = +1;
-            if (first_char == '-') {
-                sign = -1;
-                if (i >= size) {
-                    throw errors::expecting_int_error.copy();
-                }
-                first_char = static_cast<char>(begin[i++]);
-            }
-            if (!('1' <= first_char && first_char <= '9')) {
-                throw errors::expecting_int_error.copy();
-            }
-            IntType res = IntType(static_cast<int>(first_char - '0'));
-            while (true) {
-                if (i >= size) {
-                    throw errors::expecting_int_error.copy();
-                }
-                const char next_char = static_cast<char>(begin[i++]);
-                if (!('0' <= next_char && next_char <= '9')) {
-                    if (next_char == end) {
-                        break;
-                    }
-                    throw errors::expecting_int_error.copy();
-                }
-                IntType previous_res = res;
-                res = res * IntType(static_cast<int>(sign * 10)) + IntType(static_cast<int>(sign * static_cast<int>(next_char - '0')));
-                if ((previous_res < res) != (sign > 0)) {
-                    throw errors::integer_overflow_error.copy();
-                }
-            }
-            return res;
-        }
-
-        static ::std::pair<const char*, ::std::size_t> pointer_read_str_fast(const char* const begin, ::std::size_t& i, const ::std::size_t size, const char* const first) {
-            ::std::size_t str_size = pointer_read_int<::std::size_t, char>(begin, i, size, ':', first);
-            const char* str_begin = begin + i;
-            i += str_size;
-            if (i > size) {
-                throw errors::cut_off_str_error.copy();
+                        os.put(static_cast<T>(':'));
+                        helpers::detail::write_chars(os, key);
+                        i.second.template serialise<T, Traits>(os);
+                    });
+                    os.put(static_cast<T>('e'));
+                    return;
+                default:
+                    return;
             }
-            return  { str_begin, str_size };
         }
 
+        // Deserialisation of pointers / arrays
+    private:
         template<typename T>
         static void pointer_read_str_slow(const T* const begin, ::std::size_t& i, const ::std::size_t size, const char* first, ::std::string& out_str) {
-            ::std::size_t str_size = pointer_read_int<::std::size_t, T>(begin, i, size, ':', first);
+            ::std::size_t str_size = helpers::detail::pointer_read_int<::std::size_t, T>(begin, i, size, ':', first);
             if (i + str_size > size) {
                 throw errors::cut_off_str_error.copy();
             }
             out_str.reserve(str_size);
-            for (; i < i + str_size; ++i) {
+            for (const ::std::size_t str_end = i + str_size; i < str_end; ++i) {
                 out_str.push_back(static_cast<char>(begin[i]));
             }
         }
 
-        template<typename T>
+        // Makes a decoded value, which was encoded at `[start, end)` in the buffer if `spans`.
+        template<DataTag tag, bool spans>
+        static basic_data make_decoded(tag_to_type_t<tag> value, const ::std::size_t start, const ::std::size_t end, const data_allocator_type& alloc) {
+            TORREBIS_CONSTEXPR_IF (spans) {
+                helpers::detail::node_meta meta = helpers::detail::node_meta();
+                meta.span = { start, end };
+                meta.has_span = true;
+                return make_boxed<tag>(::std::move(value), meta, alloc);
+            }
+            return allocate<tag>(alloc, ::std::move(value));
+        }
+
+        template<typename T, bool spans = false>
         static basic_data pointer_bdecode_loop(
-            const T* const begin, ::std::size_t& i, const ::std::size_t size
+            const T* const begin, ::std::size_t& i, const ::std::size_t size, const data_allocator_type& alloc
         ) {
             if (i >= size) {
                 throw errors::expecting_value_error.copy();
             }
+            const ::std::size_t start = i;
             switch (static_cast<char>(begin[i])) {
                 case 'i': {
                     // int "ixxxe"
                     ++i;
-                    return make_int(pointer_read_int<int_type, T>(begin, i, size, 'e', nullptr));
+                    const int_type value = helpers::detail::pointer_read_int<int_type, T>(begin, i, size, 'e', nullptr);
+                    return make_decoded<DataTag::INT, spans>(value, start, i, alloc);
                 }
                 case 'l': {
                     // list "lxxxe"
                     ++i;
-                    list_type list;
+                    list_type list = helpers::detail::construct_with_allocator<list_type>(alloc);
                     while (true) {
                         if (i >= size) {
                             throw errors::expecting_value_error.copy();
@@ -911,17 +1295,18 @@ namespace torrebis { namespace bencode {
                         if (static_cast<char>(begin[i]) == 'e') {
                             break;
                         }
-                        list.push_back(pointer_bdecode_loop<T>(begin, i, size));
+                        list.push_back(pointer_bdecode_loop<T, spans>(begin, i, size, alloc));
                     }
                     ++i;
-                    return make_list(list);
+                    return make_decoded<DataTag::LIST, spans>(::std::move(list), start, i, alloc);
                 }
                 case 'd': {
                     // dict "dxxxe"
                     ++i;
-                    dict_type dict;
+                    dict_type dict = helpers::detail::construct_with_allocator<dict_type>(alloc);
                     const char* last_key_begin = nullptr;
                     ::std::size_t last_key_size;
+                    ::std::string last_key;  // Owns the previous key when it isn't in the buffer
                     while (true) {
                         if (i >= size) {
                             throw errors::expecting_value_error.copy();
@@ -932,7 +1317,7 @@ namespace torrebis { namespace bencode {
                         const char* key_begin;
                         ::std::size_t key_size;
                         TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<T, char>::value) {
-                            auto begin_size = pointer_read_str_fast(begin, i, size, nullptr);
+                            auto begin_size = helpers::detail::pointer_read_str_fast(reinterpret_cast<const char*>(begin), i, size, nullptr);
                             key_begin = begin_size.first;
                             key_size = begin_size.second;
                             if (last_key_begin != nullptr) {
@@ -943,8 +1328,8 @@ namespace torrebis { namespace bencode {
                             }
                             last_key_begin = key_begin;
                             last_key_size = key_size;
-                            str_type key(key_begin, key_size);
-                            dict[key] = pointer_bdecode_loop<T>(begin, i, size);
+                            str_type key = helpers::detail::take_key<str_type>(str_view(key_begin, key_size), alloc);
+                            dict.emplace_hint(dict.end(), ::std::move(key), pointer_bdecode_loop<T, spans>(begin, i, size, alloc));
                         } else {
                             ::std::string key;
                             pointer_read_str_slow<T>(begin, i, size, nullptr, key);
@@ -955,35 +1340,30 @@ namespace torrebis { namespace bencode {
                                     throw errors::key_order_error.copy();
                                 }
                             }
-                            last_key_begin = key_begin;
-                            last_key_size = key_size;
-                            TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<str_type, ::std::string>::value) {
-                                dict[key] = pointer_bdecode_loop<T>(begin, i, size);
-                            } else {
-                                str_type real_key(key_begin, key_size);
-                                dict[real_key] = pointer_bdecode_loop<T>(begin, i, size);
-                            }
+                            last_key = key;
+                            last_key_begin = last_key.data();
+                            last_key_size = last_key.size();
+                            dict.emplace_hint(dict.end(), helpers::detail::take_key<str_type>(::std::move(key), alloc), pointer_bdecode_loop<T, spans>(begin, i, size, alloc));
                         }
                     }
                     ++i;
-                    return make_dict(dict);
+                    return make_decoded<DataTag::DICT, spans>(::std::move(dict), start, i, alloc);
                 }
-                case '1': case '2': case '3':
-                case '4': case '5': case '6':
-                case '7': case '8': case '9': {
+                case '0': case '1': case '2':
+                case '3': case '4': case '5':
+                case '6': case '7': case '8':
+                case '9': {
                     // str "yy:xxxx"
                     TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<T, char>::value) {
-                        auto begin_size = pointer_read_str_fast(begin, i, size, &begin[i++]);
+                        const char* const chars = reinterpret_cast<const char*>(begin);
+                        auto begin_size = helpers::detail::pointer_read_str_fast(chars, i, size, &chars[i++]);
                         const char* str_begin = begin_size.first;
                         ::std::size_t str_size = begin_size.second;
-                        return make_str(str_type(str_begin, str_size));
+                        return make_decoded<DataTag::STR, spans>(helpers::detail::construct_with_allocator<str_type>(alloc, str_begin, str_size), start, i, alloc);
                     }
                     ::std::string s;
-                    pointer_read_str_slow<T>(begin, i, size, &begin[i++], s);
-                    TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<str_type, ::std::string>::value) {
-                        return make_str(s);
-                    }
-                    return make_str(str_type(s.data(), s.size()));
+                    pointer_read_str_slow<T>(begin, i, size, reinterpret_cast<const char*>(&begin[i++]), s);
+                    return make_decoded<DataTag::STR, spans>(helpers::detail::take_str<str_type>(::std::move(s), alloc), start, i, alloc);
                 }
                 default:
                     throw errors::unknown_value_error.copy();
@@ -992,10 +1372,14 @@ namespace torrebis { namespace bencode {
 
     public:
         template<typename T>
-        static basic_data load(const T* const begin, const ::std::size_t size) {
+        static basic_data load(const T* const begin, const ::std::size_t size, const data_allocator_type& alloc = data_allocator_type()) {
             static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            TORREBIS_CONSTEXPR_IF (helpers::detail::is_borrowed_str<str_type>::value && !helpers::detail::is_same_decayed<T, char>::value) {
+                // Borrowed strings have to point into `begin`, which only the `char` path does.
+                return load<char>(reinterpret_cast<const char*>(begin), size, alloc);
+            }
             ::std::size_t i = 0;
-            auto parsed = pointer_bdecode_loop(begin, i, size);
+            auto parsed = pointer_bdecode_loop(begin, i, size, alloc);
             if (i != size) {
                 throw errors::early_end_error.copy();
             }
@@ -1003,26 +1387,321 @@ namespace torrebis { namespace bencode {
         }
 
         template<typename T>
-        static basic_data load(const T* const begin, const T* const end) {
-            return load<T>(begin, static_cast<::std::size_t>(end - begin));
+        static basic_data load(const T* const begin, const T* const end, const data_allocator_type& alloc = data_allocator_type()) {
+            return load<T>(begin, static_cast<::std::size_t>(end - begin), alloc);
+        }
+
+        // Like `load(begin, size)`, but every value remembers where it was in the buffer. See `raw_span()`.
+        template<typename T>
+        static basic_data load(const T* const begin, const ::std::size_t size, const RecordSpans, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            TORREBIS_CONSTEXPR_IF (helpers::detail::is_borrowed_str<str_type>::value && !helpers::detail::is_same_decayed<T, char>::value) {
+                return load<char>(reinterpret_cast<const char*>(begin), size, record_spans, alloc);
+            }
+            ::std::size_t i = 0;
+            auto parsed = pointer_bdecode_loop<T, true>(begin, i, size, alloc);
+            if (i != size) {
+                throw errors::early_end_error.copy();
+            }
+            return parsed;
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load(const ::std::basic_string<T, Rest...>& s, const RecordSpans, const data_allocator_type& alloc = data_allocator_type()) {
+            return load<T>(s.data(), s.size(), record_spans, alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load(const ::std::vector<T, Rest...>& v, const RecordSpans, const data_allocator_type& alloc = data_allocator_type()) {
+            return load<T>(v.data(), v.size(), record_spans, alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load(const ::std::basic_string<T, Rest...>& s, const data_allocator_type& alloc = data_allocator_type()) {
+            return load<T>(s.data(), s.size(), alloc);
         }
 
         template<typename T, typename... Rest>
-        static basic_data load(const ::std::basic_string<T, Rest...>& s) {
-            return load<T>(s.data(), s.size());
+        static basic_data load(const ::std::basic_string<T, Rest...>&& s, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(!helpers::detail::is_borrowed_str<str_type>::value, "Borrowed strings cannot be loaded from a temporary buffer");
+            return load<T>(s.data(), s.size(), alloc);
         }
 
         template<typename T, typename... Rest>
-        static basic_data load(const ::std::vector<T, Rest...>& v) {
-            return load<T>(v.data(), v.size());
+        static basic_data load(const ::std::vector<T, Rest...>& v, const data_allocator_type& alloc = data_allocator_type()) {
+            return load<T>(v.data(), v.size(), alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load(const ::std::vector<T, Rest...>&& v, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(!helpers::detail::is_borrowed_str<str_type>::value, "Borrowed strings cannot be loaded from a temporary buffer");
+            return load<T>(v.data(), v.size(), alloc);
         }
 
 #ifdef TORREBIS_STD_ARRAY_HAS_DATA
         template<typename T, ::std::size_t N = 0>
-        static basic_data load(const ::std::array<T, N>& a) {
-            return load<T>(a.data(), a.size());
+        static basic_data load(const ::std::array<T, N>& a, const data_allocator_type& alloc = data_allocator_type()) {
+            return load<T>(a.data(), a.size(), alloc);
         }
 #endif
+
+        // Deserialisation of a single value
+    private:
+        // Moves `i` from the start of a value to the start of its item at `el`. Returns false if there isn't one.
+        static bool extract_step(const char* const begin, ::std::size_t& i, const ::std::size_t size, const path_el_type& el) {
+            if (i >= size) {
+                throw errors::expecting_value_error.copy();
+            }
+            if (el.is_key()) {
+                if (begin[i] != 'd') {
+                    return false;
+                }
+                ++i;
+                const str_type& key = *el.get_key();
+                const char* const key_begin = reinterpret_cast<const char*>(key.data());
+                const ::std::size_t key_size = key.size();
+                while (true) {
+                    if (i >= size) {
+                        throw errors::expecting_value_error.copy();
+                    }
+                    if (begin[i] == 'e') {
+                        return false;
+                    }
+                    auto current = helpers::detail::pointer_read_str_fast(begin, i, size, nullptr);
+                    if (current.second == key_size && ::std::memcmp(current.first, key_begin, key_size) == 0) {
+                        return true;
+                    }
+                    if (helpers::detail::key_less_than(key_begin, key_size, current.first, current.second)) {
+                        // Keys are sorted, so it isn't in this dict
+                        return false;
+                    }
+                    helpers::detail::pointer_skip_value(begin, i, size);
+                }
+            }
+            if (el.is_index()) {
+                if (begin[i] != 'l') {
+                    return false;
+                }
+                ++i;
+                for (::std::size_t n = el.get_index(); ; --n) {
+                    if (i >= size) {
+                        throw errors::expecting_value_error.copy();
+                    }
+                    if (begin[i] == 'e') {
+                        return false;
+                    }
+                    if (n == 0) {
+                        return true;
+                    }
+                    helpers::detail::pointer_skip_value(begin, i, size);
+                }
+            }
+            return false;
+        }
+
+        template<class T>
+        static basic_data extract_loop(const char* const begin, const ::std::size_t size, const T& path) {
+            const data_allocator_type alloc = data_allocator_type();
+            ::std::size_t i = 0;
+            for (const auto& el : path) {
+                if (!extract_step(begin, i, size, path_el_type(el))) {
+                    return basic_data();
+                }
+            }
+            return pointer_bdecode_loop<char>(begin, i, size, alloc);
+        }
+
+    public:
+        /*
+         * Decodes only the value at `path` in some bencoded data, like `load(begin, size).get_path(path...)` without
+         * building the rest. Everything not on the path is skipped over by length, and is not checked.
+         * Returns an uninitialised `basic_data` if there is nothing at `path`.
+         */
+        template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+        static basic_data extract(const char* const begin, const ::std::size_t size, PathEls... path) {
+            const ::std::initializer_list<path_el_type> path_list = { path_el_type(path)... };
+            return extract_loop(begin, size, path_list);
+        }
+
+        template<class T, class = enable_if_path_iterable<T>>  // Where T is an iterable of basic_data::path_el_type
+        static basic_data extract(const char* const begin, const ::std::size_t size, const T& path) {
+            return extract_loop(begin, size, path);
+        }
+
+        template<typename T, typename... Rest, class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+        static basic_data extract(const ::std::basic_string<T, Rest...>& s, PathEls... path) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            return extract(reinterpret_cast<const char*>(s.data()), s.size(), path...);
+        }
+
+        template<typename T, typename... Rest, class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+        static basic_data extract(const ::std::basic_string<T, Rest...>&& s, PathEls... path) {
+            static_assert(!helpers::detail::is_borrowed_str<str_type>::value, "Borrowed strings cannot be extracted from a temporary buffer");
+            return extract(s, path...);
+        }
+
+        template<typename T, typename... Rest, class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+        static basic_data extract(const ::std::vector<T, Rest...>& v, PathEls... path) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            return extract(reinterpret_cast<const char*>(v.data()), v.size(), path...);
+        }
+
+        template<typename T, typename... Rest, class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+        static basic_data extract(const ::std::vector<T, Rest...>&& v, PathEls... path) {
+            static_assert(!helpers::detail::is_borrowed_str<str_type>::value, "Borrowed strings cannot be extracted from a temporary buffer");
+            return extract(v, path...);
+        }
+
+        // Lazy deserialisation
+    private:
+        // Decodes one value from data that has already been checked, leaving the items of lists and dicts for later.
+        // If `base` isn't nullptr, the value remembers where it was relative to `base`.
+        static basic_data lazy_bdecode_loop(const char* const begin, ::std::size_t& i, const ::std::size_t size, const char* const base, const data_allocator_type& alloc) {
+            const ::std::size_t start = i;
+            helpers::detail::node_meta meta = helpers::detail::node_meta();
+            switch (begin[i]) {
+                case 'i': {
+                    // int "ixxxe"
+                    ++i;
+                    const int_type value = helpers::detail::pointer_read_int<int_type, char>(begin, i, size, 'e', nullptr);
+                    if (base == nullptr) {
+                        return allocate<DataTag::INT>(alloc, value);
+                    }
+                    meta.span = { static_cast<::std::size_t>(begin + start - base), static_cast<::std::size_t>(begin + i - base) };
+                    meta.has_span = true;
+                    return make_boxed<DataTag::INT>(int_type(value), meta, alloc);
+                }
+                case 'l':
+                case 'd': {
+                    // list "lxxxe" or dict "dxxxe"
+                    helpers::detail::pointer_skip_value(begin, i, size);
+                    if (i - start != 2) {
+                        meta.lazy_begin = begin + start;
+                        meta.lazy_size = i - start;
+                    } else if (base == nullptr) {
+                        if (begin[start] == 'l') {
+                            return allocate<DataTag::LIST>(alloc, helpers::detail::construct_with_allocator<list_type>(alloc));
+                        }
+                        return allocate<DataTag::DICT>(alloc, helpers::detail::construct_with_allocator<dict_type>(alloc));
+                    }
+                    if (base != nullptr) {
+                        meta.span = { static_cast<::std::size_t>(begin + start - base), static_cast<::std::size_t>(begin + i - base) };
+                        meta.has_span = true;
+                    }
+                    if (begin[start] == 'l') {
+                        return make_boxed<DataTag::LIST>(helpers::detail::construct_with_allocator<list_type>(alloc), meta, alloc);
+                    }
+                    return make_boxed<DataTag::DICT>(helpers::detail::construct_with_allocator<dict_type>(alloc), meta, alloc);
+                }
+                default: {
+                    // str "yy:xxxx"
+                    auto begin_size = helpers::detail::pointer_read_str_fast(begin, i, size, nullptr);
+                    str_type value = helpers::detail::construct_with_allocator<str_type>(alloc, begin_size.first, begin_size.second);
+                    if (base == nullptr) {
+                        return allocate<DataTag::STR>(alloc, ::std::move(value));
+                    }
+                    meta.span = { static_cast<::std::size_t>(begin + start - base), static_cast<::std::size_t>(begin + i - base) };
+                    meta.has_span = true;
+                    return make_boxed<DataTag::STR>(::std::move(value), meta, alloc);
+                }
+            }
+        }
+
+        // Decodes the items of a lazily loaded list or dict, if they haven't been already.
+        void load_lazy_items() const {
+            helpers::detail::node_meta* const meta = get_meta();
+            if (meta == nullptr || meta->lazy_begin == nullptr) {
+                return;
+            }
+            const char* const begin = meta->lazy_begin;
+            const ::std::size_t size = meta->lazy_size;
+            const char* const base = meta->has_span ? begin - meta->span.begin : nullptr;
+            ::std::size_t i = 1;  // After the 'l' or 'd'
+            // The items are allocated like the empty list or dict they go in, which was made with the `load_lazy` allocator
+            if (tag_ == DataTag::LIST) {
+                const data_allocator_type alloc = helpers::detail::allocator_of<data_allocator_type>(get_box<DataTag::LIST>()->value);
+                list_type list = helpers::detail::construct_with_allocator<list_type>(alloc);
+                while (begin[i] != 'e') {
+                    list.push_back(lazy_bdecode_loop(begin, i, size, base, alloc));
+                }
+                ::std::swap(get_box<DataTag::LIST>()->value, list);
+            } else {
+                const data_allocator_type alloc = helpers::detail::allocator_of<data_allocator_type>(get_box<DataTag::DICT>()->value);
+                dict_type dict = helpers::detail::construct_with_allocator<dict_type>(alloc);
+                while (begin[i] != 'e') {
+                    auto key = helpers::detail::pointer_read_str_fast(begin, i, size, nullptr);
+                    dict.emplace_hint(
+                        dict.end(),
+                        helpers::detail::take_key<str_type>(str_view(key.first, key.second), alloc),
+                        lazy_bdecode_loop(begin, i, size, base, alloc)
+                    );
+                }
+                ::std::swap(get_box<DataTag::DICT>()->value, dict);
+            }
+            meta->lazy_begin = nullptr;
+            forget_cached();
+        }
+
+    public:
+        /*
+         * Like `load`, but the items of a list or dict are only decoded the first time it is accessed
+         * (`get_list()`, `get_dict()`, `get_path(...)`, ...). The whole buffer is still checked up front.
+         *
+         * Lazily loaded data borrows from the buffer until every list and dict in it has been accessed, so the buffer
+         * must outlive it. Accessing lazily loaded data from multiple threads at once is not safe.
+         */
+        static basic_data load_lazy(const char* const begin, const ::std::size_t size, const data_allocator_type& alloc = data_allocator_type()) {
+            basic_event_handler<int_type> validator;
+            bdecode_events<int_type>(begin, size, validator);
+            ::std::size_t i = 0;
+            return lazy_bdecode_loop(begin, i, size, nullptr, alloc);
+        }
+
+        // Like `load_lazy(begin, size)`, but every value remembers where it was in the buffer. See `raw_span()`.
+        static basic_data load_lazy(const char* const begin, const ::std::size_t size, const RecordSpans, const data_allocator_type& alloc = data_allocator_type()) {
+            basic_event_handler<int_type> validator;
+            bdecode_events<int_type>(begin, size, validator);
+            ::std::size_t i = 0;
+            return lazy_bdecode_loop(begin, i, size, begin, alloc);
+        }
+
+        template<typename T>
+        static basic_data load_lazy(const T* const begin, const ::std::size_t size, const RecordSpans, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            return load_lazy(reinterpret_cast<const char*>(begin), size, record_spans, alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load_lazy(const ::std::basic_string<T, Rest...>& s, const RecordSpans, const data_allocator_type& alloc = data_allocator_type()) {
+            return load_lazy<T>(s.data(), s.size(), record_spans, alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load_lazy(const ::std::vector<T, Rest...>& v, const RecordSpans, const data_allocator_type& alloc = data_allocator_type()) {
+            return load_lazy<T>(v.data(), v.size(), record_spans, alloc);
+        }
+
+        template<typename T>
+        static basic_data load_lazy(const T* const begin, const ::std::size_t size, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            return load_lazy(reinterpret_cast<const char*>(begin), size, alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load_lazy(const ::std::basic_string<T, Rest...>& s, const data_allocator_type& alloc = data_allocator_type()) {
+            return load_lazy<T>(s.data(), s.size(), alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load_lazy(const ::std::basic_string<T, Rest...>&& s, const data_allocator_type& alloc = data_allocator_type()) = delete;
+
+        template<typename T, typename... Rest>
+        static basic_data load_lazy(const ::std::vector<T, Rest...>& v, const data_allocator_type& alloc = data_allocator_type()) {
+            return load_lazy<T>(v.data(), v.size(), alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load_lazy(const ::std::vector<T, Rest...>&& v, const data_allocator_type& alloc = data_allocator_type()) = delete;
         // Deserialisation of iterators
     private:
 
@@ -1057,7 +1736,7 @@ namespace torrebis { namespace bencode {
             if (!('1' <= first_char && first_char <= '9')) {
                 throw errors::expecting_int_error.copy();
             }
-            IntType res = IntType(static_cast<int>(first_char - '0'));
+            IntType res = IntType(static_cast<int>(sign * static_cast<int>(first_char - '0')));
             while (true) {
                 if (it == end) {
                     throw errors::expecting_int_error.copy();
@@ -1071,7 +1750,7 @@ namespace torrebis { namespace bencode {
                     throw errors::expecting_int_error.copy();
                 }
                 IntType previous_res = res;
-                res = res * IntType(static_cast<int>(sign * 10)) + IntType(static_cast<int>(sign * static_cast<int>(next_char - '0')));
+                res = res * IntType(10) + IntType(static_cast<int>(sign * static_cast<int>(next_char - '0')));
                 if ((previous_res < res) != (sign > 0)) {
                     throw errors::integer_overflow_error.copy();
                 }
@@ -1093,7 +1772,7 @@ namespace torrebis { namespace bencode {
         }
 
         template<typename Iterator>
-        static basic_data array_bdecode_loop(Iterator& it, const Iterator& end) {
+        static basic_data array_bdecode_loop(Iterator& it, const Iterator& end, const data_allocator_type& alloc) {
             if (it == end) {
                 throw errors::expecting_value_error.copy();
             }
@@ -1101,11 +1780,11 @@ namespace torrebis { namespace bencode {
                 case 'i':
                     // int "ixxxe"
                     ++it;
-                    return make_int(array_read_int<int_type, Iterator>(it, end, 'e', nullptr));
+                    return allocate<DataTag::INT>(alloc, array_read_int<int_type, Iterator>(it, end, 'e', nullptr));
                 case 'l': {
                     // list "lxxxe"
                     ++it;
-                    list_type list;
+                    list_type list = helpers::detail::construct_with_allocator<list_type>(alloc);
                     while (true) {
                         if (it == end) {
                             throw errors::expecting_value_error.copy();
@@ -1113,17 +1792,18 @@ namespace torrebis { namespace bencode {
                         if (static_cast<char>(*it) == 'e') {
                             break;
                         }
-                        list.push_back(array_bdecode_loop<Iterator>(it, end));
+                        list.push_back(array_bdecode_loop<Iterator>(it, end, alloc));
                     }
                     ++it;
-                    return make_list(list);
+                    return allocate<DataTag::LIST>(alloc, ::std::move(list));
                 }
                 case 'd': {
                     // dict "dxxxe"
                     ++it;
-                    dict_type dict;
+                    dict_type dict = helpers::detail::construct_with_allocator<dict_type>(alloc);
                     const char* last_key_begin = nullptr;
                     ::std::size_t last_key_size;
+                    ::std::string last_key;  // Owns the previous key when it isn't in the buffer
                     while (true) {
                         if (it == end) {
                             throw errors::expecting_value_error.copy();
@@ -1142,28 +1822,22 @@ namespace torrebis { namespace bencode {
                                 throw errors::key_order_error.copy();
                             }
                         }
-                        last_key_begin = key_begin;
-                        last_key_size = key_size;
-                        TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<str_type, ::std::string>::value) {
-                            dict[key] = array_bdecode_loop<Iterator>(it, end);
-                        } else {
-                            str_type real_key(key_begin, key_size);
-                            dict[real_key] = array_bdecode_loop<Iterator>(it, end);
-                        }
+                        last_key = key;
+                        last_key_begin = last_key.data();
+                        last_key_size = last_key.size();
+                        dict.emplace_hint(dict.end(), helpers::detail::take_key<str_type>(::std::move(key), alloc), array_bdecode_loop<Iterator>(it, end, alloc));
                     }
                     ++it;
-                    return make_dict(dict);
+                    return allocate<DataTag::DICT>(alloc, ::std::move(dict));
                 }
-                case '1': case '2': case '3':
-                case '4': case '5': case '6':
-                case '7': case '8': case '9': {
+                case '0': case '1': case '2':
+                case '3': case '4': case '5':
+                case '6': case '7': case '8':
+                case '9': {
                     // str "yy:xxxx"
                     ::std::string s;
                     array_read_str<Iterator>(it, end, nullptr, s);
-                    TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<str_type, ::std::string>::value) {
-                        return make_str(s);
-                    }
-                    return make_str(str_type(s.data(), s.size()));
+                    return allocate<DataTag::STR>(alloc, helpers::detail::take_str<str_type>(::std::move(s), alloc));
                 }
                 default:
                     throw errors::unknown_value_error.copy();
@@ -1173,8 +1847,9 @@ namespace torrebis { namespace bencode {
     public:
 
         template<typename Iterator>
-        static basic_data load(Iterator it, const Iterator& end) {
-            auto parsed = array_bdecode_loop<Iterator>(it, end);
+        static basic_data load(Iterator it, const Iterator& end, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(!helpers::detail::is_borrowed_str<str_type>::value, "Borrowed strings can only be loaded from a pointer");
+            auto parsed = array_bdecode_loop<Iterator>(it, end, alloc);
             if (it != end) {
                 throw errors::early_end_error.copy();
             }
@@ -1211,7 +1886,7 @@ namespace torrebis { namespace bencode {
             if (!(static_cast<T>('1') <= first_byte && first_byte <= static_cast<T>('9'))) {
                 throw errors::expecting_int_error.copy();
             }
-            IntType res = IntType(static_cast<int>(static_cast<char>(first_byte) - '0'));
+            IntType res = IntType(static_cast<int>(sign * static_cast<int>(static_cast<char>(first_byte) - '0')));
             while (true) {
                 T next_byte;
                 if (!is.read(&next_byte, 1)) {
@@ -1225,7 +1900,7 @@ namespace torrebis { namespace bencode {
                     throw errors::expecting_int_error.copy();
                 }
                 IntType previous_res = res;
-                res = res * IntType(static_cast<int>(sign * 10)) + IntType(static_cast<int>(sign * static_cast<int>(static_cast<char>(next_byte) - '0')));
+                res = res * IntType(10) + IntType(static_cast<int>(sign * static_cast<int>(static_cast<char>(next_byte) - '0')));
                 if ((previous_res < res) != (sign > 0)) {
                     throw errors::integer_overflow_error.copy();
                 }
@@ -1244,7 +1919,7 @@ namespace torrebis { namespace bencode {
         }
 
         template<class T, class Traits>
-        static basic_data stream_bdecode_loop(::std::basic_istream<T, Traits>& is, T* first) {
+        static basic_data stream_bdecode_loop(::std::basic_istream<T, Traits>& is, T* first, const data_allocator_type& alloc) {
             if (!is) {
                 throw errors::bad_stream_error.copy();
             }
@@ -1259,10 +1934,10 @@ namespace torrebis { namespace bencode {
             switch (static_cast<char>(start_byte)) {
                 case 'i':
                     // int "ixxxe"
-                    return make_int(stream_read_int<int_type, T, Traits>(is, 'e', nullptr));
+                    return allocate<DataTag::INT>(alloc, stream_read_int<int_type, T, Traits>(is, 'e', nullptr));
                 case 'l': {
                     // list "lxxxe"
-                    list_type list;
+                    list_type list = helpers::detail::construct_with_allocator<list_type>(alloc);
                     while (true) {
                         T end_byte;
                         if (!is.read(&end_byte, 1)) {
@@ -1271,15 +1946,16 @@ namespace torrebis { namespace bencode {
                         if (static_cast<char>(end_byte) == 'e') {
                             break;
                         }
-                        list.push_back(stream_bdecode_loop<T, Traits>(is, &end_byte));
+                        list.push_back(stream_bdecode_loop<T, Traits>(is, &end_byte, alloc));
                     }
-                    return make_list(list);
+                    return allocate<DataTag::LIST>(alloc, ::std::move(list));
                 }
                 case 'd': {
                     // dict "dxxxe"
-                    dict_type dict;
+                    dict_type dict = helpers::detail::construct_with_allocator<dict_type>(alloc);
                     const char* last_key_begin = nullptr;
                     ::std::size_t last_key_size;
+                    ::std::basic_string<T, Traits> last_key;  // Owns the previous key when it isn't in the buffer
                     while (true) {
                         T end_byte;
                         if (!is.read(&end_byte, 1)) {
@@ -1298,29 +1974,20 @@ namespace torrebis { namespace bencode {
                                 throw errors::key_order_error.copy();
                             }
                         }
-                        last_key_begin = key_begin;
-                        last_key_size = key_size;
-                        TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<::std::basic_string<T, Traits>, str_type>::value) {
-                            dict[key] = stream_bdecode_loop<T, Traits>(is, nullptr);
-                        } else TORREBIS_CONSTEXPR_IF (helpers::detail::has_char_t<T, str_type>::value) {
-                            str_type real_key(key_begin, key_size);
-                            dict[real_key] = stream_bdecode_loop<T, Traits>(is, nullptr);
-                        } else {
-                            str_type real_key(key_begin, key_size);
-                            dict[real_key] = stream_bdecode_loop<T, Traits>(is, nullptr);
-                        }
+                        last_key = key;
+                        last_key_begin = last_key.data();
+                        last_key_size = last_key.size();
+                        dict.emplace_hint(dict.end(), helpers::detail::take_key<str_type>(::std::move(key), alloc), stream_bdecode_loop<T, Traits>(is, nullptr, alloc));
                     }
-                    return make_dict(dict);
+                    return allocate<DataTag::DICT>(alloc, ::std::move(dict));
                 }
-                case '1': case '2': case '3':
-                case '4': case '5': case '6':
-                case '7': case '8': case '9': {
+                case '0': case '1': case '2':
+                case '3': case '4': case '5':
+                case '6': case '7': case '8':
+                case '9': {
                     // str "yy:xxxx"
                     ::std::basic_string<T, Traits> s = stream_read_str<T, Traits>(is, &start_byte);
-                    TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<str_type, ::std::basic_string<T, Traits>>::value) {
-                        return make_str(s);
-                    }
-                    return make_str(str_type(s.data(), s.size()));
+                    return allocate<DataTag::STR>(alloc, helpers::detail::take_str<str_type>(::std::move(s), alloc));
                 }
                 default:
                     throw errors::unknown_value_error.copy();
@@ -1329,8 +1996,9 @@ namespace torrebis { namespace bencode {
 
     public:
         template<class T = char, class Traits = ::std::char_traits<T>>
-        static basic_data load(::std::basic_istream<T, Traits>& is) {
-            auto parsed = stream_bdecode_loop<T, Traits>(is, nullptr);
+        static basic_data load(::std::basic_istream<T, Traits>& is, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(!helpers::detail::is_borrowed_str<str_type>::value, "Borrowed strings can only be loaded from a pointer");
+            auto parsed = stream_bdecode_loop<T, Traits>(is, nullptr, alloc);
             if (!is) {
                 throw errors::bad_stream_error.copy();
             }
@@ -1340,10 +2008,192 @@ namespace torrebis { namespace bencode {
             return parsed;
         }
 
+        // Buffered deserialisation of istreams
+
+    private:
+
+        template<typename IntType, class T, class Traits>
+        static IntType buffered_stream_read_int(helpers::detail::stream_window<T, Traits>& window, const char end_char, const T* const first) {
+            T first_byte;
+            if (first == nullptr) {
+                if (!window.next(first_byte)) {
+                    throw errors::expecting_int_error.copy();
+                }
+            } else {
+                first_byte = *first;
+            }
+            if (first_byte == static_cast<T>('0')) {
+                if (!window.next(first_byte) || static_cast<char>(first_byte) != end_char) {
+                    throw errors::expecting_int_error.copy();
+                }
+                return IntType(0);
+            }
+            int sign = +1;
+            if (first_byte == static_cast<T>('-') && !::std::is_unsigned<IntType>::value) {
+                sign = -1;
+                if (!window.next(first_byte)) {
+                    throw errors::expecting_int_error.copy();
+                }
+            }
+            if (!(static_cast<T>('1') <= first_byte && first_byte <= static_cast<T>('9'))) {
+                throw errors::expecting_int_error.copy();
+            }
+            IntType res = IntType(static_cast<int>(sign * static_cast<int>(static_cast<char>(first_byte) - '0')));
+            while (true) {
+                T next_byte;
+                if (!window.next(next_byte)) {
+                    throw errors::expecting_int_error.copy();
+                }
+                if (!(static_cast<T>('0') <= next_byte && next_byte <= static_cast<T>('9'))) {
+                    if (static_cast<char>(next_byte) == end_char) {
+                        break;
+                    }
+                    throw errors::expecting_int_error.copy();
+                }
+                IntType previous_res = res;
+                res = res * IntType(10) + IntType(static_cast<int>(sign * static_cast<int>(static_cast<char>(next_byte) - '0')));
+                if ((previous_res < res) != (sign > 0)) {
+                    throw errors::integer_overflow_error.copy();
+                }
+            }
+            return res;
+        }
+
+        template<class T, class Traits>
+        static ::std::basic_string<T, Traits> buffered_stream_read_str(helpers::detail::stream_window<T, Traits>& window, const T* first) {
+            ::std::size_t str_size = buffered_stream_read_int<::std::size_t, T, Traits>(window, ':', first);
+            ::std::basic_string<T, Traits> out_str;
+            // Grown as bytes are read (doubling, so each byte is copied a constant number of times), so a size that
+            // the stream doesn't live up to can't allocate much more than it really had
+            while (out_str.size() < str_size) {
+                const ::std::size_t old_size = out_str.size();
+                const ::std::size_t chunk = ::std::min(str_size - old_size, ::std::max(window.buffer_size(), old_size));
+                out_str.resize(old_size + chunk);
+                if (!window.read(&out_str[old_size], chunk)) {
+                    throw errors::cut_off_str_error.copy();
+                }
+            }
+            return out_str;
+        }
+
+        template<class T, class Traits>
+        static basic_data buffered_stream_bdecode_loop(helpers::detail::stream_window<T, Traits>& window, const T* first, const data_allocator_type& alloc) {
+            T start_byte;
+            if (first == nullptr) {
+                if (!window.next(start_byte)) {
+                    throw errors::expecting_value_error.copy();
+                }
+            } else {
+                start_byte = *first;
+            }
+            switch (static_cast<char>(start_byte)) {
+                case 'i':
+                    // int "ixxxe"
+                    return allocate<DataTag::INT>(alloc, buffered_stream_read_int<int_type, T, Traits>(window, 'e', nullptr));
+                case 'l': {
+                    // list "lxxxe"
+                    list_type list = helpers::detail::construct_with_allocator<list_type>(alloc);
+                    while (true) {
+                        T end_byte;
+                        if (!window.next(end_byte)) {
+                            throw errors::expecting_value_error.copy();
+                        }
+                        if (static_cast<char>(end_byte) == 'e') {
+                            break;
+                        }
+                        list.push_back(buffered_stream_bdecode_loop<T, Traits>(window, &end_byte, alloc));
+                    }
+                    return allocate<DataTag::LIST>(alloc, ::std::move(list));
+                }
+                case 'd': {
+                    // dict "dxxxe"
+                    dict_type dict = helpers::detail::construct_with_allocator<dict_type>(alloc);
+                    ::std::basic_string<T, Traits> last_key;
+                    bool has_last_key = false;
+                    while (true) {
+                        T end_byte;
+                        if (!window.next(end_byte)) {
+                            throw errors::expecting_value_error.copy();
+                        }
+                        if (static_cast<char>(end_byte) == 'e') {
+                            break;
+                        }
+                        ::std::basic_string<T, Traits> key = buffered_stream_read_str<T, Traits>(window, &end_byte);
+                        if (has_last_key) {
+                            if (!helpers::detail::key_less_than<T>(last_key.data(), last_key.size(), key.data(), key.size())) {
+                                throw errors::key_order_error.copy();
+                            }
+                        }
+                        str_type real_key = helpers::detail::take_key<str_type>(key, alloc);
+                        dict.emplace_hint(dict.end(), ::std::move(real_key), buffered_stream_bdecode_loop<T, Traits>(window, nullptr, alloc));
+                        last_key.swap(key);
+                        has_last_key = true;
+                    }
+                    return allocate<DataTag::DICT>(alloc, ::std::move(dict));
+                }
+                case '0': case '1': case '2':
+                case '3': case '4': case '5':
+                case '6': case '7': case '8':
+                case '9': {
+                    // str "yy:xxxx"
+                    ::std::basic_string<T, Traits> s = buffered_stream_read_str<T, Traits>(window, &start_byte);
+                    return allocate<DataTag::STR>(alloc, helpers::detail::take_str<str_type>(::std::move(s), alloc));
+                }
+                default:
+                    throw errors::unknown_value_error.copy();
+            }
+        }
+
+    public:
+        static constexpr ::std::size_t default_stream_buffer_size = 64 * 1024;
+
+        // Like `load(is)`, but reads `buffer_size` bytes at a time straight from `is.rdbuf()`.
+        // Bytes after the end of the value may be consumed from the stream, which is an error anyway.
+        template<class T = char, class Traits = ::std::char_traits<T>>
+        static basic_data load(::std::basic_istream<T, Traits>& is, const ::std::size_t buffer_size, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(!helpers::detail::is_borrowed_str<str_type>::value, "Borrowed strings can only be loaded from a pointer");
+            const typename ::std::basic_istream<T, Traits>::sentry sentry(is, true);
+            if (!sentry || is.rdbuf() == nullptr) {
+                throw errors::bad_stream_error.copy();
+            }
+            helpers::detail::stream_window<T, Traits> window(is.rdbuf(), buffer_size);
+            auto parsed = buffered_stream_bdecode_loop<T, Traits>(window, nullptr, alloc);
+            if (!window.at_end()) {
+                throw errors::early_end_error.copy();
+            }
+            is.setstate(::std::ios_base::eofbit);
+            return parsed;
+        }
+
     };
 
     using data = basic_data<>;
 
+    // Strings and keys borrow from the buffer that was loaded, which must outlive the data.
+    using data_view = basic_data<str_view>;
+
+    // Dicts are sorted vectors, which decode faster and use less memory, but are slower to insert into.
+    using flat_data = basic_data<::std::string, ::std::intmax_t, ::std::vector, true, flat_dict>;
+
+    // Everything is allocated with an `arena_allocator`, so is put in the arena of the current `arena::scope`.
+    using arena_data = basic_data<arena_string, ::std::intmax_t, arena_vector, true, arena_map, arena_allocator>;
+
+    // Strings are `shared_string`s, so keys decoded inside a `key_table::scope` share their characters.
+    using shared_string_data = basic_data<shared_string>;
+
+#ifdef TORREBIS_HAS_MEMORY_RESOURCE
+    namespace pmr {
+        template<typename ValueType, typename...>
+        using vector = ::std::pmr::vector<ValueType>;
+
+        template<typename KeyType, typename ValueType, typename...>
+        using map = ::std::pmr::map<KeyType, ValueType>;
+
+        // Everything is allocated from the `std::pmr::memory_resource` given to `load`, or the default resource.
+        using data = basic_data<::std::pmr::string, ::std::intmax_t, vector, true, map, ::std::pmr::polymorphic_allocator>;
+    }  // namespace torrebis::bencode::pmr
+#endif
+
     namespace helpers { namespace detail {
         template<class T>
         struct is_basic_data_ : ::std::false_type {};
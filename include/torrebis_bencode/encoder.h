@@ -0,0 +1,154 @@
+#ifndef TORREBIS_BENCODE_ENCODER_H_
+#define TORREBIS_BENCODE_ENCODER_H_
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "torrebis_bencode/helpers.h"
+#include "torrebis_bencode/str_view.h"
+#include "torrebis_bencode/writers.h"
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * Writes bencode straight to an output iterator, one value at a time, without building a `basic_data`:
+     *
+     *     std::string s;
+     *     bencode::encoder e(std::back_inserter(s));
+     *     e.begin_dict().key("interval").int_value(1800).key("peers").string_value(peers, size).end();
+     *
+     * Dict keys must be given in ascending order (The order `data` stores them in). Nothing is checked in release
+     * builds; without `NDEBUG`, misuse (like a value without a key in a dict, an `end()` with nothing to end, keys
+     * that are out of order or a second top level value) fails an `assert`.
+     */
+    template<class OutputIt>
+    class basic_encoder final {
+    private:
+        struct frame {
+            bool is_dict;
+            bool has_key;  // A key was written and its value wasn't yet
+            bool has_last_key;
+            ::std::string last_key;
+        };
+
+        OutputIt out_;
+        ::std::size_t depth_;
+        // Only used for checks, but always there so the layout doesn't depend on `NDEBUG`
+        ::std::vector<frame> frames_;
+        bool finished_;  // A whole top level value was written
+
+        void before_value() {
+#ifndef NDEBUG
+            if (frames_.empty()) {
+                assert(!finished_ && "basic_encoder: only one top level value can be written");
+            } else if (frames_.back().is_dict) {
+                assert(frames_.back().has_key && "basic_encoder: a value in a dict needs a key first");
+                frames_.back().has_key = false;
+            }
+#endif
+        }
+
+        void after_value() noexcept {
+#ifndef NDEBUG
+            if (frames_.empty()) {
+                finished_ = true;
+            }
+#endif
+        }
+
+        void begin(const char c, const bool is_dict) {
+            before_value();
+            *out_ = c;
+            ++out_;
+            ++depth_;
+#ifndef NDEBUG
+            frames_.push_back({ is_dict, false, false, ::std::string() });
+#else
+            static_cast<void>(is_dict);
+#endif
+        }
+    public:
+        explicit basic_encoder(OutputIt out) : out_(out), depth_(0), finished_(false) {}
+
+        basic_encoder& begin_dict() {
+            begin('d', true);
+            return *this;
+        }
+
+        basic_encoder& begin_list() {
+            begin('l', false);
+            return *this;
+        }
+
+        // Ends the innermost dict or list.
+        basic_encoder& end() {
+#ifndef NDEBUG
+            assert(!frames_.empty() && "basic_encoder: end() without a dict or list to end");
+            assert(!frames_.back().has_key && "basic_encoder: a key in a dict needs a value");
+            frames_.pop_back();
+#endif
+            --depth_;
+            *out_ = 'e';
+            ++out_;
+            after_value();
+            return *this;
+        }
+
+        // The key of the next value in the current dict. It must come after the previous key.
+        basic_encoder& key(const str_view k) {
+#ifndef NDEBUG
+            assert(!frames_.empty() && frames_.back().is_dict && "basic_encoder: a key has to be in a dict");
+            frame& f = frames_.back();
+            assert(!f.has_key && "basic_encoder: a key in a dict needs a value");
+            assert((!f.has_last_key || helpers::detail::key_less_than(f.last_key.data(), f.last_key.size(), k.data(), k.size())) &&
+                "basic_encoder: keys must be in ascending order");
+            f.last_key.assign(k.data(), k.size());
+            f.has_last_key = true;
+            f.has_key = true;
+#endif
+            out_ = helpers::detail::copy_int(k.size(), out_);
+            *out_ = ':';
+            out_ = helpers::detail::copy_chars(k, ++out_);
+            return *this;
+        }
+
+        template<class IntType>
+        basic_encoder& int_value(const IntType i) {
+            before_value();
+            *out_ = 'i';
+            out_ = helpers::detail::copy_int(i, ++out_);
+            *out_ = 'e';
+            ++out_;
+            after_value();
+            return *this;
+        }
+
+        basic_encoder& string_value(const char* const s, const ::std::size_t size) { return string_value(str_view(s, size)); }
+
+        basic_encoder& string_value(const str_view s) {
+            before_value();
+            out_ = helpers::detail::copy_int(s.size(), out_);
+            *out_ = ':';
+            out_ = helpers::detail::copy_chars(s, ++out_);
+            after_value();
+            return *this;
+        }
+
+        // How many dicts and lists haven't been ended yet.
+        ::std::size_t depth() const noexcept { return depth_; }
+
+        // Where the next byte will be written.
+        OutputIt position() const { return out_; }
+    };
+
+    template<class OutputIt>
+    basic_encoder<OutputIt> make_encoder(const OutputIt out) { return basic_encoder<OutputIt>(out); }
+
+    // Appends to a `std::string`.
+    using encoder = basic_encoder<::std::back_insert_iterator<::std::string>>;
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_ENCODER_H_
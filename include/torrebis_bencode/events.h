@@ -0,0 +1,143 @@
+#ifndef TORREBIS_BENCODE_EVENTS_H_
+#define TORREBIS_BENCODE_EVENTS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "torrebis_bencode/helpers.h"
+#include "torrebis_bencode/errors.h"
+#include "torrebis_bencode/readers.h"
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * A handler for `bdecode_events` that does nothing. Inherit from it to only handle some events.
+     *
+     * Strings passed to a handler point into the buffer being decoded.
+     */
+    template<typename IntType = ::std::intmax_t>
+    struct basic_event_handler {
+        using int_type = IntType;
+
+        void on_int(const int_type i) { static_cast<void>(i); }
+        void on_string(const char* const str, const ::std::size_t size) { static_cast<void>(str); static_cast<void>(size); }
+        void begin_list() {}
+        void end_list() {}
+        void begin_dict() {}
+        // Called for every key, before the value for that key.
+        void dict_key(const char* const key, const ::std::size_t size) { static_cast<void>(key); static_cast<void>(size); }
+        void end_dict() {}
+    };
+
+    using event_handler = basic_event_handler<>;
+
+    namespace helpers {
+        namespace detail {
+            template<typename IntType, class Handler>
+            static void events_bdecode_loop(const char* const begin, ::std::size_t& i, const ::std::size_t size, Handler& handler) {
+                if (i >= size) {
+                    throw errors::expecting_value_error.copy();
+                }
+                switch (begin[i]) {
+                    case 'i':
+                        // int "ixxxe"
+                        ++i;
+                        handler.on_int(pointer_read_int<IntType, char>(begin, i, size, 'e', nullptr));
+                        return;
+                    case 'l':
+                        // list "lxxxe"
+                        ++i;
+                        handler.begin_list();
+                        while (true) {
+                            if (i >= size) {
+                                throw errors::expecting_value_error.copy();
+                            }
+                            if (begin[i] == 'e') {
+                                break;
+                            }
+                            events_bdecode_loop<IntType, Handler>(begin, i, size, handler);
+                        }
+                        ++i;
+                        handler.end_list();
+                        return;
+                    case 'd': {
+                        // dict "dxxxe"
+                        ++i;
+                        handler.begin_dict();
+                        const char* last_key_begin = nullptr;
+                        ::std::size_t last_key_size = 0;
+                        while (true) {
+                            if (i >= size) {
+                                throw errors::expecting_value_error.copy();
+                            }
+                            if (begin[i] == 'e') {
+                                break;
+                            }
+                            auto key = pointer_read_str_fast(begin, i, size, nullptr);
+                            if (last_key_begin != nullptr) {
+                                if (!key_less_than(last_key_begin, last_key_size, key.first, key.second)) {
+                                    throw errors::key_order_error.copy();
+                                }
+                            }
+                            last_key_begin = key.first;
+                            last_key_size = key.second;
+                            handler.dict_key(key.first, key.second);
+                            events_bdecode_loop<IntType, Handler>(begin, i, size, handler);
+                        }
+                        ++i;
+                        handler.end_dict();
+                        return;
+                    }
+                    case '0': case '1': case '2':
+                    case '3': case '4': case '5':
+                    case '6': case '7': case '8':
+                    case '9': {
+                        // str "yy:xxxx"
+                        auto str = pointer_read_str_fast(begin, i, size, nullptr);
+                        handler.on_string(str.first, str.second);
+                        return;
+                    }
+                    default:
+                        throw errors::unknown_value_error.copy();
+                }
+            }
+        }  // namespace torrebis::bencode::helpers::detail  (Private)
+    }  // namespace torrebis::bencode::helpers
+
+    /*
+     * Decodes some bencoded data without building a `data`, calling `handler.on_int(i)`, `handler.on_string(ptr, size)`,
+     * `handler.begin_list()`, `handler.end_list()`, `handler.begin_dict()`, `handler.dict_key(ptr, size)` and
+     * `handler.end_dict()` as each part is read. `Handler` is a template parameter, so these calls can be inlined.
+     *
+     * The data is validated like `data::load`, and a `decoding_error` is thrown if it is invalid (possibly after some
+     * events have already been handled).
+     */
+    template<typename IntType = ::std::intmax_t, class Handler>
+    void bdecode_events(const char* const begin, const ::std::size_t size, Handler& handler) {
+        ::std::size_t i = 0;
+        helpers::detail::events_bdecode_loop<IntType, Handler>(begin, i, size, handler);
+        if (i != size) {
+            throw errors::early_end_error.copy();
+        }
+    }
+
+    template<typename IntType = ::std::intmax_t, typename T, class Handler>
+    void bdecode_events(const T* const begin, const ::std::size_t size, Handler& handler) {
+        static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+        bdecode_events<IntType, Handler>(reinterpret_cast<const char*>(begin), size, handler);
+    }
+
+    template<typename IntType = ::std::intmax_t, typename T, typename... Rest, class Handler>
+    void bdecode_events(const ::std::basic_string<T, Rest...>& s, Handler& handler) {
+        bdecode_events<IntType>(s.data(), s.size(), handler);
+    }
+
+    template<typename IntType = ::std::intmax_t, typename T, typename... Rest, class Handler>
+    void bdecode_events(const ::std::vector<T, Rest...>& v, Handler& handler) {
+        bdecode_events<IntType>(v.data(), v.size(), handler);
+    }
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_EVENTS_H_
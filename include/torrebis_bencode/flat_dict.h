@@ -0,0 +1,244 @@
+#ifndef TORREBIS_BENCODE_FLAT_DICT_H_
+#define TORREBIS_BENCODE_FLAT_DICT_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "torrebis_bencode/helpers.h"
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * A map kept as a sorted vector of key / value pairs, for use as the `DictType` of `basic_data`.
+     *
+     * Keys in bencoded dicts are already sorted, so decoding appends every item at the end (`emplace_hint(end(), ...)`)
+     * without allocating a node for it, and lookups are a binary search over contiguous storage. Inserting anywhere
+     * else moves every item after it, and invalidates iterators like `std::vector` does.
+     *
+     * Items can be changed through iterators, but changing a key so that the keys are no longer sorted is undefined.
+     */
+    template<typename Key, typename Value, typename Compare = ::std::less<Key>, typename Allocator = ::std::allocator<::std::pair<Key, Value>>>
+    class flat_dict final {
+    public:
+        using key_type = Key;
+        using mapped_type = Value;
+        using value_type = ::std::pair<Key, Value>;
+        using key_compare = Compare;
+        using allocator_type = Allocator;
+        using storage_type = ::std::vector<value_type, Allocator>;
+        using size_type = typename storage_type::size_type;
+        using difference_type = typename storage_type::difference_type;
+        using reference = value_type&;
+        using const_reference = const value_type&;
+        using iterator = typename storage_type::iterator;
+        using const_iterator = typename storage_type::const_iterator;
+        using reverse_iterator = typename storage_type::reverse_iterator;
+        using const_reverse_iterator = typename storage_type::const_reverse_iterator;
+    private:
+        storage_type items_;
+        Compare compare_;
+
+        bool item_less(const value_type& a, const value_type& b) const { return compare_(a.first, b.first); }
+
+        // Sorts `items_` and removes repeated keys, keeping the first of each like `std::map`.
+        void sort_items() {
+            ::std::stable_sort(items_.begin(), items_.end(), [this](const value_type& a, const value_type& b) {
+                return item_less(a, b);
+            });
+            items_.erase(::std::unique(items_.begin(), items_.end(), [this](const value_type& a, const value_type& b) {
+                return !item_less(a, b);
+            }), items_.end());
+        }
+
+    public:
+        flat_dict() : items_(), compare_() {}
+        explicit flat_dict(const Compare& compare, const Allocator& allocator = Allocator()) : items_(allocator), compare_(compare) {}
+        explicit flat_dict(const Allocator& allocator) : items_(allocator), compare_() {}
+
+        template<class InputIterator>
+        flat_dict(InputIterator first, InputIterator last, const Compare& compare = Compare(), const Allocator& allocator = Allocator()) :
+            items_(first, last, allocator), compare_(compare) { sort_items(); }
+
+        flat_dict(::std::initializer_list<value_type> items, const Compare& compare = Compare(), const Allocator& allocator = Allocator()) :
+            items_(items, allocator), compare_(compare) { sort_items(); }
+
+        flat_dict& operator=(::std::initializer_list<value_type> items) {
+            items_.assign(items);
+            sort_items();
+            return *this;
+        }
+
+        iterator begin() noexcept { return items_.begin(); }
+        const_iterator begin() const noexcept { return items_.begin(); }
+        const_iterator cbegin() const noexcept { return items_.cbegin(); }
+        iterator end() noexcept { return items_.end(); }
+        const_iterator end() const noexcept { return items_.end(); }
+        const_iterator cend() const noexcept { return items_.cend(); }
+        reverse_iterator rbegin() noexcept { return items_.rbegin(); }
+        const_reverse_iterator rbegin() const noexcept { return items_.rbegin(); }
+        reverse_iterator rend() noexcept { return items_.rend(); }
+        const_reverse_iterator rend() const noexcept { return items_.rend(); }
+
+        bool empty() const noexcept { return items_.empty(); }
+        size_type size() const noexcept { return items_.size(); }
+        size_type max_size() const noexcept { return items_.max_size(); }
+        size_type capacity() const noexcept { return items_.capacity(); }
+        void reserve(const size_type n) { items_.reserve(n); }
+        void shrink_to_fit() { items_.shrink_to_fit(); }
+        void clear() noexcept { items_.clear(); }
+
+        key_compare key_comp() const { return compare_; }
+        allocator_type get_allocator() const { return items_.get_allocator(); }
+
+        // The sorted items.
+        const storage_type& items() const noexcept { return items_; }
+
+        iterator lower_bound(const key_type& key) {
+            return ::std::lower_bound(items_.begin(), items_.end(), key, [this](const value_type& item, const key_type& k) {
+                return compare_(item.first, k);
+            });
+        }
+        const_iterator lower_bound(const key_type& key) const {
+            return ::std::lower_bound(items_.begin(), items_.end(), key, [this](const value_type& item, const key_type& k) {
+                return compare_(item.first, k);
+            });
+        }
+
+        iterator upper_bound(const key_type& key) {
+            return ::std::upper_bound(items_.begin(), items_.end(), key, [this](const key_type& k, const value_type& item) {
+                return compare_(k, item.first);
+            });
+        }
+        const_iterator upper_bound(const key_type& key) const {
+            return ::std::upper_bound(items_.begin(), items_.end(), key, [this](const key_type& k, const value_type& item) {
+                return compare_(k, item.first);
+            });
+        }
+
+        ::std::pair<iterator, iterator> equal_range(const key_type& key) {
+            const iterator it = find(key);
+            return { it, it == end() ? it : it + 1 };
+        }
+        ::std::pair<const_iterator, const_iterator> equal_range(const key_type& key) const {
+            const const_iterator it = find(key);
+            return { it, it == end() ? it : it + 1 };
+        }
+
+        iterator find(const key_type& key) {
+            const iterator it = lower_bound(key);
+            return it != end() && !compare_(key, it->first) ? it : end();
+        }
+        const_iterator find(const key_type& key) const {
+            const const_iterator it = lower_bound(key);
+            return it != end() && !compare_(key, it->first) ? it : end();
+        }
+
+        size_type count(const key_type& key) const { return find(key) == end() ? 0 : 1; }
+
+        mapped_type& at(const key_type& key) {
+            const iterator it = find(key);
+            if (it == end()) {
+                throw ::std::out_of_range("flat_dict::at");
+            }
+            return it->second;
+        }
+        const mapped_type& at(const key_type& key) const {
+            const const_iterator it = find(key);
+            if (it == end()) {
+                throw ::std::out_of_range("flat_dict::at");
+            }
+            return it->second;
+        }
+
+        mapped_type& operator[](const key_type& key) {
+            iterator it = lower_bound(key);
+            if (it == end() || compare_(key, it->first)) {
+                it = items_.emplace(it, key, mapped_type());
+            }
+            return it->second;
+        }
+        mapped_type& operator[](key_type&& key) {
+            iterator it = lower_bound(key);
+            if (it == end() || compare_(key, it->first)) {
+                it = items_.emplace(it, ::std::move(key), mapped_type());
+            }
+            return it->second;
+        }
+
+        ::std::pair<iterator, bool> insert(value_type item) {
+            const iterator it = lower_bound(item.first);
+            if (it != end() && !compare_(item.first, it->first)) {
+                return { it, false };
+            }
+            return { items_.insert(it, ::std::move(item)), true };
+        }
+
+        // Inserts at `hint` without a search if that is where `item` goes (So appending sorted items is O(1)).
+        iterator insert(const_iterator hint, value_type item) {
+            const bool after_previous = hint == cbegin() || compare_((hint - 1)->first, item.first);
+            const bool before_next = hint == cend() || compare_(item.first, hint->first);
+            if (after_previous && before_next) {
+                return items_.insert(hint, ::std::move(item));
+            }
+            return insert(::std::move(item)).first;
+        }
+
+        template<class InputIterator>
+        void insert(InputIterator first, InputIterator last) {
+            for (; first != last; ++first) {
+                insert(cend(), value_type(*first));
+            }
+        }
+
+        void insert(::std::initializer_list<value_type> items) { insert(items.begin(), items.end()); }
+
+        template<typename... Args>
+        ::std::pair<iterator, bool> emplace(Args&&... args) { return insert(value_type(::std::forward<Args>(args)...)); }
+
+        template<typename... Args>
+        iterator emplace_hint(const_iterator hint, Args&&... args) {
+            if (hint == cend()) {
+                // Build it in place at the end, and only move it if it doesn't go there
+                items_.emplace_back(::std::forward<Args>(args)...);
+                if (items_.size() == 1 || compare_(items_[items_.size() - 2].first, items_.back().first)) {
+                    return items_.end() - 1;
+                }
+                value_type item(::std::move(items_.back()));
+                items_.pop_back();
+                return insert(::std::move(item)).first;
+            }
+            return insert(hint, value_type(::std::forward<Args>(args)...));
+        }
+
+        iterator erase(const_iterator pos) { return items_.erase(pos); }
+        iterator erase(const_iterator first, const_iterator last) { return items_.erase(first, last); }
+        size_type erase(const key_type& key) {
+            const iterator it = find(key);
+            if (it == end()) {
+                return 0;
+            }
+            items_.erase(it);
+            return 1;
+        }
+
+        void swap(flat_dict& other) {
+            using ::std::swap;
+            swap(items_, other.items_);
+            swap(compare_, other.compare_);
+        }
+
+        friend void swap(flat_dict& a, flat_dict& b) { a.swap(b); }
+
+        friend bool operator==(const flat_dict& a, const flat_dict& b) { return a.items_ == b.items_; }
+        friend bool operator!=(const flat_dict& a, const flat_dict& b) { return !(a == b); }
+        friend bool operator<(const flat_dict& a, const flat_dict& b) { return a.items_ < b.items_; }
+    };
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_FLAT_DICT_H_
@@ -0,0 +1,120 @@
+#ifndef TORREBIS_BENCODE_GATHER_H_
+#define TORREBIS_BENCODE_GATHER_H_
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "torrebis_bencode/helpers.h"
+#include "torrebis_bencode/str_view.h"
+#include "torrebis_bencode/writers.h"
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * An encoding split into pieces for a gather write (`writev`), so that long strings don't have to be copied.
+     * Strings of at least `reference_size()` bytes are referenced where they are, everything else is copied into a
+     * scratch buffer. Referenced strings must stay alive and unchanged until the pieces have been written.
+     *
+     * Fill one with `basic_data::append_serialisation(gather_buffer&)`, then use `segments()`, or with POSIX,
+     * `iovecs()` or `write_to()` from "torrebis_bencode/gather_posix.h".
+     */
+    class gather_buffer final {
+    private:
+        struct piece {
+            const char* data;  // nullptr if the piece is in `scratch_`
+            ::std::size_t offset;  // Into `scratch_`
+            ::std::size_t size;
+        };
+
+        ::std::string scratch_;
+        ::std::vector<piece> pieces_;
+        ::std::size_t reference_size_;
+        ::std::size_t size_;
+
+        // Copied bytes are added to the last piece if it is also in the scratch buffer.
+        void extend_scratch(const ::std::size_t old_size) {
+            const ::std::size_t added = scratch_.size() - old_size;
+            if (!pieces_.empty() && pieces_.back().data == nullptr) {
+                pieces_.back().size += added;
+            } else {
+                pieces_.push_back({ nullptr, old_size, added });
+            }
+            size_ += added;
+        }
+
+        template<class Str>
+        void put_str_(const Str& s, ::std::true_type) { put_bytes(s.data(), s.size()); }
+
+        template<class Str>
+        void put_str_(const Str& s, ::std::false_type) {
+            const ::std::size_t old_size = scratch_.size();
+            helpers::detail::append_chars(scratch_, s);
+            extend_scratch(old_size);
+        }
+
+        const char* piece_data(const piece& p) const noexcept { return p.data == nullptr ? scratch_.data() + p.offset : p.data; }
+    public:
+        static constexpr ::std::size_t default_reference_size = 512;
+
+        explicit gather_buffer(const ::std::size_t reference_size = default_reference_size) noexcept :
+            reference_size_(reference_size), size_(0) {}
+
+        // Strings at least this long are referenced instead of copied.
+        ::std::size_t reference_size() const noexcept { return reference_size_; }
+
+        // How many bytes all of the pieces add up to.
+        ::std::size_t size() const noexcept { return size_; }
+
+        bool empty() const noexcept { return size_ == 0; }
+
+        // Forgets every piece, keeping the scratch buffer's memory.
+        void clear() noexcept {
+            scratch_.clear();
+            pieces_.clear();
+            size_ = 0;
+        }
+
+        void put(const char c) {
+            const ::std::size_t old_size = scratch_.size();
+            scratch_.push_back(c);
+            extend_scratch(old_size);
+        }
+
+        template<class IntType>
+        void put_int(const IntType i) {
+            const ::std::size_t old_size = scratch_.size();
+            helpers::detail::append_int(i, scratch_);
+            extend_scratch(old_size);
+        }
+
+        // Copies the bytes if there are fewer than `reference_size()` of them, otherwise references them.
+        void put_bytes(const char* const data, const ::std::size_t size) {
+            if (size < reference_size_) {
+                const ::std::size_t old_size = scratch_.size();
+                scratch_.append(data, size);
+                extend_scratch(old_size);
+                return;
+            }
+            pieces_.push_back({ data, 0, size });
+            size_ += size;
+        }
+
+        // `put_bytes` for a string of `char`s, otherwise the bytes are copied.
+        template<class Str>
+        void put_str(const Str& s) { put_str_(s, helpers::detail::has_char_t<char, Str>()); }
+
+        // The pieces in order. Copied pieces point into this buffer, so they are invalidated by adding to it.
+        ::std::vector<str_view> segments() const {
+            ::std::vector<str_view> result;
+            result.reserve(pieces_.size());
+            for (const piece& p : pieces_) {
+                result.emplace_back(piece_data(p), p.size);
+            }
+            return result;
+        }
+    };
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_GATHER_H_
@@ -0,0 +1,74 @@
+#ifndef TORREBIS_BENCODE_GATHER_POSIX_H_
+#define TORREBIS_BENCODE_GATHER_POSIX_H_
+
+/*
+ * Writing a `gather_buffer` with POSIX `writev`. This isn't included by "torrebis_bencode/torrebis_bencode.h", so that
+ * <sys/uio.h> and <unistd.h> are only included where they are used. Include it yourself for `iovecs` and `write_to`.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <system_error>
+#include <vector>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "torrebis_bencode/str_view.h"
+#include "torrebis_bencode/gather.h"
+
+
+namespace torrebis { namespace bencode {
+    // `buffer.segments()` for `writev`.
+    inline ::std::vector<::iovec> iovecs(const gather_buffer& buffer) {
+        const ::std::vector<str_view> segments = buffer.segments();
+        ::std::vector<::iovec> result;
+        result.reserve(segments.size());
+        for (const str_view s : segments) {
+            ::iovec v;
+            v.iov_base = const_cast<char*>(s.data());
+            v.iov_len = s.size();
+            result.push_back(v);
+        }
+        return result;
+    }
+
+    /*
+     * Writes every piece of `buffer` to `fd`, calling `writev` again after a partial write or `EINTR`, at most
+     * `IOV_MAX` pieces at a time. Other errors (Including `EAGAIN`, so `fd` should be blocking) throw a
+     * `std::system_error`.
+     */
+    inline void write_to(const gather_buffer& buffer, const int fd) {
+#ifdef IOV_MAX
+        const ::std::size_t max_iovecs = IOV_MAX;
+#else
+        const ::std::size_t max_iovecs = 1024;
+#endif
+        ::std::vector<::iovec> iov = iovecs(buffer);
+        ::std::size_t i = 0;
+        while (i < iov.size()) {
+            const ::std::size_t count = ::std::min(iov.size() - i, max_iovecs);
+            const ::ssize_t written = ::writev(fd, &iov[i], static_cast<int>(count));
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw ::std::system_error(errno, ::std::generic_category(), "bencode::write_to");
+            }
+            ::std::size_t left = static_cast<::std::size_t>(written);
+            while (i < iov.size() && left >= iov[i].iov_len) {
+                left -= iov[i].iov_len;
+                ++i;
+            }
+            if (left != 0) {
+                // Part of this piece was written
+                iov[i].iov_base = static_cast<char*>(iov[i].iov_base) + left;
+                iov[i].iov_len -= left;
+            }
+        }
+    }
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_GATHER_POSIX_H_
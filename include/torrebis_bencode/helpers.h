@@ -5,6 +5,7 @@
 
 #include <type_traits>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <algorithm>
 #include <string>
@@ -15,6 +16,14 @@
 #if defined(__cplusplus) && __cplusplus >= 202000L
 // C++ 20 or higher
 #define TORREBIS_HAS_IS_NOTHROW_CONVERTIBLE
+
+#if defined(__has_include)
+#if __has_include(<span>)
+#define TORREBIS_HAS_SPAN
+#include <span>
+#endif
+#endif
+
 #else
 
 #endif
@@ -23,9 +32,17 @@
 // C++ 17 or higher
 #define TORREBIS_CONSTEXPR_IF if constexpr
 #define TORREBIS_STD_ARRAY_HAS_DATA
+#define TORREBIS_HAS_STRING_VIEW
 
 #include <array>
 
+#if defined(__has_include)
+#if __has_include(<memory_resource>)
+#define TORREBIS_HAS_MEMORY_RESOURCE
+#include <memory_resource>
+#endif
+#endif
+
 #else
 #define TORREBIS_CONSTEXPR_IF if
 #endif
@@ -33,6 +50,7 @@
 #if defined(__cplusplus) && __cplusplus >= 201402L
 // C++ 14 or higher
 #define TORREBIS_VARIABLE_TEMPLATES
+#define TORREBIS_HAS_HETEROGENEOUS_LOOKUP
 #else
 
 #endif
@@ -120,8 +138,8 @@ namespace torrebis { namespace bencode {
             template<class CharT, class StringT>
             struct has_char_t : ::std::false_type {};
 
-            template<class CharT, class CharTraits>
-            struct has_char_t<CharT, ::std::basic_string<CharT, CharTraits>> : ::std::true_type {};
+            template<class CharT, class CharTraits, class Allocator>
+            struct has_char_t<CharT, ::std::basic_string<CharT, CharTraits, Allocator>> : ::std::true_type {};
 
             template<class CharT, class... Rest>
             struct has_char_t<CharT, ::std::vector<CharT, Rest...>> : ::std::true_type {};
@@ -132,6 +150,26 @@ namespace torrebis { namespace bencode {
 #endif
 
 
+            // FNV-1a
+            inline ::std::uint64_t hash_bytes(const void* const bytes, const ::std::size_t size, ::std::uint64_t hash = 14695981039346656037ULL) noexcept {
+                const unsigned char* const s = static_cast<const unsigned char*>(bytes);
+                for (::std::size_t i = 0; i < size; ++i) {
+                    hash ^= s[i];
+                    hash *= 1099511628211ULL;
+                }
+                return hash;
+            }
+
+            // The finaliser of splitmix64, so that similar hashes end up far apart.
+            inline ::std::uint64_t hash_mix(::std::uint64_t hash) noexcept {
+                hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+                return hash ^ (hash >> 31);
+            }
+
+            inline ::std::uint64_t hash_combine(const ::std::uint64_t seed, const ::std::uint64_t hash) noexcept {
+                return hash_mix(seed ^ (hash + 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2)));
+            }
         }  // namespace torrebis::bencode::helpers::detail  (Private)
     }  // namespace torrebis::bencode::helpers
 } }  // namespace torrebis::bencode
@@ -0,0 +1,208 @@
+#ifndef TORREBIS_BENCODE_KEY_TABLE_H_
+#define TORREBIS_BENCODE_KEY_TABLE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "torrebis_bencode/helpers.h"
+#include "torrebis_bencode/str_view.h"
+
+
+namespace torrebis { namespace bencode {
+    namespace helpers {
+        namespace detail {
+            // The characters of a `shared_string` follow this header in the same allocation.
+            struct shared_string_node {
+                ::std::atomic<::std::size_t> refcount;
+                ::std::size_t size;
+
+                char* chars() noexcept { return reinterpret_cast<char*>(this + 1); }
+            };
+        }  // namespace torrebis::bencode::helpers::detail  (Private)
+    }  // namespace torrebis::bencode::helpers
+
+    /*
+     * An immutable string whose characters are shared between copies, like a `std::shared_ptr<const std::string>`
+     * in a single allocation. It can be the `StrType` of `basic_data` (See `shared_string_data`), so that dict keys
+     * can come from a `key_table`.
+     */
+    class shared_string final {
+    public:
+        using value_type = char;
+        using traits_type = ::std::char_traits<char>;
+        using size_type = ::std::size_t;
+        using difference_type = ::std::ptrdiff_t;
+        using const_reference = const char&;
+        using const_pointer = const char*;
+        using const_iterator = const char*;
+        using iterator = const_iterator;
+    private:
+        helpers::detail::shared_string_node* node_;  // nullptr for the empty string
+
+        void release() noexcept {
+            if (node_ != nullptr && node_->refcount.fetch_sub(1, ::std::memory_order_acq_rel) == 1) {
+                node_->~shared_string_node();
+                ::operator delete(node_);
+            }
+            node_ = nullptr;
+        }
+    public:
+        shared_string() noexcept : node_(nullptr) {}
+
+        shared_string(const char* const s, const size_type size) : node_(nullptr) {
+            if (size == 0) {
+                return;
+            }
+            void* const memory = ::operator new(sizeof(helpers::detail::shared_string_node) + size + 1);
+            node_ = ::new (memory) helpers::detail::shared_string_node{ { 1 }, size };
+            ::std::memcpy(node_->chars(), s, size);
+            node_->chars()[size] = '\0';
+        }
+
+        shared_string(const char* const c_str) : shared_string(c_str, ::std::strlen(c_str)) {}
+        shared_string(const str_view s) : shared_string(s.data(), s.size()) {}
+        template<class Allocator>
+        shared_string(const ::std::basic_string<char, traits_type, Allocator>& s) : shared_string(s.data(), s.size()) {}
+
+        shared_string(const shared_string& other) noexcept : node_(other.node_) {
+            if (node_ != nullptr) {
+                node_->refcount.fetch_add(1, ::std::memory_order_relaxed);
+            }
+        }
+
+        shared_string(shared_string&& other) noexcept : node_(other.node_) { other.node_ = nullptr; }
+
+        shared_string& operator=(shared_string other) noexcept {
+            swap(other);
+            return *this;
+        }
+
+        ~shared_string() noexcept { release(); }
+
+        void swap(shared_string& other) noexcept { ::std::swap(node_, other.node_); }
+        friend void swap(shared_string& a, shared_string& b) noexcept { a.swap(b); }
+
+        const char* data() const noexcept { return node_ == nullptr ? "" : node_->chars(); }
+        const char* c_str() const noexcept { return data(); }
+        size_type size() const noexcept { return node_ == nullptr ? 0 : node_->size; }
+        size_type length() const noexcept { return size(); }
+        bool empty() const noexcept { return node_ == nullptr; }
+
+        const_iterator begin() const noexcept { return data(); }
+        const_iterator cbegin() const noexcept { return data(); }
+        const_iterator end() const noexcept { return data() + size(); }
+        const_iterator cend() const noexcept { return data() + size(); }
+
+        const_reference operator[](const size_type i) const noexcept { return data()[i]; }
+
+        // Whether this and `other` share the same characters (Not just equal ones).
+        bool shares_with(const shared_string& other) const noexcept { return node_ == other.node_; }
+
+        operator str_view() const noexcept { return str_view(data(), size()); }
+
+        template<class Allocator = ::std::allocator<char>>
+        ::std::basic_string<char, traits_type, Allocator> to_string() const {
+            return ::std::basic_string<char, traits_type, Allocator>(data(), size());
+        }
+
+        template<class Allocator>
+        explicit operator ::std::basic_string<char, traits_type, Allocator>() const { return to_string<Allocator>(); }
+
+        int compare(const shared_string& other) const noexcept {
+            if (node_ == other.node_) {
+                return 0;
+            }
+            return str_view(*this).compare(str_view(other));
+        }
+
+        friend bool operator==(const shared_string& a, const shared_string& b) noexcept {
+            return a.node_ == b.node_ || (a.size() == b.size() && ::std::memcmp(a.data(), b.data(), a.size()) == 0);
+        }
+        friend bool operator!=(const shared_string& a, const shared_string& b) noexcept { return !(a == b); }
+        friend bool operator<(const shared_string& a, const shared_string& b) noexcept { return a.compare(b) < 0; }
+        friend bool operator<=(const shared_string& a, const shared_string& b) noexcept { return a.compare(b) <= 0; }
+        friend bool operator>(const shared_string& a, const shared_string& b) noexcept { return a.compare(b) > 0; }
+        friend bool operator>=(const shared_string& a, const shared_string& b) noexcept { return a.compare(b) >= 0; }
+
+        friend ::std::ostream& operator<<(::std::ostream& os, const shared_string& s) { return os.write(s.data(), static_cast<::std::streamsize>(s.size())); }
+    };
+
+    namespace helpers {
+        namespace detail {
+            template<>
+            struct has_char_t<char, shared_string> : ::std::true_type {};
+        }  // namespace torrebis::bencode::helpers::detail  (Private)
+    }  // namespace torrebis::bencode::helpers
+
+    /*
+     * Interns dict keys, so that every decoded key with the same characters shares one `shared_string`.
+     *
+     * While a `key_table::scope` is alive, `load`, `load_lazy` and `push_decoder` take the keys of any `basic_data`
+     * whose `StrType` is `shared_string` from its table. A table can be kept for as long as documents keep being
+     * decoded; the keys it hands out don't depend on it, so it can be cleared or destroyed at any time. The keys of a
+     * lazily loaded dict are decoded when it is first accessed, so they are only interned if that is inside a scope.
+     *
+     * Not thread safe. Use one table per thread (The strings themselves can be shared between threads).
+     */
+    class key_table final {
+    private:
+        struct view_hash {
+            ::std::size_t operator()(const str_view s) const noexcept {
+                return helpers::detail::hash_bytes(s.data(), s.size());
+            }
+        };
+
+        // Each key views the characters of its value
+        ::std::unordered_map<str_view, shared_string, view_hash> keys_;
+
+        static key_table*& current_ref() noexcept {
+            static thread_local key_table* current = nullptr;
+            return current;
+        }
+    public:
+        key_table() = default;
+        key_table(const key_table&) = delete;
+        key_table& operator=(const key_table&) = delete;
+
+        // The string with the characters of `s`, shared with every other time it was interned.
+        shared_string intern(const char* const s, const ::std::size_t size) {
+            auto search = keys_.find(str_view(s, size));
+            if (search != keys_.end()) {
+                return search->second;
+            }
+            shared_string interned(s, size);
+            keys_.emplace(str_view(interned), interned);
+            return interned;
+        }
+
+        shared_string intern(const str_view s) { return intern(s.data(), s.size()); }
+
+        // How many different strings have been interned.
+        ::std::size_t size() const noexcept { return keys_.size(); }
+
+        // Forgets every string. Strings that were handed out are still valid.
+        void clear() noexcept { keys_.clear(); }
+
+        // The table of the innermost `scope` on this thread, or nullptr.
+        static key_table* current() noexcept { return current_ref(); }
+
+        // While a scope is alive, decoders on this thread intern keys in its table. Scopes can be nested.
+        class scope final {
+        private:
+            key_table* previous_;
+        public:
+            explicit scope(key_table& table) noexcept : previous_(current_ref()) { current_ref() = &table; }
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+            ~scope() noexcept { current_ref() = previous_; }
+        };
+    };
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_KEY_TABLE_H_
@@ -29,6 +29,7 @@ namespace torrebis { namespace bencode {
 
             KeyOrIndex(const index_type i) noexcept : index(i) {}
             KeyOrIndex(const str_type k) : key(::std::allocate_shared<str_type, allocator_t>(allocator_t(), k)) {}
+            KeyOrIndex(const str_type k, const allocator_t& alloc) : key(::std::allocate_shared<str_type, allocator_t>(alloc, k)) {}
             KeyOrIndex(const str_ptr_type k) noexcept : key(k) {}
             KeyOrIndex() noexcept : key(nullptr) {}
 
@@ -61,6 +62,8 @@ namespace torrebis { namespace bencode {
         basic_path_el(const index_type i) noexcept : tag_(DataTag::INT), key_or_index_(i) {}
 
         basic_path_el(const str_type k) : tag_(DataTag::STR), key_or_index_(k) {}
+        // The key is allocated with `alloc`.
+        basic_path_el(const str_type k, const allocator_t& alloc) : tag_(DataTag::STR), key_or_index_(k, alloc) {}
         basic_path_el(const ::std::shared_ptr<const str_type> k) : tag_(DataTag::STR), key_or_index_(k ? str_type(*k) : nullptr) {}
         basic_path_el(const str_ptr_type k) noexcept : tag_(DataTag::STR), key_or_index_(k) {}
         basic_path_el(const basic_path_el& other) noexcept : tag_(other.tag_) { if (tag_ == DataTag::STR) { key_or_index_.key = other.get_key(); } else { key_or_index_.index = other.get_index(); } }
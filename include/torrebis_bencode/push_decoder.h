@@ -0,0 +1,329 @@
+#ifndef TORREBIS_BENCODE_PUSH_DECODER_H_
+#define TORREBIS_BENCODE_PUSH_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "torrebis_bencode/helpers.h"
+#include "torrebis_bencode/str_view.h"
+#include "torrebis_bencode/errors.h"
+#include "torrebis_bencode/type_tags.h"
+#include "torrebis_bencode/data_class.h"
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * Decodes a single bencoded value that arrives in fragments. Each call to `feed` carries on where the last one
+     * stopped (even in the middle of an integer or string), so no byte is looked at twice.
+     */
+    template<typename BasicData = data>
+    class basic_push_decoder final {
+    public:
+        using data_t = BasicData;
+        using int_type = typename BasicData::int_type;
+        using str_type = typename BasicData::str_type;
+        using list_type = typename BasicData::list_type;
+        using dict_type = typename BasicData::dict_type;
+        using data_allocator_type = typename BasicData::data_allocator_type;
+
+        static_assert(!helpers::detail::is_borrowed_str<str_type>::value, "Borrowed strings can only be loaded from a pointer");
+
+        enum class status : ::std::int8_t {
+            NEED_MORE = 0,  // Everything fed so far was consumed, and the value is not finished.
+            DONE = 1,  // The value is finished. `consumed` bytes of the last feed were part of it.
+            ERROR = -1  // The data is not valid bencode. See `error()`.
+        };
+
+        struct feed_result {
+            status state;
+            ::std::size_t consumed;
+        };
+    private:
+        enum class token : ::std::int8_t {
+            NONE,  // Between values
+            INT,  // In "ixxxe"
+            STR_SIZE,  // In the "yy:" of "yy:xxxx"
+            STR  // In the "xxxx" of "yy:xxxx"
+        };
+
+        enum class digits : ::std::int8_t {
+            NONE,
+            SIGN,  // Only a '-'
+            ZERO,  // Only a '0', which can't be followed by any more digits
+            SOME
+        };
+
+        struct frame {
+            BasicData container;
+            bool has_key;
+            ::std::string key;  // The last key read. The pending key if `has_key`.
+            bool has_last_key;
+        };
+
+        status state_;
+        const char* error_;
+        token token_;
+        digits digits_;
+        int sign_;
+        int_type int_value_;
+        ::std::size_t str_size_;
+        ::std::string str_;
+        ::std::vector<frame> stack_;
+        BasicData result_;
+        data_allocator_type alloc_;
+
+        feed_result fail(const decoding_error& error, const ::std::size_t consumed) noexcept {
+            state_ = status::ERROR;
+            error_ = error.what();
+            return { state_, consumed };
+        }
+
+        bool expecting_key() const noexcept {
+            return !stack_.empty() && stack_.back().container.is_dict() && !stack_.back().has_key;
+        }
+
+        // Called when a whole value has been read.
+        void finish(BasicData value) {
+            if (stack_.empty()) {
+                result_ = ::std::move(value);
+                state_ = status::DONE;
+                return;
+            }
+            frame& top = stack_.back();
+            if (top.container.is_list()) {
+                top.container.get_list()->push_back(::std::move(value));
+            } else {
+                auto& dict = *top.container.get_dict();
+                dict.emplace_hint(
+                    dict.end(),
+                    helpers::detail::take_key<str_type>(top.key, alloc_),
+                    ::std::move(value)
+                );
+                top.has_key = false;
+            }
+        }
+
+        // Called when a whole string has been read into `str_`.
+        const decoding_error* finish_str() {
+            if (expecting_key()) {
+                frame& top = stack_.back();
+                if (top.has_last_key && !helpers::detail::key_less_than(top.key.data(), top.key.size(), str_.data(), str_.size())) {
+                    return &errors::key_order_error;
+                }
+                top.key.swap(str_);
+                top.has_key = true;
+                top.has_last_key = true;
+                str_.clear();
+                return nullptr;
+            }
+            finish(BasicData::template allocate<DataTag::STR>(
+                alloc_, helpers::detail::construct_with_allocator<str_type>(alloc_, str_.data(), str_.size())
+            ));
+            str_.clear();
+            return nullptr;
+        }
+
+        // Adds a digit to `value`. Returns false on overflow.
+        template<typename IntType>
+        bool push_digit(IntType& value, const char c) const noexcept {
+            const IntType previous_value = value;
+            value = value * IntType(10) + IntType(static_cast<int>(sign_ * static_cast<int>(c - '0')));
+            return sign_ > 0 ? !(value < previous_value) : !(previous_value < value);
+        }
+
+        // Reads one character of an integer or string size. Returns an error, or nullptr.
+        template<typename IntType>
+        const decoding_error* read_digit(IntType& value, const char c) const noexcept {
+            if (!('0' <= c && c <= '9')) {
+                return &errors::expecting_int_error;
+            }
+            switch (digits_) {
+                case digits::ZERO:
+                    return &errors::expecting_int_error;
+                case digits::SIGN:
+                    if (c == '0') {
+                        return &errors::expecting_int_error;
+                    }
+                    break;
+                default:
+                    break;
+            }
+            if (!push_digit(value, c)) {
+                return &errors::integer_overflow_error;
+            }
+            return nullptr;
+        }
+
+    public:
+        basic_push_decoder() : alloc_() { reset(); }
+        // Everything decoded is allocated with `alloc`.
+        explicit basic_push_decoder(const data_allocator_type& alloc) : alloc_(alloc) { reset(); }
+
+        // Forget everything fed so far and start decoding a new value.
+        void reset() {
+            state_ = status::NEED_MORE;
+            error_ = nullptr;
+            token_ = token::NONE;
+            digits_ = digits::NONE;
+            sign_ = +1;
+            int_value_ = int_type(0);
+            str_size_ = 0;
+            str_.clear();
+            stack_.clear();
+            result_.reset();
+        }
+
+        status state() const noexcept { return state_; }
+        bool done() const noexcept { return state_ == status::DONE; }
+
+        // The description of what was wrong with the data if `state()` is `status::ERROR`, otherwise nullptr.
+        const char* error() const noexcept { return error_; }
+
+        // The decoded value once `state()` is `status::DONE`, otherwise an uninitialised value.
+        const BasicData& result() const noexcept { return result_; }
+
+        feed_result feed(const char* const begin, const ::std::size_t size) {
+            if (state_ != status::NEED_MORE) {
+                return { state_, 0 };
+            }
+            ::std::size_t i = 0;
+            while (i < size) {
+                switch (token_) {
+                    case token::NONE: {
+                        const char c = begin[i];
+                        if ('0' <= c && c <= '9') {
+                            token_ = token::STR_SIZE;
+                            digits_ = digits::NONE;
+                            sign_ = +1;
+                            str_size_ = 0;
+                            continue;
+                        }
+                        if (c == 'e' && !stack_.empty()) {
+                            ++i;
+                            if (stack_.back().has_key) {
+                                return fail(errors::expecting_value_error, i);
+                            }
+                            BasicData container = ::std::move(stack_.back().container);
+                            stack_.pop_back();
+                            finish(::std::move(container));
+                            if (state_ == status::DONE) {
+                                return { state_, i };
+                            }
+                            continue;
+                        }
+                        if (expecting_key()) {
+                            return fail(errors::expecting_value_error, i);
+                        }
+                        switch (c) {
+                            case 'i':
+                                // int "ixxxe"
+                                token_ = token::INT;
+                                digits_ = digits::NONE;
+                                sign_ = +1;
+                                int_value_ = int_type(0);
+                                break;
+                            case 'l':
+                                // list "lxxxe"
+                                stack_.push_back({
+                                    BasicData::template allocate<DataTag::LIST>(alloc_, helpers::detail::construct_with_allocator<list_type>(alloc_)),
+                                    false, ::std::string(), false
+                                });
+                                break;
+                            case 'd':
+                                // dict "dxxxe"
+                                stack_.push_back({
+                                    BasicData::template allocate<DataTag::DICT>(alloc_, helpers::detail::construct_with_allocator<dict_type>(alloc_)),
+                                    false, ::std::string(), false
+                                });
+                                break;
+                            default:
+                                return fail(errors::unknown_value_error, i);
+                        }
+                        ++i;
+                        continue;
+                    }
+                    case token::INT: {
+                        const char c = begin[i++];
+                        if (c == 'e' && (digits_ == digits::ZERO || digits_ == digits::SOME)) {
+                            token_ = token::NONE;
+                            finish(BasicData::template allocate<DataTag::INT>(alloc_, int_value_));
+                            if (state_ == status::DONE) {
+                                return { state_, i };
+                            }
+                            continue;
+                        }
+                        if (c == '-' && digits_ == digits::NONE) {
+                            digits_ = digits::SIGN;
+                            sign_ = -1;
+                            continue;
+                        }
+                        const decoding_error* const error = read_digit(int_value_, c);
+                        if (error != nullptr) {
+                            return fail(*error, i);
+                        }
+                        digits_ = (c == '0' && digits_ == digits::NONE) ? digits::ZERO : digits::SOME;
+                        continue;
+                    }
+                    case token::STR_SIZE: {
+                        const char c = begin[i++];
+                        if (c == ':' && (digits_ == digits::ZERO || digits_ == digits::SOME)) {
+                            token_ = token::STR;
+                            str_.clear();
+                            // The size came from the peer, so only reserve what has arrived. `append` grows the rest.
+                            str_.reserve(str_size_ < size - i ? str_size_ : size - i);
+                            if (str_size_ != 0) {
+                                continue;
+                            }
+                        } else {
+                            const decoding_error* const error = read_digit(str_size_, c);
+                            if (error != nullptr) {
+                                return fail(*error, i);
+                            }
+                            digits_ = (c == '0' && digits_ == digits::NONE) ? digits::ZERO : digits::SOME;
+                            continue;
+                        }
+                        // An empty string is already finished
+                    }
+                    // fall through
+                    case token::STR: {
+                        const ::std::size_t remaining = str_size_ - str_.size();
+                        const ::std::size_t available = size - i < remaining ? size - i : remaining;
+                        str_.append(begin + i, available);
+                        i += available;
+                        if (str_.size() == str_size_) {
+                            token_ = token::NONE;
+                            const decoding_error* const error = finish_str();
+                            if (error != nullptr) {
+                                return fail(*error, i);
+                            }
+                            if (state_ == status::DONE) {
+                                return { state_, i };
+                            }
+                        }
+                        continue;
+                    }
+                }
+            }
+            return { state_, i };
+        }
+
+        template<typename T>
+        feed_result feed(const T* const begin, const ::std::size_t size) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            return feed(reinterpret_cast<const char*>(begin), size);
+        }
+
+        template<typename T, typename... Rest>
+        feed_result feed(const ::std::basic_string<T, Rest...>& s) {
+            return feed<T>(s.data(), s.size());
+        }
+    };
+
+    using push_decoder = basic_push_decoder<>;
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_PUSH_DECODER_H_
@@ -0,0 +1,190 @@
+#ifndef TORREBIS_BENCODE_READERS_H_
+#define TORREBIS_BENCODE_READERS_H_
+
+#include <cstddef>
+#include <cstring>
+#include <istream>
+#include <streambuf>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "torrebis_bencode/errors.h"
+
+
+namespace torrebis { namespace bencode {
+    namespace helpers {
+        namespace detail {
+            // Reads an integer from `begin[i:size]`, up to and including the character `end`.
+            // If `first` is not `nullptr`, it is the already consumed first character.
+            template<typename IntType, typename T>
+            static IntType pointer_read_int(const T* const begin, ::std::size_t& i, const ::std::size_t size, const char end, const char* const first) {
+                char first_char;
+                if (first == nullptr) {
+                    if (i >= size) {
+                        throw errors::expecting_int_error.copy();
+                    }
+                    first_char = static_cast<char>(begin[i++]);
+                } else {
+                    first_char = *first;
+                }
+                if (first_char == '0') {
+                    if (i >= size || static_cast<char>(begin[i++]) != end) {
+                        throw errors::expecting_int_error.copy();
+                    }
+                    return IntType(0);
+                }
+                int sign = +1;
+                if (first_char == '-' && !::std::is_unsigned<IntType>::value) {
+                    sign = -1;
+                    if (i >= size) {
+                        throw errors::expecting_int_error.copy();
+                    }
+                    first_char = static_cast<char>(begin[i++]);
+                }
+                if (!('1' <= first_char && first_char <= '9')) {
+                    throw errors::expecting_int_error.copy();
+                }
+                IntType res = IntType(static_cast<int>(sign * static_cast<int>(first_char - '0')));
+                while (true) {
+                    if (i >= size) {
+                        throw errors::expecting_int_error.copy();
+                    }
+                    const char next_char = static_cast<char>(begin[i++]);
+                    if (!('0' <= next_char && next_char <= '9')) {
+                        if (next_char == end) {
+                            break;
+                        }
+                        throw errors::expecting_int_error.copy();
+                    }
+                    IntType previous_res = res;
+                    res = res * IntType(10) + IntType(static_cast<int>(sign * static_cast<int>(next_char - '0')));
+                    if ((previous_res < res) != (sign > 0)) {
+                        throw errors::integer_overflow_error.copy();
+                    }
+                }
+                return res;
+            }
+
+            // Reads a string from `begin[i:size]`, returning where it starts and how long it is.
+            inline ::std::pair<const char*, ::std::size_t> pointer_read_str_fast(const char* const begin, ::std::size_t& i, const ::std::size_t size, const char* const first) {
+                ::std::size_t str_size = pointer_read_int<::std::size_t, char>(begin, i, size, ':', first);
+                const char* str_begin = begin + i;
+                if (str_size > size - i) {
+                    throw errors::cut_off_str_error.copy();
+                }
+                i += str_size;
+                return  { str_begin, str_size };
+            }
+
+            // Moves `i` just past the value that starts at `begin[i]`, without decoding it. Strings are jumped over by
+            // their length and ints are not read, so only enough is checked to find where the value ends.
+            inline void pointer_skip_value(const char* const begin, ::std::size_t& i, const ::std::size_t size) {
+                ::std::size_t depth = 0;
+                do {
+                    if (i >= size) {
+                        throw errors::expecting_value_error.copy();
+                    }
+                    switch (begin[i]) {
+                        case 'i': {
+                            // int "ixxxe"
+                            const void* const end = ::std::memchr(begin + i, 'e', size - i);
+                            if (end == nullptr) {
+                                throw errors::expecting_int_error.copy();
+                            }
+                            i = static_cast<::std::size_t>(static_cast<const char*>(end) - begin) + 1;
+                            break;
+                        }
+                        case 'l':
+                        case 'd':
+                            // list "lxxxe" or dict "dxxxe"
+                            ++i;
+                            ++depth;
+                            break;
+                        case 'e':
+                            if (depth == 0) {
+                                throw errors::expecting_value_error.copy();
+                            }
+                            ++i;
+                            --depth;
+                            break;
+                        case '0': case '1': case '2':
+                        case '3': case '4': case '5':
+                        case '6': case '7': case '8':
+                        case '9':
+                            // str "yy:xxxx"
+                            pointer_read_str_fast(begin, i, size, nullptr);
+                            break;
+                        default:
+                            throw errors::unknown_value_error.copy();
+                    }
+                } while (depth != 0);
+            }
+
+            // Reads from a stream buffer a chunk at a time, instead of one `is.read` per byte.
+            template<class T, class Traits>
+            class stream_window final {
+            private:
+                ::std::basic_streambuf<T, Traits>* const buf_;
+                ::std::vector<T> window_;
+                ::std::size_t pos_;
+                ::std::size_t end_;
+
+                bool fill() {
+                    pos_ = 0;
+                    end_ = static_cast<::std::size_t>(buf_->sgetn(window_.data(), static_cast<::std::streamsize>(window_.size())));
+                    return end_ != 0;
+                }
+            public:
+                stream_window(::std::basic_streambuf<T, Traits>* const buf, const ::std::size_t buffer_size) :
+                    buf_(buf), window_(buffer_size == 0 ? 1 : buffer_size), pos_(0), end_(0) {}
+
+                ::std::size_t buffer_size() const noexcept { return window_.size(); }
+
+                // Reads the next byte into `out`, returning false at the end of the stream.
+                bool next(T& out) {
+                    if (pos_ == end_ && !fill()) {
+                        return false;
+                    }
+                    out = window_[pos_++];
+                    return true;
+                }
+
+                // Reads `size` bytes into `out`. Reads straight from the stream buffer when it would take more than a window.
+                bool read(T* out, ::std::size_t size) {
+                    ::std::size_t available = end_ - pos_;
+                    if (available >= size) {
+                        Traits::copy(out, window_.data() + pos_, size);
+                        pos_ += size;
+                        return true;
+                    }
+                    Traits::copy(out, window_.data() + pos_, available);
+                    out += available;
+                    size -= available;
+                    pos_ = end_ = 0;
+                    if (size >= window_.size()) {
+                        return static_cast<::std::size_t>(buf_->sgetn(out, static_cast<::std::streamsize>(size))) == size;
+                    }
+                    while (size > 0) {
+                        if (!fill()) {
+                            return false;
+                        }
+                        available = size < end_ ? size : end_;
+                        Traits::copy(out, window_.data(), available);
+                        pos_ = available;
+                        out += available;
+                        size -= available;
+                    }
+                    return true;
+                }
+
+                // Whether everything in the stream has been read.
+                bool at_end() {
+                    return pos_ == end_ && Traits::eq_int_type(buf_->sgetc(), Traits::eof());
+                }
+            };
+        }  // namespace torrebis::bencode::helpers::detail  (Private)
+    }  // namespace torrebis::bencode::helpers
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_READERS_H_
@@ -0,0 +1,112 @@
+#ifndef TORREBIS_BENCODE_STR_VIEW_H_
+#define TORREBIS_BENCODE_STR_VIEW_H_
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+#include "torrebis_bencode/helpers.h"
+
+#ifdef TORREBIS_HAS_STRING_VIEW
+#include <string_view>
+#endif
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * A non-owning view over a string of bytes, used as the `StrType` of `data_view`.
+     * A view borrows from the buffer it was made from, which must outlive it.
+     */
+    template<class T = char, class Traits = ::std::char_traits<T>>
+    class basic_str_view final {
+    public:
+        using traits_type = Traits;
+        using value_type = T;
+        using size_type = ::std::size_t;
+        using difference_type = ::std::ptrdiff_t;
+        using const_pointer = const T*;
+        using const_reference = const T&;
+        using const_iterator = const T*;
+        using iterator = const_iterator;
+    private:
+        const T* data_;
+        size_type size_;
+    public:
+        constexpr basic_str_view() noexcept : data_(nullptr), size_(0) {}
+        constexpr basic_str_view(const T* const data, const size_type size) noexcept : data_(data), size_(size) {}
+        basic_str_view(const T* const c_str) noexcept : data_(c_str), size_(Traits::length(c_str)) {}
+        template<class Allocator>
+        basic_str_view(const ::std::basic_string<T, Traits, Allocator>& s) noexcept : data_(s.data()), size_(s.size()) {}
+#ifdef TORREBIS_HAS_STRING_VIEW
+        constexpr basic_str_view(const ::std::basic_string_view<T, Traits> s) noexcept : data_(s.data()), size_(s.size()) {}
+        constexpr operator ::std::basic_string_view<T, Traits>() const noexcept { return { data_, size_ }; }
+#endif
+
+        constexpr const T* data() const noexcept { return data_; }
+        constexpr size_type size() const noexcept { return size_; }
+        constexpr size_type length() const noexcept { return size_; }
+        constexpr bool empty() const noexcept { return size_ == 0; }
+
+        constexpr const_iterator begin() const noexcept { return data_; }
+        constexpr const_iterator end() const noexcept { return data_ + size_; }
+        constexpr const_iterator cbegin() const noexcept { return data_; }
+        constexpr const_iterator cend() const noexcept { return data_ + size_; }
+
+        constexpr const_reference operator[](const size_type i) const noexcept { return data_[i]; }
+        constexpr const_reference front() const noexcept { return data_[0]; }
+        constexpr const_reference back() const noexcept { return data_[size_ - 1]; }
+
+        int compare(const basic_str_view other) const noexcept {
+            const int cmp = size_ < other.size_
+                ? Traits::compare(data_, other.data_, size_)
+                : Traits::compare(data_, other.data_, other.size_);
+            if (cmp != 0) {
+                return cmp;
+            }
+            return size_ == other.size_ ? 0 : (size_ < other.size_ ? -1 : +1);
+        }
+
+        template<class Allocator = ::std::allocator<T>>
+        ::std::basic_string<T, Traits, Allocator> to_string() const {
+            return ::std::basic_string<T, Traits, Allocator>(data_, size_);
+        }
+
+        template<class Allocator>
+        explicit operator ::std::basic_string<T, Traits, Allocator>() const {
+            return ::std::basic_string<T, Traits, Allocator>(data_, size_);
+        }
+
+        bool operator==(const basic_str_view other) const noexcept { return size_ == other.size_ && Traits::compare(data_, other.data_, size_) == 0; }
+        bool operator!=(const basic_str_view other) const noexcept { return !operator==(other); }
+        bool operator<(const basic_str_view other) const noexcept { return compare(other) < 0; }
+        bool operator<=(const basic_str_view other) const noexcept { return compare(other) <= 0; }
+        bool operator>(const basic_str_view other) const noexcept { return compare(other) > 0; }
+        bool operator>=(const basic_str_view other) const noexcept { return compare(other) >= 0; }
+    };
+
+    using str_view = basic_str_view<>;
+
+    namespace helpers {
+        namespace detail {
+            template<class CharT, class Traits>
+            struct has_char_t<CharT, basic_str_view<CharT, Traits>> : ::std::true_type {};
+
+            // Whether a `StrType` refers to the buffer it was decoded from instead of owning a copy.
+            template<class StrType>
+            struct is_borrowed_str : ::std::false_type {};
+
+            template<class CharT, class Traits>
+            struct is_borrowed_str<basic_str_view<CharT, Traits>> : ::std::true_type {};
+
+#ifdef TORREBIS_HAS_STRING_VIEW
+            template<class CharT, class Traits>
+            struct has_char_t<CharT, ::std::basic_string_view<CharT, Traits>> : ::std::true_type {};
+
+            template<class CharT, class Traits>
+            struct is_borrowed_str<::std::basic_string_view<CharT, Traits>> : ::std::true_type {};
+#endif
+        }  // namespace torrebis::bencode::helpers::detail  (Private)
+    }  // namespace torrebis::bencode::helpers
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_STR_VIEW_H_
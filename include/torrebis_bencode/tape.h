@@ -0,0 +1,395 @@
+#ifndef TORREBIS_BENCODE_TAPE_H_
+#define TORREBIS_BENCODE_TAPE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "torrebis_bencode/helpers.h"
+#include "torrebis_bencode/str_view.h"
+#include "torrebis_bencode/errors.h"
+#include "torrebis_bencode/readers.h"
+#include "torrebis_bencode/type_tags.h"
+#include "torrebis_bencode/path_el.h"
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * A flat representation of some bencoded data. Every value is written to one contiguous tape of 64 bit words:
+     *
+     *     str:   [STR  | offset of the string in the buffer] [size]
+     *     int:   [INT]                                       [value]
+     *     list:  [LIST | index after the matching end] items...           [END | number of items]
+     *     dict:  [DICT | index after the matching end] key, value, ...    [END | number of keys]
+     *
+     * The tag is the top 8 bits of a word and the payload is the other 56. Strings borrow from the
+     * buffer that was parsed, which must outlive the tape.
+     */
+    class tape final {
+    public:
+        using word_type = ::std::uint64_t;
+        using int_type = ::std::int64_t;
+        using str_type = str_view;
+        using path_el_type = basic_path_el<str_type>;
+
+        class value;
+        class iterator;
+        class item_iterator;
+        struct item_range;
+    private:
+        enum : unsigned { tag_shift = 56 };
+        enum : ::std::uint8_t { end_tag = 4 };
+
+        const char* buffer_;
+        ::std::vector<word_type> words_;
+
+        tape(const char* const buffer) noexcept : buffer_(buffer) {}
+
+        static word_type make_word(const ::std::uint8_t tag, const word_type payload) noexcept {
+            return (static_cast<word_type>(tag) << tag_shift) | payload;
+        }
+        static word_type make_word(const DataTag tag, const word_type payload) noexcept {
+            return make_word(static_cast<::std::uint8_t>(tag), payload);
+        }
+        ::std::uint8_t tag_at(const ::std::size_t index) const noexcept {
+            return static_cast<::std::uint8_t>(words_[index] >> tag_shift);
+        }
+        word_type payload_at(const ::std::size_t index) const noexcept {
+            return words_[index] & ((word_type(1) << tag_shift) - 1);
+        }
+        // The index of the value after the one at `index`.
+        ::std::size_t skip(const ::std::size_t index) const noexcept {
+            switch (static_cast<DataTag>(tag_at(index))) {
+                case DataTag::LIST:
+                case DataTag::DICT:
+                    return payload_at(index);
+                default:
+                    return index + 2;
+            }
+        }
+
+        void push_str(const ::std::pair<const char*, ::std::size_t> begin_size) {
+            words_.push_back(make_word(DataTag::STR, static_cast<word_type>(begin_size.first - buffer_)));
+            words_.push_back(begin_size.second);
+        }
+
+        void parse_loop(::std::size_t& i, const ::std::size_t size) {
+            if (i >= size) {
+                throw errors::expecting_value_error.copy();
+            }
+            switch (buffer_[i]) {
+                case 'i': {
+                    // int "ixxxe"
+                    ++i;
+                    const int_type int_value = helpers::detail::pointer_read_int<int_type, char>(buffer_, i, size, 'e', nullptr);
+                    words_.push_back(make_word(DataTag::INT, 0));
+                    words_.push_back(static_cast<word_type>(int_value));
+                    return;
+                }
+                case 'l':
+                case 'd': {
+                    // list "lxxxe" or dict "dxxxe"
+                    const DataTag tag = buffer_[i] == 'l' ? DataTag::LIST : DataTag::DICT;
+                    ++i;
+                    const ::std::size_t start = words_.size();
+                    words_.push_back(make_word(tag, 0));
+                    word_type count = 0;
+                    const char* last_key_begin = nullptr;
+                    ::std::size_t last_key_size = 0;
+                    while (true) {
+                        if (i >= size) {
+                            throw errors::expecting_value_error.copy();
+                        }
+                        if (buffer_[i] == 'e') {
+                            break;
+                        }
+                        if (tag == DataTag::DICT) {
+                            auto key = helpers::detail::pointer_read_str_fast(buffer_, i, size, nullptr);
+                            if (last_key_begin != nullptr) {
+                                if (!helpers::detail::key_less_than(last_key_begin, last_key_size, key.first, key.second)) {
+                                    throw errors::key_order_error.copy();
+                                }
+                            }
+                            last_key_begin = key.first;
+                            last_key_size = key.second;
+                            push_str(key);
+                        }
+                        parse_loop(i, size);
+                        ++count;
+                    }
+                    ++i;
+                    words_.push_back(make_word(end_tag, count));
+                    words_[start] = make_word(tag, words_.size());
+                    return;
+                }
+                case '0': case '1': case '2': case '3': case '4':
+                case '5': case '6': case '7': case '8': case '9':
+                    // str "yy:xxxx"
+                    push_str(helpers::detail::pointer_read_str_fast(buffer_, i, size, nullptr));
+                    return;
+                default:
+                    throw errors::unknown_value_error.copy();
+            }
+        }
+
+    public:
+        tape(const tape& other) = default;
+        tape(tape&& other) noexcept : buffer_(other.buffer_), words_(::std::move(other.words_)) {}
+        tape& operator=(const tape& other) = default;
+        tape& operator=(tape&& other) noexcept { buffer_ = other.buffer_; words_ = ::std::move(other.words_); return *this; }
+
+        static tape parse(const char* const begin, const ::std::size_t size) {
+            tape result(begin);
+            // Every value takes 2 words for at least 2 bytes ("0:", "le"), so a tape never needs more than `size`
+            // words. Reserving an eighth of that is enough for buffers dominated by long strings, and with the
+            // vector's doubling costs at most 3 more allocations for ones made only of short values.
+            result.words_.reserve(size / sizeof(word_type) + 2);
+            ::std::size_t i = 0;
+            result.parse_loop(i, size);
+            if (i != size) {
+                throw errors::early_end_error.copy();
+            }
+            return result;
+        }
+
+        template<typename T>
+        static tape parse(const T* const begin, const ::std::size_t size) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            return parse(reinterpret_cast<const char*>(begin), size);
+        }
+
+        template<typename T, typename... Rest>
+        static tape parse(const ::std::basic_string<T, Rest...>& s) {
+            return parse<T>(s.data(), s.size());
+        }
+
+        template<typename T, typename... Rest>
+        static tape parse(const ::std::basic_string<T, Rest...>&& s) = delete;
+
+        template<typename T, typename... Rest>
+        static tape parse(const ::std::vector<T, Rest...>& v) {
+            return parse<T>(v.data(), v.size());
+        }
+
+        template<typename T, typename... Rest>
+        static tape parse(const ::std::vector<T, Rest...>&& v) = delete;
+
+        const char* buffer() const noexcept { return buffer_; }
+        const ::std::vector<word_type>& words() const noexcept { return words_; }
+
+        value root() const noexcept;
+
+        /*
+         * A reference to a single value on a tape. Cheap to copy; only valid while the tape is.
+         */
+        class value final {
+        private:
+            friend class tape;
+            friend class iterator;
+            friend class item_iterator;
+
+            const tape* tape_;
+            ::std::size_t index_;
+
+            value(const tape* const t, const ::std::size_t index) noexcept : tape_(t), index_(index) {}
+
+            // The index of the matching END word of a list or dict.
+            ::std::size_t end_index() const noexcept { return tape_->skip(index_) - 1; }
+        public:
+            value() noexcept : tape_(nullptr), index_(0) {}
+
+            bool operator==(const value& other) const noexcept { return tape_ == other.tape_ && index_ == other.index_; }
+            bool operator!=(const value& other) const noexcept { return !operator==(other); }
+            explicit operator bool() const noexcept { return tape_ != nullptr; }
+            bool operator!() const noexcept { return tape_ == nullptr; }
+
+            DataTag get_tag() const noexcept {
+                return tape_ == nullptr ? DataTag::UNINITIALISED : static_cast<DataTag>(tape_->tag_at(index_));
+            }
+
+            bool is_valid() const noexcept { return tape_ != nullptr; }
+            bool is_str() const noexcept { return get_tag() == DataTag::STR; }
+            bool is_int() const noexcept { return get_tag() == DataTag::INT; }
+            bool is_list() const noexcept { return get_tag() == DataTag::LIST; }
+            bool is_dict() const noexcept { return get_tag() == DataTag::DICT; }
+
+            // Where this value is on the tape.
+            ::std::size_t index() const noexcept { return index_; }
+
+            // The value of an int, or 0 if this is not an int.
+            int_type get_int() const noexcept {
+                return is_int() ? static_cast<int_type>(tape_->words_[index_ + 1]) : 0;
+            }
+
+            // The value of a str, or an empty view if this is not a str.
+            str_type get_str() const noexcept {
+                if (!is_str()) {
+                    return str_type();
+                }
+                return str_type(
+                    tape_->buffer_ + tape_->payload_at(index_),
+                    tape_->words_[index_ + 1]
+                );
+            }
+
+            // The number of items in a list or keys in a dict, otherwise 0.
+            ::std::size_t size() const noexcept {
+                if (!is_list() && !is_dict()) {
+                    return 0;
+                }
+                return tape_->payload_at(end_index());
+            }
+
+            // Iterate over the items of a list.
+            iterator begin() const noexcept;
+            iterator end() const noexcept;
+
+            // Iterate over the (key, value) pairs of a dict.
+            item_range items() const noexcept;
+
+            // The item at index `i` of a list, or an invalid value if out of range or not a list.
+            value operator[](::std::size_t i) const noexcept {
+                if (!is_list()) {
+                    return value();
+                }
+                const ::std::size_t end = end_index();
+                ::std::size_t index = index_ + 1;
+                for (; i > 0 && index < end; --i) {
+                    index = tape_->skip(index);
+                }
+                return index < end ? value(tape_, index) : value();
+            }
+
+            // The value for `key` in a dict, or an invalid value if missing or not a dict.
+            value find(const str_type key) const noexcept {
+                if (!is_dict()) {
+                    return value();
+                }
+                const ::std::size_t end = end_index();
+                ::std::size_t index = index_ + 1;
+                while (index < end) {
+                    const str_type k = value(tape_, index).get_str();
+                    if (k == key) {
+                        return value(tape_, index + 2);
+                    }
+                    if (key < k) {
+                        // Keys are sorted, so it can't be further on.
+                        break;
+                    }
+                    index = tape_->skip(index + 2);
+                }
+                return value();
+            }
+
+            value get_path() const noexcept { return *this; }
+
+            template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+            value get_path(PathEls... path) const {
+                value result = *this;
+                const path_el_type path_arr[sizeof...(path)] = { path_el_type(path)... };
+                for (::std::size_t i = 0; i < sizeof...(path) && result; ++i) {
+                    const path_el_type& path_i = path_arr[i];
+                    if (path_i.is_key()) {
+                        result = result.find(*path_i.get_key());
+                    } else if (path_i.is_index()) {
+                        result = result[path_i.get_index()];
+                    } else {
+                        return value();
+                    }
+                }
+                return result;
+            }
+        };
+
+        class iterator final {
+        private:
+            friend class value;
+            value current_;
+
+            iterator(const tape* const t, const ::std::size_t index) noexcept : current_(t, index) {}
+        public:
+            using iterator_category = ::std::forward_iterator_tag;
+            using value_type = tape::value;
+            using difference_type = ::std::ptrdiff_t;
+            using pointer = const value*;
+            using reference = const value&;
+
+            iterator() noexcept = default;
+
+            reference operator*() const noexcept { return current_; }
+            pointer operator->() const noexcept { return &current_; }
+            iterator& operator++() noexcept { current_.index_ = current_.tape_->skip(current_.index_); return *this; }
+            iterator operator++(int) noexcept { iterator old = *this; ++*this; return old; }
+            bool operator==(const iterator& other) const noexcept { return current_ == other.current_; }
+            bool operator!=(const iterator& other) const noexcept { return current_ != other.current_; }
+        };
+
+        class item_iterator final {
+        private:
+            friend class value;
+            ::std::pair<str_type, value> current_;
+
+            item_iterator(const tape* const t, const ::std::size_t index) noexcept : current_(str_type(), value(t, index)) {
+                load();
+            }
+            void load() noexcept {
+                // `current_.second` holds the key's index until it is loaded.
+                const value key = current_.second;
+                if (static_cast<DataTag>(key.tape_->tag_at(key.index_)) == DataTag::STR) {
+                    current_.first = key.get_str();
+                    current_.second.index_ = key.index_ + 2;
+                }
+            }
+        public:
+            using iterator_category = ::std::forward_iterator_tag;
+            using value_type = ::std::pair<str_type, value>;
+            using difference_type = ::std::ptrdiff_t;
+            using pointer = const value_type*;
+            using reference = const value_type&;
+
+            item_iterator() noexcept = default;
+
+            reference operator*() const noexcept { return current_; }
+            pointer operator->() const noexcept { return &current_; }
+            item_iterator& operator++() noexcept {
+                current_.second.index_ = current_.second.tape_->skip(current_.second.index_);
+                load();
+                return *this;
+            }
+            item_iterator operator++(int) noexcept { item_iterator old = *this; ++*this; return old; }
+            bool operator==(const item_iterator& other) const noexcept { return current_.second == other.current_.second; }
+            bool operator!=(const item_iterator& other) const noexcept { return current_.second != other.current_.second; }
+        };
+
+        struct item_range {
+            item_iterator begin_;
+            item_iterator end_;
+
+            item_iterator begin() const noexcept { return begin_; }
+            item_iterator end() const noexcept { return end_; }
+        };
+    };
+
+    inline tape::value tape::root() const noexcept { return words_.empty() ? value() : value(this, 0); }
+
+    inline tape::iterator tape::value::begin() const noexcept {
+        return is_list() ? iterator(tape_, index_ + 1) : iterator();
+    }
+
+    inline tape::iterator tape::value::end() const noexcept {
+        return is_list() ? iterator(tape_, end_index()) : iterator();
+    }
+
+    inline tape::item_range tape::value::items() const noexcept {
+        if (!is_dict()) {
+            return { item_iterator(), item_iterator() };
+        }
+        return { item_iterator(tape_, index_ + 1), item_iterator(tape_, end_index()) };
+    }
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_TAPE_H_
@@ -7,11 +7,24 @@
 #define TORREBIS_BENCODE_VERSION_PATCH 0
 
 #include "torrebis_bencode/helpers.h"
+#include "torrebis_bencode/str_view.h"
 #include "torrebis_bencode/errors.h"
+#include "torrebis_bencode/readers.h"
+#include "torrebis_bencode/writers.h"
+#include "torrebis_bencode/gather.h"
+#include "torrebis_bencode/encoder.h"
 #include "torrebis_bencode/type_tags.h"
 #include "torrebis_bencode/path_el.h"
+#include "torrebis_bencode/flat_dict.h"
+#include "torrebis_bencode/arena.h"
+#include "torrebis_bencode/key_table.h"
 #include "torrebis_bencode/data_class.h"
 #include "torrebis_bencode/visitors.h"
+#include "torrebis_bencode/tape.h"
+#include "torrebis_bencode/push_decoder.h"
+#include "torrebis_bencode/events.h"
+#include "torrebis_bencode/cursor.h"
+#include "torrebis_bencode/compact_data.h"
 
 
 #endif  // TORREBIS_BENCODE_TORREBIS_BENCODE_H_
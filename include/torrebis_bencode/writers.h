@@ -0,0 +1,298 @@
+#ifndef TORREBIS_BENCODE_WRITERS_H_
+#define TORREBIS_BENCODE_WRITERS_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+#include "torrebis_bencode/helpers.h"
+
+
+namespace torrebis { namespace bencode {
+    namespace helpers {
+        namespace detail {
+            // "00", "01", ..., "99", so two digits can be written at a time.
+            inline const char* digit_pairs() noexcept {
+                static const char pairs[] =
+                    "00010203040506070809"
+                    "10111213141516171819"
+                    "20212223242526272829"
+                    "30313233343536373839"
+                    "40414243444546474849"
+                    "50515253545556575859"
+                    "60616263646566676869"
+                    "70717273747576777879"
+                    "80818283848586878889"
+                    "90919293949596979899";
+                return pairs;
+            }
+
+            // Built in integers are formatted through their unsigned type, anything else (like a big integer class)
+            // only needs comparisons, `/`, `%` and a conversion to `int`.
+            template<class IntType>
+            struct is_builtin_int : ::std::integral_constant<bool,
+                ::std::is_integral<IntType>::value && !::std::is_same<IntType, bool>::value> {};
+
+            template<class IntType>
+            bool is_negative_(const IntType i, ::std::true_type) noexcept { return i < IntType(0); }
+
+            template<class IntType>
+            bool is_negative_(const IntType, ::std::false_type) noexcept { return false; }
+
+            template<class Unsigned>
+            using wide_unsigned = typename ::std::conditional<(sizeof(Unsigned) > sizeof(unsigned long long)), Unsigned, unsigned long long>::type;
+
+            // The number of digits in `u`, by comparing instead of dividing when it fits in 64 bits.
+            inline ::std::size_t digits64(const unsigned long long u) noexcept {
+                static const unsigned long long powers[] = {
+                    10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+                    1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+                    100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+                    1000000000000000000ull, 10000000000000000000ull
+                };
+                ::std::size_t digits = 1;
+                for (const unsigned long long power : powers) {
+                    digits += (u >= power);
+                }
+                return digits;
+            }
+
+            template<class Unsigned>
+            ::std::size_t unsigned_digits(const Unsigned u) noexcept {
+                TORREBIS_CONSTEXPR_IF (sizeof(Unsigned) <= sizeof(unsigned long long)) {
+                    return digits64(static_cast<unsigned long long>(u));
+                }
+                wide_unsigned<Unsigned> v = u;
+                ::std::size_t digits = 1;
+                while (v >= 10000) {
+                    v /= 10000;
+                    digits += 4;
+                }
+                return digits + (v >= 10) + (v >= 100) + (v >= 1000);
+            }
+
+            // Writes the digits of `u` so that the last one is just before `end`.
+            template<class Unsigned, class T>
+            void write_unsigned_backwards(const Unsigned u, T* end) noexcept {
+                const char* const pairs = digit_pairs();
+                wide_unsigned<Unsigned> v = u;
+                while (v >= 100) {
+                    const ::std::size_t pair = static_cast<::std::size_t>(v % 100) * 2;
+                    v /= 100;
+                    *--end = static_cast<T>(pairs[pair + 1]);
+                    *--end = static_cast<T>(pairs[pair]);
+                }
+                if (v >= 10) {
+                    const ::std::size_t pair = static_cast<::std::size_t>(v) * 2;
+                    *--end = static_cast<T>(pairs[pair + 1]);
+                    *--end = static_cast<T>(pairs[pair]);
+                } else {
+                    *--end = static_cast<T>('0' + static_cast<char>(v));
+                }
+            }
+
+            template<class IntType>
+            typename ::std::make_unsigned<IntType>::type magnitude_(const IntType i, const bool negative) noexcept {
+                using unsigned_type = typename ::std::make_unsigned<IntType>::type;
+                // Negated as unsigned, so the smallest value doesn't overflow
+                return negative ? static_cast<unsigned_type>(unsigned_type(0) - static_cast<unsigned_type>(i)) : static_cast<unsigned_type>(i);
+            }
+
+            template<class IntType>
+            ::std::size_t int_size_(const IntType i, ::std::true_type) noexcept {
+                const bool negative = is_negative_(i, ::std::is_signed<IntType>());
+                return static_cast<::std::size_t>(negative) + unsigned_digits(magnitude_(i, negative));
+            }
+
+            template<class IntType>
+            ::std::size_t int_size_(IntType i, ::std::false_type) {
+                ::std::size_t size = i < IntType(0) ? 2 : 1;
+                while (i <= IntType(-100) || IntType(100) <= i) {
+                    i /= IntType(100);
+                    size += 2;
+                }
+                return size + static_cast<::std::size_t>(i <= IntType(-10) || IntType(10) <= i);
+            }
+
+            // How many characters `i` is in decimal, including a '-'.
+            template<class IntType>
+            ::std::size_t int_size(const IntType i) { return int_size_(i, is_builtin_int<IntType>()); }
+
+            template<class IntType, class T>
+            T* write_int_(const IntType i, T* const out, ::std::true_type) noexcept {
+                const bool negative = is_negative_(i, ::std::is_signed<IntType>());
+                const auto u = magnitude_(i, negative);
+                if (negative) {
+                    *out = static_cast<T>('-');
+                }
+                T* const end = out + static_cast<::std::size_t>(negative) + unsigned_digits(u);
+                write_unsigned_backwards(u, end);
+                return end;
+            }
+
+            template<class IntType, class T>
+            T* write_int_(IntType i, T* const out, ::std::false_type) {
+                const char* const pairs = digit_pairs();
+                T* const end = out + int_size(i);
+                T* p = end;
+                const bool negative = i < IntType(0);
+                // Digits are taken from a negative number without negating it, which could overflow
+                while (i <= IntType(-100) || IntType(100) <= i) {
+                    int pair = static_cast<int>(i % IntType(100));
+                    i /= IntType(100);
+                    pair = (pair < 0 ? -pair : pair) * 2;
+                    *--p = static_cast<T>(pairs[pair + 1]);
+                    *--p = static_cast<T>(pairs[pair]);
+                }
+                int last = static_cast<int>(i);
+                last = last < 0 ? -last : last;
+                if (last >= 10) {
+                    *--p = static_cast<T>(pairs[last * 2 + 1]);
+                    *--p = static_cast<T>(pairs[last * 2]);
+                } else {
+                    *--p = static_cast<T>('0' + static_cast<char>(last));
+                }
+                if (negative) {
+                    *--p = static_cast<T>('-');
+                }
+                return end;
+            }
+
+            // Writes `int_size(i)` characters of `i` in decimal to `out`, returning the end of them.
+            template<class IntType, class T>
+            T* write_int(const IntType i, T* const out) { return write_int_(i, out, is_builtin_int<IntType>()); }
+
+            // Built in integers are written to the stack first, so that `s` doesn't have to fill space it will overwrite.
+            template<class IntType, class T, class Traits, class Allocator>
+            void append_int_(const IntType i, ::std::basic_string<T, Traits, Allocator>& s, ::std::true_type) {
+                T buffer[::std::numeric_limits<IntType>::digits10 + 2];
+                s.append(buffer, write_int(i, buffer));
+            }
+
+            template<class IntType, class T, class Traits, class Allocator>
+            void append_int_(const IntType i, ::std::basic_string<T, Traits, Allocator>& s, ::std::false_type) {
+                const ::std::size_t old_size = s.size();
+                s.resize(old_size + int_size(i));
+                write_int(i, &s[old_size]);
+            }
+
+            // Appends `i` in decimal to `s`, growing it once.
+            template<class IntType, class T, class Traits, class Allocator>
+            void append_int(const IntType i, ::std::basic_string<T, Traits, Allocator>& s) {
+                append_int_(i, s, is_builtin_int<IntType>());
+            }
+
+            // Writes `i` in decimal to `out`, returning the iterator after it.
+            template<class IntType, class T>
+            T* copy_int(const IntType i, T* const out) { return write_int(i, out); }
+
+            template<class IntType, class OutputIt>
+            OutputIt copy_int(const IntType i, OutputIt out) {
+                TORREBIS_CONSTEXPR_IF (is_builtin_int<IntType>::value) {
+                    char buffer[::std::numeric_limits<IntType>::digits10 + 2];
+                    return ::std::copy(buffer, write_int(i, buffer), out);
+                }
+                ::std::string s;
+                append_int(i, s);
+                return ::std::copy(s.begin(), s.end(), out);
+            }
+
+            // The container of a `std::back_insert_iterator` (A protected member), so ranges can be inserted at once.
+            template<class Container>
+            Container& back_inserted_container(::std::back_insert_iterator<Container>& it) noexcept {
+                struct access : ::std::back_insert_iterator<Container> {
+                    static Container* get(::std::back_insert_iterator<Container>& i) noexcept { return i.*(&access::container); }
+                };
+                return *access::get(it);
+            }
+
+            template<class IntType, class Container>
+            ::std::back_insert_iterator<Container> copy_int(const IntType i, ::std::back_insert_iterator<Container> out) {
+                Container& c = back_inserted_container(out);
+                TORREBIS_CONSTEXPR_IF (is_builtin_int<IntType>::value) {
+                    char buffer[::std::numeric_limits<IntType>::digits10 + 2];
+                    c.insert(c.end(), buffer, write_int(i, buffer));
+                    return out;
+                }
+                ::std::string s;
+                append_int(i, s);
+                c.insert(c.end(), s.begin(), s.end());
+                return out;
+            }
+
+            template<class T, class Str>
+            T* copy_chars_(const Str& str, T* const out, ::std::true_type) noexcept {
+                const ::std::size_t size = str.size();
+                if (size != 0) {
+                    ::std::memcpy(out, str.data(), size);
+                }
+                return out + size;
+            }
+
+            template<class T, class Str>
+            T* copy_chars_(const Str& str, T* out, ::std::false_type) {
+                for (const auto byte : str) {
+                    *out++ = static_cast<T>(static_cast<char>(byte));
+                }
+                return out;
+            }
+
+            // Writes the bytes of `str` to `out`, returning the iterator after them.
+            template<class Str, class T>
+            T* copy_chars(const Str& str, T* const out) { return copy_chars_(str, out, has_char_t<T, Str>()); }
+
+            template<class Str, class Container>
+            ::std::back_insert_iterator<Container> copy_chars(const Str& str, ::std::back_insert_iterator<Container> out) {
+                Container& c = back_inserted_container(out);
+                c.insert(c.end(), str.begin(), str.end());
+                return out;
+            }
+
+            template<class Str, class OutputIt>
+            OutputIt copy_chars(const Str& str, OutputIt out) {
+                for (const auto byte : str) {
+                    *out = static_cast<char>(byte);
+                    ++out;
+                }
+                return out;
+            }
+
+            template<class T, class Traits, class Allocator, class Str>
+            void append_chars_(::std::basic_string<T, Traits, Allocator>& s, const Str& str, ::std::true_type) { s.append(str.data(), str.size()); }
+
+            template<class T, class Traits, class Allocator, class Str>
+            void append_chars_(::std::basic_string<T, Traits, Allocator>& s, const Str& str, ::std::false_type) {
+                for (const auto byte : str) {
+                    s.push_back(static_cast<T>(static_cast<char>(byte)));
+                }
+            }
+
+            // Appends the bytes of `str` to `s`, converting each one if they aren't already `T`s.
+            template<class T, class Traits, class Allocator, class Str>
+            void append_chars(::std::basic_string<T, Traits, Allocator>& s, const Str& str) { append_chars_(s, str, has_char_t<T, Str>()); }
+
+            template<class T, class Traits, class Str>
+            void write_chars_(::std::basic_ostream<T, Traits>& os, const Str& str, ::std::true_type) {
+                os.write(str.data(), static_cast<::std::streamsize>(str.size()));
+            }
+
+            template<class T, class Traits, class Str>
+            void write_chars_(::std::basic_ostream<T, Traits>& os, const Str& str, ::std::false_type) {
+                for (const auto byte : str) {
+                    os.put(static_cast<T>(static_cast<char>(byte)));
+                }
+            }
+
+            // Writes the bytes of `str` to `os`, like `append_chars`.
+            template<class T, class Traits, class Str>
+            void write_chars(::std::basic_ostream<T, Traits>& os, const Str& str) { write_chars_(os, str, has_char_t<T, Str>()); }
+        }  // namespace torrebis::bencode::helpers::detail  (Private)
+    }  // namespace torrebis::bencode::helpers
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_WRITERS_H_
@@ -4,6 +4,11 @@
 #ifndef TORREBIS_BENCODE_TORREBIS_BENCODE_H_
 #define TORREBIS_BENCODE_TORREBIS_BENCODE_H_
 
+#define TORREBIS_BENCODE_VERSION "1.0.0"
+#define TORREBIS_BENCODE_VERSION_MAJOR 1
+#define TORREBIS_BENCODE_VERSION_MINOR 0
+#define TORREBIS_BENCODE_VERSION_PATCH 0
+
 
 // Expanding  #include "torrebis_bencode/helpers.h"
 // Various macros to enable stuff for newer C++ versions
@@ -13,6 +18,7 @@
 
 #include <type_traits>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <algorithm>
 #include <string>
@@ -23,6 +29,14 @@
 #if defined(__cplusplus) && __cplusplus >= 202000L
 // C++ 20 or higher
 #define TORREBIS_HAS_IS_NOTHROW_CONVERTIBLE
+
+#if defined(__has_include)
+#if __has_include(<span>)
+#define TORREBIS_HAS_SPAN
+#include <span>
+#endif
+#endif
+
 #else
 
 #endif
@@ -31,9 +45,17 @@
 // C++ 17 or higher
 #define TORREBIS_CONSTEXPR_IF if constexpr
 #define TORREBIS_STD_ARRAY_HAS_DATA
+#define TORREBIS_HAS_STRING_VIEW
 
 #include <array>
 
+#if defined(__has_include)
+#if __has_include(<memory_resource>)
+#define TORREBIS_HAS_MEMORY_RESOURCE
+#include <memory_resource>
+#endif
+#endif
+
 #else
 #define TORREBIS_CONSTEXPR_IF if
 #endif
@@ -41,6 +63,7 @@
 #if defined(__cplusplus) && __cplusplus >= 201402L
 // C++ 14 or higher
 #define TORREBIS_VARIABLE_TEMPLATES
+#define TORREBIS_HAS_HETEROGENEOUS_LOOKUP
 #else
 
 #endif
@@ -128,8 +151,8 @@ namespace torrebis { namespace bencode {
             template<class CharT, class StringT>
             struct has_char_t : ::std::false_type {};
 
-            template<class CharT, class CharTraits>
-            struct has_char_t<CharT, ::std::basic_string<CharT, CharTraits>> : ::std::true_type {};
+            template<class CharT, class CharTraits, class Allocator>
+            struct has_char_t<CharT, ::std::basic_string<CharT, CharTraits, Allocator>> : ::std::true_type {};
 
             template<class CharT, class... Rest>
             struct has_char_t<CharT, ::std::vector<CharT, Rest...>> : ::std::true_type {};
@@ -140,6 +163,26 @@ namespace torrebis { namespace bencode {
 #endif
 
 
+            // FNV-1a
+            inline ::std::uint64_t hash_bytes(const void* const bytes, const ::std::size_t size, ::std::uint64_t hash = 14695981039346656037ULL) noexcept {
+                const unsigned char* const s = static_cast<const unsigned char*>(bytes);
+                for (::std::size_t i = 0; i < size; ++i) {
+                    hash ^= s[i];
+                    hash *= 1099511628211ULL;
+                }
+                return hash;
+            }
+
+            // The finaliser of splitmix64, so that similar hashes end up far apart.
+            inline ::std::uint64_t hash_mix(::std::uint64_t hash) noexcept {
+                hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+                return hash ^ (hash >> 31);
+            }
+
+            inline ::std::uint64_t hash_combine(const ::std::uint64_t seed, const ::std::uint64_t hash) noexcept {
+                return hash_mix(seed ^ (hash + 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2)));
+            }
         }  // namespace torrebis::bencode::helpers::detail  (Private)
     }  // namespace torrebis::bencode::helpers
 } }  // namespace torrebis::bencode
@@ -148,6 +191,121 @@ namespace torrebis { namespace bencode {
 
 // Done expanding  #include "torrebis_bencode/helpers.h"
 
+// Expanding  #include "torrebis_bencode/str_view.h"
+#ifndef TORREBIS_BENCODE_STR_VIEW_H_
+#define TORREBIS_BENCODE_STR_VIEW_H_
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+
+#ifdef TORREBIS_HAS_STRING_VIEW
+#include <string_view>
+#endif
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * A non-owning view over a string of bytes, used as the `StrType` of `data_view`.
+     * A view borrows from the buffer it was made from, which must outlive it.
+     */
+    template<class T = char, class Traits = ::std::char_traits<T>>
+    class basic_str_view final {
+    public:
+        using traits_type = Traits;
+        using value_type = T;
+        using size_type = ::std::size_t;
+        using difference_type = ::std::ptrdiff_t;
+        using const_pointer = const T*;
+        using const_reference = const T&;
+        using const_iterator = const T*;
+        using iterator = const_iterator;
+    private:
+        const T* data_;
+        size_type size_;
+    public:
+        constexpr basic_str_view() noexcept : data_(nullptr), size_(0) {}
+        constexpr basic_str_view(const T* const data, const size_type size) noexcept : data_(data), size_(size) {}
+        basic_str_view(const T* const c_str) noexcept : data_(c_str), size_(Traits::length(c_str)) {}
+        template<class Allocator>
+        basic_str_view(const ::std::basic_string<T, Traits, Allocator>& s) noexcept : data_(s.data()), size_(s.size()) {}
+#ifdef TORREBIS_HAS_STRING_VIEW
+        constexpr basic_str_view(const ::std::basic_string_view<T, Traits> s) noexcept : data_(s.data()), size_(s.size()) {}
+        constexpr operator ::std::basic_string_view<T, Traits>() const noexcept { return { data_, size_ }; }
+#endif
+
+        constexpr const T* data() const noexcept { return data_; }
+        constexpr size_type size() const noexcept { return size_; }
+        constexpr size_type length() const noexcept { return size_; }
+        constexpr bool empty() const noexcept { return size_ == 0; }
+
+        constexpr const_iterator begin() const noexcept { return data_; }
+        constexpr const_iterator end() const noexcept { return data_ + size_; }
+        constexpr const_iterator cbegin() const noexcept { return data_; }
+        constexpr const_iterator cend() const noexcept { return data_ + size_; }
+
+        constexpr const_reference operator[](const size_type i) const noexcept { return data_[i]; }
+        constexpr const_reference front() const noexcept { return data_[0]; }
+        constexpr const_reference back() const noexcept { return data_[size_ - 1]; }
+
+        int compare(const basic_str_view other) const noexcept {
+            const int cmp = size_ < other.size_
+                ? Traits::compare(data_, other.data_, size_)
+                : Traits::compare(data_, other.data_, other.size_);
+            if (cmp != 0) {
+                return cmp;
+            }
+            return size_ == other.size_ ? 0 : (size_ < other.size_ ? -1 : +1);
+        }
+
+        template<class Allocator = ::std::allocator<T>>
+        ::std::basic_string<T, Traits, Allocator> to_string() const {
+            return ::std::basic_string<T, Traits, Allocator>(data_, size_);
+        }
+
+        template<class Allocator>
+        explicit operator ::std::basic_string<T, Traits, Allocator>() const {
+            return ::std::basic_string<T, Traits, Allocator>(data_, size_);
+        }
+
+        bool operator==(const basic_str_view other) const noexcept { return size_ == other.size_ && Traits::compare(data_, other.data_, size_) == 0; }
+        bool operator!=(const basic_str_view other) const noexcept { return !operator==(other); }
+        bool operator<(const basic_str_view other) const noexcept { return compare(other) < 0; }
+        bool operator<=(const basic_str_view other) const noexcept { return compare(other) <= 0; }
+        bool operator>(const basic_str_view other) const noexcept { return compare(other) > 0; }
+        bool operator>=(const basic_str_view other) const noexcept { return compare(other) >= 0; }
+    };
+
+    using str_view = basic_str_view<>;
+
+    namespace helpers {
+        namespace detail {
+            template<class CharT, class Traits>
+            struct has_char_t<CharT, basic_str_view<CharT, Traits>> : ::std::true_type {};
+
+            // Whether a `StrType` refers to the buffer it was decoded from instead of owning a copy.
+            template<class StrType>
+            struct is_borrowed_str : ::std::false_type {};
+
+            template<class CharT, class Traits>
+            struct is_borrowed_str<basic_str_view<CharT, Traits>> : ::std::true_type {};
+
+#ifdef TORREBIS_HAS_STRING_VIEW
+            template<class CharT, class Traits>
+            struct has_char_t<CharT, ::std::basic_string_view<CharT, Traits>> : ::std::true_type {};
+
+            template<class CharT, class Traits>
+            struct is_borrowed_str<::std::basic_string_view<CharT, Traits>> : ::std::true_type {};
+#endif
+        }  // namespace torrebis::bencode::helpers::detail  (Private)
+    }  // namespace torrebis::bencode::helpers
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_STR_VIEW_H_
+
+// Done expanding  #include "torrebis_bencode/str_view.h"
+
 // Expanding  #include "torrebis_bencode/errors.h"
 #ifndef TORREBIS_BENCODE_ERRORS_H_
 #define TORREBIS_BENCODE_ERRORS_H_
@@ -202,1860 +360,5787 @@ namespace torrebis { namespace bencode {
 
 // Done expanding  #include "torrebis_bencode/errors.h"
 
-// Expanding  #include "torrebis_bencode/type_tags.h"
-#ifndef TORREBIS_BENCODE_TYPE_TAGS_H_
-#define TORREBIS_BENCODE_TYPE_TAGS_H_
+// Expanding  #include "torrebis_bencode/readers.h"
+#ifndef TORREBIS_BENCODE_READERS_H_
+#define TORREBIS_BENCODE_READERS_H_
 
-#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <istream>
+#include <streambuf>
 #include <type_traits>
+#include <utility>
+#include <vector>
+
 
 
 namespace torrebis { namespace bencode {
-    enum class DataTag : ::std::int8_t {
-        STR = 0,
-        INT = 1,
-        LIST = 2,
-        DICT = 3,
+    namespace helpers {
+        namespace detail {
+            // Reads an integer from `begin[i:size]`, up to and including the character `end`.
+            // If `first` is not `nullptr`, it is the already consumed first character.
+            template<typename IntType, typename T>
+            static IntType pointer_read_int(const T* const begin, ::std::size_t& i, const ::std::size_t size, const char end, const char* const first) {
+                char first_char;
+                if (first == nullptr) {
+                    if (i >= size) {
+                        throw errors::expecting_int_error.copy();
+                    }
+                    first_char = static_cast<char>(begin[i++]);
+                } else {
+                    first_char = *first;
+                }
+                if (first_char == '0') {
+                    if (i >= size || static_cast<char>(begin[i++]) != end) {
+                        throw errors::expecting_int_error.copy();
+                    }
+                    return IntType(0);
+                }
+                int sign = +1;
+                if (first_char == '-' && !::std::is_unsigned<IntType>::value) {
+                    sign = -1;
+                    if (i >= size) {
+                        throw errors::expecting_int_error.copy();
+                    }
+                    first_char = static_cast<char>(begin[i++]);
+                }
+                if (!('1' <= first_char && first_char <= '9')) {
+                    throw errors::expecting_int_error.copy();
+                }
+                IntType res = IntType(static_cast<int>(sign * static_cast<int>(first_char - '0')));
+                while (true) {
+                    if (i >= size) {
+                        throw errors::expecting_int_error.copy();
+                    }
+                    const char next_char = static_cast<char>(begin[i++]);
+                    if (!('0' <= next_char && next_char <= '9')) {
+                        if (next_char == end) {
+                            break;
+                        }
+                        throw errors::expecting_int_error.copy();
+                    }
+                    IntType previous_res = res;
+                    res = res * IntType(10) + IntType(static_cast<int>(sign * static_cast<int>(next_char - '0')));
+                    if ((previous_res < res) != (sign > 0)) {
+                        throw errors::integer_overflow_error.copy();
+                    }
+                }
+                return res;
+            }
 
-        UNINITIALISED = -1
-    };
+            // Reads a string from `begin[i:size]`, returning where it starts and how long it is.
+            inline ::std::pair<const char*, ::std::size_t> pointer_read_str_fast(const char* const begin, ::std::size_t& i, const ::std::size_t size, const char* const first) {
+                ::std::size_t str_size = pointer_read_int<::std::size_t, char>(begin, i, size, ':', first);
+                const char* str_begin = begin + i;
+                if (str_size > size - i) {
+                    throw errors::cut_off_str_error.copy();
+                }
+                i += str_size;
+                return  { str_begin, str_size };
+            }
 
+            // Moves `i` just past the value that starts at `begin[i]`, without decoding it. Strings are jumped over by
+            // their length and ints are not read, so only enough is checked to find where the value ends.
+            inline void pointer_skip_value(const char* const begin, ::std::size_t& i, const ::std::size_t size) {
+                ::std::size_t depth = 0;
+                do {
+                    if (i >= size) {
+                        throw errors::expecting_value_error.copy();
+                    }
+                    switch (begin[i]) {
+                        case 'i': {
+                            // int "ixxxe"
+                            const void* const end = ::std::memchr(begin + i, 'e', size - i);
+                            if (end == nullptr) {
+                                throw errors::expecting_int_error.copy();
+                            }
+                            i = static_cast<::std::size_t>(static_cast<const char*>(end) - begin) + 1;
+                            break;
+                        }
+                        case 'l':
+                        case 'd':
+                            // list "lxxxe" or dict "dxxxe"
+                            ++i;
+                            ++depth;
+                            break;
+                        case 'e':
+                            if (depth == 0) {
+                                throw errors::expecting_value_error.copy();
+                            }
+                            ++i;
+                            --depth;
+                            break;
+                        case '0': case '1': case '2':
+                        case '3': case '4': case '5':
+                        case '6': case '7': case '8':
+                        case '9':
+                            // str "yy:xxxx"
+                            pointer_read_str_fast(begin, i, size, nullptr);
+                            break;
+                        default:
+                            throw errors::unknown_value_error.copy();
+                    }
+                } while (depth != 0);
+            }
 
-    namespace helpers {
-        namespace detail {
-            enum MakeStr {
-                make_str = static_cast<::std::int8_t>(0)
-            };
-            enum MakeInt {
-                make_int = static_cast<::std::int8_t>(1)
-            };
-            enum MakeList {
-                make_list = static_cast<::std::int8_t>(2)
-            };
-            enum MakeDict {
-                make_dict = static_cast<::std::int8_t>(3)
-            };
+            // Reads from a stream buffer a chunk at a time, instead of one `is.read` per byte.
+            template<class T, class Traits>
+            class stream_window final {
+            private:
+                ::std::basic_streambuf<T, Traits>* const buf_;
+                ::std::vector<T> window_;
+                ::std::size_t pos_;
+                ::std::size_t end_;
+
+                bool fill() {
+                    pos_ = 0;
+                    end_ = static_cast<::std::size_t>(buf_->sgetn(window_.data(), static_cast<::std::streamsize>(window_.size())));
+                    return end_ != 0;
+                }
+            public:
+                stream_window(::std::basic_streambuf<T, Traits>* const buf, const ::std::size_t buffer_size) :
+                    buf_(buf), window_(buffer_size == 0 ? 1 : buffer_size), pos_(0), end_(0) {}
 
-            template<typename T>
-            struct make_specifier_to_tag;
+                ::std::size_t buffer_size() const noexcept { return window_.size(); }
 
-            template<>
-            struct make_specifier_to_tag<MakeStr> : ::std::integral_constant<DataTag, DataTag::STR> {
-            };
-            template<>
-            struct make_specifier_to_tag<MakeInt> : ::std::integral_constant<DataTag, DataTag::INT> {
-            };
-            template<>
-            struct make_specifier_to_tag<MakeList> : ::std::integral_constant<DataTag, DataTag::LIST> {
-            };
-            template<>
-            struct make_specifier_to_tag<MakeDict> : ::std::integral_constant<DataTag, DataTag::DICT> {
-            };
+                // Reads the next byte into `out`, returning false at the end of the stream.
+                bool next(T& out) {
+                    if (pos_ == end_ && !fill()) {
+                        return false;
+                    }
+                    out = window_[pos_++];
+                    return true;
+                }
 
-            template<DataTag tag>
-            struct tag_to_make_specifier;
+                // Reads `size` bytes into `out`. Reads straight from the stream buffer when it would take more than a window.
+                bool read(T* out, ::std::size_t size) {
+                    ::std::size_t available = end_ - pos_;
+                    if (available >= size) {
+                        Traits::copy(out, window_.data() + pos_, size);
+                        pos_ += size;
+                        return true;
+                    }
+                    Traits::copy(out, window_.data() + pos_, available);
+                    out += available;
+                    size -= available;
+                    pos_ = end_ = 0;
+                    if (size >= window_.size()) {
+                        return static_cast<::std::size_t>(buf_->sgetn(out, static_cast<::std::streamsize>(size))) == size;
+                    }
+                    while (size > 0) {
+                        if (!fill()) {
+                            return false;
+                        }
+                        available = size < end_ ? size : end_;
+                        Traits::copy(out, window_.data(), available);
+                        pos_ = available;
+                        out += available;
+                        size -= available;
+                    }
+                    return true;
+                }
 
-            template<>
-            struct tag_to_make_specifier<DataTag::STR> : ::std::integral_constant<MakeStr, make_str> {
-            };
-            template<>
-            struct tag_to_make_specifier<DataTag::INT> : ::std::integral_constant<MakeInt, make_int> {
-            };
-            template<>
-            struct tag_to_make_specifier<DataTag::LIST> : ::std::integral_constant<MakeList, make_list> {
-            };
-            template<>
-            struct tag_to_make_specifier<DataTag::DICT> : ::std::integral_constant<MakeDict, make_dict> {
+                // Whether everything in the stream has been read.
+                bool at_end() {
+                    return pos_ == end_ && Traits::eq_int_type(buf_->sgetc(), Traits::eof());
+                }
             };
         }  // namespace torrebis::bencode::helpers::detail  (Private)
+    }  // namespace torrebis::bencode::helpers
+} }  // namespace torrebis::bencode
 
-        template<DataTag tag, class StrType, class IntType, class ListType, class DictType, class UninitialisedType>
-        struct tag_to_type;
+#endif  // TORREBIS_BENCODE_READERS_H_
 
-        template<class StrType, class IntType, class ListType, class DictType, class UninitialisedType>
-        struct tag_to_type<DataTag::STR, StrType, IntType, ListType, DictType, UninitialisedType> {
-            using type = StrType;
-        };
+// Done expanding  #include "torrebis_bencode/readers.h"
 
-        template<class StrType, class IntType, class ListType, class DictType, class UninitialisedType>
-        struct tag_to_type<DataTag::INT, StrType, IntType, ListType, DictType, UninitialisedType> {
-            using type = IntType;
-        };
+// Expanding  #include "torrebis_bencode/writers.h"
+#ifndef TORREBIS_BENCODE_WRITERS_H_
+#define TORREBIS_BENCODE_WRITERS_H_
 
-        template<class StrType, class IntType, class ListType, class DictType, class UninitialisedType>
-        struct tag_to_type<DataTag::LIST, StrType, IntType, ListType, DictType, UninitialisedType> {
-            using type = ListType;
-        };
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <type_traits>
 
-        template<class StrType, class IntType, class ListType, class DictType, class UninitialisedType>
-        struct tag_to_type<DataTag::DICT, StrType, IntType, ListType, DictType, UninitialisedType> {
-            using type = DictType;
-        };
 
-        template<class StrType, class IntType, class ListType, class DictType, class UninitialisedType>
-        struct tag_to_type<DataTag::UNINITIALISED, StrType, IntType, ListType, DictType, UninitialisedType> {
-            using type = UninitialisedType;
-        };
 
-        template<DataTag tag, class StrType, class IntType, class ListType, class DictType, class UninitialisedType>
-        using tag_to_type_t = typename tag_to_type<tag, StrType, IntType, ListType, DictType, UninitialisedType>::type;
+namespace torrebis { namespace bencode {
+    namespace helpers {
+        namespace detail {
+            // "00", "01", ..., "99", so two digits can be written at a time.
+            inline const char* digit_pairs() noexcept {
+                static const char pairs[] =
+                    "00010203040506070809"
+                    "10111213141516171819"
+                    "20212223242526272829"
+                    "30313233343536373839"
+                    "40414243444546474849"
+                    "50515253545556575859"
+                    "60616263646566676869"
+                    "70717273747576777879"
+                    "80818283848586878889"
+                    "90919293949596979899";
+                return pairs;
+            }
 
-        template<DataTag tag, class StrType, class IntType, class ListType, class DictType>
-        struct itag_to_type;
+            // Built in integers are formatted through their unsigned type, anything else (like a big integer class)
+            // only needs comparisons, `/`, `%` and a conversion to `int`.
+            template<class IntType>
+            struct is_builtin_int : ::std::integral_constant<bool,
+                ::std::is_integral<IntType>::value && !::std::is_same<IntType, bool>::value> {};
+
+            template<class IntType>
+            bool is_negative_(const IntType i, ::std::true_type) noexcept { return i < IntType(0); }
+
+            template<class IntType>
+            bool is_negative_(const IntType, ::std::false_type) noexcept { return false; }
+
+            template<class Unsigned>
+            using wide_unsigned = typename ::std::conditional<(sizeof(Unsigned) > sizeof(unsigned long long)), Unsigned, unsigned long long>::type;
+
+            // The number of digits in `u`, by comparing instead of dividing when it fits in 64 bits.
+            inline ::std::size_t digits64(const unsigned long long u) noexcept {
+                static const unsigned long long powers[] = {
+                    10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+                    1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+                    100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+                    1000000000000000000ull, 10000000000000000000ull
+                };
+                ::std::size_t digits = 1;
+                for (const unsigned long long power : powers) {
+                    digits += (u >= power);
+                }
+                return digits;
+            }
 
-        template<class StrType, class IntType, class ListType, class DictType>
-        struct itag_to_type<DataTag::STR, StrType, IntType, ListType, DictType> {
-            using type = StrType;
-        };
+            template<class Unsigned>
+            ::std::size_t unsigned_digits(const Unsigned u) noexcept {
+                TORREBIS_CONSTEXPR_IF (sizeof(Unsigned) <= sizeof(unsigned long long)) {
+                    return digits64(static_cast<unsigned long long>(u));
+                }
+                wide_unsigned<Unsigned> v = u;
+                ::std::size_t digits = 1;
+                while (v >= 10000) {
+                    v /= 10000;
+                    digits += 4;
+                }
+                return digits + (v >= 10) + (v >= 100) + (v >= 1000);
+            }
 
-        template<class StrType, class IntType, class ListType, class DictType>
-        struct itag_to_type<DataTag::INT, StrType, IntType, ListType, DictType> {
-            using type = IntType;
-        };
+            // Writes the digits of `u` so that the last one is just before `end`.
+            template<class Unsigned, class T>
+            void write_unsigned_backwards(const Unsigned u, T* end) noexcept {
+                const char* const pairs = digit_pairs();
+                wide_unsigned<Unsigned> v = u;
+                while (v >= 100) {
+                    const ::std::size_t pair = static_cast<::std::size_t>(v % 100) * 2;
+                    v /= 100;
+                    *--end = static_cast<T>(pairs[pair + 1]);
+                    *--end = static_cast<T>(pairs[pair]);
+                }
+                if (v >= 10) {
+                    const ::std::size_t pair = static_cast<::std::size_t>(v) * 2;
+                    *--end = static_cast<T>(pairs[pair + 1]);
+                    *--end = static_cast<T>(pairs[pair]);
+                } else {
+                    *--end = static_cast<T>('0' + static_cast<char>(v));
+                }
+            }
 
-        template<class StrType, class IntType, class ListType, class DictType>
-        struct itag_to_type<DataTag::LIST, StrType, IntType, ListType, DictType> {
-            using type = ListType;
-        };
+            template<class IntType>
+            typename ::std::make_unsigned<IntType>::type magnitude_(const IntType i, const bool negative) noexcept {
+                using unsigned_type = typename ::std::make_unsigned<IntType>::type;
+                // Negated as unsigned, so the smallest value doesn't overflow
+                return negative ? static_cast<unsigned_type>(unsigned_type(0) - static_cast<unsigned_type>(i)) : static_cast<unsigned_type>(i);
+            }
 
-        template<class StrType, class IntType, class ListType, class DictType>
-        struct itag_to_type<DataTag::DICT, StrType, IntType, ListType, DictType> {
-            using type = DictType;
-        };
+            template<class IntType>
+            ::std::size_t int_size_(const IntType i, ::std::true_type) noexcept {
+                const bool negative = is_negative_(i, ::std::is_signed<IntType>());
+                return static_cast<::std::size_t>(negative) + unsigned_digits(magnitude_(i, negative));
+            }
 
-        template<DataTag tag, class StrType, class IntType, class ListType, class DictType>
-        using itag_to_type_t = typename itag_to_type<tag, StrType, IntType, ListType, DictType>::type;
+            template<class IntType>
+            ::std::size_t int_size_(IntType i, ::std::false_type) {
+                ::std::size_t size = i < IntType(0) ? 2 : 1;
+                while (i <= IntType(-100) || IntType(100) <= i) {
+                    i /= IntType(100);
+                    size += 2;
+                }
+                return size + static_cast<::std::size_t>(i <= IntType(-10) || IntType(10) <= i);
+            }
 
-        template<DataTag tag, typename StrType, StrType StrValue, typename IntType, IntType IntValue, typename ListType, ListType ListValue, typename DictType, DictType DictValue>
-        struct tag_to_value;
+            // How many characters `i` is in decimal, including a '-'.
+            template<class IntType>
+            ::std::size_t int_size(const IntType i) { return int_size_(i, is_builtin_int<IntType>()); }
 
-        template<typename StrType, StrType StrValue, typename IntType, IntType IntValue, typename ListType, ListType ListValue, typename DictType, DictType DictValue>
-        struct tag_to_value<DataTag::STR, StrType, StrValue, IntType, IntValue, ListType, ListValue, DictType, DictValue> : ::std::integral_constant<StrType, StrValue> {};
+            template<class IntType, class T>
+            T* write_int_(const IntType i, T* const out, ::std::true_type) noexcept {
+                const bool negative = is_negative_(i, ::std::is_signed<IntType>());
+                const auto u = magnitude_(i, negative);
+                if (negative) {
+                    *out = static_cast<T>('-');
+                }
+                T* const end = out + static_cast<::std::size_t>(negative) + unsigned_digits(u);
+                write_unsigned_backwards(u, end);
+                return end;
+            }
 
-        template<typename StrType, StrType StrValue, typename IntType, IntType IntValue, typename ListType, ListType ListValue, typename DictType, DictType DictValue>
-        struct tag_to_value<DataTag::INT, StrType, StrValue, IntType, IntValue, ListType, ListValue, DictType, DictValue> : ::std::integral_constant<IntType, IntValue> {};
+            template<class IntType, class T>
+            T* write_int_(IntType i, T* const out, ::std::false_type) {
+                const char* const pairs = digit_pairs();
+                T* const end = out + int_size(i);
+                T* p = end;
+                const bool negative = i < IntType(0);
+                // Digits are taken from a negative number without negating it, which could overflow
+                while (i <= IntType(-100) || IntType(100) <= i) {
+                    int pair = static_cast<int>(i % IntType(100));
+                    i /= IntType(100);
+                    pair = (pair < 0 ? -pair : pair) * 2;
+                    *--p = static_cast<T>(pairs[pair + 1]);
+                    *--p = static_cast<T>(pairs[pair]);
+                }
+                int last = static_cast<int>(i);
+                last = last < 0 ? -last : last;
+                if (last >= 10) {
+                    *--p = static_cast<T>(pairs[last * 2 + 1]);
+                    *--p = static_cast<T>(pairs[last * 2]);
+                } else {
+                    *--p = static_cast<T>('0' + static_cast<char>(last));
+                }
+                if (negative) {
+                    *--p = static_cast<T>('-');
+                }
+                return end;
+            }
 
-        template<typename StrType, StrType StrValue, typename IntType, IntType IntValue, typename ListType, ListType ListValue, typename DictType, DictType DictValue>
-        struct tag_to_value<DataTag::LIST, StrType, StrValue, IntType, IntValue, ListType, ListValue, DictType, DictValue> : ::std::integral_constant<ListType, ListValue> {};
+            // Writes `int_size(i)` characters of `i` in decimal to `out`, returning the end of them.
+            template<class IntType, class T>
+            T* write_int(const IntType i, T* const out) { return write_int_(i, out, is_builtin_int<IntType>()); }
 
-        template<typename StrType, StrType StrValue, typename IntType, IntType IntValue, typename ListType, ListType ListValue, typename DictType, DictType DictValue>
-        struct tag_to_value<DataTag::DICT, StrType, StrValue, IntType, IntValue, ListType, ListValue, DictType, DictValue> : ::std::integral_constant<DictType, DictValue> {};
+            // Built in integers are written to the stack first, so that `s` doesn't have to fill space it will overwrite.
+            template<class IntType, class T, class Traits, class Allocator>
+            void append_int_(const IntType i, ::std::basic_string<T, Traits, Allocator>& s, ::std::true_type) {
+                T buffer[::std::numeric_limits<IntType>::digits10 + 2];
+                s.append(buffer, write_int(i, buffer));
+            }
 
+            template<class IntType, class T, class Traits, class Allocator>
+            void append_int_(const IntType i, ::std::basic_string<T, Traits, Allocator>& s, ::std::false_type) {
+                const ::std::size_t old_size = s.size();
+                s.resize(old_size + int_size(i));
+                write_int(i, &s[old_size]);
+            }
 
-        template<class T, class StrType, class IntType, class ListType, class DictType>
-        struct type_to_tag;
+            // Appends `i` in decimal to `s`, growing it once.
+            template<class IntType, class T, class Traits, class Allocator>
+            void append_int(const IntType i, ::std::basic_string<T, Traits, Allocator>& s) {
+                append_int_(i, s, is_builtin_int<IntType>());
+            }
 
-        template<class StrType, class IntType, class ListType, class DictType>
-        struct type_to_tag<StrType, StrType, IntType, ListType, DictType> : ::std::integral_constant<DataTag, DataTag::STR> {};
+            // Writes `i` in decimal to `out`, returning the iterator after it.
+            template<class IntType, class T>
+            T* copy_int(const IntType i, T* const out) { return write_int(i, out); }
 
-        template<class StrType, class IntType, class ListType, class DictType>
-        struct type_to_tag<IntType, StrType, IntType, ListType, DictType> : ::std::integral_constant<DataTag, DataTag::INT> {};
+            template<class IntType, class OutputIt>
+            OutputIt copy_int(const IntType i, OutputIt out) {
+                TORREBIS_CONSTEXPR_IF (is_builtin_int<IntType>::value) {
+                    char buffer[::std::numeric_limits<IntType>::digits10 + 2];
+                    return ::std::copy(buffer, write_int(i, buffer), out);
+                }
+                ::std::string s;
+                append_int(i, s);
+                return ::std::copy(s.begin(), s.end(), out);
+            }
 
-        template<class StrType, class IntType, class ListType, class DictType>
-        struct type_to_tag<ListType, StrType, IntType, ListType, DictType> : ::std::integral_constant<DataTag, DataTag::LIST> {};
+            // The container of a `std::back_insert_iterator` (A protected member), so ranges can be inserted at once.
+            template<class Container>
+            Container& back_inserted_container(::std::back_insert_iterator<Container>& it) noexcept {
+                struct access : ::std::back_insert_iterator<Container> {
+                    static Container* get(::std::back_insert_iterator<Container>& i) noexcept { return i.*(&access::container); }
+                };
+                return *access::get(it);
+            }
 
-        template<class StrType, class IntType, class ListType, class DictType>
-        struct type_to_tag<DictType, StrType, IntType, ListType, DictType> : ::std::integral_constant<DataTag, DataTag::DICT> {};
+            template<class IntType, class Container>
+            ::std::back_insert_iterator<Container> copy_int(const IntType i, ::std::back_insert_iterator<Container> out) {
+                Container& c = back_inserted_container(out);
+                TORREBIS_CONSTEXPR_IF (is_builtin_int<IntType>::value) {
+                    char buffer[::std::numeric_limits<IntType>::digits10 + 2];
+                    c.insert(c.end(), buffer, write_int(i, buffer));
+                    return out;
+                }
+                ::std::string s;
+                append_int(i, s);
+                c.insert(c.end(), s.begin(), s.end());
+                return out;
+            }
 
-        template<class StrType, class IntType, class ListType, class DictType>
-        struct type_to_tag<void, StrType, IntType, ListType, DictType> : ::std::integral_constant<DataTag, DataTag::UNINITIALISED> {};
+            template<class T, class Str>
+            T* copy_chars_(const Str& str, T* const out, ::std::true_type) noexcept {
+                const ::std::size_t size = str.size();
+                if (size != 0) {
+                    ::std::memcpy(out, str.data(), size);
+                }
+                return out + size;
+            }
 
-#ifdef TORREBIS_VARIABLE_TEMPLATES
-        template<DataTag tag, typename StrType, StrType StrValue, typename IntType, IntType IntValue, typename ListType, ListType ListValue, typename DictType, DictType DictValue>
-        constexpr
-        typename tag_to_value<tag, StrType, StrValue, IntType, IntValue, ListType, ListValue, DictType, DictValue>::type
-        tag_to_value_v = tag_to_value<tag, StrType, StrValue, IntType, IntValue, ListType, ListValue, DictType, DictValue>::value;
+            template<class T, class Str>
+            T* copy_chars_(const Str& str, T* out, ::std::false_type) {
+                for (const auto byte : str) {
+                    *out++ = static_cast<T>(static_cast<char>(byte));
+                }
+                return out;
+            }
 
-        template<class T, class StrType, class IntType, class ListType, class DictType>
-        constexpr DataTag type_to_tag_v = type_to_tag<T, StrType, IntType, ListType, DictType>::value;
-#endif
+            // Writes the bytes of `str` to `out`, returning the iterator after them.
+            template<class Str, class T>
+            T* copy_chars(const Str& str, T* const out) { return copy_chars_(str, out, has_char_t<T, Str>()); }
 
-    }  // namespace ::torrebis::bencode::helpers
+            template<class Str, class Container>
+            ::std::back_insert_iterator<Container> copy_chars(const Str& str, ::std::back_insert_iterator<Container> out) {
+                Container& c = back_inserted_container(out);
+                c.insert(c.end(), str.begin(), str.end());
+                return out;
+            }
 
-} }  // namespace ::torrebis::bencode
+            template<class Str, class OutputIt>
+            OutputIt copy_chars(const Str& str, OutputIt out) {
+                for (const auto byte : str) {
+                    *out = static_cast<char>(byte);
+                    ++out;
+                }
+                return out;
+            }
 
-#endif  // TORREBIS_BENCODE_TYPE_TAGS_H_
+            template<class T, class Traits, class Allocator, class Str>
+            void append_chars_(::std::basic_string<T, Traits, Allocator>& s, const Str& str, ::std::true_type) { s.append(str.data(), str.size()); }
 
-// Done expanding  #include "torrebis_bencode/type_tags.h"
+            template<class T, class Traits, class Allocator, class Str>
+            void append_chars_(::std::basic_string<T, Traits, Allocator>& s, const Str& str, ::std::false_type) {
+                for (const auto byte : str) {
+                    s.push_back(static_cast<T>(static_cast<char>(byte)));
+                }
+            }
 
-// Expanding  #include "torrebis_bencode/path_el.h"
-#ifndef TORREBIS_BENCODE_PATH_EL_H_
-#define TORREBIS_BENCODE_PATH_EL_H_
+            // Appends the bytes of `str` to `s`, converting each one if they aren't already `T`s.
+            template<class T, class Traits, class Allocator, class Str>
+            void append_chars(::std::basic_string<T, Traits, Allocator>& s, const Str& str) { append_chars_(s, str, has_char_t<T, Str>()); }
+
+            template<class T, class Traits, class Str>
+            void write_chars_(::std::basic_ostream<T, Traits>& os, const Str& str, ::std::true_type) {
+                os.write(str.data(), static_cast<::std::streamsize>(str.size()));
+            }
+
+            template<class T, class Traits, class Str>
+            void write_chars_(::std::basic_ostream<T, Traits>& os, const Str& str, ::std::false_type) {
+                for (const auto byte : str) {
+                    os.put(static_cast<T>(static_cast<char>(byte)));
+                }
+            }
+
+            // Writes the bytes of `str` to `os`, like `append_chars`.
+            template<class T, class Traits, class Str>
+            void write_chars(::std::basic_ostream<T, Traits>& os, const Str& str) { write_chars_(os, str, has_char_t<T, Str>()); }
+        }  // namespace torrebis::bencode::helpers::detail  (Private)
+    }  // namespace torrebis::bencode::helpers
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_WRITERS_H_
 
+// Done expanding  #include "torrebis_bencode/writers.h"
+
+// Expanding  #include "torrebis_bencode/gather.h"
+#ifndef TORREBIS_BENCODE_GATHER_H_
+#define TORREBIS_BENCODE_GATHER_H_
+
+#include <cstddef>
 #include <string>
-#include <memory>
 #include <type_traits>
+#include <vector>
 
 
 
 namespace torrebis { namespace bencode {
-    template<class StrType_ = ::std::string, template<typename T> class Allocator_ = ::std::allocator>
-    class basic_path_el final {
-    public:
-        using StrType = StrType_;
-        template<typename T>
-        using Allocator = Allocator_<T>;
+    /*
+     * An encoding split into pieces for a gather write (`writev`), so that long strings don't have to be copied.
+     * Strings of at least `reference_size()` bytes are referenced where they are, everything else is copied into a
+     * scratch buffer. Referenced strings must stay alive and unchanged until the pieces have been written.
+     *
+     * Fill one with `basic_data::append_serialisation(gather_buffer&)`, then use `segments()`, or with POSIX,
+     * `iovecs()` or `write_to()` from "torrebis_bencode/gather_posix.h".
+     */
+    class gather_buffer final {
+    private:
+        struct piece {
+            const char* data;  // nullptr if the piece is in `scratch_`
+            ::std::size_t offset;  // Into `scratch_`
+            ::std::size_t size;
+        };
 
-        using str_type = StrType;
-        using str_ptr_type = ::std::shared_ptr<str_type>;
-        using allocator_t = Allocator<str_type>;
+        ::std::string scratch_;
+        ::std::vector<piece> pieces_;
+        ::std::size_t reference_size_;
+        ::std::size_t size_;
 
-        using index_type = ::std::size_t;
-    private:
-        DataTag tag_;  // Can only be DataTag::STR or DataTag::INT
-        union KeyOrIndex {
-            str_ptr_type key;
-            index_type index;
+        // Copied bytes are added to the last piece if it is also in the scratch buffer.
+        void extend_scratch(const ::std::size_t old_size) {
+            const ::std::size_t added = scratch_.size() - old_size;
+            if (!pieces_.empty() && pieces_.back().data == nullptr) {
+                pieces_.back().size += added;
+            } else {
+                pieces_.push_back({ nullptr, old_size, added });
+            }
+            size_ += added;
+        }
 
-            KeyOrIndex(const index_type i) noexcept : index(i) {}
-            KeyOrIndex(const str_type k) : key(::std::allocate_shared<str_type, allocator_t>(allocator_t(), k)) {}
-            KeyOrIndex(const str_ptr_type k) noexcept : key(k) {}
-            KeyOrIndex() noexcept : key(nullptr) {}
+        template<class Str>
+        void put_str_(const Str& s, ::std::true_type) { put_bytes(s.data(), s.size()); }
 
-            ~KeyOrIndex() noexcept {}  // basic_path_el class should handle this.
-        } key_or_index_;
-    public:
+        template<class Str>
+        void put_str_(const Str& s, ::std::false_type) {
+            const ::std::size_t old_size = scratch_.size();
+            helpers::detail::append_chars(scratch_, s);
+            extend_scratch(old_size);
+        }
 
-#ifdef TORREBIS_HAS_IS_NOTHROW_CONVERTIBLE
-        template<class T>
-        basic_path_el(
-            const typename ::std::enable_if<::std::is_convertible<T, index_type>::value && !::std::is_nothrow_convertible<T, index_type>::value, T>::type i
-        ) : tag_(DataTag::INT), key_or_index_(static_cast<::std::size_t>(i)) {}
+        const char* piece_data(const piece& p) const noexcept { return p.data == nullptr ? scratch_.data() + p.offset : p.data; }
+    public:
+        static constexpr ::std::size_t default_reference_size = 512;
 
-        template<class T>
-        basic_path_el(
-            const typename ::std::enable_if<::std::is_nothrow_convertible<T, index_type>::value, T>::type i
-        ) noexcept : tag_(DataTag::INT), key_or_index_(static_cast<::std::size_t>(i)) {}
-#else
-        template<class T>
-        basic_path_el(
-            const typename ::std::enable_if<::std::is_convertible<T, index_type>::value && !::std::is_integral<T>::value, T>::type i
-        ) : tag_(DataTag::INT), key_or_index_(static_cast<::std::size_t>(i)) {}
+        explicit gather_buffer(const ::std::size_t reference_size = default_reference_size) noexcept :
+            reference_size_(reference_size), size_(0) {}
 
-        template<class T>
-        basic_path_el(
-            const typename ::std::enable_if<::std::is_integral<T>::value, T>::type i
-        ) noexcept : tag_(DataTag::INT), key_or_index_(static_cast<::std::size_t>(i)) {}
-#endif
+        // Strings at least this long are referenced instead of copied.
+        ::std::size_t reference_size() const noexcept { return reference_size_; }
 
-        basic_path_el(const index_type i) noexcept : tag_(DataTag::INT), key_or_index_(i) {}
+        // How many bytes all of the pieces add up to.
+        ::std::size_t size() const noexcept { return size_; }
 
-        basic_path_el(const str_type k) : tag_(DataTag::STR), key_or_index_(k) {}
-        basic_path_el(const ::std::shared_ptr<const str_type> k) : tag_(DataTag::STR), key_or_index_(k ? str_type(*k) : nullptr) {}
-        basic_path_el(const str_ptr_type k) noexcept : tag_(DataTag::STR), key_or_index_(k) {}
-        basic_path_el(const basic_path_el& other) noexcept : tag_(other.tag_) { if (tag_ == DataTag::STR) { key_or_index_.key = other.get_key(); } else { key_or_index_.index = other.get_index(); } }
-        basic_path_el(const basic_path_el&& other) noexcept : tag_(other.tag_) { if (tag_ == DataTag::STR) { key_or_index_.key = other.get_key(); } else { key_or_index_.index = other.get_index(); } }
-        template<typename... Args, class = typename helpers::detail::path_el_str_constructor_enable_if<Args...>::type>
-        basic_path_el(const Args... args) : tag_(DataTag::STR), key_or_index_(str_type(args...)) {}
-        basic_path_el& operator=(basic_path_el other) noexcept { if (&other != this) { swap(other); }; return *this; }
-        index_type operator=(index_type other) noexcept { set_index(other); return other; }
-        str_type& operator=(str_type other) noexcept { set_key(other); return other; }
-        str_ptr_type operator=(str_ptr_type other) noexcept { set_key(other); return other; }
-        bool operator==(const basic_path_el& other) const noexcept { if (&other == this) { return true; } if (is_key()) { return other.is_key() && get_key() == other.get_key(); } return other.is_index() && get_index() == other.get_index(); }
-        bool operator!=(const basic_path_el& other) const noexcept { return !operator==(other); }
-        void swap(basic_path_el& other) noexcept {
-            using ::std::swap;
-            if (is_key()) {
-                if (other.is_key()) {
-                    swap(key_or_index_.key, other.key_or_index_.key);
-                } else {
-                    index_type i = other.key_or_index_.index;
-                    other.key_or_index_.key = key_or_index_.key;
-                    key_or_index_.key = nullptr;
-                    key_or_index_.index = i;
-                    other.tag_ = DataTag::STR;
-                    tag_ = DataTag::INT;
-                }
-            } else if (other.is_key()) {
-                index_type i = key_or_index_.index;
-                key_or_index_.key = other.key_or_index_.key;
-                other.key_or_index_.key = nullptr;
-                other.key_or_index_.index = i;
-                tag_ = DataTag::STR;
-                other.tag_ = DataTag::INT;
-            } else {
-                index_type i = key_or_index_.index;
-                key_or_index_.index = other.key_or_index_.index;
-                other.key_or_index_.index = i;
-            }
-        };
+        bool empty() const noexcept { return size_ == 0; }
 
-        bool is_key() const noexcept { return tag_ == DataTag::STR && key_or_index_.key != nullptr; }
-        bool is_index() const noexcept { return tag_ == DataTag::INT; }
+        // Forgets every piece, keeping the scratch buffer's memory.
+        void clear() noexcept {
+            scratch_.clear();
+            pieces_.clear();
+            size_ = 0;
+        }
 
-        str_ptr_type get_key() const noexcept { return is_key() ? key_or_index_.key : nullptr; }
-        index_type get_index() const noexcept { return is_index() ? key_or_index_.index : static_cast<index_type>(-1); }
+        void put(const char c) {
+            const ::std::size_t old_size = scratch_.size();
+            scratch_.push_back(c);
+            extend_scratch(old_size);
+        }
 
-        void set_key(str_type k) { tag_ = DataTag::STR; key_or_index_.key = k; }
-        void set_key(str_ptr_type k) noexcept {
-            if (is_index()) {
-                key_or_index_.index = 0;
-            }
-            tag_ = DataTag::STR;
-            key_or_index_.key = k;
+        template<class IntType>
+        void put_int(const IntType i) {
+            const ::std::size_t old_size = scratch_.size();
+            helpers::detail::append_int(i, scratch_);
+            extend_scratch(old_size);
         }
-        void set_index(index_type i) noexcept {
-            if (is_key()) {
-                key_or_index_.key = nullptr;
+
+        // Copies the bytes if there are fewer than `reference_size()` of them, otherwise references them.
+        void put_bytes(const char* const data, const ::std::size_t size) {
+            if (size < reference_size_) {
+                const ::std::size_t old_size = scratch_.size();
+                scratch_.append(data, size);
+                extend_scratch(old_size);
+                return;
             }
-            tag_ = DataTag::INT;
-            key_or_index_.index = i;
+            pieces_.push_back({ data, 0, size });
+            size_ += size;
         }
 
-        ~basic_path_el() noexcept {
-            if (is_key()) {
-                key_or_index_.key = nullptr;
-            } else if (is_index()) {
-                key_or_index_.index = static_cast<index_type>(-1);
+        // `put_bytes` for a string of `char`s, otherwise the bytes are copied.
+        template<class Str>
+        void put_str(const Str& s) { put_str_(s, helpers::detail::has_char_t<char, Str>()); }
+
+        // The pieces in order. Copied pieces point into this buffer, so they are invalidated by adding to it.
+        ::std::vector<str_view> segments() const {
+            ::std::vector<str_view> result;
+            result.reserve(pieces_.size());
+            for (const piece& p : pieces_) {
+                result.emplace_back(piece_data(p), p.size);
             }
-            tag_ = DataTag::UNINITIALISED;
+            return result;
         }
     };
-
-    using path_el = basic_path_el<>;
 } }  // namespace torrebis::bencode
 
-#endif  // TORREBIS_BENCODE_PATH_EL_H_
+#endif  // TORREBIS_BENCODE_GATHER_H_
 
-// Done expanding  #include "torrebis_bencode/path_el.h"
+// Done expanding  #include "torrebis_bencode/gather.h"
 
-// Expanding  #include "torrebis_bencode/data_class.h"
-#ifndef TORREBIS_BENCODE_DATA_CLASS_H_
-#define TORREBIS_BENCODE_DATA_CLASS_H_
+// Expanding  #include "torrebis_bencode/encoder.h"
+#ifndef TORREBIS_BENCODE_ENCODER_H_
+#define TORREBIS_BENCODE_ENCODER_H_
 
+#include <cassert>
+#include <cstddef>
+#include <iterator>
 #include <string>
 #include <vector>
-#include <map>
-#include <memory>
-#include <type_traits>
-#include <utility>
-#include <ostream>
 
-#ifdef TORREBIS_STD_ARRAY_HAS_DATA
-#include <array>
-#endif
 
 
 namespace torrebis { namespace bencode {
+    /*
+     * Writes bencode straight to an output iterator, one value at a time, without building a `basic_data`:
+     *
+     *     std::string s;
+     *     bencode::encoder e(std::back_inserter(s));
+     *     e.begin_dict().key("interval").int_value(1800).key("peers").string_value(peers, size).end();
+     *
+     * Dict keys must be given in ascending order (The order `data` stores them in). Nothing is checked in release
+     * builds; without `NDEBUG`, misuse (like a value without a key in a dict, an `end()` with nothing to end, keys
+     * that are out of order or a second top level value) fails an `assert`.
+     */
+    template<class OutputIt>
+    class basic_encoder final {
+    private:
+        struct frame {
+            bool is_dict;
+            bool has_key;  // A key was written and its value wasn't yet
+            bool has_last_key;
+            ::std::string last_key;
+        };
 
-// The following macros are used to define out-of-line functions
-
-#define TORREBIS_BASIC_DATA_TEMPLATE_INNER \
-    class StrType, class IntType, template<typename, typename...> class ListType, \
-    bool dict_is_ordered, template<typename, typename, typename...> class DictType, \
-    template<typename> class Allocator
+        OutputIt out_;
+        ::std::size_t depth_;
+        // Only used for checks, but always there so the layout doesn't depend on `NDEBUG`
+        ::std::vector<frame> frames_;
+        bool finished_;  // A whole top level value was written
+
+        void before_value() {
+#ifndef NDEBUG
+            if (frames_.empty()) {
+                assert(!finished_ && "basic_encoder: only one top level value can be written");
+            } else if (frames_.back().is_dict) {
+                assert(frames_.back().has_key && "basic_encoder: a value in a dict needs a key first");
+                frames_.back().has_key = false;
+            }
+#endif
+        }
 
-#define TORREBIS_BASIC_DATA_TEMPLATE template<TORREBIS_BASIC_DATA_TEMPLATE_INNER>
-#define TORREBIS_BASIC_DATA_TEMPLATE_TYPE_FORWARD StrType, IntType, ListType, dict_is_ordered, DictType, Allocator
-#define TORREBIS_BASIC_DATA_TEMPLATE_TYPE basic_data<TORREBIS_BASIC_DATA_TEMPLATE_TYPE_FORWARD>
-#define TORREBIS_BASIC_DATA_TEMPLATE_FORWARD(basic_data) (basic_data)::StrType, (basic_data)::IntType, (basic_data)::ListType, (basic_data)::dict_is_ordered, (basic_data)::DictType, (basic_data)::Allocator
+        void after_value() noexcept {
+#ifndef NDEBUG
+            if (frames_.empty()) {
+                finished_ = true;
+            }
+#endif
+        }
 
-    template<class StrType_ = ::std::string,
-        class IntType_ = ::std::intmax_t,
-        template<typename ValueType, typename...> class ListType_ = ::std::vector,
-        bool dict_is_ordered_ = true,
-        template<typename KeyType, typename ValueType, typename...> class DictType_ = ::std::map,
-        template<typename T> class Allocator_ = ::std::allocator
-    >
-    class basic_data final {
-    private:
-        DataTag tag_;
-        ::std::shared_ptr<void> value_;
+        void begin(const char c, const bool is_dict) {
+            before_value();
+            *out_ = c;
+            ++out_;
+            ++depth_;
+#ifndef NDEBUG
+            frames_.push_back({ is_dict, false, false, ::std::string() });
+#else
+            static_cast<void>(is_dict);
+#endif
+        }
     public:
-        static constexpr bool dict_is_ordered = dict_is_ordered_;
+        explicit basic_encoder(OutputIt out) : out_(out), depth_(0), finished_(false) {}
 
-        using StrType = StrType_;
-        using IntType = IntType_;
-        template<typename ValueType, typename... Args>
-        using ListType = ListType_<ValueType, Args...>;
-        template<typename KeyType, typename ValueType, typename... Args>
-        using DictType = DictType_<KeyType, ValueType, Args...>;
-        template<typename T>
-        using Allocator = Allocator_<T>;
+        basic_encoder& begin_dict() {
+            begin('d', true);
+            return *this;
+        }
 
-        using str_type = StrType;
-        using int_type = IntType;
-        using list_type = ListType<basic_data>;
-        using dict_type = DictType<str_type, basic_data>;
+        basic_encoder& begin_list() {
+            begin('l', false);
+            return *this;
+        }
 
-        using const_str_type = const StrType;
-        using const_int_type = const IntType;
-        using const_list_type = const ListType<basic_data>;
-        using const_dict_type = const DictType<str_type, basic_data>;
+        // Ends the innermost dict or list.
+        basic_encoder& end() {
+#ifndef NDEBUG
+            assert(!frames_.empty() && "basic_encoder: end() without a dict or list to end");
+            assert(!frames_.back().has_key && "basic_encoder: a key in a dict needs a value");
+            frames_.pop_back();
+#endif
+            --depth_;
+            *out_ = 'e';
+            ++out_;
+            after_value();
+            return *this;
+        }
 
-        using str_allocator_type = const Allocator<str_type>;
-        using int_allocator_type = const Allocator<int_type>;
-        using list_allocator_type = const Allocator<list_type>;
-        using dict_allocator_type = const Allocator<dict_type>;
+        // The key of the next value in the current dict. It must come after the previous key.
+        basic_encoder& key(const str_view k) {
+#ifndef NDEBUG
+            assert(!frames_.empty() && frames_.back().is_dict && "basic_encoder: a key has to be in a dict");
+            frame& f = frames_.back();
+            assert(!f.has_key && "basic_encoder: a key in a dict needs a value");
+            assert((!f.has_last_key || helpers::detail::key_less_than(f.last_key.data(), f.last_key.size(), k.data(), k.size())) &&
+                "basic_encoder: keys must be in ascending order");
+            f.last_key.assign(k.data(), k.size());
+            f.has_last_key = true;
+            f.has_key = true;
+#endif
+            out_ = helpers::detail::copy_int(k.size(), out_);
+            *out_ = ':';
+            out_ = helpers::detail::copy_chars(k, ++out_);
+            return *this;
+        }
 
-        using str_ptr = ::std::shared_ptr<str_type>;
-        using int_ptr = ::std::shared_ptr<int_type>;
-        using list_ptr = ::std::shared_ptr<list_type>;
-        using dict_ptr = ::std::shared_ptr<dict_type>;
-        using void_ptr = ::std::shared_ptr<void>;
+        template<class IntType>
+        basic_encoder& int_value(const IntType i) {
+            before_value();
+            *out_ = 'i';
+            out_ = helpers::detail::copy_int(i, ++out_);
+            *out_ = 'e';
+            ++out_;
+            after_value();
+            return *this;
+        }
 
-        using const_str_ptr = const ::std::shared_ptr<const_str_type>;
-        using const_int_ptr = const ::std::shared_ptr<const_int_type>;
-        using const_list_ptr = const ::std::shared_ptr<const_list_type>;
-        using const_dict_ptr = const ::std::shared_ptr<const_dict_type>;
-        using const_void_ptr = const ::std::shared_ptr<const void>;
+        basic_encoder& string_value(const char* const s, const ::std::size_t size) { return string_value(str_view(s, size)); }
 
-        template<DataTag tag>
-        using tag_to_type = typename helpers::tag_to_type<tag, str_type, int_type, list_type, dict_type, void>;
+        basic_encoder& string_value(const str_view s) {
+            before_value();
+            out_ = helpers::detail::copy_int(s.size(), out_);
+            *out_ = ':';
+            out_ = helpers::detail::copy_chars(s, ++out_);
+            after_value();
+            return *this;
+        }
 
-        template<DataTag tag>
-        using tag_to_type_t = typename tag_to_type<tag>::type;
+        // How many dicts and lists haven't been ended yet.
+        ::std::size_t depth() const noexcept { return depth_; }
 
-        template<DataTag tag>
-        using tag_to_const_type = typename helpers::tag_to_type<tag, const_str_type, const_int_type, const_list_type, const_dict_type, const void>;
+        // Where the next byte will be written.
+        OutputIt position() const { return out_; }
+    };
 
-        template<DataTag tag>
-        using tag_to_const_type_t = typename tag_to_const_type<tag>::type;
+    template<class OutputIt>
+    basic_encoder<OutputIt> make_encoder(const OutputIt out) { return basic_encoder<OutputIt>(out); }
 
-        template<DataTag tag>
-        using tag_to_allocator = typename helpers::itag_to_type<tag, str_allocator_type, int_allocator_type, list_allocator_type, dict_allocator_type>;
+    // Appends to a `std::string`.
+    using encoder = basic_encoder<::std::back_insert_iterator<::std::string>>;
+} }  // namespace torrebis::bencode
 
-        template<DataTag tag>
-        using tag_to_allocator_t = typename tag_to_allocator<tag>::type;
+#endif  // TORREBIS_BENCODE_ENCODER_H_
 
-        template<DataTag tag>
-        using tag_to_ptr = typename helpers::tag_to_type<tag, str_ptr, int_ptr, list_ptr, dict_ptr, void_ptr>;
+// Done expanding  #include "torrebis_bencode/encoder.h"
 
-        template<DataTag tag>
-        using tag_to_ptr_t = typename tag_to_ptr<tag>::type;
+// Expanding  #include "torrebis_bencode/type_tags.h"
+#ifndef TORREBIS_BENCODE_TYPE_TAGS_H_
+#define TORREBIS_BENCODE_TYPE_TAGS_H_
 
-        template<DataTag tag>
-        using tag_to_const_ptr = typename helpers::tag_to_type<tag, const_str_ptr, const_int_ptr, const_list_ptr, const_dict_ptr, const_void_ptr>;
+#include <cstdint>
+#include <type_traits>
 
-        template<DataTag tag>
-        using tag_to_const_ptr_t = typename tag_to_const_ptr<tag>::type;
 
-        template<class type>
-        using type_to_tag = typename helpers::type_to_tag<type, str_type, int_type, list_type, dict_type>;
+namespace torrebis { namespace bencode {
+    enum class DataTag : ::std::int8_t {
+        STR = 0,
+        INT = 1,
+        LIST = 2,
+        DICT = 3,
 
-#ifdef TORREBIS_VARIABLE_TEMPLATES
-        template<class type>
-        static constexpr DataTag type_to_tag_v = type_to_tag<type>::value;
-#endif
+        UNINITIALISED = -1
+    };
 
-    private:
-        template<typename MakeSpecifier>
-        basic_data(const MakeSpecifier, tag_to_ptr_t<helpers::detail::make_specifier_to_tag<MakeSpecifier>::value> value) noexcept :
-            tag_(helpers::detail::make_specifier_to_tag<MakeSpecifier>::value), value_(value) {}
 
-    public:
-        basic_data() noexcept : tag_(DataTag::UNINITIALISED), value_(nullptr) {}
+    namespace helpers {
+        namespace detail {
+            enum MakeStr {
+                make_str = static_cast<::std::int8_t>(0)
+            };
+            enum MakeInt {
+                make_int = static_cast<::std::int8_t>(1)
+            };
+            enum MakeList {
+                make_list = static_cast<::std::int8_t>(2)
+            };
+            enum MakeDict {
+                make_dict = static_cast<::std::int8_t>(3)
+            };
 
-        basic_data(const basic_data& other) noexcept : tag_(other.tag_), value_(other.value_) {}
-        basic_data(const basic_data&& other) noexcept : tag_(other.tag_), value_(other.value_) {}
-        basic_data& operator=(const basic_data& other) noexcept { if (&other != this) { tag_ = other.tag_; value_ = other.value_; }; return *this; }
-        basic_data& operator=(const basic_data&& other) noexcept { tag_ = other.tag_; value_ = other.value_; return *this; }
-        bool operator==(const basic_data& other) const noexcept { return tag_ == other.tag_ && value_ == other.value_; }
-        bool operator!=(const basic_data& other) const noexcept { return !operator==(other); }
-        void swap(basic_data& other) noexcept {
-            DataTag other_tag = other.tag_;
-            other.tag_ = tag_;
-            tag_ = other_tag;
-            ::std::swap(value_, other.value_);
-        };
-        explicit operator bool() const noexcept { return tag_ != DataTag::UNINITIALISED; }
-        bool operator!() const noexcept { return tag_ == DataTag::UNINITIALISED; }
+            template<typename T>
+            struct make_specifier_to_tag;
 
-        DataTag get_tag() const noexcept {
-            return tag_;
-        }
+            template<>
+            struct make_specifier_to_tag<MakeStr> : ::std::integral_constant<DataTag, DataTag::STR> {
+            };
+            template<>
+            struct make_specifier_to_tag<MakeInt> : ::std::integral_constant<DataTag, DataTag::INT> {
+            };
+            template<>
+            struct make_specifier_to_tag<MakeList> : ::std::integral_constant<DataTag, DataTag::LIST> {
+            };
+            template<>
+            struct make_specifier_to_tag<MakeDict> : ::std::integral_constant<DataTag, DataTag::DICT> {
+            };
 
-        template<DataTag tag>
-        bool is() const noexcept { return tag == tag_; }
-        template<typename T>
-        bool is() const noexcept { return type_to_tag<T>::value == tag_; }
-        bool is(DataTag tag) const noexcept { return tag == tag_; }
+            template<DataTag tag>
+            struct tag_to_make_specifier;
 
-        bool is_valid() const noexcept { return tag_ != DataTag::UNINITIALISED; }
-        bool is_str() const noexcept { return tag_ == DataTag::STR; }
-        bool is_int() const noexcept { return tag_ == DataTag::INT; }
-        bool is_list() const noexcept { return tag_ == DataTag::LIST; }
-        bool is_dict() const noexcept { return tag_ == DataTag::DICT; }
+            template<>
+            struct tag_to_make_specifier<DataTag::STR> : ::std::integral_constant<MakeStr, make_str> {
+            };
+            template<>
+            struct tag_to_make_specifier<DataTag::INT> : ::std::integral_constant<MakeInt, make_int> {
+            };
+            template<>
+            struct tag_to_make_specifier<DataTag::LIST> : ::std::integral_constant<MakeList, make_list> {
+            };
+            template<>
+            struct tag_to_make_specifier<DataTag::DICT> : ::std::integral_constant<MakeDict, make_dict> {
+            };
+        }  // namespace torrebis::bencode::helpers::detail  (Private)
 
-        template<DataTag tag>
-        tag_to_ptr_t<tag> get() noexcept {
-            return (tag == DataTag::UNINITIALISED || tag == tag_)
-                   ? ::std::static_pointer_cast<tag_to_type_t<tag>>(value_)
-                   : nullptr;
-        }
+        template<DataTag tag, class StrType, class IntType, class ListType, class DictType, class UninitialisedType>
+        struct tag_to_type;
 
-        template<DataTag tag>
-        tag_to_const_ptr_t<tag> get() const noexcept {
-            return (tag == DataTag::UNINITIALISED || tag == tag_)
-                   ? ::std::static_pointer_cast<tag_to_const_type_t<tag>>(value_)
-                   : nullptr;
-        }
+        template<class StrType, class IntType, class ListType, class DictType, class UninitialisedType>
+        struct tag_to_type<DataTag::STR, StrType, IntType, ListType, DictType, UninitialisedType> {
+            using type = StrType;
+        };
 
-        template<typename T>
-        ::std::shared_ptr<T> get() noexcept {
-            TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<T, void>::value) {
-                return value_;
-            }
-            if (type_to_tag<T>::value == tag_) {
-                return ::std::static_pointer_cast<T>(value_);
-            }
-            return nullptr;
-        }
+        template<class StrType, class IntType, class ListType, class DictType, class UninitialisedType>
+        struct tag_to_type<DataTag::INT, StrType, IntType, ListType, DictType, UninitialisedType> {
+            using type = IntType;
+        };
 
-        template<typename T>
-        const ::std::shared_ptr<const T> get() const noexcept {
-            TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<T, void>::value) {
-                return value_;
-            }
-            if (type_to_tag<T>::value == tag_) {
-                return ::std::static_pointer_cast<const T>(value_);
-            }
-            return nullptr;
-        }
+        template<class StrType, class IntType, class ListType, class DictType, class UninitialisedType>
+        struct tag_to_type<DataTag::LIST, StrType, IntType, ListType, DictType, UninitialisedType> {
+            using type = ListType;
+        };
 
-        void_ptr get(DataTag tag) noexcept {
-            return (tag == DataTag::UNINITIALISED || tag == tag_) ? value_ : nullptr;
-        }
-        const_void_ptr get(DataTag tag) const noexcept {
-            return (tag == DataTag::UNINITIALISED || tag == tag_) ? ::std::static_pointer_cast<const void>(value_) : nullptr;
-        }
+        template<class StrType, class IntType, class ListType, class DictType, class UninitialisedType>
+        struct tag_to_type<DataTag::DICT, StrType, IntType, ListType, DictType, UninitialisedType> {
+            using type = DictType;
+        };
 
-        str_ptr get_str() noexcept { return get<DataTag::STR>(); }
-        const_str_ptr get_str() const noexcept { return get<DataTag::STR>(); }
-        int_ptr get_int() noexcept { return get<DataTag::INT>(); }
-        const_int_ptr get_int() const noexcept { return get<DataTag::INT>(); }
-        list_ptr get_list() noexcept { return get<DataTag::LIST>(); }
-        const_list_ptr get_list() const noexcept { return get<DataTag::LIST>(); }
-        dict_ptr get_dict() noexcept { return get<DataTag::DICT>(); }
-        const_dict_ptr get_dict() const noexcept { return get<DataTag::DICT>(); }
-        void_ptr get_any() noexcept { return get<DataTag::UNINITIALISED>(); }
-        const_void_ptr get_any() const noexcept { return get<DataTag::UNINITIALISED>(); }
+        template<class StrType, class IntType, class ListType, class DictType, class UninitialisedType>
+        struct tag_to_type<DataTag::UNINITIALISED, StrType, IntType, ListType, DictType, UninitialisedType> {
+            using type = UninitialisedType;
+        };
 
-        template<DataTag tag>
-        void set(const tag_to_type<tag> value) {
-            using allocator_t = tag_to_allocator_t<tag>;
-            value_ = ::std::allocate_shared<tag_to_type_t<tag>, allocator_t>(allocator_t(), value);
-        }
+        template<DataTag tag, class StrType, class IntType, class ListType, class DictType, class UninitialisedType>
+        using tag_to_type_t = typename tag_to_type<tag, StrType, IntType, ListType, DictType, UninitialisedType>::type;
 
-        template<DataTag tag>
-        void set(const tag_to_ptr<tag> value) noexcept {
-            if (value == nullptr || tag == DataTag::UNINITIALISED) {
-                tag_ = DataTag::UNINITIALISED;
-                value_ = nullptr;
-                return;
-            }
+        template<DataTag tag, class StrType, class IntType, class ListType, class DictType>
+        struct itag_to_type;
 
-            using type = tag_to_type<tag>;
-            if (tag != tag_) {
-                tag_ = tag;
-                value = nullptr;
-            }
-            ::std::static_pointer_cast<type>(value_) = value;
-        }
+        template<class StrType, class IntType, class ListType, class DictType>
+        struct itag_to_type<DataTag::STR, StrType, IntType, ListType, DictType> {
+            using type = StrType;
+        };
 
-        void set(const DataTag tag, const ::std::shared_ptr<void> value) noexcept {
-            if (value == nullptr || tag == DataTag::UNINITIALISED) {
-                tag_ = DataTag::UNINITIALISED;
-                value_ = nullptr;
-                return;
-            }
-            if (tag != tag_) {
-                tag_ = tag;
-            }
-            value_ = value;
-        }
+        template<class StrType, class IntType, class ListType, class DictType>
+        struct itag_to_type<DataTag::INT, StrType, IntType, ListType, DictType> {
+            using type = IntType;
+        };
 
-        template<typename T>
-        void set(T value) { set<type_to_tag<T>::value>(value); }
+        template<class StrType, class IntType, class ListType, class DictType>
+        struct itag_to_type<DataTag::LIST, StrType, IntType, ListType, DictType> {
+            using type = ListType;
+        };
 
-        template<DataTag tag, typename... Args>
-        void set(Args... args) {
-            using type = tag_to_type<tag>;
-            using allocator_t = tag_to_allocator_t<tag>;
-            value_ = ::std::allocate_shared<type, allocator_t>(allocator_t(), type(args...));
-        }
+        template<class StrType, class IntType, class ListType, class DictType>
+        struct itag_to_type<DataTag::DICT, StrType, IntType, ListType, DictType> {
+            using type = DictType;
+        };
 
-        void set_str(const str_type s) { set<DataTag::STR>(s); }
-        void set_str(const str_ptr s) noexcept { set<DataTag::STR>(s); }
-        template<typename... Args> void set_str(Args... args) { set<DataTag::STR>(args...); }
-        void set_int(const int_type i) { set<DataTag::INT>(i); }
-        void set_int(const int_ptr i) noexcept { set<DataTag::INT>(i); }
-        template<typename... Args> void set_int(Args... args) { set<DataTag::INT>(args...); }
-        void set_list(const list_type l) { set<DataTag::LIST>(l); }
-        void set_list(const list_ptr l) noexcept { set<DataTag::LIST>(l); }
-        template<typename... Args> void set_list(Args... args) { set<DataTag::LIST>(args...); }
-        void set_dict(const dict_type d) { set<DataTag::DICT>(d); }
-        void set_dict(const dict_ptr d) noexcept { set<DataTag::DICT>(d); }
-        template<typename... Args> void set_dict(Args... args) { set<DataTag::DICT>(args...); }
+        template<DataTag tag, class StrType, class IntType, class ListType, class DictType>
+        using itag_to_type_t = typename itag_to_type<tag, StrType, IntType, ListType, DictType>::type;
 
-        template<DataTag tag>
-        static basic_data make(const tag_to_type<tag> value) {
-            using allocator_t = tag_to_allocator_t<tag>;
-            return basic_data(
-                helpers::detail::tag_to_make_specifier<tag>::value,
-                ::std::allocate_shared<tag_to_type_t<tag>, allocator_t>(allocator_t(), value)
-            );
-        }
+        template<DataTag tag, typename StrType, StrType StrValue, typename IntType, IntType IntValue, typename ListType, ListType ListValue, typename DictType, DictType DictValue>
+        struct tag_to_value;
 
-        template<DataTag tag>
-        static basic_data make(const tag_to_ptr<tag> value) noexcept {
-            if (value == nullptr || tag == DataTag::UNINITIALISED) {
-                return basic_data();
-            }
+        template<typename StrType, StrType StrValue, typename IntType, IntType IntValue, typename ListType, ListType ListValue, typename DictType, DictType DictValue>
+        struct tag_to_value<DataTag::STR, StrType, StrValue, IntType, IntValue, ListType, ListValue, DictType, DictValue> : ::std::integral_constant<StrType, StrValue> {};
 
-            return basic_data(
-                helpers::detail::tag_to_make_specifier<tag>::value,
-                value
-            );
-        }
+        template<typename StrType, StrType StrValue, typename IntType, IntType IntValue, typename ListType, ListType ListValue, typename DictType, DictType DictValue>
+        struct tag_to_value<DataTag::INT, StrType, StrValue, IntType, IntValue, ListType, ListValue, DictType, DictValue> : ::std::integral_constant<IntType, IntValue> {};
 
-        static basic_data make(const DataTag tag, const ::std::shared_ptr<void> value) noexcept {
-            if (value == nullptr || tag == DataTag::UNINITIALISED) {
-                return basic_data();
-            }
-            switch (tag) {
-                case DataTag::STR:
-                    return basic_data(make_str, value);
-                case DataTag::INT:
-                    return basic_data(make_int, value);
-                case DataTag::LIST:
-                    return basic_data(make_list, value);
-                case DataTag::DICT:
-                    return basic_data(make_dict, value);
-                default:
-                    return basic_data();
-            }
-        }
+        template<typename StrType, StrType StrValue, typename IntType, IntType IntValue, typename ListType, ListType ListValue, typename DictType, DictType DictValue>
+        struct tag_to_value<DataTag::LIST, StrType, StrValue, IntType, IntValue, ListType, ListValue, DictType, DictValue> : ::std::integral_constant<ListType, ListValue> {};
 
-        template<typename T>
-        static basic_data make(T value) { return make<type_to_tag<T>::value>(value); }
+        template<typename StrType, StrType StrValue, typename IntType, IntType IntValue, typename ListType, ListType ListValue, typename DictType, DictType DictValue>
+        struct tag_to_value<DataTag::DICT, StrType, StrValue, IntType, IntValue, ListType, ListValue, DictType, DictValue> : ::std::integral_constant<DictType, DictValue> {};
 
-        template<DataTag tag, typename... Args>
-        static basic_data make(Args... args) {
-            using type = tag_to_type_t<tag>;
-            using allocator_t = tag_to_allocator_t<tag>;
-            return basic_data(
-                helpers::detail::tag_to_make_specifier<tag>::value,
-                ::std::allocate_shared<type, allocator_t>(allocator_t(), type(args...))
-            );
-        }
 
-        static basic_data make_str(const str_type s) { return make<DataTag::STR>(s); }
-        static basic_data make_str(const str_ptr s) noexcept { return make<DataTag::STR>(s); }
-        template<typename... Args> static basic_data make_str(Args... args) { return make<DataTag::STR>(args...); }
-        static basic_data make_int(const int_type i) { return make<DataTag::INT>(i); }
-        static basic_data make_int(const int_ptr i) noexcept { return make<DataTag::INT>(i); }
-        template<typename... Args> static basic_data make_int(Args... args) { return make<DataTag::INT>(args...); }
-        static basic_data make_list(const list_type l) { return make<DataTag::LIST>(l); }
-        static basic_data make_list(const list_ptr l) noexcept { return make<DataTag::LIST>(l); }
-        template<typename... Args> static basic_data make_list(Args... args) { return make<DataTag::LIST>(args...); }
-        static basic_data make_dict(const dict_type d) { return make<DataTag::DICT>(d); }
-        static basic_data make_dict(const dict_ptr d) noexcept { return make<DataTag::DICT>(d); }
-        template<typename... Args> static basic_data make_dict(Args... args) { return make<DataTag::DICT>(args...); }
+        template<class T, class StrType, class IntType, class ListType, class DictType>
+        struct type_to_tag;
 
-        void reset() noexcept { tag_ = DataTag::UNINITIALISED; value_ = nullptr; }
+        template<class StrType, class IntType, class ListType, class DictType>
+        struct type_to_tag<StrType, StrType, IntType, ListType, DictType> : ::std::integral_constant<DataTag, DataTag::STR> {};
 
-        ~basic_data() noexcept { tag_ = DataTag::UNINITIALISED; value_ = nullptr; }
+        template<class StrType, class IntType, class ListType, class DictType>
+        struct type_to_tag<IntType, StrType, IntType, ListType, DictType> : ::std::integral_constant<DataTag, DataTag::INT> {};
 
-        using path_el_type = basic_path_el<str_type>;
+        template<class StrType, class IntType, class ListType, class DictType>
+        struct type_to_tag<ListType, StrType, IntType, ListType, DictType> : ::std::integral_constant<DataTag, DataTag::LIST> {};
 
-        template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
-        const basic_data* get_path(PathEls... path) const {
-            const basic_data* result = this;
-            const path_el_type path_arr[sizeof...(path)] = { path... };
-            for (::std::size_t i = 0; i < sizeof...(path); ++i) {
-                const path_el_type path_i(path_arr[i]);
-                if (path_i.is_key()) {
-                    if (!result->is_dict()) {
-                        return nullptr;
-                    }
-                    dict_type& dict = result->get_dict();
-                    auto search = dict.find(*path_i.get_key());
-                    if (search == dict.end()) {
-                        return nullptr;
+        template<class StrType, class IntType, class ListType, class DictType>
+        struct type_to_tag<DictType, StrType, IntType, ListType, DictType> : ::std::integral_constant<DataTag, DataTag::DICT> {};
+
+        template<class StrType, class IntType, class ListType, class DictType>
+        struct type_to_tag<void, StrType, IntType, ListType, DictType> : ::std::integral_constant<DataTag, DataTag::UNINITIALISED> {};
+
+#ifdef TORREBIS_VARIABLE_TEMPLATES
+        template<DataTag tag, typename StrType, StrType StrValue, typename IntType, IntType IntValue, typename ListType, ListType ListValue, typename DictType, DictType DictValue>
+        constexpr
+        typename tag_to_value<tag, StrType, StrValue, IntType, IntValue, ListType, ListValue, DictType, DictValue>::type
+        tag_to_value_v = tag_to_value<tag, StrType, StrValue, IntType, IntValue, ListType, ListValue, DictType, DictValue>::value;
+
+        template<class T, class StrType, class IntType, class ListType, class DictType>
+        constexpr DataTag type_to_tag_v = type_to_tag<T, StrType, IntType, ListType, DictType>::value;
+#endif
+
+    }  // namespace ::torrebis::bencode::helpers
+
+} }  // namespace ::torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_TYPE_TAGS_H_
+
+// Done expanding  #include "torrebis_bencode/type_tags.h"
+
+// Expanding  #include "torrebis_bencode/path_el.h"
+#ifndef TORREBIS_BENCODE_PATH_EL_H_
+#define TORREBIS_BENCODE_PATH_EL_H_
+
+#include <string>
+#include <memory>
+#include <type_traits>
+
+
+
+namespace torrebis { namespace bencode {
+    template<class StrType_ = ::std::string, template<typename T> class Allocator_ = ::std::allocator>
+    class basic_path_el final {
+    public:
+        using StrType = StrType_;
+        template<typename T>
+        using Allocator = Allocator_<T>;
+
+        using str_type = StrType;
+        using str_ptr_type = ::std::shared_ptr<str_type>;
+        using allocator_t = Allocator<str_type>;
+
+        using index_type = ::std::size_t;
+    private:
+        DataTag tag_;  // Can only be DataTag::STR or DataTag::INT
+        union KeyOrIndex {
+            str_ptr_type key;
+            index_type index;
+
+            KeyOrIndex(const index_type i) noexcept : index(i) {}
+            KeyOrIndex(const str_type k) : key(::std::allocate_shared<str_type, allocator_t>(allocator_t(), k)) {}
+            KeyOrIndex(const str_type k, const allocator_t& alloc) : key(::std::allocate_shared<str_type, allocator_t>(alloc, k)) {}
+            KeyOrIndex(const str_ptr_type k) noexcept : key(k) {}
+            KeyOrIndex() noexcept : key(nullptr) {}
+
+            ~KeyOrIndex() noexcept {}  // basic_path_el class should handle this.
+        } key_or_index_;
+    public:
+
+#ifdef TORREBIS_HAS_IS_NOTHROW_CONVERTIBLE
+        template<class T>
+        basic_path_el(
+            const typename ::std::enable_if<::std::is_convertible<T, index_type>::value && !::std::is_nothrow_convertible<T, index_type>::value, T>::type i
+        ) : tag_(DataTag::INT), key_or_index_(static_cast<::std::size_t>(i)) {}
+
+        template<class T>
+        basic_path_el(
+            const typename ::std::enable_if<::std::is_nothrow_convertible<T, index_type>::value, T>::type i
+        ) noexcept : tag_(DataTag::INT), key_or_index_(static_cast<::std::size_t>(i)) {}
+#else
+        template<class T>
+        basic_path_el(
+            const typename ::std::enable_if<::std::is_convertible<T, index_type>::value && !::std::is_integral<T>::value, T>::type i
+        ) : tag_(DataTag::INT), key_or_index_(static_cast<::std::size_t>(i)) {}
+
+        template<class T>
+        basic_path_el(
+            const typename ::std::enable_if<::std::is_integral<T>::value, T>::type i
+        ) noexcept : tag_(DataTag::INT), key_or_index_(static_cast<::std::size_t>(i)) {}
+#endif
+
+        basic_path_el(const index_type i) noexcept : tag_(DataTag::INT), key_or_index_(i) {}
+
+        basic_path_el(const str_type k) : tag_(DataTag::STR), key_or_index_(k) {}
+        // The key is allocated with `alloc`.
+        basic_path_el(const str_type k, const allocator_t& alloc) : tag_(DataTag::STR), key_or_index_(k, alloc) {}
+        basic_path_el(const ::std::shared_ptr<const str_type> k) : tag_(DataTag::STR), key_or_index_(k ? str_type(*k) : nullptr) {}
+        basic_path_el(const str_ptr_type k) noexcept : tag_(DataTag::STR), key_or_index_(k) {}
+        basic_path_el(const basic_path_el& other) noexcept : tag_(other.tag_) { if (tag_ == DataTag::STR) { key_or_index_.key = other.get_key(); } else { key_or_index_.index = other.get_index(); } }
+        basic_path_el(const basic_path_el&& other) noexcept : tag_(other.tag_) { if (tag_ == DataTag::STR) { key_or_index_.key = other.get_key(); } else { key_or_index_.index = other.get_index(); } }
+        template<typename... Args, class = typename helpers::detail::path_el_str_constructor_enable_if<Args...>::type>
+        basic_path_el(const Args... args) : tag_(DataTag::STR), key_or_index_(str_type(args...)) {}
+        basic_path_el& operator=(basic_path_el other) noexcept { if (&other != this) { swap(other); }; return *this; }
+        index_type operator=(index_type other) noexcept { set_index(other); return other; }
+        str_type& operator=(str_type other) noexcept { set_key(other); return other; }
+        str_ptr_type operator=(str_ptr_type other) noexcept { set_key(other); return other; }
+        bool operator==(const basic_path_el& other) const noexcept { if (&other == this) { return true; } if (is_key()) { return other.is_key() && get_key() == other.get_key(); } return other.is_index() && get_index() == other.get_index(); }
+        bool operator!=(const basic_path_el& other) const noexcept { return !operator==(other); }
+        void swap(basic_path_el& other) noexcept {
+            using ::std::swap;
+            if (is_key()) {
+                if (other.is_key()) {
+                    swap(key_or_index_.key, other.key_or_index_.key);
+                } else {
+                    index_type i = other.key_or_index_.index;
+                    other.key_or_index_.key = key_or_index_.key;
+                    key_or_index_.key = nullptr;
+                    key_or_index_.index = i;
+                    other.tag_ = DataTag::STR;
+                    tag_ = DataTag::INT;
+                }
+            } else if (other.is_key()) {
+                index_type i = key_or_index_.index;
+                key_or_index_.key = other.key_or_index_.key;
+                other.key_or_index_.key = nullptr;
+                other.key_or_index_.index = i;
+                tag_ = DataTag::STR;
+                other.tag_ = DataTag::INT;
+            } else {
+                index_type i = key_or_index_.index;
+                key_or_index_.index = other.key_or_index_.index;
+                other.key_or_index_.index = i;
+            }
+        };
+
+        bool is_key() const noexcept { return tag_ == DataTag::STR && key_or_index_.key != nullptr; }
+        bool is_index() const noexcept { return tag_ == DataTag::INT; }
+
+        str_ptr_type get_key() const noexcept { return is_key() ? key_or_index_.key : nullptr; }
+        index_type get_index() const noexcept { return is_index() ? key_or_index_.index : static_cast<index_type>(-1); }
+
+        void set_key(str_type k) { tag_ = DataTag::STR; key_or_index_.key = k; }
+        void set_key(str_ptr_type k) noexcept {
+            if (is_index()) {
+                key_or_index_.index = 0;
+            }
+            tag_ = DataTag::STR;
+            key_or_index_.key = k;
+        }
+        void set_index(index_type i) noexcept {
+            if (is_key()) {
+                key_or_index_.key = nullptr;
+            }
+            tag_ = DataTag::INT;
+            key_or_index_.index = i;
+        }
+
+        ~basic_path_el() noexcept {
+            if (is_key()) {
+                key_or_index_.key = nullptr;
+            } else if (is_index()) {
+                key_or_index_.index = static_cast<index_type>(-1);
+            }
+            tag_ = DataTag::UNINITIALISED;
+        }
+    };
+
+    using path_el = basic_path_el<>;
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_PATH_EL_H_
+
+// Done expanding  #include "torrebis_bencode/path_el.h"
+
+// Expanding  #include "torrebis_bencode/flat_dict.h"
+#ifndef TORREBIS_BENCODE_FLAT_DICT_H_
+#define TORREBIS_BENCODE_FLAT_DICT_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * A map kept as a sorted vector of key / value pairs, for use as the `DictType` of `basic_data`.
+     *
+     * Keys in bencoded dicts are already sorted, so decoding appends every item at the end (`emplace_hint(end(), ...)`)
+     * without allocating a node for it, and lookups are a binary search over contiguous storage. Inserting anywhere
+     * else moves every item after it, and invalidates iterators like `std::vector` does.
+     *
+     * Items can be changed through iterators, but changing a key so that the keys are no longer sorted is undefined.
+     */
+    template<typename Key, typename Value, typename Compare = ::std::less<Key>, typename Allocator = ::std::allocator<::std::pair<Key, Value>>>
+    class flat_dict final {
+    public:
+        using key_type = Key;
+        using mapped_type = Value;
+        using value_type = ::std::pair<Key, Value>;
+        using key_compare = Compare;
+        using allocator_type = Allocator;
+        using storage_type = ::std::vector<value_type, Allocator>;
+        using size_type = typename storage_type::size_type;
+        using difference_type = typename storage_type::difference_type;
+        using reference = value_type&;
+        using const_reference = const value_type&;
+        using iterator = typename storage_type::iterator;
+        using const_iterator = typename storage_type::const_iterator;
+        using reverse_iterator = typename storage_type::reverse_iterator;
+        using const_reverse_iterator = typename storage_type::const_reverse_iterator;
+    private:
+        storage_type items_;
+        Compare compare_;
+
+        bool item_less(const value_type& a, const value_type& b) const { return compare_(a.first, b.first); }
+
+        // Sorts `items_` and removes repeated keys, keeping the first of each like `std::map`.
+        void sort_items() {
+            ::std::stable_sort(items_.begin(), items_.end(), [this](const value_type& a, const value_type& b) {
+                return item_less(a, b);
+            });
+            items_.erase(::std::unique(items_.begin(), items_.end(), [this](const value_type& a, const value_type& b) {
+                return !item_less(a, b);
+            }), items_.end());
+        }
+
+    public:
+        flat_dict() : items_(), compare_() {}
+        explicit flat_dict(const Compare& compare, const Allocator& allocator = Allocator()) : items_(allocator), compare_(compare) {}
+        explicit flat_dict(const Allocator& allocator) : items_(allocator), compare_() {}
+
+        template<class InputIterator>
+        flat_dict(InputIterator first, InputIterator last, const Compare& compare = Compare(), const Allocator& allocator = Allocator()) :
+            items_(first, last, allocator), compare_(compare) { sort_items(); }
+
+        flat_dict(::std::initializer_list<value_type> items, const Compare& compare = Compare(), const Allocator& allocator = Allocator()) :
+            items_(items, allocator), compare_(compare) { sort_items(); }
+
+        flat_dict& operator=(::std::initializer_list<value_type> items) {
+            items_.assign(items);
+            sort_items();
+            return *this;
+        }
+
+        iterator begin() noexcept { return items_.begin(); }
+        const_iterator begin() const noexcept { return items_.begin(); }
+        const_iterator cbegin() const noexcept { return items_.cbegin(); }
+        iterator end() noexcept { return items_.end(); }
+        const_iterator end() const noexcept { return items_.end(); }
+        const_iterator cend() const noexcept { return items_.cend(); }
+        reverse_iterator rbegin() noexcept { return items_.rbegin(); }
+        const_reverse_iterator rbegin() const noexcept { return items_.rbegin(); }
+        reverse_iterator rend() noexcept { return items_.rend(); }
+        const_reverse_iterator rend() const noexcept { return items_.rend(); }
+
+        bool empty() const noexcept { return items_.empty(); }
+        size_type size() const noexcept { return items_.size(); }
+        size_type max_size() const noexcept { return items_.max_size(); }
+        size_type capacity() const noexcept { return items_.capacity(); }
+        void reserve(const size_type n) { items_.reserve(n); }
+        void shrink_to_fit() { items_.shrink_to_fit(); }
+        void clear() noexcept { items_.clear(); }
+
+        key_compare key_comp() const { return compare_; }
+        allocator_type get_allocator() const { return items_.get_allocator(); }
+
+        // The sorted items.
+        const storage_type& items() const noexcept { return items_; }
+
+        iterator lower_bound(const key_type& key) {
+            return ::std::lower_bound(items_.begin(), items_.end(), key, [this](const value_type& item, const key_type& k) {
+                return compare_(item.first, k);
+            });
+        }
+        const_iterator lower_bound(const key_type& key) const {
+            return ::std::lower_bound(items_.begin(), items_.end(), key, [this](const value_type& item, const key_type& k) {
+                return compare_(item.first, k);
+            });
+        }
+
+        iterator upper_bound(const key_type& key) {
+            return ::std::upper_bound(items_.begin(), items_.end(), key, [this](const key_type& k, const value_type& item) {
+                return compare_(k, item.first);
+            });
+        }
+        const_iterator upper_bound(const key_type& key) const {
+            return ::std::upper_bound(items_.begin(), items_.end(), key, [this](const key_type& k, const value_type& item) {
+                return compare_(k, item.first);
+            });
+        }
+
+        ::std::pair<iterator, iterator> equal_range(const key_type& key) {
+            const iterator it = find(key);
+            return { it, it == end() ? it : it + 1 };
+        }
+        ::std::pair<const_iterator, const_iterator> equal_range(const key_type& key) const {
+            const const_iterator it = find(key);
+            return { it, it == end() ? it : it + 1 };
+        }
+
+        iterator find(const key_type& key) {
+            const iterator it = lower_bound(key);
+            return it != end() && !compare_(key, it->first) ? it : end();
+        }
+        const_iterator find(const key_type& key) const {
+            const const_iterator it = lower_bound(key);
+            return it != end() && !compare_(key, it->first) ? it : end();
+        }
+
+        size_type count(const key_type& key) const { return find(key) == end() ? 0 : 1; }
+
+        mapped_type& at(const key_type& key) {
+            const iterator it = find(key);
+            if (it == end()) {
+                throw ::std::out_of_range("flat_dict::at");
+            }
+            return it->second;
+        }
+        const mapped_type& at(const key_type& key) const {
+            const const_iterator it = find(key);
+            if (it == end()) {
+                throw ::std::out_of_range("flat_dict::at");
+            }
+            return it->second;
+        }
+
+        mapped_type& operator[](const key_type& key) {
+            iterator it = lower_bound(key);
+            if (it == end() || compare_(key, it->first)) {
+                it = items_.emplace(it, key, mapped_type());
+            }
+            return it->second;
+        }
+        mapped_type& operator[](key_type&& key) {
+            iterator it = lower_bound(key);
+            if (it == end() || compare_(key, it->first)) {
+                it = items_.emplace(it, ::std::move(key), mapped_type());
+            }
+            return it->second;
+        }
+
+        ::std::pair<iterator, bool> insert(value_type item) {
+            const iterator it = lower_bound(item.first);
+            if (it != end() && !compare_(item.first, it->first)) {
+                return { it, false };
+            }
+            return { items_.insert(it, ::std::move(item)), true };
+        }
+
+        // Inserts at `hint` without a search if that is where `item` goes (So appending sorted items is O(1)).
+        iterator insert(const_iterator hint, value_type item) {
+            const bool after_previous = hint == cbegin() || compare_((hint - 1)->first, item.first);
+            const bool before_next = hint == cend() || compare_(item.first, hint->first);
+            if (after_previous && before_next) {
+                return items_.insert(hint, ::std::move(item));
+            }
+            return insert(::std::move(item)).first;
+        }
+
+        template<class InputIterator>
+        void insert(InputIterator first, InputIterator last) {
+            for (; first != last; ++first) {
+                insert(cend(), value_type(*first));
+            }
+        }
+
+        void insert(::std::initializer_list<value_type> items) { insert(items.begin(), items.end()); }
+
+        template<typename... Args>
+        ::std::pair<iterator, bool> emplace(Args&&... args) { return insert(value_type(::std::forward<Args>(args)...)); }
+
+        template<typename... Args>
+        iterator emplace_hint(const_iterator hint, Args&&... args) {
+            if (hint == cend()) {
+                // Build it in place at the end, and only move it if it doesn't go there
+                items_.emplace_back(::std::forward<Args>(args)...);
+                if (items_.size() == 1 || compare_(items_[items_.size() - 2].first, items_.back().first)) {
+                    return items_.end() - 1;
+                }
+                value_type item(::std::move(items_.back()));
+                items_.pop_back();
+                return insert(::std::move(item)).first;
+            }
+            return insert(hint, value_type(::std::forward<Args>(args)...));
+        }
+
+        iterator erase(const_iterator pos) { return items_.erase(pos); }
+        iterator erase(const_iterator first, const_iterator last) { return items_.erase(first, last); }
+        size_type erase(const key_type& key) {
+            const iterator it = find(key);
+            if (it == end()) {
+                return 0;
+            }
+            items_.erase(it);
+            return 1;
+        }
+
+        void swap(flat_dict& other) {
+            using ::std::swap;
+            swap(items_, other.items_);
+            swap(compare_, other.compare_);
+        }
+
+        friend void swap(flat_dict& a, flat_dict& b) { a.swap(b); }
+
+        friend bool operator==(const flat_dict& a, const flat_dict& b) { return a.items_ == b.items_; }
+        friend bool operator!=(const flat_dict& a, const flat_dict& b) { return !(a == b); }
+        friend bool operator<(const flat_dict& a, const flat_dict& b) { return a.items_ < b.items_; }
+    };
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_FLAT_DICT_H_
+
+// Done expanding  #include "torrebis_bencode/flat_dict.h"
+
+// Expanding  #include "torrebis_bencode/arena.h"
+#ifndef TORREBIS_BENCODE_ARENA_H_
+#define TORREBIS_BENCODE_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * A monotonic arena. Allocating bumps a pointer through a chunk of memory, deallocating does nothing, and all of
+     * it is given back at once by `reset()` or the destructor. Everything allocated in an arena must be destroyed
+     * before it is reset.
+     *
+     * Not thread safe. Use one arena per thread.
+     */
+    class arena final {
+    private:
+        struct chunk {
+            chunk* previous;
+            ::std::size_t size;  // Usable bytes after this header
+        };
+
+        static constexpr ::std::size_t header_size = (sizeof(chunk) + alignof(::std::max_align_t) - 1) & ~(alignof(::std::max_align_t) - 1);
+
+        chunk* chunks_;  // The chunk being allocated from, or nullptr
+        chunk* spare_;  // A chunk kept by `reset()` for when the caller supplied buffer fills up again, or nullptr
+        char* buffer_;  // The caller supplied buffer, used before any chunks
+        ::std::size_t buffer_size_;
+        char* pos_;
+        char* end_;
+        ::std::size_t next_chunk_size_;
+        ::std::size_t bytes_used_;
+
+        static char* chunk_data(chunk* const c) noexcept { return reinterpret_cast<char*>(c) + header_size; }
+
+        // Aligns `pos_` to `align`, returning nullptr if `size` bytes don't fit after that.
+        void* bump(const ::std::size_t size, const ::std::size_t align) noexcept {
+            if (pos_ == nullptr) {
+                return nullptr;
+            }
+            const ::std::uintptr_t pos = reinterpret_cast<::std::uintptr_t>(pos_);
+            const ::std::size_t padding = (align - (pos & (align - 1))) & (align - 1);
+            if (padding > static_cast<::std::size_t>(end_ - pos_) || size > static_cast<::std::size_t>(end_ - pos_) - padding) {
+                return nullptr;
+            }
+            char* const result = pos_ + padding;
+            pos_ = result + size;
+            bytes_used_ += padding + size;
+            return result;
+        }
+
+        void use_chunk(chunk* const c) noexcept {
+            c->previous = chunks_;
+            chunks_ = c;
+            pos_ = chunk_data(c);
+            end_ = pos_ + c->size;
+        }
+
+        void add_chunk(const ::std::size_t at_least) {
+            constexpr ::std::size_t max_size = static_cast<::std::size_t>(-1);
+            ::std::size_t size = next_chunk_size_;
+            while (size < at_least) {
+                size = size > max_size / 2 ? at_least : size * 2;
+            }
+            if (size > max_size - header_size) {
+                throw ::std::bad_alloc();
+            }
+            chunk* const c = static_cast<chunk*>(::operator new(header_size + size));
+            c->size = size;
+            use_chunk(c);
+            next_chunk_size_ = size > max_size / 2 ? size : size * 2;
+        }
+
+        void free_spare() noexcept {
+            if (spare_ != nullptr) {
+                ::operator delete(spare_);
+                spare_ = nullptr;
+            }
+        }
+
+        static arena*& current_ref() noexcept {
+            static thread_local arena* current = nullptr;
+            return current;
+        }
+
+    public:
+        static constexpr ::std::size_t default_chunk_size = 4096;
+
+        explicit arena(const ::std::size_t first_chunk_size = default_chunk_size) noexcept :
+            chunks_(nullptr), spare_(nullptr), buffer_(nullptr), buffer_size_(0), pos_(nullptr), end_(nullptr),
+            next_chunk_size_(first_chunk_size == 0 ? 1 : first_chunk_size), bytes_used_(0) {}
+
+        // Allocates from `buffer` first, then from the heap once it is full. `buffer` must outlive the arena.
+        arena(void* const buffer, const ::std::size_t size, const ::std::size_t next_chunk_size = default_chunk_size) noexcept :
+            chunks_(nullptr), spare_(nullptr), buffer_(static_cast<char*>(buffer)), buffer_size_(size), pos_(buffer_), end_(buffer_ + size),
+            next_chunk_size_(next_chunk_size == 0 ? 1 : next_chunk_size), bytes_used_(0) {}
+
+        arena(const arena&) = delete;
+        arena& operator=(const arena&) = delete;
+
+        ~arena() noexcept { release(); }
+
+        // Never returns nullptr. Throws `std::bad_alloc` if the heap is out of memory or `size` is too big.
+        void* allocate(const ::std::size_t size, const ::std::size_t align = alignof(::std::max_align_t)) {
+            void* result = bump(size, align);
+            if (result != nullptr) {
+                return result;
+            }
+            if (spare_ != nullptr) {
+                chunk* const c = spare_;
+                spare_ = nullptr;
+                use_chunk(c);
+                result = bump(size, align);
+                if (result != nullptr) {
+                    return result;
+                }
+            }
+            if (size > static_cast<::std::size_t>(-1) - align) {
+                throw ::std::bad_alloc();
+            }
+            add_chunk(size + align);
+            result = bump(size, align);
+            if (result == nullptr) {
+                throw ::std::bad_alloc();
+            }
+            return result;
+        }
+
+        /*
+         * Makes all of the memory available again. The most recent (largest) chunk is kept, so an arena that is reset
+         * between documents of about the same size stops allocating from the heap. With a caller supplied buffer,
+         * the buffer is used first again and the kept chunk once it is full.
+         */
+        void reset() noexcept {
+            // Chunks only ever grow, so the newest is the largest. `spare_` is only set when there are no chunks.
+            chunk* const keep = chunks_ != nullptr ? chunks_ : spare_;
+            while (chunks_ != nullptr) {
+                chunk* const previous = chunks_->previous;
+                if (chunks_ != keep) {
+                    ::operator delete(chunks_);
+                }
+                chunks_ = previous;
+            }
+            spare_ = nullptr;
+            if (buffer_ != nullptr) {
+                spare_ = keep;
+                pos_ = buffer_;
+                end_ = buffer_ + buffer_size_;
+            } else if (keep != nullptr) {
+                use_chunk(keep);
+            }
+            bytes_used_ = 0;
+        }
+
+        // Gives all of the memory back to the heap.
+        void release() noexcept {
+            free_spare();
+            while (chunks_ != nullptr) {
+                chunk* const previous = chunks_->previous;
+                ::operator delete(chunks_);
+                chunks_ = previous;
+            }
+            pos_ = buffer_;
+            end_ = buffer_ == nullptr ? nullptr : buffer_ + buffer_size_;
+            bytes_used_ = 0;
+        }
+
+        // How many bytes have been allocated since the last reset, including alignment padding.
+        ::std::size_t bytes_used() const noexcept { return bytes_used_; }
+
+        // The arena of the innermost `scope` on this thread, or nullptr.
+        static arena* current() noexcept { return current_ref(); }
+
+        /*
+         * While a scope is alive, `arena_allocator`s that are default constructed on this thread allocate from its
+         * arena. Scopes can be nested.
+         */
+        class scope final {
+        private:
+            arena* previous_;
+        public:
+            explicit scope(arena& a) noexcept : previous_(current_ref()) { current_ref() = &a; }
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+            ~scope() noexcept { current_ref() = previous_; }
+        };
+    };
+
+    /*
+     * An allocator that allocates from an `arena`. A default constructed allocator uses `arena::current()`, so it can
+     * be the `Allocator` of `basic_data`, which default constructs its allocators. With no arena it uses the heap.
+     */
+    template<typename T>
+    class arena_allocator {
+    private:
+        arena* arena_;
+
+        template<typename U>
+        friend class arena_allocator;
+    public:
+        using value_type = T;
+
+        arena_allocator() noexcept : arena_(arena::current()) {}
+        explicit arena_allocator(arena& a) noexcept : arena_(&a) {}
+        template<typename U>
+        arena_allocator(const arena_allocator<U>& other) noexcept : arena_(other.arena_) {}
+
+        T* allocate(const ::std::size_t n) {
+            if (n > static_cast<::std::size_t>(-1) / sizeof(T)) {
+                throw ::std::bad_alloc();
+            }
+            if (arena_ == nullptr) {
+                return static_cast<T*>(::operator new(n * sizeof(T)));
+            }
+            return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* const p, const ::std::size_t n) noexcept {
+            static_cast<void>(n);
+            if (arena_ == nullptr) {
+                ::operator delete(p);
+            }
+        }
+
+        // The arena this allocates from, or nullptr for the heap.
+        arena* get_arena() const noexcept { return arena_; }
+
+        template<typename U>
+        bool operator==(const arena_allocator<U>& other) const noexcept { return arena_ == other.arena_; }
+        template<typename U>
+        bool operator!=(const arena_allocator<U>& other) const noexcept { return arena_ != other.arena_; }
+    };
+
+    using arena_string = ::std::basic_string<char, ::std::char_traits<char>, arena_allocator<char>>;
+
+    template<typename ValueType, typename...>
+    using arena_vector = ::std::vector<ValueType, arena_allocator<ValueType>>;
+
+    template<typename KeyType, typename ValueType, typename...>
+    using arena_map = ::std::map<KeyType, ValueType, ::std::less<KeyType>, arena_allocator<::std::pair<const KeyType, ValueType>>>;
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_ARENA_H_
+
+// Done expanding  #include "torrebis_bencode/arena.h"
+
+// Expanding  #include "torrebis_bencode/key_table.h"
+#ifndef TORREBIS_BENCODE_KEY_TABLE_H_
+#define TORREBIS_BENCODE_KEY_TABLE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+
+
+namespace torrebis { namespace bencode {
+    namespace helpers {
+        namespace detail {
+            // The characters of a `shared_string` follow this header in the same allocation.
+            struct shared_string_node {
+                ::std::atomic<::std::size_t> refcount;
+                ::std::size_t size;
+
+                char* chars() noexcept { return reinterpret_cast<char*>(this + 1); }
+            };
+        }  // namespace torrebis::bencode::helpers::detail  (Private)
+    }  // namespace torrebis::bencode::helpers
+
+    /*
+     * An immutable string whose characters are shared between copies, like a `std::shared_ptr<const std::string>`
+     * in a single allocation. It can be the `StrType` of `basic_data` (See `shared_string_data`), so that dict keys
+     * can come from a `key_table`.
+     */
+    class shared_string final {
+    public:
+        using value_type = char;
+        using traits_type = ::std::char_traits<char>;
+        using size_type = ::std::size_t;
+        using difference_type = ::std::ptrdiff_t;
+        using const_reference = const char&;
+        using const_pointer = const char*;
+        using const_iterator = const char*;
+        using iterator = const_iterator;
+    private:
+        helpers::detail::shared_string_node* node_;  // nullptr for the empty string
+
+        void release() noexcept {
+            if (node_ != nullptr && node_->refcount.fetch_sub(1, ::std::memory_order_acq_rel) == 1) {
+                node_->~shared_string_node();
+                ::operator delete(node_);
+            }
+            node_ = nullptr;
+        }
+    public:
+        shared_string() noexcept : node_(nullptr) {}
+
+        shared_string(const char* const s, const size_type size) : node_(nullptr) {
+            if (size == 0) {
+                return;
+            }
+            void* const memory = ::operator new(sizeof(helpers::detail::shared_string_node) + size + 1);
+            node_ = ::new (memory) helpers::detail::shared_string_node{ { 1 }, size };
+            ::std::memcpy(node_->chars(), s, size);
+            node_->chars()[size] = '\0';
+        }
+
+        shared_string(const char* const c_str) : shared_string(c_str, ::std::strlen(c_str)) {}
+        shared_string(const str_view s) : shared_string(s.data(), s.size()) {}
+        template<class Allocator>
+        shared_string(const ::std::basic_string<char, traits_type, Allocator>& s) : shared_string(s.data(), s.size()) {}
+
+        shared_string(const shared_string& other) noexcept : node_(other.node_) {
+            if (node_ != nullptr) {
+                node_->refcount.fetch_add(1, ::std::memory_order_relaxed);
+            }
+        }
+
+        shared_string(shared_string&& other) noexcept : node_(other.node_) { other.node_ = nullptr; }
+
+        shared_string& operator=(shared_string other) noexcept {
+            swap(other);
+            return *this;
+        }
+
+        ~shared_string() noexcept { release(); }
+
+        void swap(shared_string& other) noexcept { ::std::swap(node_, other.node_); }
+        friend void swap(shared_string& a, shared_string& b) noexcept { a.swap(b); }
+
+        const char* data() const noexcept { return node_ == nullptr ? "" : node_->chars(); }
+        const char* c_str() const noexcept { return data(); }
+        size_type size() const noexcept { return node_ == nullptr ? 0 : node_->size; }
+        size_type length() const noexcept { return size(); }
+        bool empty() const noexcept { return node_ == nullptr; }
+
+        const_iterator begin() const noexcept { return data(); }
+        const_iterator cbegin() const noexcept { return data(); }
+        const_iterator end() const noexcept { return data() + size(); }
+        const_iterator cend() const noexcept { return data() + size(); }
+
+        const_reference operator[](const size_type i) const noexcept { return data()[i]; }
+
+        // Whether this and `other` share the same characters (Not just equal ones).
+        bool shares_with(const shared_string& other) const noexcept { return node_ == other.node_; }
+
+        operator str_view() const noexcept { return str_view(data(), size()); }
+
+        template<class Allocator = ::std::allocator<char>>
+        ::std::basic_string<char, traits_type, Allocator> to_string() const {
+            return ::std::basic_string<char, traits_type, Allocator>(data(), size());
+        }
+
+        template<class Allocator>
+        explicit operator ::std::basic_string<char, traits_type, Allocator>() const { return to_string<Allocator>(); }
+
+        int compare(const shared_string& other) const noexcept {
+            if (node_ == other.node_) {
+                return 0;
+            }
+            return str_view(*this).compare(str_view(other));
+        }
+
+        friend bool operator==(const shared_string& a, const shared_string& b) noexcept {
+            return a.node_ == b.node_ || (a.size() == b.size() && ::std::memcmp(a.data(), b.data(), a.size()) == 0);
+        }
+        friend bool operator!=(const shared_string& a, const shared_string& b) noexcept { return !(a == b); }
+        friend bool operator<(const shared_string& a, const shared_string& b) noexcept { return a.compare(b) < 0; }
+        friend bool operator<=(const shared_string& a, const shared_string& b) noexcept { return a.compare(b) <= 0; }
+        friend bool operator>(const shared_string& a, const shared_string& b) noexcept { return a.compare(b) > 0; }
+        friend bool operator>=(const shared_string& a, const shared_string& b) noexcept { return a.compare(b) >= 0; }
+
+        friend ::std::ostream& operator<<(::std::ostream& os, const shared_string& s) { return os.write(s.data(), static_cast<::std::streamsize>(s.size())); }
+    };
+
+    namespace helpers {
+        namespace detail {
+            template<>
+            struct has_char_t<char, shared_string> : ::std::true_type {};
+        }  // namespace torrebis::bencode::helpers::detail  (Private)
+    }  // namespace torrebis::bencode::helpers
+
+    /*
+     * Interns dict keys, so that every decoded key with the same characters shares one `shared_string`.
+     *
+     * While a `key_table::scope` is alive, `load`, `load_lazy` and `push_decoder` take the keys of any `basic_data`
+     * whose `StrType` is `shared_string` from its table. A table can be kept for as long as documents keep being
+     * decoded; the keys it hands out don't depend on it, so it can be cleared or destroyed at any time. The keys of a
+     * lazily loaded dict are decoded when it is first accessed, so they are only interned if that is inside a scope.
+     *
+     * Not thread safe. Use one table per thread (The strings themselves can be shared between threads).
+     */
+    class key_table final {
+    private:
+        struct view_hash {
+            ::std::size_t operator()(const str_view s) const noexcept {
+                return helpers::detail::hash_bytes(s.data(), s.size());
+            }
+        };
+
+        // Each key views the characters of its value
+        ::std::unordered_map<str_view, shared_string, view_hash> keys_;
+
+        static key_table*& current_ref() noexcept {
+            static thread_local key_table* current = nullptr;
+            return current;
+        }
+    public:
+        key_table() = default;
+        key_table(const key_table&) = delete;
+        key_table& operator=(const key_table&) = delete;
+
+        // The string with the characters of `s`, shared with every other time it was interned.
+        shared_string intern(const char* const s, const ::std::size_t size) {
+            auto search = keys_.find(str_view(s, size));
+            if (search != keys_.end()) {
+                return search->second;
+            }
+            shared_string interned(s, size);
+            keys_.emplace(str_view(interned), interned);
+            return interned;
+        }
+
+        shared_string intern(const str_view s) { return intern(s.data(), s.size()); }
+
+        // How many different strings have been interned.
+        ::std::size_t size() const noexcept { return keys_.size(); }
+
+        // Forgets every string. Strings that were handed out are still valid.
+        void clear() noexcept { keys_.clear(); }
+
+        // The table of the innermost `scope` on this thread, or nullptr.
+        static key_table* current() noexcept { return current_ref(); }
+
+        // While a scope is alive, decoders on this thread intern keys in its table. Scopes can be nested.
+        class scope final {
+        private:
+            key_table* previous_;
+        public:
+            explicit scope(key_table& table) noexcept : previous_(current_ref()) { current_ref() = &table; }
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+            ~scope() noexcept { current_ref() = previous_; }
+        };
+    };
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_KEY_TABLE_H_
+
+// Done expanding  #include "torrebis_bencode/key_table.h"
+
+// Expanding  #include "torrebis_bencode/data_class.h"
+#ifndef TORREBIS_BENCODE_DATA_CLASS_H_
+#define TORREBIS_BENCODE_DATA_CLASS_H_
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <initializer_list>
+#include <stdexcept>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <ostream>
+
+#ifdef TORREBIS_STD_ARRAY_HAS_DATA
+#include <array>
+#endif
+
+
+// Expanding  #include "torrebis_bencode/events.h"
+#ifndef TORREBIS_BENCODE_EVENTS_H_
+#define TORREBIS_BENCODE_EVENTS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * A handler for `bdecode_events` that does nothing. Inherit from it to only handle some events.
+     *
+     * Strings passed to a handler point into the buffer being decoded.
+     */
+    template<typename IntType = ::std::intmax_t>
+    struct basic_event_handler {
+        using int_type = IntType;
+
+        void on_int(const int_type i) { static_cast<void>(i); }
+        void on_string(const char* const str, const ::std::size_t size) { static_cast<void>(str); static_cast<void>(size); }
+        void begin_list() {}
+        void end_list() {}
+        void begin_dict() {}
+        // Called for every key, before the value for that key.
+        void dict_key(const char* const key, const ::std::size_t size) { static_cast<void>(key); static_cast<void>(size); }
+        void end_dict() {}
+    };
+
+    using event_handler = basic_event_handler<>;
+
+    namespace helpers {
+        namespace detail {
+            template<typename IntType, class Handler>
+            static void events_bdecode_loop(const char* const begin, ::std::size_t& i, const ::std::size_t size, Handler& handler) {
+                if (i >= size) {
+                    throw errors::expecting_value_error.copy();
+                }
+                switch (begin[i]) {
+                    case 'i':
+                        // int "ixxxe"
+                        ++i;
+                        handler.on_int(pointer_read_int<IntType, char>(begin, i, size, 'e', nullptr));
+                        return;
+                    case 'l':
+                        // list "lxxxe"
+                        ++i;
+                        handler.begin_list();
+                        while (true) {
+                            if (i >= size) {
+                                throw errors::expecting_value_error.copy();
+                            }
+                            if (begin[i] == 'e') {
+                                break;
+                            }
+                            events_bdecode_loop<IntType, Handler>(begin, i, size, handler);
+                        }
+                        ++i;
+                        handler.end_list();
+                        return;
+                    case 'd': {
+                        // dict "dxxxe"
+                        ++i;
+                        handler.begin_dict();
+                        const char* last_key_begin = nullptr;
+                        ::std::size_t last_key_size = 0;
+                        while (true) {
+                            if (i >= size) {
+                                throw errors::expecting_value_error.copy();
+                            }
+                            if (begin[i] == 'e') {
+                                break;
+                            }
+                            auto key = pointer_read_str_fast(begin, i, size, nullptr);
+                            if (last_key_begin != nullptr) {
+                                if (!key_less_than(last_key_begin, last_key_size, key.first, key.second)) {
+                                    throw errors::key_order_error.copy();
+                                }
+                            }
+                            last_key_begin = key.first;
+                            last_key_size = key.second;
+                            handler.dict_key(key.first, key.second);
+                            events_bdecode_loop<IntType, Handler>(begin, i, size, handler);
+                        }
+                        ++i;
+                        handler.end_dict();
+                        return;
+                    }
+                    case '0': case '1': case '2':
+                    case '3': case '4': case '5':
+                    case '6': case '7': case '8':
+                    case '9': {
+                        // str "yy:xxxx"
+                        auto str = pointer_read_str_fast(begin, i, size, nullptr);
+                        handler.on_string(str.first, str.second);
+                        return;
+                    }
+                    default:
+                        throw errors::unknown_value_error.copy();
+                }
+            }
+        }  // namespace torrebis::bencode::helpers::detail  (Private)
+    }  // namespace torrebis::bencode::helpers
+
+    /*
+     * Decodes some bencoded data without building a `data`, calling `handler.on_int(i)`, `handler.on_string(ptr, size)`,
+     * `handler.begin_list()`, `handler.end_list()`, `handler.begin_dict()`, `handler.dict_key(ptr, size)` and
+     * `handler.end_dict()` as each part is read. `Handler` is a template parameter, so these calls can be inlined.
+     *
+     * The data is validated like `data::load`, and a `decoding_error` is thrown if it is invalid (possibly after some
+     * events have already been handled).
+     */
+    template<typename IntType = ::std::intmax_t, class Handler>
+    void bdecode_events(const char* const begin, const ::std::size_t size, Handler& handler) {
+        ::std::size_t i = 0;
+        helpers::detail::events_bdecode_loop<IntType, Handler>(begin, i, size, handler);
+        if (i != size) {
+            throw errors::early_end_error.copy();
+        }
+    }
+
+    template<typename IntType = ::std::intmax_t, typename T, class Handler>
+    void bdecode_events(const T* const begin, const ::std::size_t size, Handler& handler) {
+        static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+        bdecode_events<IntType, Handler>(reinterpret_cast<const char*>(begin), size, handler);
+    }
+
+    template<typename IntType = ::std::intmax_t, typename T, typename... Rest, class Handler>
+    void bdecode_events(const ::std::basic_string<T, Rest...>& s, Handler& handler) {
+        bdecode_events<IntType>(s.data(), s.size(), handler);
+    }
+
+    template<typename IntType = ::std::intmax_t, typename T, typename... Rest, class Handler>
+    void bdecode_events(const ::std::vector<T, Rest...>& v, Handler& handler) {
+        bdecode_events<IntType>(v.data(), v.size(), handler);
+    }
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_EVENTS_H_
+
+// Done expanding  #include "torrebis_bencode/events.h"
+
+namespace torrebis { namespace bencode {
+
+// The following macros are used to define out-of-line functions
+
+#define TORREBIS_BASIC_DATA_TEMPLATE_INNER \
+    class StrType, class IntType, template<typename, typename...> class ListType, \
+    bool dict_is_ordered, template<typename, typename, typename...> class DictType, \
+    template<typename> class Allocator
+
+#define TORREBIS_BASIC_DATA_TEMPLATE template<TORREBIS_BASIC_DATA_TEMPLATE_INNER>
+#define TORREBIS_BASIC_DATA_TEMPLATE_TYPE_FORWARD StrType, IntType, ListType, dict_is_ordered, DictType, Allocator
+#define TORREBIS_BASIC_DATA_TEMPLATE_TYPE basic_data<TORREBIS_BASIC_DATA_TEMPLATE_TYPE_FORWARD>
+#define TORREBIS_BASIC_DATA_TEMPLATE_FORWARD(basic_data) (basic_data)::StrType, (basic_data)::IntType, (basic_data)::ListType, (basic_data)::dict_is_ordered, (basic_data)::DictType, (basic_data)::Allocator
+
+    // Where a value was encoded in the buffer it was loaded from, as offsets from the start of the buffer.
+    struct source_span {
+        ::std::size_t begin;
+        ::std::size_t end;
+
+        ::std::size_t size() const noexcept { return end - begin; }
+    };
+
+    // Pass to `load` or `load_lazy` to remember where each value was encoded. See `basic_data::raw_span()`.
+    enum RecordSpans {
+        record_spans
+    };
+
+    namespace helpers { namespace detail {
+        // Whether `T` is a range of path elements, rather than a single key.
+        template<class T, class PathEl, class = void>
+        struct is_path_iterable : ::std::false_type {};
+
+        template<class T, class PathEl>
+        struct is_path_iterable<T, PathEl, typename ::std::enable_if<
+            ::std::is_convertible<decltype(*::std::begin(::std::declval<const T&>())), PathEl>::value &&
+            !::std::is_convertible<T, typename PathEl::str_type>::value
+        >::type> : ::std::true_type {};
+
+        // Bookkeeping kept next to a value that needs it. See `basic_data::boxed_flag`.
+        struct node_meta {
+            // The encoding of a lazily loaded list or dict whose items haven't been decoded yet, otherwise nullptr.
+            const char* lazy_begin;
+            ::std::size_t lazy_size;
+            // Where the value was loaded from, if `has_span`.
+            source_span span;
+            bool has_span;
+            // The result of `basic_data::cached_hash()`, if `has_hash`. Forgotten when the value is accessed mutably.
+            bool has_hash;
+            // The result of `basic_data::cached_serialised_size()`, if `has_size`. Forgotten like `hash`.
+            bool has_size;
+            ::std::uint64_t hash;
+            ::std::size_t size;
+            // The list or dict this was an item of when it last remembered its hash or size, which forgets them too.
+            ::std::weak_ptr<node_meta> parent;
+        };
+
+        template<class T, class Alloc, class... Args>
+        T construct_with_allocator_(::std::true_type, const Alloc& alloc, Args&&... args) { return T(::std::forward<Args>(args)..., alloc); }
+
+        template<class T, class Alloc, class... Args>
+        T construct_with_allocator_(::std::false_type, const Alloc&, Args&&... args) { return T(::std::forward<Args>(args)...); }
+
+        // Constructs a `T` from `args`, passing `alloc` after them if `T` takes an allocator that `alloc` converts to.
+        template<class T, class Alloc, class... Args>
+        T construct_with_allocator(const Alloc& alloc, Args&&... args) {
+            return construct_with_allocator_<T>(::std::uses_allocator<T, Alloc>(), alloc, ::std::forward<Args>(args)...);
+        }
+
+        template<class To, class From, class Alloc>
+        To take_str_(From&& s, const Alloc&, ::std::true_type) { return ::std::forward<From>(s); }
+
+        template<class To, class From, class Alloc>
+        To take_str_(From&& s, const Alloc& alloc, ::std::false_type) { return construct_with_allocator<To>(alloc, s.data(), s.size()); }
+
+        // `s` as a `To`, moved if it already is one, otherwise copied with `alloc`.
+        template<class To, class From, class Alloc>
+        To take_str(From&& s, const Alloc& alloc) { return take_str_<To>(::std::forward<From>(s), alloc, is_same_decayed<To, From>()); }
+
+        template<class To, class From, class Alloc>
+        To take_key_(From&& s, const Alloc& alloc, ::std::false_type) { return take_str<To>(::std::forward<From>(s), alloc); }
+
+        template<class To, class From, class Alloc>
+        To take_key_(From&& s, const Alloc&, ::std::true_type) {
+            key_table* const table = key_table::current();
+            const char* const chars = reinterpret_cast<const char*>(s.data());
+            return table == nullptr ? shared_string(chars, s.size()) : table->intern(chars, s.size());
+        }
+
+        // A dict key made like `take_str`, except that `shared_string` keys come from the current `key_table` if there is one.
+        template<class To, class From, class Alloc>
+        To take_key(From&& s, const Alloc& alloc) { return take_key_<To>(::std::forward<From>(s), alloc, is_same_decayed<To, shared_string>()); }
+
+        template<class Alloc, class T>
+        auto allocator_of_(const T& container, int) -> typename ::std::enable_if<
+            ::std::is_convertible<decltype(container.get_allocator()), Alloc>::value, Alloc
+        >::type { return container.get_allocator(); }
+
+        template<class Alloc, class T>
+        Alloc allocator_of_(const T&, long) { return Alloc(); }
+
+        // The allocator of `container` as an `Alloc`, or a default constructed `Alloc` if it can't be converted.
+        template<class Alloc, class T>
+        Alloc allocator_of(const T& container) { return allocator_of_<Alloc>(container, 0); }
+
+        template<class T>
+        struct node_box {
+            T value;
+            node_meta meta;
+        };
+    } }  // namespace torrebis::bencode::helpers::detail
+
+    template<class StrType_ = ::std::string,
+        class IntType_ = ::std::intmax_t,
+        template<typename ValueType, typename...> class ListType_ = ::std::vector,
+        bool dict_is_ordered_ = true,
+        template<typename KeyType, typename ValueType, typename...> class DictType_ = ::std::map,
+        template<typename T> class Allocator_ = ::std::allocator
+    >
+    class basic_data final {
+    private:
+        enum : ::std::uint8_t {
+            boxed_flag = 1  // `value_` points to a `helpers::detail::node_box` instead of the value itself
+        };
+
+        DataTag tag_;
+        ::std::uint8_t flags_;  // Fits in the padding after `tag_`
+        ::std::shared_ptr<void> value_;
+    public:
+        static constexpr bool dict_is_ordered = dict_is_ordered_;
+
+        using StrType = StrType_;
+        using IntType = IntType_;
+        template<typename ValueType, typename... Args>
+        using ListType = ListType_<ValueType, Args...>;
+        template<typename KeyType, typename ValueType, typename... Args>
+        using DictType = DictType_<KeyType, ValueType, Args...>;
+        template<typename T>
+        using Allocator = Allocator_<T>;
+
+        using str_type = StrType;
+        using int_type = IntType;
+        using list_type = ListType<basic_data>;
+        using dict_type = DictType<str_type, basic_data>;
+
+        using const_str_type = const StrType;
+        using const_int_type = const IntType;
+        using const_list_type = const ListType<basic_data>;
+        using const_dict_type = const DictType<str_type, basic_data>;
+
+        // Rebound to allocate each value. Functions that allocate can be given an instance of it.
+        using data_allocator_type = Allocator<basic_data>;
+        using str_allocator_type = Allocator<str_type>;
+        using int_allocator_type = Allocator<int_type>;
+        using list_allocator_type = Allocator<list_type>;
+        using dict_allocator_type = Allocator<dict_type>;
+
+        using str_ptr = ::std::shared_ptr<str_type>;
+        using int_ptr = ::std::shared_ptr<int_type>;
+        using list_ptr = ::std::shared_ptr<list_type>;
+        using dict_ptr = ::std::shared_ptr<dict_type>;
+        using void_ptr = ::std::shared_ptr<void>;
+
+        using const_str_ptr = const ::std::shared_ptr<const_str_type>;
+        using const_int_ptr = const ::std::shared_ptr<const_int_type>;
+        using const_list_ptr = const ::std::shared_ptr<const_list_type>;
+        using const_dict_ptr = const ::std::shared_ptr<const_dict_type>;
+        using const_void_ptr = const ::std::shared_ptr<const void>;
+
+        template<DataTag tag>
+        using tag_to_type = typename helpers::tag_to_type<tag, str_type, int_type, list_type, dict_type, void>;
+
+        template<DataTag tag>
+        using tag_to_type_t = typename tag_to_type<tag>::type;
+
+        template<DataTag tag>
+        using tag_to_const_type = typename helpers::tag_to_type<tag, const_str_type, const_int_type, const_list_type, const_dict_type, const void>;
+
+        template<DataTag tag>
+        using tag_to_const_type_t = typename tag_to_const_type<tag>::type;
+
+        template<DataTag tag>
+        using tag_to_allocator = typename helpers::itag_to_type<tag, str_allocator_type, int_allocator_type, list_allocator_type, dict_allocator_type>;
+
+        template<DataTag tag>
+        using tag_to_allocator_t = typename tag_to_allocator<tag>::type;
+
+        template<DataTag tag>
+        using tag_to_ptr = typename helpers::tag_to_type<tag, str_ptr, int_ptr, list_ptr, dict_ptr, void_ptr>;
+
+        template<DataTag tag>
+        using tag_to_ptr_t = typename tag_to_ptr<tag>::type;
+
+        template<DataTag tag>
+        using tag_to_const_ptr = typename helpers::tag_to_type<tag, const_str_ptr, const_int_ptr, const_list_ptr, const_dict_ptr, const_void_ptr>;
+
+        template<DataTag tag>
+        using tag_to_const_ptr_t = typename tag_to_const_ptr<tag>::type;
+
+        template<class type>
+        using type_to_tag = typename helpers::type_to_tag<type, str_type, int_type, list_type, dict_type>;
+
+#ifdef TORREBIS_VARIABLE_TEMPLATES
+        template<class type>
+        static constexpr DataTag type_to_tag_v = type_to_tag<type>::value;
+#endif
+
+    private:
+        template<typename MakeSpecifier>
+        basic_data(const MakeSpecifier, tag_to_ptr_t<helpers::detail::make_specifier_to_tag<MakeSpecifier>::value> value) noexcept :
+            tag_(helpers::detail::make_specifier_to_tag<MakeSpecifier>::value), flags_(0), value_(value) {}
+
+        basic_data(const DataTag tag, const ::std::uint8_t flags, void_ptr value) noexcept :
+            tag_(tag), flags_(flags), value_(value) {}
+
+        template<DataTag tag>
+        using box_type = helpers::detail::node_box<tag_to_type_t<tag>>;
+
+        // Doesn't copy `value_`, so looking inside the box doesn't touch the reference count.
+        template<DataTag tag>
+        box_type<tag>* get_box() const noexcept {
+            return static_cast<box_type<tag>*>(value_.get());
+        }
+
+        helpers::detail::node_meta* get_meta() const noexcept {
+            if (!(flags_ & boxed_flag)) {
+                return nullptr;
+            }
+            switch (tag_) {
+                case DataTag::STR:
+                    return &get_box<DataTag::STR>()->meta;
+                case DataTag::INT:
+                    return &get_box<DataTag::INT>()->meta;
+                case DataTag::LIST:
+                    return &get_box<DataTag::LIST>()->meta;
+                case DataTag::DICT:
+                    return &get_box<DataTag::DICT>()->meta;
+                default:
+                    return nullptr;
+            }
+        }
+
+        // A pointer to the value itself (not its box), decoding the items of a lazily loaded list or dict first.
+        void_ptr value_ptr() const {
+            if (!(flags_ & boxed_flag)) {
+                return value_;
+            }
+            load_lazy_items();
+            switch (tag_) {
+                case DataTag::STR:
+                    return str_ptr(value_, &get_box<DataTag::STR>()->value);
+                case DataTag::INT:
+                    return int_ptr(value_, &get_box<DataTag::INT>()->value);
+                case DataTag::LIST:
+                    return list_ptr(value_, &get_box<DataTag::LIST>()->value);
+                case DataTag::DICT:
+                    return dict_ptr(value_, &get_box<DataTag::DICT>()->value);
+                default:
+                    return value_;
+            }
+        }
+
+        /*
+         * Makes this forget its cached hash and size, along with every list and dict it was an item of when they were
+         * remembered. Stops at the first that has nothing to forget: a list or dict only remembers while its items do.
+         */
+        void forget_cached() const noexcept {
+            helpers::detail::node_meta* meta = get_meta();
+            ::std::shared_ptr<helpers::detail::node_meta> parent;
+            while (meta != nullptr && (meta->has_hash || meta->has_size)) {
+                meta->has_hash = false;
+                meta->has_size = false;
+                parent = meta->parent.lock();
+                meta = parent.get();
+            }
+        }
+
+        // `value_ptr()` for access that could change the value, so a cached hash or size would be wrong.
+        void_ptr mutable_value_ptr() {
+            forget_cached();
+            return value_ptr();
+        }
+
+        // What `set` does, after making the lists and dicts the old value was in forget their cached hash and size.
+        void replace(basic_data&& value) noexcept {
+            forget_cached();
+            *this = ::std::move(value);
+        }
+
+        template<DataTag tag>
+        static basic_data make_boxed(tag_to_type_t<tag>&& value, const helpers::detail::node_meta& meta, const data_allocator_type& alloc) {
+            using allocator_t = Allocator<box_type<tag>>;
+            return basic_data(tag, boxed_flag, ::std::allocate_shared<box_type<tag>, allocator_t>(allocator_t(alloc), box_type<tag>{ ::std::move(value), meta }));
+        }
+
+    public:
+        basic_data() noexcept : tag_(DataTag::UNINITIALISED), flags_(0), value_(nullptr) {}
+
+        basic_data(const basic_data& other) noexcept : tag_(other.tag_), flags_(other.flags_), value_(other.value_) {}
+        basic_data(basic_data&& other) noexcept : tag_(other.tag_), flags_(other.flags_), value_(::std::move(other.value_)) {
+            other.tag_ = DataTag::UNINITIALISED;
+            other.flags_ = 0;
+        }
+        basic_data& operator=(const basic_data& other) noexcept { if (&other != this) { tag_ = other.tag_; flags_ = other.flags_; value_ = other.value_; }; return *this; }
+        basic_data& operator=(basic_data&& other) noexcept {
+            if (&other != this) {
+                tag_ = other.tag_;
+                flags_ = other.flags_;
+                value_ = ::std::move(other.value_);
+                other.tag_ = DataTag::UNINITIALISED;
+                other.flags_ = 0;
+            }
+            return *this;
+        }
+        // Whether this and `other` are the same value (Not just equal ones). See `equals()`.
+        bool operator==(const basic_data& other) const noexcept { return tag_ == other.tag_ && value_ == other.value_; }
+        bool operator!=(const basic_data& other) const noexcept { return !operator==(other); }
+        void swap(basic_data& other) noexcept {
+            DataTag other_tag = other.tag_;
+            other.tag_ = tag_;
+            tag_ = other_tag;
+            ::std::swap(flags_, other.flags_);
+            ::std::swap(value_, other.value_);
+        };
+        explicit operator bool() const noexcept { return tag_ != DataTag::UNINITIALISED; }
+        bool operator!() const noexcept { return tag_ == DataTag::UNINITIALISED; }
+
+        DataTag get_tag() const noexcept {
+            return tag_;
+        }
+
+        template<DataTag tag>
+        bool is() const noexcept { return tag == tag_; }
+        template<typename T>
+        bool is() const noexcept { return type_to_tag<T>::value == tag_; }
+        bool is(DataTag tag) const noexcept { return tag == tag_; }
+
+        bool is_valid() const noexcept { return tag_ != DataTag::UNINITIALISED; }
+        bool is_str() const noexcept { return tag_ == DataTag::STR; }
+        bool is_int() const noexcept { return tag_ == DataTag::INT; }
+        bool is_list() const noexcept { return tag_ == DataTag::LIST; }
+        bool is_dict() const noexcept { return tag_ == DataTag::DICT; }
+
+        // Getting a lazily loaded list or dict decodes its items, which can throw.
+
+        template<DataTag tag>
+        tag_to_ptr_t<tag> get() {
+            return (tag == DataTag::UNINITIALISED || tag == tag_)
+                   ? ::std::static_pointer_cast<tag_to_type_t<tag>>(mutable_value_ptr())
+                   : nullptr;
+        }
+
+        template<DataTag tag>
+        tag_to_const_ptr_t<tag> get() const {
+            return (tag == DataTag::UNINITIALISED || tag == tag_)
+                   ? ::std::static_pointer_cast<tag_to_const_type_t<tag>>(value_ptr())
+                   : nullptr;
+        }
+
+        template<typename T>
+        ::std::shared_ptr<T> get() {
+            TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<T, void>::value) {
+                return mutable_value_ptr();
+            }
+            if (type_to_tag<T>::value == tag_) {
+                return ::std::static_pointer_cast<T>(mutable_value_ptr());
+            }
+            return nullptr;
+        }
+
+        template<typename T>
+        const ::std::shared_ptr<const T> get() const {
+            TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<T, void>::value) {
+                return value_ptr();
+            }
+            if (type_to_tag<T>::value == tag_) {
+                return ::std::static_pointer_cast<const T>(value_ptr());
+            }
+            return nullptr;
+        }
+
+        void_ptr get(DataTag tag) {
+            return (tag == DataTag::UNINITIALISED || tag == tag_) ? mutable_value_ptr() : nullptr;
+        }
+        const_void_ptr get(DataTag tag) const {
+            return (tag == DataTag::UNINITIALISED || tag == tag_) ? ::std::static_pointer_cast<const void>(value_ptr()) : nullptr;
+        }
+
+        str_ptr get_str() noexcept { return get<DataTag::STR>(); }
+        const_str_ptr get_str() const noexcept { return get<DataTag::STR>(); }
+        int_ptr get_int() noexcept { return get<DataTag::INT>(); }
+        const_int_ptr get_int() const noexcept { return get<DataTag::INT>(); }
+        list_ptr get_list() { return get<DataTag::LIST>(); }
+        const_list_ptr get_list() const { return get<DataTag::LIST>(); }
+        dict_ptr get_dict() { return get<DataTag::DICT>(); }
+        const_dict_ptr get_dict() const { return get<DataTag::DICT>(); }
+        void_ptr get_any() { return get<DataTag::UNINITIALISED>(); }
+        const_void_ptr get_any() const { return get<DataTag::UNINITIALISED>(); }
+
+        /*
+         * Where this value was encoded in the buffer it was loaded from, if it was loaded with `record_spans`,
+         * otherwise nullptr. This is not updated if the value is changed.
+         */
+        const source_span* raw_span() const noexcept {
+            const helpers::detail::node_meta* const meta = get_meta();
+            return meta != nullptr && meta->has_span ? &meta->span : nullptr;
+        }
+
+        // Whether this is a lazily loaded list or dict whose items haven't been decoded yet.
+        bool is_lazy() const noexcept {
+            const helpers::detail::node_meta* const meta = get_meta();
+            return meta != nullptr && meta->lazy_begin != nullptr;
+        }
+
+        template<DataTag tag>
+        void set(const tag_to_type_t<tag>& value) { replace(make<tag>(value)); }
+
+        template<DataTag tag>
+        void set(tag_to_type_t<tag>&& value) { replace(make<tag>(::std::move(value))); }
+
+        template<DataTag tag>
+        void set(const tag_to_ptr_t<tag> value) noexcept { replace(make<tag>(value)); }
+
+        void set(const DataTag tag, const ::std::shared_ptr<void> value) noexcept { replace(make(tag, value)); }
+
+        template<typename T>
+        void set(T&& value) { set<type_to_tag<typename helpers::detail::remove_cv_ref<T>::type>::value>(::std::forward<T>(value)); }
+
+        // Constructs the new value in place from `args`.
+        template<DataTag tag, typename... Args>
+        void set(Args&&... args) { replace(make<tag>(::std::forward<Args>(args)...)); }
+
+        void set_str(const str_type& s) { set<DataTag::STR>(s); }
+        void set_str(str_type&& s) { set<DataTag::STR>(::std::move(s)); }
+        void set_str(const str_ptr s) noexcept { set<DataTag::STR>(s); }
+        template<typename... Args> void set_str(Args&&... args) { set<DataTag::STR>(::std::forward<Args>(args)...); }
+        void set_int(const int_type& i) { set<DataTag::INT>(i); }
+        void set_int(const int_ptr i) noexcept { set<DataTag::INT>(i); }
+        template<typename... Args> void set_int(Args&&... args) { set<DataTag::INT>(::std::forward<Args>(args)...); }
+        void set_list(const list_type& l) { set<DataTag::LIST>(l); }
+        void set_list(list_type&& l) { set<DataTag::LIST>(::std::move(l)); }
+        void set_list(const list_ptr l) noexcept { set<DataTag::LIST>(l); }
+        template<typename... Args> void set_list(Args&&... args) { set<DataTag::LIST>(::std::forward<Args>(args)...); }
+        void set_dict(const dict_type& d) { set<DataTag::DICT>(d); }
+        void set_dict(dict_type&& d) { set<DataTag::DICT>(::std::move(d)); }
+        void set_dict(const dict_ptr d) noexcept { set<DataTag::DICT>(d); }
+        template<typename... Args> void set_dict(Args&&... args) { set<DataTag::DICT>(::std::forward<Args>(args)...); }
+
+        template<DataTag tag>
+        static basic_data make(const tag_to_type_t<tag>& value) { return allocate<tag>(data_allocator_type(), value); }
+
+        template<DataTag tag>
+        static basic_data make(tag_to_type_t<tag>&& value) { return allocate<tag>(data_allocator_type(), ::std::move(value)); }
+
+        template<DataTag tag>
+        static basic_data make(const tag_to_ptr_t<tag> value) noexcept {
+            if (value == nullptr || tag == DataTag::UNINITIALISED) {
+                return basic_data();
+            }
+
+            return basic_data(
+                helpers::detail::tag_to_make_specifier<tag>::value,
+                value
+            );
+        }
+
+        static basic_data make(const DataTag tag, const ::std::shared_ptr<void> value) noexcept {
+            if (value == nullptr || tag == DataTag::UNINITIALISED) {
+                return basic_data();
+            }
+            return basic_data(tag, 0, value);
+        }
+
+        template<typename T>
+        static basic_data make(T&& value) { return make<type_to_tag<typename helpers::detail::remove_cv_ref<T>::type>::value>(::std::forward<T>(value)); }
+
+        // Constructs the value in place from `args`.
+        template<DataTag tag, typename... Args>
+        static basic_data make(Args&&... args) { return allocate<tag>(data_allocator_type(), ::std::forward<Args>(args)...); }
+
+    private:
+        template<DataTag tag, typename... Args>
+        static basic_data allocate_(::std::false_type, const data_allocator_type& alloc, Args&&... args) {
+            using type = tag_to_type_t<tag>;
+            using allocator_t = tag_to_allocator_t<tag>;
+            return basic_data(
+                helpers::detail::tag_to_make_specifier<tag>::value,
+                ::std::allocate_shared<type, allocator_t>(allocator_t(alloc), ::std::forward<Args>(args)...)
+            );
+        }
+
+        // Lists and dicts are boxed, so they have somewhere to remember their hash and serialised size.
+        template<DataTag tag, typename... Args>
+        static basic_data allocate_(::std::true_type, const data_allocator_type& alloc, Args&&... args) {
+            using type = tag_to_type_t<tag>;
+            using allocator_t = tag_to_allocator_t<tag>;
+            // Constructed the way `allocate_shared` would (So a scoped allocator still reaches it), then moved into the box
+            allocator_t value_alloc(alloc);
+            typename ::std::aligned_storage<sizeof(type), alignof(type)>::type storage;
+            type* const value = reinterpret_cast<type*>(&storage);
+            ::std::allocator_traits<allocator_t>::construct(value_alloc, value, ::std::forward<Args>(args)...);
+            struct destroyer {
+                allocator_t& alloc;
+                type* value;
+                ~destroyer() { ::std::allocator_traits<allocator_t>::destroy(alloc, value); }
+            } destroy{ value_alloc, value };
+            return make_boxed<tag>(::std::move(*value), helpers::detail::node_meta(), alloc);
+        }
+
+    public:
+        // Like `make<tag>(args...)`, but the value is allocated with `alloc` (rebound to its type).
+        template<DataTag tag, typename... Args>
+        static basic_data allocate(const data_allocator_type& alloc, Args&&... args) {
+            return allocate_<tag>(::std::integral_constant<bool, tag == DataTag::LIST || tag == DataTag::DICT>(), alloc, ::std::forward<Args>(args)...);
+        }
+
+        static basic_data make_str(const str_type& s) { return make<DataTag::STR>(s); }
+        static basic_data make_str(str_type&& s) { return make<DataTag::STR>(::std::move(s)); }
+        static basic_data make_str(const str_ptr s) noexcept { return make<DataTag::STR>(s); }
+        template<typename... Args> static basic_data make_str(Args&&... args) { return make<DataTag::STR>(::std::forward<Args>(args)...); }
+        static basic_data make_int(const int_type& i) { return make<DataTag::INT>(i); }
+        static basic_data make_int(const int_ptr i) noexcept { return make<DataTag::INT>(i); }
+        template<typename... Args> static basic_data make_int(Args&&... args) { return make<DataTag::INT>(::std::forward<Args>(args)...); }
+        static basic_data make_list(const list_type& l) { return make<DataTag::LIST>(l); }
+        static basic_data make_list(list_type&& l) { return make<DataTag::LIST>(::std::move(l)); }
+        static basic_data make_list(const list_ptr l) noexcept { return make<DataTag::LIST>(l); }
+        template<typename... Args> static basic_data make_list(Args&&... args) { return make<DataTag::LIST>(::std::forward<Args>(args)...); }
+        static basic_data make_dict(const dict_type& d) { return make<DataTag::DICT>(d); }
+        static basic_data make_dict(dict_type&& d) { return make<DataTag::DICT>(::std::move(d)); }
+        static basic_data make_dict(const dict_ptr d) noexcept { return make<DataTag::DICT>(d); }
+        template<typename... Args> static basic_data make_dict(Args&&... args) { return make<DataTag::DICT>(::std::forward<Args>(args)...); }
+
+        void reset() noexcept { forget_cached(); tag_ = DataTag::UNINITIALISED; flags_ = 0; value_ = nullptr; }
+
+        ~basic_data() noexcept { tag_ = DataTag::UNINITIALISED; flags_ = 0; value_ = nullptr; }
+
+        using path_el_type = basic_path_el<str_type>;
+
+    private:
+        // The item at `el` in `data`, or nullptr if there isn't one.
+        template<class BasicData>
+        static BasicData* path_step(BasicData* const data, const path_el_type& el) {
+            if (el.is_key()) {
+                if (!data->is_dict()) {
+                    return nullptr;
+                }
+                auto& dict = *data->get_dict();
+                auto search = dict.find(*el.get_key());
+                if (search == dict.end()) {
+                    return nullptr;
+                }
+                return &search->second;
+            }
+            if (el.is_index()) {
+                if (!data->is_list()) {
+                    return nullptr;
+                }
+                auto& list = *data->get_list();
+                if (el.get_index() >= list.size()) {
+                    return nullptr;
+                }
+                return &list[el.get_index()];
+            }
+            return nullptr;
+        }
+
+        // Follows as much of `path` as possible, returning how many elements were followed and where that led.
+        template<class BasicData, class T>
+        static ::std::pair<::std::size_t, BasicData*> path_loop(BasicData* result, const T& path) {
+            ::std::size_t i = 0;
+            for (const auto& el : path) {
+                BasicData* const next = path_step<BasicData>(result, path_el_type(el));
+                if (next == nullptr) {
+                    break;
+                }
+                result = next;
+                ++i;
+            }
+            return { i, result };
+        }
+
+        template<class T>
+        using enable_if_path_iterable = typename ::std::enable_if<helpers::detail::is_path_iterable<T, path_el_type>::value>::type;
+
+    public:
+        template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+        const basic_data* get_path(PathEls... path) const {
+            const ::std::initializer_list<path_el_type> path_list = { path_el_type(path)... };
+            return get_path(path_list);
+        }
+
+        template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+        basic_data* get_path(PathEls... path) {
+            const ::std::initializer_list<path_el_type> path_list = { path_el_type(path)... };
+            return get_path(path_list);
+        }
+
+        template<class T, class = enable_if_path_iterable<T>>  // Where T is an iterable of basic_data::path_el_type
+        const basic_data* get_path(const T& path) const {
+            auto followed = path_loop<const basic_data, T>(this, path);
+            return followed.first == static_cast<::std::size_t>(::std::distance(::std::begin(path), ::std::end(path))) ? followed.second : nullptr;
+        }
+
+        template<class T, class = enable_if_path_iterable<T>>
+        basic_data* get_path(const T& path) {
+            auto followed = path_loop<basic_data, T>(this, path);
+            return followed.first == static_cast<::std::size_t>(::std::distance(::std::begin(path), ::std::end(path))) ? followed.second : nullptr;
+        }
+
+        // How many elements of the path could be followed, and the data at the end of them.
+
+        template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+        const ::std::pair<const ::std::size_t, const basic_data&> try_path(PathEls... path) const {
+            const ::std::initializer_list<path_el_type> path_list = { path_el_type(path)... };
+            return try_path(path_list);
+        }
+
+        template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+        const ::std::pair<const ::std::size_t, basic_data&> try_path(PathEls... path) {
+            const ::std::initializer_list<path_el_type> path_list = { path_el_type(path)... };
+            return try_path(path_list);
+        }
+
+        template<typename T, class = enable_if_path_iterable<T>>
+        ::std::pair<const ::std::size_t, const basic_data&> try_path(const T& path) const {
+            auto followed = path_loop<const basic_data, T>(this, path);
+            return { followed.first, *followed.second };
+        }
+
+        template<typename T, class = enable_if_path_iterable<T>>
+        ::std::pair<const ::std::size_t, basic_data&> try_path(const T& path) {
+            auto followed = path_loop<basic_data, T>(this, path);
+            return { followed.first, *followed.second };
+        }
+
+        // Copy-on-write editing
+    private:
+        /*
+         * A copy of this with `*value` (or nothing, if `value` is nullptr) at the end of the path from `first` to `last`.
+         * Each list and dict on the path is copied, so it gets new copies of its items that share their values.
+         */
+        template<class Iterator>
+        basic_data with_path_(Iterator first, const Iterator last, const basic_data* const value) const {
+            const path_el_type el(*first);
+            const bool at_end = ++first == last;
+            if (el.is_key() && is_dict()) {
+                dict_type dict = *get_dict();
+                const data_allocator_type alloc = helpers::detail::allocator_of<data_allocator_type>(dict);
+                auto search = dict.find(*el.get_key());
+                if (at_end && value == nullptr) {
+                    if (search == dict.end()) {
+                        throw ::std::out_of_range("basic_data::without_path");
+                    }
+                    dict.erase(search);
+                } else if (at_end && search == dict.end()) {
+                    dict.emplace(*el.get_key(), *value);
+                } else if (at_end) {
+                    search->second = *value;
+                } else if (search == dict.end()) {
+                    throw ::std::out_of_range(value == nullptr ? "basic_data::without_path" : "basic_data::with_path");
+                } else {
+                    search->second = search->second.with_path_(first, last, value);
+                }
+                return allocate<DataTag::DICT>(alloc, ::std::move(dict));
+            }
+            if (el.is_index() && is_list()) {
+                list_type list = *get_list();
+                const data_allocator_type alloc = helpers::detail::allocator_of<data_allocator_type>(list);
+                const ::std::size_t index = el.get_index();
+                if (index >= list.size()) {
+                    throw ::std::out_of_range(value == nullptr ? "basic_data::without_path" : "basic_data::with_path");
+                }
+                auto item = list.begin() + static_cast<typename list_type::difference_type>(index);
+                if (at_end && value == nullptr) {
+                    list.erase(item);
+                } else if (at_end) {
+                    *item = *value;
+                } else {
+                    *item = item->with_path_(first, last, value);
+                }
+                return allocate<DataTag::LIST>(alloc, ::std::move(list));
+            }
+            throw ::std::out_of_range(value == nullptr ? "basic_data::without_path" : "basic_data::with_path");
+        }
+
+    public:
+        /*
+         * A copy of this with `value` at `path`, leaving this and every copy of it unchanged. Only the lists and dicts on
+         * the path are copied, and their items still share everything below them with this. The last element of the path
+         * can be a key that isn't in its dict yet. Throws `std::out_of_range` if the rest of the path can't be followed.
+         */
+        template<class T, class = enable_if_path_iterable<T>>
+        basic_data with_path(const T& path, const basic_data& value) const {
+            if (::std::begin(path) == ::std::end(path)) {
+                return value;
+            }
+            return with_path_(::std::begin(path), ::std::end(path), &value);
+        }
+
+        basic_data with_path(const ::std::initializer_list<path_el_type> path, const basic_data& value) const {
+            return with_path<::std::initializer_list<path_el_type>>(path, value);
+        }
+
+        // A copy of this without the dict item or list item at `path`, like `with_path`. An empty path gives nothing.
+        template<class T, class = enable_if_path_iterable<T>>
+        basic_data without_path(const T& path) const {
+            if (::std::begin(path) == ::std::end(path)) {
+                return basic_data();
+            }
+            return with_path_(::std::begin(path), ::std::end(path), nullptr);
+        }
+
+        basic_data without_path(const ::std::initializer_list<path_el_type> path) const {
+            return without_path<::std::initializer_list<path_el_type>>(path);
+        }
+
+        // Structural comparison
+    private:
+        // The list or dict a `cached_hash()` or `cached_serialised_size()` walk is in, which its items are linked to.
+        struct cache_parent {
+            ::std::weak_ptr<helpers::detail::node_meta> meta;  // Empty if it isn't boxed
+            bool cacheable;  // Whether changing any item so far would make it forget, so it can remember
+        };
+
+        // Where to link the items of this while remembering its hash or size, or nullptr if they can't be.
+        cache_parent* as_cache_parent(cache_parent& storage) const {
+            helpers::detail::node_meta* const meta = get_meta();
+            if (meta == nullptr || (tag_ != DataTag::LIST && tag_ != DataTag::DICT)) {
+                return nullptr;
+            }
+            storage.meta = ::std::shared_ptr<helpers::detail::node_meta>(value_, meta);
+            storage.cacheable = true;
+            return &storage;
+        }
+
+        /*
+         * Links this item to `parent`, so that changing it makes `parent` forget. `parent` can't remember if this can't
+         * be linked: a list or dict that isn't boxed (Made from a `list_ptr` or `dict_ptr`), or an item of another list
+         * or dict that is still alive.
+         */
+        void link_to(cache_parent* const parent) const noexcept {
+            if (parent == nullptr) {
+                return;
+            }
+            helpers::detail::node_meta* const meta = get_meta();
+            if (meta == nullptr) {
+                if (tag_ == DataTag::LIST || tag_ == DataTag::DICT) {
+                    parent->cacheable = false;
+                }
+                return;
+            }
+            if (!meta->parent.owner_before(parent->meta) && !parent->meta.owner_before(meta->parent)) {
+                return;  // Already linked to it
+            }
+            if (meta->parent.expired()) {
+                meta->parent = parent->meta;
+            } else {
+                parent->cacheable = false;
+            }
+        }
+
+        ::std::uint64_t remember_hash(cache_parent* const parent) const {
+            link_to(parent);
+            helpers::detail::node_meta* const meta = get_meta();
+            if (meta != nullptr && meta->has_hash) {
+                return meta->hash;
+            }
+            cache_parent storage;
+            cache_parent* const self = as_cache_parent(storage);
+            const ::std::uint64_t hash = compute_hash<true>(self);
+            if (meta == nullptr) {
+                return hash;
+            }
+            if (self == nullptr || self->cacheable) {
+                meta->hash = hash;
+                meta->has_hash = true;
+            } else if (parent != nullptr) {
+                parent->cacheable = false;
+            }
+            return hash;
+        }
+
+        template<bool cached>
+        ::std::uint64_t item_hash(cache_parent* const parent) const { return cached ? remember_hash(parent) : hash(); }
+
+        template<bool cached>
+        ::std::uint64_t compute_hash(cache_parent* const self) const {
+            switch (tag_) {
+                case DataTag::INT: {
+                    const int_type& i = *get_int();
+                    TORREBIS_CONSTEXPR_IF (::std::is_integral<int_type>::value) {
+                        return helpers::detail::hash_combine('i', helpers::detail::hash_bytes(&i, sizeof(i)));
+                    }
+                    ::std::string s;
+                    helpers::detail::append_int(i, s);
+                    return helpers::detail::hash_combine('i', helpers::detail::hash_bytes(s.data(), s.size()));
+                }
+                case DataTag::STR: {
+                    const str_type& ss = *get_str();
+                    return helpers::detail::hash_combine('s', helpers::detail::hash_bytes(ss.data(), ss.size() * sizeof(*ss.data())));
+                }
+                case DataTag::LIST: {
+                    ::std::uint64_t hash = 'l';
+                    for (const basic_data& i : *get_list()) {
+                        hash = helpers::detail::hash_combine(hash, i.item_hash<cached>(self));
+                    }
+                    return hash;
+                }
+                case DataTag::DICT: {
+                    // Summed, so that it doesn't depend on the order of the items
+                    ::std::uint64_t sum = 0;
+                    const auto& dict = *get_dict();
+                    for (const auto& i : dict) {
+                        const ::std::uint64_t key_hash = helpers::detail::hash_bytes(i.first.data(), i.first.size() * sizeof(*i.first.data()));
+                        sum += helpers::detail::hash_combine(key_hash, i.second.template item_hash<cached>(self));
+                    }
+                    return helpers::detail::hash_combine(helpers::detail::hash_combine('d', dict.size()), sum);
+                }
+                default:
+                    return 0;
+            }
+        }
+
+    public:
+        /*
+         * Whether this and `other` have the same type and equal values, comparing lists and dicts item by item (Copies of
+         * the same value are equal without looking at their items).
+         */
+        bool equals(const basic_data& other) const {
+            if (tag_ != other.tag_) {
+                return false;
+            }
+            if (value_ == other.value_) {
+                return true;
+            }
+            switch (tag_) {
+                case DataTag::INT:
+                    return *get_int() == *other.get_int();
+                case DataTag::STR:
+                    return *get_str() == *other.get_str();
+                case DataTag::LIST: {
+                    const list_type& a = *get_list();
+                    const list_type& b = *other.get_list();
+                    if (a.size() != b.size()) {
+                        return false;
+                    }
+                    auto it = b.begin();
+                    for (const basic_data& i : a) {
+                        if (!i.equals(*it)) {
+                            return false;
+                        }
+                        ++it;
+                    }
+                    return true;
+                }
+                case DataTag::DICT: {
+                    const dict_type& a = *get_dict();
+                    const dict_type& b = *other.get_dict();
+                    if (a.size() != b.size()) {
+                        return false;
+                    }
+                    TORREBIS_CONSTEXPR_IF (dict_is_ordered) {
+                        auto it = b.begin();
+                        for (const auto& i : a) {
+                            if (!(i.first == it->first) || !i.second.equals(it->second)) {
+                                return false;
+                            }
+                            ++it;
+                        }
+                        return true;
+                    }
+                    for (const auto& i : a) {
+                        auto search = b.find(i.first);
+                        if (search == b.end() || !i.second.equals(search->second)) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+                default:
+                    return true;
+            }
+        }
+
+        // A hash of the structure and values of this, so values that `equals()` each other have the same hash.
+        ::std::uint64_t hash() const { return compute_hash<false>(nullptr); }
+
+        /*
+         * `hash()`, remembered by this and every list and dict in it, so hashing it again, or hashing something that
+         * contains it, doesn't look at items that haven't changed. See "Comparing and hashing" in the README for what
+         * makes them forget.
+         *
+         * Not thread safe: remembering the hash writes to the value, so it can't be called on the same document (or
+         * copies of it) from different threads at once.
+         */
+        ::std::uint64_t cached_hash() const { return remember_hash(nullptr); }
+
+        // For unordered containers of `basic_data` that compare by value.
+        struct structural_hash {
+            ::std::size_t operator()(const basic_data& data) const { return static_cast<::std::size_t>(data.hash()); }
+        };
+
+        struct structural_equal {
+            bool operator()(const basic_data& a, const basic_data& b) const { return a.equals(b); }
+        };
+
+        // Serialisation
+    private:
+        /*
+         * Calls `f` with each item of `dict` in the order they are encoded in. If `DictType` isn't ordered, that means
+         * sorting pointers to its items by key first. Each pointer is sorted with the first 8 bytes of its key, so most
+         * comparisons don't have to look at the key itself.
+         */
+        template<class Function>
+        static void for_each_sorted_item(const dict_type& dict, Function&& f) {
+            TORREBIS_CONSTEXPR_IF (dict_is_ordered) {
+                for (const auto& i : dict) {
+                    f(i);
+                }
+                return;
+            }
+            using item_type = typename dict_type::value_type;
+            struct sort_entry {
+                ::std::uint64_t prefix;  // Big endian, so comparing prefixes compares the bytes in order
+                const item_type* item;
+            };
+            ::std::vector<sort_entry> items;
+            items.reserve(dict.size());
+            for (const item_type& i : dict) {
+                const unsigned char* const key = reinterpret_cast<const unsigned char*>(i.first.data());
+                const ::std::size_t prefix_size = ::std::min<::std::size_t>(i.first.size(), 8);
+                ::std::uint64_t prefix = 0;
+                for (::std::size_t j = 0; j < 8; ++j) {
+                    prefix = (prefix << 8) | (j < prefix_size ? key[j] : 0);
+                }
+                items.push_back({ prefix, &i });
+            }
+            ::std::sort(items.begin(), items.end(), [](const sort_entry& a, const sort_entry& b) {
+                if (a.prefix != b.prefix) {
+                    return a.prefix < b.prefix;
+                }
+                return helpers::detail::key_less_than(a.item->first.data(), a.item->first.size(), b.item->first.data(), b.item->first.size());
+            });
+            for (const sort_entry& i : items) {
+                f(*i.item);
+            }
+        }
+
+        ::std::size_t remember_serialised_size(cache_parent* const parent) const {
+            link_to(parent);
+            helpers::detail::node_meta* const meta = get_meta();
+            if (meta != nullptr && meta->has_size) {
+                return meta->size;
+            }
+            cache_parent storage;
+            cache_parent* const self = is_lazy() ? nullptr : as_cache_parent(storage);
+            const ::std::size_t size = compute_serialised_size<true>(self);
+            if (meta == nullptr) {
+                return size;
+            }
+            // A lazily loaded list or dict remembers its encoded size, and forgets it when its items are decoded
+            if (self == nullptr || self->cacheable) {
+                meta->size = size;
+                meta->has_size = true;
+            } else if (parent != nullptr) {
+                parent->cacheable = false;
+            }
+            return size;
+        }
+
+        template<bool cached>
+        ::std::size_t item_serialised_size(cache_parent* const parent) const { return cached ? remember_serialised_size(parent) : serialised_size(); }
+
+        template<bool cached>
+        ::std::size_t compute_serialised_size(cache_parent* const self) const {
+            if (is_lazy()) {
+                return get_meta()->lazy_size;
+            }
+            switch (get_tag()) {
+                case DataTag::STR: {
+                    ::std::size_t str_size = get_str()->size();
+                    return helpers::detail::int_size<::std::size_t>(str_size) + 1 + str_size;
+                }
+                case DataTag::INT:
+                    return 2 + helpers::detail::int_size<int_type>(*get_int());
+                case DataTag::LIST: {
+                    ::std::size_t size = 2;
+                    for (const basic_data& i : *get_list()) {
+                        size += i.item_serialised_size<cached>(self);
+                    }
+                    return size;
+                }
+                case DataTag::DICT: {
+                    ::std::size_t size = 2;
+                    for (const auto& i : *get_dict()) {
+                        ::std::size_t key_size = i.first.size();
+                        size += helpers::detail::int_size<::std::size_t>(key_size) + 1 + key_size + i.second.template item_serialised_size<cached>(self);
+                    }
+                    return size;
+                }
+                default:
+                    return 0;
+            }
+        }
+
+    public:
+        // How many bytes `serialise()` writes.
+        ::std::size_t serialised_size() const { return compute_serialised_size<false>(nullptr); }
+
+        /*
+         * `serialised_size()`, remembered by this and every list and dict in it, so sizing it again (Or serialising it,
+         * which reserves the remembered size) only looks at items that have changed. See "Serialising" in the README
+         * for what makes them forget.
+         *
+         * Not thread safe, as it writes to the value. `serialise()` and `append_serialisation()` never trust the
+         * remembered size to be right.
+         */
+        ::std::size_t cached_serialised_size() const { return remember_serialised_size(nullptr); }
+
+        template<class T = char, class Traits = ::std::char_traits<T>>
+        ::std::basic_string<T, Traits> serialise() const {
+            ::std::basic_string<T, Traits> s;
+            append_serialisation(s);
+            return s;
+        }
+
+    private:
+        template<class OutputIt>
+        OutputIt serialise_to_loop(OutputIt out) const {
+            if (is_lazy()) {
+                // Untouched since it was loaded, so the original encoding is still right
+                const helpers::detail::node_meta* const meta = get_meta();
+                return helpers::detail::copy_chars(str_view(meta->lazy_begin, meta->lazy_size), out);
+            }
+            switch (get_tag()) {
+                case DataTag::STR: {
+                    const str_type& ss = *get_str();
+                    out = helpers::detail::copy_int<::std::size_t>(ss.size(), out);
+                    *out = ':';
+                    return helpers::detail::copy_chars(ss, ++out);
+                }
+                case DataTag::INT:
+                    *out = 'i';
+                    out = helpers::detail::copy_int<int_type>(*get_int(), ++out);
+                    *out = 'e';
+                    return ++out;
+                case DataTag::LIST:
+                    *out = 'l';
+                    ++out;
+                    for (const basic_data& i : *get_list()) {
+                        out = i.serialise_to_loop(out);
+                    }
+                    *out = 'e';
+                    return ++out;
+                case DataTag::DICT:
+                    *out = 'd';
+                    ++out;
+                    for_each_sorted_item(*get_dict(), [&out](const typename dict_type::value_type& i) {
+                        const str_type& key = i.first;
+                        out = helpers::detail::copy_int<::std::size_t>(key.size(), out);
+                        *out = ':';
+                        out = helpers::detail::copy_chars(key, ++out);
+                        out = i.second.serialise_to_loop(out);
+                    });
+                    *out = 'e';
+                    return ++out;
+                default:
+                    return out;
+            }
+        }
+
+    public:
+        template<class T = char, class Traits = ::std::char_traits<T>>
+        void append_serialisation(::std::basic_string<T, Traits>& s) const {
+            // Only reserves a remembered size: working one out would walk the value twice
+            const helpers::detail::node_meta* const meta = get_meta();
+            if (meta != nullptr && meta->has_size && s.size() + meta->size > s.capacity()) {
+                s.reserve(s.size() + meta->size);
+            }
+            serialise_to_loop(::std::back_inserter(s));
+        }
+
+    private:
+        void append_gather_loop(gather_buffer& out) const {
+            if (is_lazy()) {
+                const helpers::detail::node_meta* const meta = get_meta();
+                out.put_bytes(meta->lazy_begin, meta->lazy_size);
+                return;
+            }
+            switch (get_tag()) {
+                case DataTag::STR: {
+                    const str_type& ss = *get_str();
+                    out.put_int<::std::size_t>(ss.size());
+                    out.put(':');
+                    out.put_str(ss);
+                    return;
+                }
+                case DataTag::INT:
+                    out.put('i');
+                    out.put_int<int_type>(*get_int());
+                    out.put('e');
+                    return;
+                case DataTag::LIST:
+                    out.put('l');
+                    for (const basic_data& i : *get_list()) {
+                        i.append_gather_loop(out);
+                    }
+                    out.put('e');
+                    return;
+                case DataTag::DICT:
+                    out.put('d');
+                    for_each_sorted_item(*get_dict(), [&out](const typename dict_type::value_type& i) {
+                        out.put_int<::std::size_t>(i.first.size());
+                        out.put(':');
+                        out.put_str(i.first);
+                        i.second.append_gather_loop(out);
+                    });
+                    out.put('e');
+                    return;
+                default:
+                    return;
+            }
+        }
+
+    public:
+        /*
+         * Appends the encoding to `out`, referencing long strings where they are instead of copying them. This must
+         * not be changed or destroyed until `out` has been written.
+         */
+        void append_serialisation(gather_buffer& out) const { append_gather_loop(out); }
+
+        /*
+         * Writes the encoding to `out`, returning the iterator after it. `out` can be any output iterator that can be
+         * assigned `char`s, so for a pointer or array there must be room for `serialised_size()` elements.
+         */
+        template<class OutputIt>
+        OutputIt serialise_to(OutputIt out) const { return serialise_to_loop(out); }
+
+        /*
+         * Writes the encoding to the `capacity` elements at `out`, returning how many were written. If it doesn't fit,
+         * nothing is written and 0 is returned.
+         */
+        template<class T>
+        ::std::size_t serialise_to(T* const out, const ::std::size_t capacity) const {
+            const ::std::size_t size = serialised_size();
+            if (size > capacity) {
+                return 0;
+            }
+            serialise_to_loop(out);
+            return size;
+        }
+
+#ifdef TORREBIS_HAS_SPAN
+        // Like `serialise_to(out.data(), out.size())`.
+        template<class T, ::std::size_t Extent>
+        ::std::size_t serialise_to(const ::std::span<T, Extent> out) const { return serialise_to(out.data(), out.size()); }
+#endif
+
+        template<class T = char, class Traits = std::char_traits<T>>
+        void serialise(::std::basic_ostream<T, Traits>& os) const {
+            if (is_lazy()) {
+                const helpers::detail::node_meta* const meta = get_meta();
+                TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<T, char>::value) {
+                    os.write(reinterpret_cast<const T*>(meta->lazy_begin), static_cast<::std::streamsize>(meta->lazy_size));
+                } else {
+                    for (::std::size_t i = 0; i < meta->lazy_size; ++i) {
+                        os.put(static_cast<T>(meta->lazy_begin[i]));
+                    }
+                }
+                return;
+            }
+            switch (get_tag()) {
+                case DataTag::STR: {
+                    const str_type& ss = *get_str();
+                    ::std::basic_string<T, Traits> size_str;
+                    helpers::detail::append_int<::std::size_t>(ss.size(), size_str);
+                    os.write(size_str.data(), size_str.size());
+                    os.put(static_cast<T>(':'));
+                    helpers::detail::write_chars(os, ss);
+                    return;
+                }
+                case DataTag::INT: {
+                    os.put(static_cast<T>('i'));
+                    ::std::basic_string<T, Traits> int_str;
+                    helpers::detail::append_int<int_type>(*get_int(), int_str);
+                    os.write(int_str.data(), int_str.size());
+                    os.put(static_cast<T>('e'));
+                    return;
+                }
+                case DataTag::LIST:
+                    os.put(static_cast<T>('l'));
+                    for (const basic_data& i : *get_list()) {
+                        i.serialise<T, Traits>(os);
+                    }
+                    os.put(static_cast<T>('e'));
+                    return;
+                case DataTag::DICT:
+                    os.put(static_cast<T>('d'));
+                    for_each_sorted_item(*get_dict(), [&os](const typename dict_type::value_type& i) {
+                        const str_type& key = i.first;
+                        ::std::basic_string<T, Traits> key_size_str;
+                        helpers::detail::append_int<::std::size_t>(key.size(), key_size_str);
+                        os.write(key_size_str.data(), key_size_str.size());
+                        os.put(static_cast<T>(':'));
+                        helpers::detail::write_chars(os, key);
+                        i.second.template serialise<T, Traits>(os);
+                    });
+                    os.put(static_cast<T>('e'));
+                    return;
+                default:
+                    return;
+            }
+        }
+
+        // Deserialisation of pointers / arrays
+    private:
+        template<typename T>
+        static void pointer_read_str_slow(const T* const begin, ::std::size_t& i, const ::std::size_t size, const char* first, ::std::string& out_str) {
+            ::std::size_t str_size = helpers::detail::pointer_read_int<::std::size_t, T>(begin, i, size, ':', first);
+            if (i + str_size > size) {
+                throw errors::cut_off_str_error.copy();
+            }
+            out_str.reserve(str_size);
+            for (const ::std::size_t str_end = i + str_size; i < str_end; ++i) {
+                out_str.push_back(static_cast<char>(begin[i]));
+            }
+        }
+
+        // Makes a decoded value, which was encoded at `[start, end)` in the buffer if `spans`.
+        template<DataTag tag, bool spans>
+        static basic_data make_decoded(tag_to_type_t<tag> value, const ::std::size_t start, const ::std::size_t end, const data_allocator_type& alloc) {
+            TORREBIS_CONSTEXPR_IF (spans) {
+                helpers::detail::node_meta meta = helpers::detail::node_meta();
+                meta.span = { start, end };
+                meta.has_span = true;
+                return make_boxed<tag>(::std::move(value), meta, alloc);
+            }
+            return allocate<tag>(alloc, ::std::move(value));
+        }
+
+        template<typename T, bool spans = false>
+        static basic_data pointer_bdecode_loop(
+            const T* const begin, ::std::size_t& i, const ::std::size_t size, const data_allocator_type& alloc
+        ) {
+            if (i >= size) {
+                throw errors::expecting_value_error.copy();
+            }
+            const ::std::size_t start = i;
+            switch (static_cast<char>(begin[i])) {
+                case 'i': {
+                    // int "ixxxe"
+                    ++i;
+                    const int_type value = helpers::detail::pointer_read_int<int_type, T>(begin, i, size, 'e', nullptr);
+                    return make_decoded<DataTag::INT, spans>(value, start, i, alloc);
+                }
+                case 'l': {
+                    // list "lxxxe"
+                    ++i;
+                    list_type list = helpers::detail::construct_with_allocator<list_type>(alloc);
+                    while (true) {
+                        if (i >= size) {
+                            throw errors::expecting_value_error.copy();
+                        }
+                        if (static_cast<char>(begin[i]) == 'e') {
+                            break;
+                        }
+                        list.push_back(pointer_bdecode_loop<T, spans>(begin, i, size, alloc));
+                    }
+                    ++i;
+                    return make_decoded<DataTag::LIST, spans>(::std::move(list), start, i, alloc);
+                }
+                case 'd': {
+                    // dict "dxxxe"
+                    ++i;
+                    dict_type dict = helpers::detail::construct_with_allocator<dict_type>(alloc);
+                    const char* last_key_begin = nullptr;
+                    ::std::size_t last_key_size;
+                    ::std::string last_key;  // Owns the previous key when it isn't in the buffer
+                    while (true) {
+                        if (i >= size) {
+                            throw errors::expecting_value_error.copy();
+                        }
+                        if (static_cast<char>(begin[i]) == 'e') {
+                            break;
+                        }
+                        const char* key_begin;
+                        ::std::size_t key_size;
+                        TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<T, char>::value) {
+                            auto begin_size = helpers::detail::pointer_read_str_fast(reinterpret_cast<const char*>(begin), i, size, nullptr);
+                            key_begin = begin_size.first;
+                            key_size = begin_size.second;
+                            if (last_key_begin != nullptr) {
+                                // TODO
+                                if (!helpers::detail::key_less_than(last_key_begin, last_key_size, key_begin, key_size)) {
+                                    throw errors::key_order_error.copy();
+                                }
+                            }
+                            last_key_begin = key_begin;
+                            last_key_size = key_size;
+                            str_type key = helpers::detail::take_key<str_type>(str_view(key_begin, key_size), alloc);
+                            dict.emplace_hint(dict.end(), ::std::move(key), pointer_bdecode_loop<T, spans>(begin, i, size, alloc));
+                        } else {
+                            ::std::string key;
+                            pointer_read_str_slow<T>(begin, i, size, nullptr, key);
+                            key_begin = key.data();
+                            key_size = key.size();
+                            if (last_key_begin != nullptr) {
+                                if (!helpers::detail::key_less_than(last_key_begin, last_key_size, key_begin, key_size)) {
+                                    throw errors::key_order_error.copy();
+                                }
+                            }
+                            last_key = key;
+                            last_key_begin = last_key.data();
+                            last_key_size = last_key.size();
+                            dict.emplace_hint(dict.end(), helpers::detail::take_key<str_type>(::std::move(key), alloc), pointer_bdecode_loop<T, spans>(begin, i, size, alloc));
+                        }
+                    }
+                    ++i;
+                    return make_decoded<DataTag::DICT, spans>(::std::move(dict), start, i, alloc);
+                }
+                case '0': case '1': case '2':
+                case '3': case '4': case '5':
+                case '6': case '7': case '8':
+                case '9': {
+                    // str "yy:xxxx"
+                    TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<T, char>::value) {
+                        const char* const chars = reinterpret_cast<const char*>(begin);
+                        auto begin_size = helpers::detail::pointer_read_str_fast(chars, i, size, &chars[i++]);
+                        const char* str_begin = begin_size.first;
+                        ::std::size_t str_size = begin_size.second;
+                        return make_decoded<DataTag::STR, spans>(helpers::detail::construct_with_allocator<str_type>(alloc, str_begin, str_size), start, i, alloc);
+                    }
+                    ::std::string s;
+                    pointer_read_str_slow<T>(begin, i, size, reinterpret_cast<const char*>(&begin[i++]), s);
+                    return make_decoded<DataTag::STR, spans>(helpers::detail::take_str<str_type>(::std::move(s), alloc), start, i, alloc);
+                }
+                default:
+                    throw errors::unknown_value_error.copy();
+            }
+        }
+
+    public:
+        template<typename T>
+        static basic_data load(const T* const begin, const ::std::size_t size, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            TORREBIS_CONSTEXPR_IF (helpers::detail::is_borrowed_str<str_type>::value && !helpers::detail::is_same_decayed<T, char>::value) {
+                // Borrowed strings have to point into `begin`, which only the `char` path does.
+                return load<char>(reinterpret_cast<const char*>(begin), size, alloc);
+            }
+            ::std::size_t i = 0;
+            auto parsed = pointer_bdecode_loop(begin, i, size, alloc);
+            if (i != size) {
+                throw errors::early_end_error.copy();
+            }
+            return parsed;
+        }
+
+        template<typename T>
+        static basic_data load(const T* const begin, const T* const end, const data_allocator_type& alloc = data_allocator_type()) {
+            return load<T>(begin, static_cast<::std::size_t>(end - begin), alloc);
+        }
+
+        // Like `load(begin, size)`, but every value remembers where it was in the buffer. See `raw_span()`.
+        template<typename T>
+        static basic_data load(const T* const begin, const ::std::size_t size, const RecordSpans, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            TORREBIS_CONSTEXPR_IF (helpers::detail::is_borrowed_str<str_type>::value && !helpers::detail::is_same_decayed<T, char>::value) {
+                return load<char>(reinterpret_cast<const char*>(begin), size, record_spans, alloc);
+            }
+            ::std::size_t i = 0;
+            auto parsed = pointer_bdecode_loop<T, true>(begin, i, size, alloc);
+            if (i != size) {
+                throw errors::early_end_error.copy();
+            }
+            return parsed;
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load(const ::std::basic_string<T, Rest...>& s, const RecordSpans, const data_allocator_type& alloc = data_allocator_type()) {
+            return load<T>(s.data(), s.size(), record_spans, alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load(const ::std::vector<T, Rest...>& v, const RecordSpans, const data_allocator_type& alloc = data_allocator_type()) {
+            return load<T>(v.data(), v.size(), record_spans, alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load(const ::std::basic_string<T, Rest...>& s, const data_allocator_type& alloc = data_allocator_type()) {
+            return load<T>(s.data(), s.size(), alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load(const ::std::basic_string<T, Rest...>&& s, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(!helpers::detail::is_borrowed_str<str_type>::value, "Borrowed strings cannot be loaded from a temporary buffer");
+            return load<T>(s.data(), s.size(), alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load(const ::std::vector<T, Rest...>& v, const data_allocator_type& alloc = data_allocator_type()) {
+            return load<T>(v.data(), v.size(), alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load(const ::std::vector<T, Rest...>&& v, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(!helpers::detail::is_borrowed_str<str_type>::value, "Borrowed strings cannot be loaded from a temporary buffer");
+            return load<T>(v.data(), v.size(), alloc);
+        }
+
+#ifdef TORREBIS_STD_ARRAY_HAS_DATA
+        template<typename T, ::std::size_t N = 0>
+        static basic_data load(const ::std::array<T, N>& a, const data_allocator_type& alloc = data_allocator_type()) {
+            return load<T>(a.data(), a.size(), alloc);
+        }
+#endif
+
+        // Deserialisation of a single value
+    private:
+        // Moves `i` from the start of a value to the start of its item at `el`. Returns false if there isn't one.
+        static bool extract_step(const char* const begin, ::std::size_t& i, const ::std::size_t size, const path_el_type& el) {
+            if (i >= size) {
+                throw errors::expecting_value_error.copy();
+            }
+            if (el.is_key()) {
+                if (begin[i] != 'd') {
+                    return false;
+                }
+                ++i;
+                const str_type& key = *el.get_key();
+                const char* const key_begin = reinterpret_cast<const char*>(key.data());
+                const ::std::size_t key_size = key.size();
+                while (true) {
+                    if (i >= size) {
+                        throw errors::expecting_value_error.copy();
+                    }
+                    if (begin[i] == 'e') {
+                        return false;
+                    }
+                    auto current = helpers::detail::pointer_read_str_fast(begin, i, size, nullptr);
+                    if (current.second == key_size && ::std::memcmp(current.first, key_begin, key_size) == 0) {
+                        return true;
+                    }
+                    if (helpers::detail::key_less_than(key_begin, key_size, current.first, current.second)) {
+                        // Keys are sorted, so it isn't in this dict
+                        return false;
+                    }
+                    helpers::detail::pointer_skip_value(begin, i, size);
+                }
+            }
+            if (el.is_index()) {
+                if (begin[i] != 'l') {
+                    return false;
+                }
+                ++i;
+                for (::std::size_t n = el.get_index(); ; --n) {
+                    if (i >= size) {
+                        throw errors::expecting_value_error.copy();
+                    }
+                    if (begin[i] == 'e') {
+                        return false;
+                    }
+                    if (n == 0) {
+                        return true;
+                    }
+                    helpers::detail::pointer_skip_value(begin, i, size);
+                }
+            }
+            return false;
+        }
+
+        template<class T>
+        static basic_data extract_loop(const char* const begin, const ::std::size_t size, const T& path) {
+            const data_allocator_type alloc = data_allocator_type();
+            ::std::size_t i = 0;
+            for (const auto& el : path) {
+                if (!extract_step(begin, i, size, path_el_type(el))) {
+                    return basic_data();
+                }
+            }
+            return pointer_bdecode_loop<char>(begin, i, size, alloc);
+        }
+
+    public:
+        /*
+         * Decodes only the value at `path` in some bencoded data, like `load(begin, size).get_path(path...)` without
+         * building the rest. Everything not on the path is skipped over by length, and is not checked.
+         * Returns an uninitialised `basic_data` if there is nothing at `path`.
+         */
+        template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+        static basic_data extract(const char* const begin, const ::std::size_t size, PathEls... path) {
+            const ::std::initializer_list<path_el_type> path_list = { path_el_type(path)... };
+            return extract_loop(begin, size, path_list);
+        }
+
+        template<class T, class = enable_if_path_iterable<T>>  // Where T is an iterable of basic_data::path_el_type
+        static basic_data extract(const char* const begin, const ::std::size_t size, const T& path) {
+            return extract_loop(begin, size, path);
+        }
+
+        template<typename T, typename... Rest, class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+        static basic_data extract(const ::std::basic_string<T, Rest...>& s, PathEls... path) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            return extract(reinterpret_cast<const char*>(s.data()), s.size(), path...);
+        }
+
+        template<typename T, typename... Rest, class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+        static basic_data extract(const ::std::basic_string<T, Rest...>&& s, PathEls... path) {
+            static_assert(!helpers::detail::is_borrowed_str<str_type>::value, "Borrowed strings cannot be extracted from a temporary buffer");
+            return extract(s, path...);
+        }
+
+        template<typename T, typename... Rest, class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+        static basic_data extract(const ::std::vector<T, Rest...>& v, PathEls... path) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            return extract(reinterpret_cast<const char*>(v.data()), v.size(), path...);
+        }
+
+        template<typename T, typename... Rest, class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+        static basic_data extract(const ::std::vector<T, Rest...>&& v, PathEls... path) {
+            static_assert(!helpers::detail::is_borrowed_str<str_type>::value, "Borrowed strings cannot be extracted from a temporary buffer");
+            return extract(v, path...);
+        }
+
+        // Lazy deserialisation
+    private:
+        // Decodes one value from data that has already been checked, leaving the items of lists and dicts for later.
+        // If `base` isn't nullptr, the value remembers where it was relative to `base`.
+        static basic_data lazy_bdecode_loop(const char* const begin, ::std::size_t& i, const ::std::size_t size, const char* const base, const data_allocator_type& alloc) {
+            const ::std::size_t start = i;
+            helpers::detail::node_meta meta = helpers::detail::node_meta();
+            switch (begin[i]) {
+                case 'i': {
+                    // int "ixxxe"
+                    ++i;
+                    const int_type value = helpers::detail::pointer_read_int<int_type, char>(begin, i, size, 'e', nullptr);
+                    if (base == nullptr) {
+                        return allocate<DataTag::INT>(alloc, value);
+                    }
+                    meta.span = { static_cast<::std::size_t>(begin + start - base), static_cast<::std::size_t>(begin + i - base) };
+                    meta.has_span = true;
+                    return make_boxed<DataTag::INT>(int_type(value), meta, alloc);
+                }
+                case 'l':
+                case 'd': {
+                    // list "lxxxe" or dict "dxxxe"
+                    helpers::detail::pointer_skip_value(begin, i, size);
+                    if (i - start != 2) {
+                        meta.lazy_begin = begin + start;
+                        meta.lazy_size = i - start;
+                    } else if (base == nullptr) {
+                        if (begin[start] == 'l') {
+                            return allocate<DataTag::LIST>(alloc, helpers::detail::construct_with_allocator<list_type>(alloc));
+                        }
+                        return allocate<DataTag::DICT>(alloc, helpers::detail::construct_with_allocator<dict_type>(alloc));
+                    }
+                    if (base != nullptr) {
+                        meta.span = { static_cast<::std::size_t>(begin + start - base), static_cast<::std::size_t>(begin + i - base) };
+                        meta.has_span = true;
+                    }
+                    if (begin[start] == 'l') {
+                        return make_boxed<DataTag::LIST>(helpers::detail::construct_with_allocator<list_type>(alloc), meta, alloc);
+                    }
+                    return make_boxed<DataTag::DICT>(helpers::detail::construct_with_allocator<dict_type>(alloc), meta, alloc);
+                }
+                default: {
+                    // str "yy:xxxx"
+                    auto begin_size = helpers::detail::pointer_read_str_fast(begin, i, size, nullptr);
+                    str_type value = helpers::detail::construct_with_allocator<str_type>(alloc, begin_size.first, begin_size.second);
+                    if (base == nullptr) {
+                        return allocate<DataTag::STR>(alloc, ::std::move(value));
+                    }
+                    meta.span = { static_cast<::std::size_t>(begin + start - base), static_cast<::std::size_t>(begin + i - base) };
+                    meta.has_span = true;
+                    return make_boxed<DataTag::STR>(::std::move(value), meta, alloc);
+                }
+            }
+        }
+
+        // Decodes the items of a lazily loaded list or dict, if they haven't been already.
+        void load_lazy_items() const {
+            helpers::detail::node_meta* const meta = get_meta();
+            if (meta == nullptr || meta->lazy_begin == nullptr) {
+                return;
+            }
+            const char* const begin = meta->lazy_begin;
+            const ::std::size_t size = meta->lazy_size;
+            const char* const base = meta->has_span ? begin - meta->span.begin : nullptr;
+            ::std::size_t i = 1;  // After the 'l' or 'd'
+            // The items are allocated like the empty list or dict they go in, which was made with the `load_lazy` allocator
+            if (tag_ == DataTag::LIST) {
+                const data_allocator_type alloc = helpers::detail::allocator_of<data_allocator_type>(get_box<DataTag::LIST>()->value);
+                list_type list = helpers::detail::construct_with_allocator<list_type>(alloc);
+                while (begin[i] != 'e') {
+                    list.push_back(lazy_bdecode_loop(begin, i, size, base, alloc));
+                }
+                ::std::swap(get_box<DataTag::LIST>()->value, list);
+            } else {
+                const data_allocator_type alloc = helpers::detail::allocator_of<data_allocator_type>(get_box<DataTag::DICT>()->value);
+                dict_type dict = helpers::detail::construct_with_allocator<dict_type>(alloc);
+                while (begin[i] != 'e') {
+                    auto key = helpers::detail::pointer_read_str_fast(begin, i, size, nullptr);
+                    dict.emplace_hint(
+                        dict.end(),
+                        helpers::detail::take_key<str_type>(str_view(key.first, key.second), alloc),
+                        lazy_bdecode_loop(begin, i, size, base, alloc)
+                    );
+                }
+                ::std::swap(get_box<DataTag::DICT>()->value, dict);
+            }
+            meta->lazy_begin = nullptr;
+            forget_cached();
+        }
+
+    public:
+        /*
+         * Like `load`, but the items of a list or dict are only decoded the first time it is accessed
+         * (`get_list()`, `get_dict()`, `get_path(...)`, ...). The whole buffer is still checked up front.
+         *
+         * Lazily loaded data borrows from the buffer until every list and dict in it has been accessed, so the buffer
+         * must outlive it. Accessing lazily loaded data from multiple threads at once is not safe.
+         */
+        static basic_data load_lazy(const char* const begin, const ::std::size_t size, const data_allocator_type& alloc = data_allocator_type()) {
+            basic_event_handler<int_type> validator;
+            bdecode_events<int_type>(begin, size, validator);
+            ::std::size_t i = 0;
+            return lazy_bdecode_loop(begin, i, size, nullptr, alloc);
+        }
+
+        // Like `load_lazy(begin, size)`, but every value remembers where it was in the buffer. See `raw_span()`.
+        static basic_data load_lazy(const char* const begin, const ::std::size_t size, const RecordSpans, const data_allocator_type& alloc = data_allocator_type()) {
+            basic_event_handler<int_type> validator;
+            bdecode_events<int_type>(begin, size, validator);
+            ::std::size_t i = 0;
+            return lazy_bdecode_loop(begin, i, size, begin, alloc);
+        }
+
+        template<typename T>
+        static basic_data load_lazy(const T* const begin, const ::std::size_t size, const RecordSpans, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            return load_lazy(reinterpret_cast<const char*>(begin), size, record_spans, alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load_lazy(const ::std::basic_string<T, Rest...>& s, const RecordSpans, const data_allocator_type& alloc = data_allocator_type()) {
+            return load_lazy<T>(s.data(), s.size(), record_spans, alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load_lazy(const ::std::vector<T, Rest...>& v, const RecordSpans, const data_allocator_type& alloc = data_allocator_type()) {
+            return load_lazy<T>(v.data(), v.size(), record_spans, alloc);
+        }
+
+        template<typename T>
+        static basic_data load_lazy(const T* const begin, const ::std::size_t size, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            return load_lazy(reinterpret_cast<const char*>(begin), size, alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load_lazy(const ::std::basic_string<T, Rest...>& s, const data_allocator_type& alloc = data_allocator_type()) {
+            return load_lazy<T>(s.data(), s.size(), alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load_lazy(const ::std::basic_string<T, Rest...>&& s, const data_allocator_type& alloc = data_allocator_type()) = delete;
+
+        template<typename T, typename... Rest>
+        static basic_data load_lazy(const ::std::vector<T, Rest...>& v, const data_allocator_type& alloc = data_allocator_type()) {
+            return load_lazy<T>(v.data(), v.size(), alloc);
+        }
+
+        template<typename T, typename... Rest>
+        static basic_data load_lazy(const ::std::vector<T, Rest...>&& v, const data_allocator_type& alloc = data_allocator_type()) = delete;
+        // Deserialisation of iterators
+    private:
+
+        template<typename IntType, typename Iterator>
+        static IntType array_read_int(Iterator& it, const Iterator& end, const char end_char, const char* const first) {
+            char first_char;
+            if (first == nullptr) {
+                if (it == end) {
+                    throw errors::expecting_int_error.copy();
+                }
+                first_char = static_cast<char>(*it);
+                ++it;
+            } else {
+                first_char = *first;
+            }
+            if (first_char == '0') {
+                if (it == end || static_cast<char>(*it) != end_char) {
+                    throw errors::expecting_int_error.copy();
+                }
+                ++it;
+                return IntType(0);
+            }
+            int sign = +1;
+            if (first_char == '-') {
+                sign = -1;
+                if (it == end) {
+                    throw errors::expecting_int_error.copy();
+                }
+                first_char = static_cast<char>(*it);
+                ++it;
+            }
+            if (!('1' <= first_char && first_char <= '9')) {
+                throw errors::expecting_int_error.copy();
+            }
+            IntType res = IntType(static_cast<int>(sign * static_cast<int>(first_char - '0')));
+            while (true) {
+                if (it == end) {
+                    throw errors::expecting_int_error.copy();
+                }
+                const char next_char = static_cast<char>(*it);
+                ++it;
+                if (!('0' <= next_char && next_char <= '9')) {
+                    if (next_char == end_char) {
+                        break;
+                    }
+                    throw errors::expecting_int_error.copy();
+                }
+                IntType previous_res = res;
+                res = res * IntType(10) + IntType(static_cast<int>(sign * static_cast<int>(next_char - '0')));
+                if ((previous_res < res) != (sign > 0)) {
+                    throw errors::integer_overflow_error.copy();
+                }
+            }
+            return res;
+        }
+
+        template<typename Iterator>
+        static void array_read_str(Iterator& it, const Iterator& end, const char* first, ::std::string& out_str) {
+            ::std::size_t str_size = array_read_int<::std::size_t, Iterator>(it, end, ':', first);
+            out_str.reserve(str_size);
+            for (; str_size-- > 0;) {
+                if (it == end) {
+                    throw errors::cut_off_str_error.copy();
+                }
+                out_str.push_back(static_cast<char>(*it));
+                ++it;
+            }
+        }
+
+        template<typename Iterator>
+        static basic_data array_bdecode_loop(Iterator& it, const Iterator& end, const data_allocator_type& alloc) {
+            if (it == end) {
+                throw errors::expecting_value_error.copy();
+            }
+            switch (static_cast<char>(*it)) {
+                case 'i':
+                    // int "ixxxe"
+                    ++it;
+                    return allocate<DataTag::INT>(alloc, array_read_int<int_type, Iterator>(it, end, 'e', nullptr));
+                case 'l': {
+                    // list "lxxxe"
+                    ++it;
+                    list_type list = helpers::detail::construct_with_allocator<list_type>(alloc);
+                    while (true) {
+                        if (it == end) {
+                            throw errors::expecting_value_error.copy();
+                        }
+                        if (static_cast<char>(*it) == 'e') {
+                            break;
+                        }
+                        list.push_back(array_bdecode_loop<Iterator>(it, end, alloc));
+                    }
+                    ++it;
+                    return allocate<DataTag::LIST>(alloc, ::std::move(list));
+                }
+                case 'd': {
+                    // dict "dxxxe"
+                    ++it;
+                    dict_type dict = helpers::detail::construct_with_allocator<dict_type>(alloc);
+                    const char* last_key_begin = nullptr;
+                    ::std::size_t last_key_size;
+                    ::std::string last_key;  // Owns the previous key when it isn't in the buffer
+                    while (true) {
+                        if (it == end) {
+                            throw errors::expecting_value_error.copy();
+                        }
+                        if (static_cast<char>(*it) == 'e') {
+                            break;
+                        }
+                        const char* key_begin;
+                        ::std::size_t key_size;
+                        ::std::string key;
+                        array_read_str<Iterator>(it, end, nullptr, key);
+                        key_begin = key.data();
+                        key_size = key.size();
+                        if (last_key_begin != nullptr) {
+                            if (!helpers::detail::key_less_than(last_key_begin, last_key_size, key_begin, key_size)) {
+                                throw errors::key_order_error.copy();
+                            }
+                        }
+                        last_key = key;
+                        last_key_begin = last_key.data();
+                        last_key_size = last_key.size();
+                        dict.emplace_hint(dict.end(), helpers::detail::take_key<str_type>(::std::move(key), alloc), array_bdecode_loop<Iterator>(it, end, alloc));
+                    }
+                    ++it;
+                    return allocate<DataTag::DICT>(alloc, ::std::move(dict));
+                }
+                case '0': case '1': case '2':
+                case '3': case '4': case '5':
+                case '6': case '7': case '8':
+                case '9': {
+                    // str "yy:xxxx"
+                    ::std::string s;
+                    array_read_str<Iterator>(it, end, nullptr, s);
+                    return allocate<DataTag::STR>(alloc, helpers::detail::take_str<str_type>(::std::move(s), alloc));
+                }
+                default:
+                    throw errors::unknown_value_error.copy();
+            }
+        }
+
+    public:
+
+        template<typename Iterator>
+        static basic_data load(Iterator it, const Iterator& end, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(!helpers::detail::is_borrowed_str<str_type>::value, "Borrowed strings can only be loaded from a pointer");
+            auto parsed = array_bdecode_loop<Iterator>(it, end, alloc);
+            if (it != end) {
+                throw errors::early_end_error.copy();
+            }
+            return parsed;
+        }
+
+        // Deserialisation of istreams
+
+    private:
+
+        template<typename IntType, class T, class Traits>
+        static IntType stream_read_int(::std::basic_istream<T, Traits>& is, const char end_char, const char* const first) {
+            T first_byte;
+            if (first == nullptr) {
+                if (!is.read(&first_byte, 1)) {
+                    throw errors::expecting_int_error.copy();
+                }
+            } else {
+                first_byte = static_cast<T>(*first);
+            }
+            if (first_byte == static_cast<T>('0')) {
+                if (!is.read(&first_byte, 1) || static_cast<char>(first_byte) != end_char) {
+                    throw errors::expecting_int_error.copy();
+                }
+                return IntType(0);
+            }
+            int sign = +1;
+            if (first_byte == static_cast<T>('-')) {
+                sign = -1;
+                if (!is.read(&first_byte, 1)) {
+                    throw errors::expecting_int_error.copy();
+                }
+            }
+            if (!(static_cast<T>('1') <= first_byte && first_byte <= static_cast<T>('9'))) {
+                throw errors::expecting_int_error.copy();
+            }
+            IntType res = IntType(static_cast<int>(sign * static_cast<int>(static_cast<char>(first_byte) - '0')));
+            while (true) {
+                T next_byte;
+                if (!is.read(&next_byte, 1)) {
+                    throw errors::expecting_int_error.copy();
+                }
+
+                if (!(static_cast<T>('0') <= next_byte && next_byte <= static_cast<T>('9'))) {
+                    if (static_cast<char>(next_byte) == end_char) {
+                        break;
                     }
-                    result = &search->second;
-                } else if (path_i.is_index()) {
-                    if (!result->is_list()) {
-                        return nullptr;
+                    throw errors::expecting_int_error.copy();
+                }
+                IntType previous_res = res;
+                res = res * IntType(10) + IntType(static_cast<int>(sign * static_cast<int>(static_cast<char>(next_byte) - '0')));
+                if ((previous_res < res) != (sign > 0)) {
+                    throw errors::integer_overflow_error.copy();
+                }
+            }
+            return res;
+        }
+
+        template<class T, class Traits>
+        static ::std::basic_string<T, Traits> stream_read_str(::std::basic_istream<T, Traits>& is, const char* first) {
+            ::std::size_t str_size = stream_read_int<::std::size_t, T, Traits>(is, ':', first);
+            ::std::basic_string<T, Traits> out_str(str_size, static_cast<T>('\0'));
+            if (!is.read(&out_str[0], static_cast<::std::streamsize>(str_size))) {
+                throw errors::cut_off_str_error.copy();
+            }
+            return out_str;
+        }
+
+        template<class T, class Traits>
+        static basic_data stream_bdecode_loop(::std::basic_istream<T, Traits>& is, T* first, const data_allocator_type& alloc) {
+            if (!is) {
+                throw errors::bad_stream_error.copy();
+            }
+            T start_byte;
+            if (first == nullptr) {
+                if (!is.read(&start_byte, 1)) {
+                    throw errors::expecting_value_error.copy();
+                }
+            } else {
+                start_byte = *first;
+            }
+            switch (static_cast<char>(start_byte)) {
+                case 'i':
+                    // int "ixxxe"
+                    return allocate<DataTag::INT>(alloc, stream_read_int<int_type, T, Traits>(is, 'e', nullptr));
+                case 'l': {
+                    // list "lxxxe"
+                    list_type list = helpers::detail::construct_with_allocator<list_type>(alloc);
+                    while (true) {
+                        T end_byte;
+                        if (!is.read(&end_byte, 1)) {
+                            throw errors::expecting_value_error.copy();
+                        }
+                        if (static_cast<char>(end_byte) == 'e') {
+                            break;
+                        }
+                        list.push_back(stream_bdecode_loop<T, Traits>(is, &end_byte, alloc));
                     }
-                    list_type& list = result->get_list();
-                    if (path_i.get_index() >= list.size()) {
-                        return nullptr;
+                    return allocate<DataTag::LIST>(alloc, ::std::move(list));
+                }
+                case 'd': {
+                    // dict "dxxxe"
+                    dict_type dict = helpers::detail::construct_with_allocator<dict_type>(alloc);
+                    const char* last_key_begin = nullptr;
+                    ::std::size_t last_key_size;
+                    ::std::basic_string<T, Traits> last_key;  // Owns the previous key when it isn't in the buffer
+                    while (true) {
+                        T end_byte;
+                        if (!is.read(&end_byte, 1)) {
+                            throw errors::expecting_value_error.copy();
+                        }
+                        if (static_cast<char>(end_byte) == 'e') {
+                            break;
+                        }
+                        const char* key_begin;
+                        ::std::size_t key_size;
+                        ::std::basic_string<T, Traits> key = stream_read_str<T, Traits>(is, &end_byte);
+                        key_begin = key.data();
+                        key_size = key.size();
+                        if (last_key_begin != nullptr) {
+                            if (!helpers::detail::key_less_than<T>(last_key_begin, last_key_size, key_begin, key_size)) {
+                                throw errors::key_order_error.copy();
+                            }
+                        }
+                        last_key = key;
+                        last_key_begin = last_key.data();
+                        last_key_size = last_key.size();
+                        dict.emplace_hint(dict.end(), helpers::detail::take_key<str_type>(::std::move(key), alloc), stream_bdecode_loop<T, Traits>(is, nullptr, alloc));
                     }
-                    result = &list.at(path_i.get_index());
-                } else {
-                    return nullptr;
+                    return allocate<DataTag::DICT>(alloc, ::std::move(dict));
                 }
+                case '0': case '1': case '2':
+                case '3': case '4': case '5':
+                case '6': case '7': case '8':
+                case '9': {
+                    // str "yy:xxxx"
+                    ::std::basic_string<T, Traits> s = stream_read_str<T, Traits>(is, &start_byte);
+                    return allocate<DataTag::STR>(alloc, helpers::detail::take_str<str_type>(::std::move(s), alloc));
+                }
+                default:
+                    throw errors::unknown_value_error.copy();
             }
-            return result;
         }
 
-        template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
-        basic_data* get_path(PathEls... path) {
-            basic_data* result = this;
-            const path_el_type path_arr[sizeof...(path)] = { path_el_type(path)... };
-            for (::std::size_t i = 0; i < sizeof...(path); ++i) {
-                const path_el_type path_i(path_arr[i]);
-                if (path_i.is_key()) {
-                    if (!result->is_dict()) {
-                        return nullptr;
-                    }
-                    dict_type& dict = *result->get_dict();
-                    auto search = dict.find(*path_i.get_key());
-                    if (search == dict.end()) {
-                        return nullptr;
-                    }
-                    result = &search->second;
-                } else if (path_i.is_index()) {
-                    if (!result->is_list()) {
-                        return nullptr;
-                    }
-                    list_type& list = *result->get_list();
-                    if (path_i.get_index() >= list.size()) {
-                        return nullptr;
-                    }
-                    result = &list.at(path_i.get_index());
-                } else {
-                    return nullptr;
-                }
+    public:
+        template<class T = char, class Traits = ::std::char_traits<T>>
+        static basic_data load(::std::basic_istream<T, Traits>& is, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(!helpers::detail::is_borrowed_str<str_type>::value, "Borrowed strings can only be loaded from a pointer");
+            auto parsed = stream_bdecode_loop<T, Traits>(is, nullptr, alloc);
+            if (!is) {
+                throw errors::bad_stream_error.copy();
             }
-            return result;
+            if (is.peek() != Traits::eof()) {
+                throw errors::early_end_error.copy();
+            }
+            return parsed;
         }
 
-        template<class T>  // Where T is an iterable of basic_data::path_el_type
-        const basic_data* get_path(T path) const {
-            const basic_data& result = *this;
-            for (const auto& el : path) {
-                path_el_type path_i(el);
-                if (path_i.is_key()) {
-                    if (!result.is_dict()) {
-                        return nullptr;
-                    }
-                    dict_type& dict = *result.get_dict();
-                    auto search = dict.find(*path_i.get_key());
-                    if (search == dict.end()) {
-                        return nullptr;
-                    }
-                    result = search->second;
-                } else if (path_i.is_index()) {
-                    if (!result.is_list()) {
-                        return nullptr;
-                    }
-                    list_type& list = *result.get_list();
-                    if (path_i.get_index() >= list.size()) {
-                        return nullptr;
-                    }
-                    result = list[path_i.get_index()];
-                } else {
-                    return nullptr;
+        // Buffered deserialisation of istreams
+
+    private:
+
+        template<typename IntType, class T, class Traits>
+        static IntType buffered_stream_read_int(helpers::detail::stream_window<T, Traits>& window, const char end_char, const T* const first) {
+            T first_byte;
+            if (first == nullptr) {
+                if (!window.next(first_byte)) {
+                    throw errors::expecting_int_error.copy();
                 }
+            } else {
+                first_byte = *first;
             }
-            return &result;
-        }
-
-        template<class T>
-        basic_data* get_path(T path) {
-            basic_data& result = *this;
-            for (const auto& el : path) {
-                path_el_type path_i(el);
-                if (path_i.is_key()) {
-                    if (!result.is_dict()) {
-                        return nullptr;
-                    }
-                    dict_type& dict = *result.get_dict();
-                    auto search = dict.find(*path_i.get_key());
-                    if (search == dict.end()) {
-                        return nullptr;
-                    }
-                    result = search->second;
-                } else if (path_i.is_index()) {
-                    if (!result.is_list()) {
-                        return nullptr;
-                    }
-                    list_type& list = *result.get_list();
-                    if (path_i.get_index() >= list.size()) {
-                        return nullptr;
-                    }
-                    result = list[path_i.get_index()];
-                } else {
-                    return nullptr;
+            if (first_byte == static_cast<T>('0')) {
+                if (!window.next(first_byte) || static_cast<char>(first_byte) != end_char) {
+                    throw errors::expecting_int_error.copy();
                 }
+                return IntType(0);
             }
-            return &result;
-        }
-
-        template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
-        const ::std::pair<const ::std::size_t, const basic_data&> try_path(PathEls... path) const {
-            const basic_data& result = *this;
-            ::std::size_t i = 0;
-            const path_el_type path_arr[sizeof...(path)] = { path... };
-            for (i = 0; i < sizeof...(path); ++i) {
-                const path_el_type path_i(path_arr[i]);
-                if (path_i.is_key()) {
-                    if (!result.is_dict()) {
-                        break;
-                    }
-                    dict_type& dict = *result.get_dict();
-                    auto search = dict.find(*path_i.get_key());
-                    if (search == dict.end()) {
-                        break;
-                    }
-                    result = search->second;
-                } else if (path_i.is_index()) {
-                    if (!result.is_list()) {
-                        break;
-                    }
-                    list_type& list = *result.get_list();
-                    if (path_i.get_index() >= list.size()) {
-                        break;
-                    }
-                    result = list[path_i.get_index()];
-                } else {
-                    break;
+            int sign = +1;
+            if (first_byte == static_cast<T>('-') && !::std::is_unsigned<IntType>::value) {
+                sign = -1;
+                if (!window.next(first_byte)) {
+                    throw errors::expecting_int_error.copy();
                 }
             }
-            return { i, result };
-        }
-
-        template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
-        const ::std::pair<const ::std::size_t, basic_data&> try_path(PathEls... path) {
-            basic_data& result = *this;
-            ::std::size_t i = 0;
-            const path_el_type path_arr[sizeof...(path)] = { path... };
-            for (i = 0; i < sizeof...(path); ++i) {
-                const path_el_type path_i(path_arr[i]);
-                if (path_i.is_key()) {
-                    if (!result.is_dict()) {
-                        break;
-                    }
-                    dict_type& dict = *result.get_dict();
-                    auto search = dict.find(*path_i.get_key());
-                    if (search == dict.end()) {
-                        break;
-                    }
-                    result = search->second;
-                } else if (path_i.is_index()) {
-                    if (!result.is_list()) {
-                        break;
-                    }
-                    list_type& list = *result.get_list();
-                    if (path_i.get_index() >= list.size()) {
+            if (!(static_cast<T>('1') <= first_byte && first_byte <= static_cast<T>('9'))) {
+                throw errors::expecting_int_error.copy();
+            }
+            IntType res = IntType(static_cast<int>(sign * static_cast<int>(static_cast<char>(first_byte) - '0')));
+            while (true) {
+                T next_byte;
+                if (!window.next(next_byte)) {
+                    throw errors::expecting_int_error.copy();
+                }
+                if (!(static_cast<T>('0') <= next_byte && next_byte <= static_cast<T>('9'))) {
+                    if (static_cast<char>(next_byte) == end_char) {
                         break;
                     }
-                    result = list[path_i.get_index()];
-                } else {
-                    break;
+                    throw errors::expecting_int_error.copy();
+                }
+                IntType previous_res = res;
+                res = res * IntType(10) + IntType(static_cast<int>(sign * static_cast<int>(static_cast<char>(next_byte) - '0')));
+                if ((previous_res < res) != (sign > 0)) {
+                    throw errors::integer_overflow_error.copy();
                 }
             }
-            return { i, result };
+            return res;
         }
 
-        template<typename T>
-        ::std::pair<const ::std::size_t, const basic_data&> try_path(T path) const {
-            const basic_data& result = *this;
-            ::std::size_t i = 0;
-            for (auto& el : path) {
-                ++i;
-                path_el_type path_i(el);
-                if (path_i.is_key()) {
-                    if (!result.is_dict()) {
-                        break;
-                    }
-                    dict_type& dict = *result.get_dict();
-                    auto search = dict.find(*path_i.get_key());
-                    if (search == dict.end()) {
-                        break;
-                    }
-                    result = search->second;
-                } else if (path_i.is_index()) {
-                    if (!result.is_list()) {
-                        break;
-                    }
-                    list_type& list = *result.get_list();
-                    if (path_i.get_index() >= list.size()) {
-                        break;
-                    }
-                    result = list[path_i.get_index()];
-                } else {
-                    break;
+        template<class T, class Traits>
+        static ::std::basic_string<T, Traits> buffered_stream_read_str(helpers::detail::stream_window<T, Traits>& window, const T* first) {
+            ::std::size_t str_size = buffered_stream_read_int<::std::size_t, T, Traits>(window, ':', first);
+            ::std::basic_string<T, Traits> out_str;
+            // Grown as bytes are read (doubling, so each byte is copied a constant number of times), so a size that
+            // the stream doesn't live up to can't allocate much more than it really had
+            while (out_str.size() < str_size) {
+                const ::std::size_t old_size = out_str.size();
+                const ::std::size_t chunk = ::std::min(str_size - old_size, ::std::max(window.buffer_size(), old_size));
+                out_str.resize(old_size + chunk);
+                if (!window.read(&out_str[old_size], chunk)) {
+                    throw errors::cut_off_str_error.copy();
                 }
             }
-            return { i, result };
+            return out_str;
         }
 
-        template<typename T>
-        ::std::pair<const ::std::size_t, basic_data&> try_path(T path) {
-            basic_data& result = *this;
-            ::std::size_t i = 0;
-            for (auto& el : path) {
-                ++i;
-                path_el_type path_i(el);
-                if (path_i.is_key()) {
-                    if (!result.is_dict()) {
-                        break;
-                    }
-                    dict_type& dict = *result.get_dict();
-                    auto search = dict.find(*path_i.get_key());
-                    if (search == dict.end()) {
-                        break;
-                    }
-                    result = search->second;
-                } else if (path_i.is_index()) {
-                    if (!result.is_list()) {
-                        break;
-                    }
-                    list_type& list = *result.get_list();
-                    if (path_i.get_index() >= list.size()) {
-                        break;
-                    }
-                    result = list[path_i.get_index()];
-                } else {
-                    break;
+        template<class T, class Traits>
+        static basic_data buffered_stream_bdecode_loop(helpers::detail::stream_window<T, Traits>& window, const T* first, const data_allocator_type& alloc) {
+            T start_byte;
+            if (first == nullptr) {
+                if (!window.next(start_byte)) {
+                    throw errors::expecting_value_error.copy();
                 }
+            } else {
+                start_byte = *first;
             }
-            return { i, result };
-        }
-
-        // Serialisation
-    private:
-        template<typename IntType>
-        static ::std::size_t serialised_int_size(IntType i) {
-            if (i == 0) {
-                return 1;
-            }
-            ::std::size_t size = 0;
-            if (i < 0) {
-                i = -i;
-                ++size;
-            }
-            do {
-                i /= 10;
-                ++size;
-            } while (i != 0);
-            return size;
-        }
-
-        template<bool reserve, typename IntType, typename T, typename Traits = ::std::char_traits<T>>
-        static void int_to_string(IntType i, ::std::basic_string<T, Traits>& out_str) {
-            TORREBIS_CONSTEXPR_IF (helpers::detail::is_any<IntType,
-                int, long, long long, unsigned, unsigned long, unsigned long long>::value) {
-                TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<T, char>::value) {
-                    out_str.append(::std::to_string(i));
-                    return;
+            switch (static_cast<char>(start_byte)) {
+                case 'i':
+                    // int "ixxxe"
+                    return allocate<DataTag::INT>(alloc, buffered_stream_read_int<int_type, T, Traits>(window, 'e', nullptr));
+                case 'l': {
+                    // list "lxxxe"
+                    list_type list = helpers::detail::construct_with_allocator<list_type>(alloc);
+                    while (true) {
+                        T end_byte;
+                        if (!window.next(end_byte)) {
+                            throw errors::expecting_value_error.copy();
+                        }
+                        if (static_cast<char>(end_byte) == 'e') {
+                            break;
+                        }
+                        list.push_back(buffered_stream_bdecode_loop<T, Traits>(window, &end_byte, alloc));
+                    }
+                    return allocate<DataTag::LIST>(alloc, ::std::move(list));
                 }
-                ::std::string s = ::std::to_string(i);
-                TORREBIS_CONSTEXPR_IF (reserve) {
-                    ::std::size_t reservation = out_str.size() + s.size();
-                    if (out_str.capacity() < reservation) {
-                        out_str.reserve(reservation);
+                case 'd': {
+                    // dict "dxxxe"
+                    dict_type dict = helpers::detail::construct_with_allocator<dict_type>(alloc);
+                    ::std::basic_string<T, Traits> last_key;
+                    bool has_last_key = false;
+                    while (true) {
+                        T end_byte;
+                        if (!window.next(end_byte)) {
+                            throw errors::expecting_value_error.copy();
+                        }
+                        if (static_cast<char>(end_byte) == 'e') {
+                            break;
+                        }
+                        ::std::basic_string<T, Traits> key = buffered_stream_read_str<T, Traits>(window, &end_byte);
+                        if (has_last_key) {
+                            if (!helpers::detail::key_less_than<T>(last_key.data(), last_key.size(), key.data(), key.size())) {
+                                throw errors::key_order_error.copy();
+                            }
+                        }
+                        str_type real_key = helpers::detail::take_key<str_type>(key, alloc);
+                        dict.emplace_hint(dict.end(), ::std::move(real_key), buffered_stream_bdecode_loop<T, Traits>(window, nullptr, alloc));
+                        last_key.swap(key);
+                        has_last_key = true;
                     }
+                    return allocate<DataTag::DICT>(alloc, ::std::move(dict));
                 }
-                for (const char c : s) {
-                    s.push_back(static_cast<T>(c));
+                case '0': case '1': case '2':
+                case '3': case '4': case '5':
+                case '6': case '7': case '8':
+                case '9': {
+                    // str "yy:xxxx"
+                    ::std::basic_string<T, Traits> s = buffered_stream_read_str<T, Traits>(window, &start_byte);
+                    return allocate<DataTag::STR>(alloc, helpers::detail::take_str<str_type>(::std::move(s), alloc));
                 }
-                return;
-            }
-            if (i == 0) {
-                out_str.push_back(static_cast<T>("0"));
-                return;
+                default:
+                    throw errors::unknown_value_error.copy();
             }
-            TORREBIS_CONSTEXPR_IF (reserve) {
-                ::std::size_t reservation = out_str.size() + serialised_int_size<IntType>(i);
-                if (out_str.capacity() < reservation) {
-                    out_str.reserve(reservation);
-                }
+        }
+
+    public:
+        static constexpr ::std::size_t default_stream_buffer_size = 64 * 1024;
+
+        // Like `load(is)`, but reads `buffer_size` bytes at a time straight from `is.rdbuf()`.
+        // Bytes after the end of the value may be consumed from the stream, which is an error anyway.
+        template<class T = char, class Traits = ::std::char_traits<T>>
+        static basic_data load(::std::basic_istream<T, Traits>& is, const ::std::size_t buffer_size, const data_allocator_type& alloc = data_allocator_type()) {
+            static_assert(!helpers::detail::is_borrowed_str<str_type>::value, "Borrowed strings can only be loaded from a pointer");
+            const typename ::std::basic_istream<T, Traits>::sentry sentry(is, true);
+            if (!sentry || is.rdbuf() == nullptr) {
+                throw errors::bad_stream_error.copy();
             }
-            if (i < 0) {
-                i = -i;
-                out_str.push_back(static_cast<T>('-'));
+            helpers::detail::stream_window<T, Traits> window(is.rdbuf(), buffer_size);
+            auto parsed = buffered_stream_bdecode_loop<T, Traits>(window, nullptr, alloc);
+            if (!window.at_end()) {
+                throw errors::early_end_error.copy();
             }
-            do {
-                IntType mod = i % 10;
-                i /= 10;
-                out_str.push_back(static_cast<T>(static_cast<char>('0' + static_cast<int>(mod))));
-            } while (i != 0);
+            is.setstate(::std::ios_base::eofbit);
+            return parsed;
         }
 
+    };
+
+    using data = basic_data<>;
+
+    // Strings and keys borrow from the buffer that was loaded, which must outlive the data.
+    using data_view = basic_data<str_view>;
+
+    // Dicts are sorted vectors, which decode faster and use less memory, but are slower to insert into.
+    using flat_data = basic_data<::std::string, ::std::intmax_t, ::std::vector, true, flat_dict>;
+
+    // Everything is allocated with an `arena_allocator`, so is put in the arena of the current `arena::scope`.
+    using arena_data = basic_data<arena_string, ::std::intmax_t, arena_vector, true, arena_map, arena_allocator>;
+
+    // Strings are `shared_string`s, so keys decoded inside a `key_table::scope` share their characters.
+    using shared_string_data = basic_data<shared_string>;
+
+#ifdef TORREBIS_HAS_MEMORY_RESOURCE
+    namespace pmr {
+        template<typename ValueType, typename...>
+        using vector = ::std::pmr::vector<ValueType>;
+
+        template<typename KeyType, typename ValueType, typename...>
+        using map = ::std::pmr::map<KeyType, ValueType>;
+
+        // Everything is allocated from the `std::pmr::memory_resource` given to `load`, or the default resource.
+        using data = basic_data<::std::pmr::string, ::std::intmax_t, vector, true, map, ::std::pmr::polymorphic_allocator>;
+    }  // namespace torrebis::bencode::pmr
+#endif
+
+    namespace helpers { namespace detail {
+        template<class T>
+        struct is_basic_data_ : ::std::false_type {};
+
+        TORREBIS_BASIC_DATA_TEMPLATE
+        struct is_basic_data_<TORREBIS_BASIC_DATA_TEMPLATE_TYPE> : ::std::true_type {};
+
+        template<class T>
+        struct is_basic_data : is_basic_data_<typename remove_cv_ref<T>::type> {};
+    } }  // namespace torrebis::bencode::helpers::detail
+
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_DATA_CLASS_H_
+
+// Done expanding  #include "torrebis_bencode/data_class.h"
+
+// Expanding  #include "torrebis_bencode/visitors.h"
+#ifndef TORREBIS_BENCODE_VISITORS_H_
+#define TORREBIS_BENCODE_VISITORS_H_
+
+#include <vector>
+
+#include <torrebis_bencode/type_tags.h>
+#include <torrebis_bencode/data_class.h>
+
+namespace torrebis { namespace bencode {
+
+    template<typename BasicData = data>
+    class visitor {
     public:
-        ::std::size_t serialised_size() const {
-            switch (get_tag()) {
-                case DataTag::STR: {
-                    ::std::size_t str_size = get_str()->size();
-                    return serialised_int_size<::std::size_t>(str_size) + 1 + str_size;
-                }
-                case DataTag::INT:
-                    return 2 + serialised_int_size<int_type>(*get_int());
-                case DataTag::LIST: {
-                    ::std::size_t size = 2;
-                    for (const basic_data& i : *get_list()) {
-                        size += i.serialised_size();
-                    }
-                    return size;
-                }
-                case DataTag::DICT: {
-                    ::std::size_t size = 2;
-                    for (const auto& i : *get_dict()) {
-                        ::std::size_t key_size = i.first.size();
-                        size += serialised_int_size<::std::size_t>(key_size) + 1 + key_size + i.second.serialised_size();
-                    }
-                    return size;
-                }
-                default:
-                    return 0;
-            }
-        }
+        using data_t = const BasicData&;
+        using path_t = const ::std::vector<typename BasicData::path_el_type>&;
+        using str_type = const typename BasicData::const_str_ptr;
+        using int_type = const typename BasicData::const_int_ptr;
+        using list_type = const typename BasicData::const_list_ptr;
+        using dict_type = const typename BasicData::const_dict_ptr;
 
-        template<class T = char, class Traits = ::std::char_traits<T>>
-        ::std::basic_string<T, Traits> serialise() const {
-            ::std::basic_string<T, Traits> s;
-            s.reserve(serialised_size());
-            append_serialisation(s);
-            return s;
+        virtual void visit(const data_t dat) {
+            // Start the visit with an empty path.
+            typename ::std::remove_reference<path_t>::type path;
+            visit_any(dat, path);
+            return;
         }
-
-    private:
-        template<class T, class Traits>
-        void append_serialisation_loop(::std::basic_string<T, Traits>& s) const {
-            switch (get_tag()) {
-                case DataTag::STR: {
-                    const str_type& ss = *get_str();
-                    int_to_string<false, ::std::size_t, T, Traits>(ss.size(), s);
-                    s.push_back(static_cast<T>(':'));
-                    TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<str_type, ::std::basic_string<T, Traits>>::value) {
-                        s.append(ss);
-                    } else {
-                        for (const auto byte : ss) {
-                            s.push_back(static_cast<T>(static_cast<char>(ss)));
-                        }
-                    }
+    protected:
+        virtual void visit_any(data_t dat, const path_t path) {
+            switch (dat.get_tag()) {
+                case DataTag::STR:
+                    visit_str(dat.get_str(), path);
                     return;
-                }
                 case DataTag::INT:
-                    s.push_back(static_cast<T>('i'));
-                    int_to_string<false, int_type, T, Traits>(*get_int(), s);
-                    s.push_back(static_cast<T>('e'));
+                    visit_int(dat.get_int(), path);
                     return;
                 case DataTag::LIST:
-                    s.push_back(static_cast<T>('l'));
-                    for (const basic_data& i : *get_list()) {
-                        i.append_serialisation_loop<T, Traits>(s);
-                    }
-                    s.push_back(static_cast<T>('e'));
+                    visit_list(dat.get_list(), path);
                     return;
                 case DataTag::DICT:
-                    s.push_back(static_cast<T>('d'));
-                    for (const auto& i : *get_dict()) {
-                        const str_type& key = i.first;
-                        int_to_string<false, ::std::size_t, T, Traits>(key.size(), s);
-                        s.push_back(static_cast<T>(':'));
-                        TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<str_type, ::std::basic_string<T, Traits>>::value) {
-                            s.append(key);
-                        } else {
-                            for (const auto byte : key) {
-                                s.push_back(static_cast<T>(static_cast<char>(byte)));
-                            }
-                        }
-                        i.second.template append_serialisation_loop<T, Traits>(s);
-                    }
-                    s.push_back(static_cast<T>('e'));
+                    visit_dict(dat.get_dict(), path);
                     return;
                 default:
                     return;
             }
         }
 
-    public:
-        template<class T = char, class Traits = ::std::char_traits<T>>
-        void append_serialisation(::std::basic_string<T, Traits>& s) const {
-            const ::std::size_t reservation = s.size() + serialised_size();
-            if (reservation > s.capacity()) {
-                s.reserve(reservation);
+        virtual void visit_str(const str_type str, const path_t path) {
+            // Do nothing.
+            // Note: By default, visit_key uses this function to visit dictionary keys
+            // with the final element of `path` set as a key, with a value of the index of the key.
+        }
+
+
+        virtual void visit_int(const int_type i, const path_t path) {
+            // Do nothing.
+        }
+
+        virtual void visit_list(const list_type list, const path_t path) {
+            // Visit all members with visit_item one level deeper.
+            typename ::std::remove_const<typename ::std::remove_reference<path_t>::type>::type new_path(path);
+            ::std::size_t i = 0;
+            new_path.push_back(0);
+            for (const data_t& el : *list) {
+                new_path[new_path.size() - 1] = i++;
+                visit_item(el, new_path);
             }
-            append_serialisation_loop<T, Traits>(s);
         }
 
-        template<class T = char, class Traits = std::char_traits<T>>
-        void serialise(::std::basic_ostream<T, Traits>& os) const {
-            switch (get_tag()) {
-                case DataTag::STR: {
-                    const str_type& ss = *get_str();
-                    ::std::basic_string<T, Traits> size_str;
-                    int_to_string<true, ::std::size_t, T, Traits>(ss.size(), size_str);
-                    os.write(size_str.data(), size_str.size());
-                    os.put(static_cast<T>(':'));
-                    TORREBIS_CONSTEXPR_IF (helpers::detail::has_char_t<T, str_type>::value) {
-                        os.write(ss.data(), ss.size());
-                    } else {
-                        for (const auto byte : ss) {
-                            os.put(static_cast<T>(static_cast<char>(byte)));
-                        }
-                    }
-                    return;
-                }
-                case DataTag::INT: {
-                    os.put(static_cast<T>('i'));
-                    ::std::basic_string<T, Traits> int_str;
-                    int_to_string<true, int_type, T, Traits>(*get_int(), int_str);
-                    os.write(int_str.data(), int_str.size());
-                    os.put(static_cast<T>('e'));
-                    return;
-                }
-                case DataTag::LIST:
-                    os.put(static_cast<T>('l'));
-                    for (const basic_data& i : *get_list()) {
-                        i.serialise<T, Traits>(os);
-                    }
-                    os.put(static_cast<T>('e'));
-                    return;
-                case DataTag::DICT:
-                    os.put(static_cast<T>('d'));
-                    for (const ::std::pair<const str_type, const basic_data>& i : *get_dict()) {
-                        const str_type& key = i.first;
-                        ::std::basic_string<T, Traits> key_size_str;
-                        int_to_string<true, ::std::size_t, T, Traits>(key.size(), key_size_str);
-                        os.write(key_size_str.data(), key_size_str.size());
-                        os.put(static_cast<T>(':'));
-                        TORREBIS_CONSTEXPR_IF (helpers::detail::has_char_t<T, str_type>::value) {
-                            os.write(key.data(), key.size());
-                        } else {
-                            for (const auto byte : key) {
-                                os.put(static_cast<T>(static_cast<char>(byte)));
-                            }
-                        }
-                        i.second.template serialise<T, Traits>(os);
-                    }
-                    os.put(static_cast<T>('e'));
-                    return;
-                default:
-                    return;
+        virtual void visit_item(data_t item, const path_t path) {
+            // Just visit it with visit_any.
+            return visit_any(item, path);
+        }
+
+        virtual void visit_dict(const dict_type dict, const path_t path) {
+            // Visit:
+            //    keys with nullptr at the end of the path.
+            //    values with the key at the end of the path.
+            typename ::std::remove_const<typename ::std::remove_reference<path_t>::type>::type new_path(path);
+            ::std::size_t i = 0;
+            new_path.push_back(0);
+            for (const auto& el : *dict) {
+                data_t key = BasicData::make_str(el.first);
+                visit_key(key, new_path);
+                new_path[new_path.size() - 1] = key.get_str();
+                visit_value(el.second, new_path);
+                new_path[new_path.size() - 1] = ++i;
             }
         }
 
-        // Deserialisation of pointers / arrays
+        virtual void visit_key(data_t k, const path_t path) {
+            visit_any(k, path);
+            return;
+        }
+
+        virtual void visit_value(data_t value, const path_t path) {
+            // Just visit it with visit_any.
+            visit_any(value, path);
+            return;
+        }
+    };
+
+    /*
+     * Outputs some data to a stream.
+     */
+    template<typename BasicData = data>
+    class print_visitor : public visitor<BasicData> {
     private:
-        template<typename IntType, typename T>
-        static IntType pointer_read_int(const T* const begin, ::std::size_t& i, const ::std::size_t size, const char end, const char* const first) {
-            char first_char;
-            if (first == nullptr) {
-                if (i >= size) {
-                    throw errors::expecting_int_error.copy();
-                }
-                first_char = static_cast<char>(begin[i++]);
-            } else {
-                first_char = *first;
-            }
-            if (first_char == '0') {
-                if (i >= size || static_cast<char>(begin[i++]) != end) {
-                    throw errors::expecting_int_error.copy();
-                }
-                return IntType(0);
-            }
-            int sign = +1;
-            if (first_char == '-') {
-                sign = -1;
-                if (i >= size) {
-                    throw errors::expecting_int_error.copy();
-                }
-                first_char = static_cast<char>(begin[i++]);
-            }
-            if (!('1' <= first_char && first_char <= '9')) {
-                throw errors::expecting_int_error.copy();
-            }
-            IntType res = IntType(static_cast<int>(first_char - '0'));
-            while (true) {
-                if (i >= size) {
-                    throw errors::expecting_int_error.copy();
-                }
-                const char next_char = static_cast<char>(begin[i++]);
-                if (!('0' <= next_char && next_char <= '9')) {
-                    if (next_char == end) {
-                        break;
-                    }
-                    throw errors::expecting_int_error.copy();
-                }
-                IntType previous_res = res;
-                res = res * IntType(static_cast<int>(sign * 10)) + IntType(static_cast<int>(sign * static_cast<int>(next_char - '0')));
-                if ((previous_res < res) != (sign > 0)) {
-                    throw errors::integer_overflow_error.copy();
+        ::std::ostream& os_;
+        const char indent_char_;
+        const ::std::size_t indent_width_;
+    public:
+        using data_t = typename visitor<BasicData>::data_t;
+        using path_t = typename visitor<BasicData>::path_t;
+        using str_type = typename visitor<BasicData>::str_type;
+        using int_type = typename visitor<BasicData>::int_type;
+        using list_type = typename visitor<BasicData>::list_type;
+        using dict_type = typename visitor<BasicData>::dict_type;
+
+        explicit print_visitor(
+            std::ostream& os,
+            const char indent_char = ' ',
+            const ::std::size_t indent_width = 4) :
+            os_(os), indent_char_(indent_char), indent_width_(indent_width) {}
+    protected:
+        virtual void visit_str(const str_type str, const path_t path) {
+            os_ << ::std::string("\"");
+            for (const char c : *str) {
+                if (' ' <= c && c <= '~') {
+                    if (c == '\\' || c == '"') os_ << ::std::string("\\");
+                    char s[2] = { c, '\0' };
+                    os_ << ::std::string(s);
+                } else {
+                    os_ << ::std::string("\\x");
+                    ::std::uint8_t x = static_cast<::std::uint8_t>(c);
+                    char s[3] = { static_cast<char>('0' + (x >> 4)), static_cast<char>('0' + (x & 0xF)), '\0' };
+                    os_ << ::std::string(s);
                 }
             }
-            return res;
+            os_ << ::std::string("\"");
+        }
+
+        virtual void visit_int(const int_type i, const path_t path) {
+            os_ << *i;
+        }
+
+        virtual void visit_list(const list_type list, const path_t path) {
+            os_ << ::std::string("[");
+            visitor<BasicData>::visit_list(list, path);
+            os_ << ::std::string("\n") << ::std::string(indent_width_ * path.size(), indent_char_) << ::std::string("]");
+        }
+
+        virtual void visit_item(const data_t item, const path_t path) {
+            os_ << ((path[path.size() - 1] == 0) ? ::std::string("\n") : ::std::string(",\n"));
+            os_ << ::std::string(indent_width_ * path.size(), indent_char_);
+            visitor<BasicData>::visit_item(item, path);
+        }
+
+        virtual void visit_dict(const dict_type dict, const path_t path) {
+            os_ << ::std::string("{");
+            visitor<BasicData>::visit_dict(dict, path);
+            os_ << ::std::string("\n") << ::std::string(indent_width_ * path.size(), indent_char_) << ::std::string("}");
         }
 
-        static ::std::pair<const char*, ::std::size_t> pointer_read_str_fast(const char* const begin, ::std::size_t& i, const ::std::size_t size, const char* const first) {
-            ::std::size_t str_size = pointer_read_int<::std::size_t, char>(begin, i, size, ':', first);
-            const char* str_begin = begin + i;
-            i += str_size;
-            if (i > size) {
-                throw errors::cut_off_str_error.copy();
-            }
-            return  { str_begin, str_size };
+        virtual void visit_key(const data_t k, const path_t path) {
+            os_ << ((path[path.size() - 1] == 0) ? ::std::string("\n") : ::std::string(",\n"));
+            os_ << ::std::string(indent_width_ * path.size(), indent_char_);
+            visitor<BasicData>::visit_key(k, path);
+            os_ << ::std::string(": ");
         }
+    };
 
-        template<typename T>
-        static void pointer_read_str_slow(const T* const begin, ::std::size_t& i, const ::std::size_t size, const char* first, ::std::string& out_str) {
-            ::std::size_t str_size = pointer_read_int<::std::size_t, T>(begin, i, size, ':', first);
-            if (i + str_size > size) {
-                throw errors::cut_off_str_error.copy();
-            }
-            out_str.reserve(str_size);
-            for (; i < i + str_size; ++i) {
-                out_str.push_back(static_cast<char>(begin[i]));
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_VISITORS_H_
+
+// Done expanding  #include "torrebis_bencode/visitors.h"
+
+// Expanding  #include "torrebis_bencode/tape.h"
+#ifndef TORREBIS_BENCODE_TAPE_H_
+#define TORREBIS_BENCODE_TAPE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * A flat representation of some bencoded data. Every value is written to one contiguous tape of 64 bit words:
+     *
+     *     str:   [STR  | offset of the string in the buffer] [size]
+     *     int:   [INT]                                       [value]
+     *     list:  [LIST | index after the matching end] items...           [END | number of items]
+     *     dict:  [DICT | index after the matching end] key, value, ...    [END | number of keys]
+     *
+     * The tag is the top 8 bits of a word and the payload is the other 56. Strings borrow from the
+     * buffer that was parsed, which must outlive the tape.
+     */
+    class tape final {
+    public:
+        using word_type = ::std::uint64_t;
+        using int_type = ::std::int64_t;
+        using str_type = str_view;
+        using path_el_type = basic_path_el<str_type>;
+
+        class value;
+        class iterator;
+        class item_iterator;
+        struct item_range;
+    private:
+        enum : unsigned { tag_shift = 56 };
+        enum : ::std::uint8_t { end_tag = 4 };
+
+        const char* buffer_;
+        ::std::vector<word_type> words_;
+
+        tape(const char* const buffer) noexcept : buffer_(buffer) {}
+
+        static word_type make_word(const ::std::uint8_t tag, const word_type payload) noexcept {
+            return (static_cast<word_type>(tag) << tag_shift) | payload;
+        }
+        static word_type make_word(const DataTag tag, const word_type payload) noexcept {
+            return make_word(static_cast<::std::uint8_t>(tag), payload);
+        }
+        ::std::uint8_t tag_at(const ::std::size_t index) const noexcept {
+            return static_cast<::std::uint8_t>(words_[index] >> tag_shift);
+        }
+        word_type payload_at(const ::std::size_t index) const noexcept {
+            return words_[index] & ((word_type(1) << tag_shift) - 1);
+        }
+        // The index of the value after the one at `index`.
+        ::std::size_t skip(const ::std::size_t index) const noexcept {
+            switch (static_cast<DataTag>(tag_at(index))) {
+                case DataTag::LIST:
+                case DataTag::DICT:
+                    return payload_at(index);
+                default:
+                    return index + 2;
             }
         }
 
-        template<typename T>
-        static basic_data pointer_bdecode_loop(
-            const T* const begin, ::std::size_t& i, const ::std::size_t size
-        ) {
+        void push_str(const ::std::pair<const char*, ::std::size_t> begin_size) {
+            words_.push_back(make_word(DataTag::STR, static_cast<word_type>(begin_size.first - buffer_)));
+            words_.push_back(begin_size.second);
+        }
+
+        void parse_loop(::std::size_t& i, const ::std::size_t size) {
             if (i >= size) {
                 throw errors::expecting_value_error.copy();
             }
-            switch (static_cast<char>(begin[i])) {
+            switch (buffer_[i]) {
                 case 'i': {
                     // int "ixxxe"
                     ++i;
-                    return make_int(pointer_read_int<int_type, T>(begin, i, size, 'e', nullptr));
-                }
-                case 'l': {
-                    // list "lxxxe"
-                    ++i;
-                    list_type list;
-                    while (true) {
-                        if (i >= size) {
-                            throw errors::expecting_value_error.copy();
-                        }
-                        if (static_cast<char>(begin[i]) == 'e') {
-                            break;
-                        }
-                        list.push_back(pointer_bdecode_loop<T>(begin, i, size));
-                    }
-                    ++i;
-                    return make_list(list);
+                    const int_type int_value = helpers::detail::pointer_read_int<int_type, char>(buffer_, i, size, 'e', nullptr);
+                    words_.push_back(make_word(DataTag::INT, 0));
+                    words_.push_back(static_cast<word_type>(int_value));
+                    return;
                 }
+                case 'l':
                 case 'd': {
-                    // dict "dxxxe"
+                    // list "lxxxe" or dict "dxxxe"
+                    const DataTag tag = buffer_[i] == 'l' ? DataTag::LIST : DataTag::DICT;
                     ++i;
-                    dict_type dict;
+                    const ::std::size_t start = words_.size();
+                    words_.push_back(make_word(tag, 0));
+                    word_type count = 0;
                     const char* last_key_begin = nullptr;
-                    ::std::size_t last_key_size;
+                    ::std::size_t last_key_size = 0;
                     while (true) {
                         if (i >= size) {
                             throw errors::expecting_value_error.copy();
                         }
-                        if (static_cast<char>(begin[i]) == 'e') {
+                        if (buffer_[i] == 'e') {
                             break;
                         }
-                        const char* key_begin;
-                        ::std::size_t key_size;
-                        TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<T, char>::value) {
-                            auto begin_size = pointer_read_str_fast(begin, i, size, nullptr);
-                            key_begin = begin_size.first;
-                            key_size = begin_size.second;
-                            if (last_key_begin != nullptr) {
-                                // TODO
-                                if (!helpers::detail::key_less_than(last_key_begin, last_key_size, key_begin, key_size)) {
-                                    throw errors::key_order_error.copy();
-                                }
-                            }
-                            last_key_begin = key_begin;
-                            last_key_size = key_size;
-                            str_type key(key_begin, key_size);
-                            dict[key] = pointer_bdecode_loop<T>(begin, i, size);
-                        } else {
-                            ::std::string key;
-                            pointer_read_str_slow<T>(begin, i, size, nullptr, key);
-                            key_begin = key.data();
-                            key_size = key.size();
+                        if (tag == DataTag::DICT) {
+                            auto key = helpers::detail::pointer_read_str_fast(buffer_, i, size, nullptr);
                             if (last_key_begin != nullptr) {
-                                if (!helpers::detail::key_less_than(last_key_begin, last_key_size, key_begin, key_size)) {
+                                if (!helpers::detail::key_less_than(last_key_begin, last_key_size, key.first, key.second)) {
                                     throw errors::key_order_error.copy();
                                 }
                             }
-                            last_key_begin = key_begin;
-                            last_key_size = key_size;
-                            TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<str_type, ::std::string>::value) {
-                                dict[key] = pointer_bdecode_loop<T>(begin, i, size);
-                            } else {
-                                str_type real_key(key_begin, key_size);
-                                dict[real_key] = pointer_bdecode_loop<T>(begin, i, size);
-                            }
+                            last_key_begin = key.first;
+                            last_key_size = key.second;
+                            push_str(key);
                         }
+                        parse_loop(i, size);
+                        ++count;
                     }
                     ++i;
-                    return make_dict(dict);
+                    words_.push_back(make_word(end_tag, count));
+                    words_[start] = make_word(tag, words_.size());
+                    return;
                 }
-                case '1': case '2': case '3':
-                case '4': case '5': case '6':
-                case '7': case '8': case '9': {
+                case '0': case '1': case '2': case '3': case '4':
+                case '5': case '6': case '7': case '8': case '9':
                     // str "yy:xxxx"
-                    TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<T, char>::value) {
-                        auto begin_size = pointer_read_str_fast(begin, i, size, &begin[i++]);
-                        const char* str_begin = begin_size.first;
-                        ::std::size_t str_size = begin_size.second;
-                        return make_str(str_type(str_begin, str_size));
-                    }
-                    ::std::string s;
-                    pointer_read_str_slow<T>(begin, i, size, &begin[i++], s);
-                    TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<str_type, ::std::string>::value) {
-                        return make_str(s);
-                    }
-                    return make_str(str_type(s.data(), s.size()));
-                }
+                    push_str(helpers::detail::pointer_read_str_fast(buffer_, i, size, nullptr));
+                    return;
                 default:
                     throw errors::unknown_value_error.copy();
             }
         }
 
     public:
-        template<typename T>
-        static basic_data load(const T* const begin, const ::std::size_t size) {
-            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+        tape(const tape& other) = default;
+        tape(tape&& other) noexcept : buffer_(other.buffer_), words_(::std::move(other.words_)) {}
+        tape& operator=(const tape& other) = default;
+        tape& operator=(tape&& other) noexcept { buffer_ = other.buffer_; words_ = ::std::move(other.words_); return *this; }
+
+        static tape parse(const char* const begin, const ::std::size_t size) {
+            tape result(begin);
+            // Every value takes 2 words for at least 2 bytes ("0:", "le"), so a tape never needs more than `size`
+            // words. Reserving an eighth of that is enough for buffers dominated by long strings, and with the
+            // vector's doubling costs at most 3 more allocations for ones made only of short values.
+            result.words_.reserve(size / sizeof(word_type) + 2);
             ::std::size_t i = 0;
-            auto parsed = pointer_bdecode_loop(begin, i, size);
+            result.parse_loop(i, size);
             if (i != size) {
                 throw errors::early_end_error.copy();
             }
-            return parsed;
+            return result;
         }
 
         template<typename T>
-        static basic_data load(const T* const begin, const T* const end) {
-            return load<T>(begin, static_cast<::std::size_t>(end - begin));
+        static tape parse(const T* const begin, const ::std::size_t size) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            return parse(reinterpret_cast<const char*>(begin), size);
         }
 
         template<typename T, typename... Rest>
-        static basic_data load(const ::std::basic_string<T, Rest...>& s) {
-            return load<T>(s.data(), s.size());
+        static tape parse(const ::std::basic_string<T, Rest...>& s) {
+            return parse<T>(s.data(), s.size());
         }
 
         template<typename T, typename... Rest>
-        static basic_data load(const ::std::vector<T, Rest...>& v) {
-            return load<T>(v.data(), v.size());
-        }
+        static tape parse(const ::std::basic_string<T, Rest...>&& s) = delete;
 
-#ifdef TORREBIS_STD_ARRAY_HAS_DATA
-        template<typename T, ::std::size_t N = 0>
-        static basic_data load(const ::std::array<T, N>& a) {
-            return load<T>(a.data(), a.size());
+        template<typename T, typename... Rest>
+        static tape parse(const ::std::vector<T, Rest...>& v) {
+            return parse<T>(v.data(), v.size());
         }
-#endif
-        // Deserialisation of iterators
-    private:
 
-        template<typename IntType, typename Iterator>
-        static IntType array_read_int(Iterator& it, const Iterator& end, const char end_char, const char* const first) {
-            char first_char;
-            if (first == nullptr) {
-                if (it == end) {
-                    throw errors::expecting_int_error.copy();
-                }
-                first_char = static_cast<char>(*it);
-                ++it;
-            } else {
-                first_char = *first;
+        template<typename T, typename... Rest>
+        static tape parse(const ::std::vector<T, Rest...>&& v) = delete;
+
+        const char* buffer() const noexcept { return buffer_; }
+        const ::std::vector<word_type>& words() const noexcept { return words_; }
+
+        value root() const noexcept;
+
+        /*
+         * A reference to a single value on a tape. Cheap to copy; only valid while the tape is.
+         */
+        class value final {
+        private:
+            friend class tape;
+            friend class iterator;
+            friend class item_iterator;
+
+            const tape* tape_;
+            ::std::size_t index_;
+
+            value(const tape* const t, const ::std::size_t index) noexcept : tape_(t), index_(index) {}
+
+            // The index of the matching END word of a list or dict.
+            ::std::size_t end_index() const noexcept { return tape_->skip(index_) - 1; }
+        public:
+            value() noexcept : tape_(nullptr), index_(0) {}
+
+            bool operator==(const value& other) const noexcept { return tape_ == other.tape_ && index_ == other.index_; }
+            bool operator!=(const value& other) const noexcept { return !operator==(other); }
+            explicit operator bool() const noexcept { return tape_ != nullptr; }
+            bool operator!() const noexcept { return tape_ == nullptr; }
+
+            DataTag get_tag() const noexcept {
+                return tape_ == nullptr ? DataTag::UNINITIALISED : static_cast<DataTag>(tape_->tag_at(index_));
             }
-            if (first_char == '0') {
-                if (it == end || static_cast<char>(*it) != end_char) {
-                    throw errors::expecting_int_error.copy();
+
+            bool is_valid() const noexcept { return tape_ != nullptr; }
+            bool is_str() const noexcept { return get_tag() == DataTag::STR; }
+            bool is_int() const noexcept { return get_tag() == DataTag::INT; }
+            bool is_list() const noexcept { return get_tag() == DataTag::LIST; }
+            bool is_dict() const noexcept { return get_tag() == DataTag::DICT; }
+
+            // Where this value is on the tape.
+            ::std::size_t index() const noexcept { return index_; }
+
+            // The value of an int, or 0 if this is not an int.
+            int_type get_int() const noexcept {
+                return is_int() ? static_cast<int_type>(tape_->words_[index_ + 1]) : 0;
+            }
+
+            // The value of a str, or an empty view if this is not a str.
+            str_type get_str() const noexcept {
+                if (!is_str()) {
+                    return str_type();
                 }
-                ++it;
-                return IntType(0);
+                return str_type(
+                    tape_->buffer_ + tape_->payload_at(index_),
+                    tape_->words_[index_ + 1]
+                );
             }
-            int sign = +1;
-            if (first_char == '-') {
-                sign = -1;
-                if (it == end) {
-                    throw errors::expecting_int_error.copy();
+
+            // The number of items in a list or keys in a dict, otherwise 0.
+            ::std::size_t size() const noexcept {
+                if (!is_list() && !is_dict()) {
+                    return 0;
                 }
-                first_char = static_cast<char>(*it);
-                ++it;
+                return tape_->payload_at(end_index());
             }
-            if (!('1' <= first_char && first_char <= '9')) {
-                throw errors::expecting_int_error.copy();
+
+            // Iterate over the items of a list.
+            iterator begin() const noexcept;
+            iterator end() const noexcept;
+
+            // Iterate over the (key, value) pairs of a dict.
+            item_range items() const noexcept;
+
+            // The item at index `i` of a list, or an invalid value if out of range or not a list.
+            value operator[](::std::size_t i) const noexcept {
+                if (!is_list()) {
+                    return value();
+                }
+                const ::std::size_t end = end_index();
+                ::std::size_t index = index_ + 1;
+                for (; i > 0 && index < end; --i) {
+                    index = tape_->skip(index);
+                }
+                return index < end ? value(tape_, index) : value();
             }
-            IntType res = IntType(static_cast<int>(first_char - '0'));
-            while (true) {
-                if (it == end) {
-                    throw errors::expecting_int_error.copy();
+
+            // The value for `key` in a dict, or an invalid value if missing or not a dict.
+            value find(const str_type key) const noexcept {
+                if (!is_dict()) {
+                    return value();
                 }
-                const char next_char = static_cast<char>(*it);
-                ++it;
-                if (!('0' <= next_char && next_char <= '9')) {
-                    if (next_char == end_char) {
+                const ::std::size_t end = end_index();
+                ::std::size_t index = index_ + 1;
+                while (index < end) {
+                    const str_type k = value(tape_, index).get_str();
+                    if (k == key) {
+                        return value(tape_, index + 2);
+                    }
+                    if (key < k) {
+                        // Keys are sorted, so it can't be further on.
                         break;
                     }
-                    throw errors::expecting_int_error.copy();
+                    index = tape_->skip(index + 2);
                 }
-                IntType previous_res = res;
-                res = res * IntType(static_cast<int>(sign * 10)) + IntType(static_cast<int>(sign * static_cast<int>(next_char - '0')));
-                if ((previous_res < res) != (sign > 0)) {
-                    throw errors::integer_overflow_error.copy();
+                return value();
+            }
+
+            value get_path() const noexcept { return *this; }
+
+            template<class... PathEls, class = typename ::std::enable_if<helpers::detail::all_convertible<path_el_type, PathEls...>::value>::type>
+            value get_path(PathEls... path) const {
+                value result = *this;
+                const path_el_type path_arr[sizeof...(path)] = { path_el_type(path)... };
+                for (::std::size_t i = 0; i < sizeof...(path) && result; ++i) {
+                    const path_el_type& path_i = path_arr[i];
+                    if (path_i.is_key()) {
+                        result = result.find(*path_i.get_key());
+                    } else if (path_i.is_index()) {
+                        result = result[path_i.get_index()];
+                    } else {
+                        return value();
+                    }
                 }
+                return result;
             }
-            return res;
+        };
+
+        class iterator final {
+        private:
+            friend class value;
+            value current_;
+
+            iterator(const tape* const t, const ::std::size_t index) noexcept : current_(t, index) {}
+        public:
+            using iterator_category = ::std::forward_iterator_tag;
+            using value_type = tape::value;
+            using difference_type = ::std::ptrdiff_t;
+            using pointer = const value*;
+            using reference = const value&;
+
+            iterator() noexcept = default;
+
+            reference operator*() const noexcept { return current_; }
+            pointer operator->() const noexcept { return &current_; }
+            iterator& operator++() noexcept { current_.index_ = current_.tape_->skip(current_.index_); return *this; }
+            iterator operator++(int) noexcept { iterator old = *this; ++*this; return old; }
+            bool operator==(const iterator& other) const noexcept { return current_ == other.current_; }
+            bool operator!=(const iterator& other) const noexcept { return current_ != other.current_; }
+        };
+
+        class item_iterator final {
+        private:
+            friend class value;
+            ::std::pair<str_type, value> current_;
+
+            item_iterator(const tape* const t, const ::std::size_t index) noexcept : current_(str_type(), value(t, index)) {
+                load();
+            }
+            void load() noexcept {
+                // `current_.second` holds the key's index until it is loaded.
+                const value key = current_.second;
+                if (static_cast<DataTag>(key.tape_->tag_at(key.index_)) == DataTag::STR) {
+                    current_.first = key.get_str();
+                    current_.second.index_ = key.index_ + 2;
+                }
+            }
+        public:
+            using iterator_category = ::std::forward_iterator_tag;
+            using value_type = ::std::pair<str_type, value>;
+            using difference_type = ::std::ptrdiff_t;
+            using pointer = const value_type*;
+            using reference = const value_type&;
+
+            item_iterator() noexcept = default;
+
+            reference operator*() const noexcept { return current_; }
+            pointer operator->() const noexcept { return &current_; }
+            item_iterator& operator++() noexcept {
+                current_.second.index_ = current_.second.tape_->skip(current_.second.index_);
+                load();
+                return *this;
+            }
+            item_iterator operator++(int) noexcept { item_iterator old = *this; ++*this; return old; }
+            bool operator==(const item_iterator& other) const noexcept { return current_.second == other.current_.second; }
+            bool operator!=(const item_iterator& other) const noexcept { return current_.second != other.current_.second; }
+        };
+
+        struct item_range {
+            item_iterator begin_;
+            item_iterator end_;
+
+            item_iterator begin() const noexcept { return begin_; }
+            item_iterator end() const noexcept { return end_; }
+        };
+    };
+
+    inline tape::value tape::root() const noexcept { return words_.empty() ? value() : value(this, 0); }
+
+    inline tape::iterator tape::value::begin() const noexcept {
+        return is_list() ? iterator(tape_, index_ + 1) : iterator();
+    }
+
+    inline tape::iterator tape::value::end() const noexcept {
+        return is_list() ? iterator(tape_, end_index()) : iterator();
+    }
+
+    inline tape::item_range tape::value::items() const noexcept {
+        if (!is_dict()) {
+            return { item_iterator(), item_iterator() };
+        }
+        return { item_iterator(tape_, index_ + 1), item_iterator(tape_, end_index()) };
+    }
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_TAPE_H_
+
+// Done expanding  #include "torrebis_bencode/tape.h"
+
+// Expanding  #include "torrebis_bencode/push_decoder.h"
+#ifndef TORREBIS_BENCODE_PUSH_DECODER_H_
+#define TORREBIS_BENCODE_PUSH_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * Decodes a single bencoded value that arrives in fragments. Each call to `feed` carries on where the last one
+     * stopped (even in the middle of an integer or string), so no byte is looked at twice.
+     */
+    template<typename BasicData = data>
+    class basic_push_decoder final {
+    public:
+        using data_t = BasicData;
+        using int_type = typename BasicData::int_type;
+        using str_type = typename BasicData::str_type;
+        using list_type = typename BasicData::list_type;
+        using dict_type = typename BasicData::dict_type;
+        using data_allocator_type = typename BasicData::data_allocator_type;
+
+        static_assert(!helpers::detail::is_borrowed_str<str_type>::value, "Borrowed strings can only be loaded from a pointer");
+
+        enum class status : ::std::int8_t {
+            NEED_MORE = 0,  // Everything fed so far was consumed, and the value is not finished.
+            DONE = 1,  // The value is finished. `consumed` bytes of the last feed were part of it.
+            ERROR = -1  // The data is not valid bencode. See `error()`.
+        };
+
+        struct feed_result {
+            status state;
+            ::std::size_t consumed;
+        };
+    private:
+        enum class token : ::std::int8_t {
+            NONE,  // Between values
+            INT,  // In "ixxxe"
+            STR_SIZE,  // In the "yy:" of "yy:xxxx"
+            STR  // In the "xxxx" of "yy:xxxx"
+        };
+
+        enum class digits : ::std::int8_t {
+            NONE,
+            SIGN,  // Only a '-'
+            ZERO,  // Only a '0', which can't be followed by any more digits
+            SOME
+        };
+
+        struct frame {
+            BasicData container;
+            bool has_key;
+            ::std::string key;  // The last key read. The pending key if `has_key`.
+            bool has_last_key;
+        };
+
+        status state_;
+        const char* error_;
+        token token_;
+        digits digits_;
+        int sign_;
+        int_type int_value_;
+        ::std::size_t str_size_;
+        ::std::string str_;
+        ::std::vector<frame> stack_;
+        BasicData result_;
+        data_allocator_type alloc_;
+
+        feed_result fail(const decoding_error& error, const ::std::size_t consumed) noexcept {
+            state_ = status::ERROR;
+            error_ = error.what();
+            return { state_, consumed };
+        }
+
+        bool expecting_key() const noexcept {
+            return !stack_.empty() && stack_.back().container.is_dict() && !stack_.back().has_key;
+        }
+
+        // Called when a whole value has been read.
+        void finish(BasicData value) {
+            if (stack_.empty()) {
+                result_ = ::std::move(value);
+                state_ = status::DONE;
+                return;
+            }
+            frame& top = stack_.back();
+            if (top.container.is_list()) {
+                top.container.get_list()->push_back(::std::move(value));
+            } else {
+                auto& dict = *top.container.get_dict();
+                dict.emplace_hint(
+                    dict.end(),
+                    helpers::detail::take_key<str_type>(top.key, alloc_),
+                    ::std::move(value)
+                );
+                top.has_key = false;
+            }
+        }
+
+        // Called when a whole string has been read into `str_`.
+        const decoding_error* finish_str() {
+            if (expecting_key()) {
+                frame& top = stack_.back();
+                if (top.has_last_key && !helpers::detail::key_less_than(top.key.data(), top.key.size(), str_.data(), str_.size())) {
+                    return &errors::key_order_error;
+                }
+                top.key.swap(str_);
+                top.has_key = true;
+                top.has_last_key = true;
+                str_.clear();
+                return nullptr;
+            }
+            finish(BasicData::template allocate<DataTag::STR>(
+                alloc_, helpers::detail::construct_with_allocator<str_type>(alloc_, str_.data(), str_.size())
+            ));
+            str_.clear();
+            return nullptr;
+        }
+
+        // Adds a digit to `value`. Returns false on overflow.
+        template<typename IntType>
+        bool push_digit(IntType& value, const char c) const noexcept {
+            const IntType previous_value = value;
+            value = value * IntType(10) + IntType(static_cast<int>(sign_ * static_cast<int>(c - '0')));
+            return sign_ > 0 ? !(value < previous_value) : !(previous_value < value);
+        }
+
+        // Reads one character of an integer or string size. Returns an error, or nullptr.
+        template<typename IntType>
+        const decoding_error* read_digit(IntType& value, const char c) const noexcept {
+            if (!('0' <= c && c <= '9')) {
+                return &errors::expecting_int_error;
+            }
+            switch (digits_) {
+                case digits::ZERO:
+                    return &errors::expecting_int_error;
+                case digits::SIGN:
+                    if (c == '0') {
+                        return &errors::expecting_int_error;
+                    }
+                    break;
+                default:
+                    break;
+            }
+            if (!push_digit(value, c)) {
+                return &errors::integer_overflow_error;
+            }
+            return nullptr;
         }
 
-        template<typename Iterator>
-        static void array_read_str(Iterator& it, const Iterator& end, const char* first, ::std::string& out_str) {
-            ::std::size_t str_size = array_read_int<::std::size_t, Iterator>(it, end, ':', first);
-            out_str.reserve(str_size);
-            for (; str_size-- > 0;) {
-                if (it == end) {
-                    throw errors::cut_off_str_error.copy();
-                }
-                out_str.push_back(static_cast<char>(*it));
-                ++it;
-            }
+    public:
+        basic_push_decoder() : alloc_() { reset(); }
+        // Everything decoded is allocated with `alloc`.
+        explicit basic_push_decoder(const data_allocator_type& alloc) : alloc_(alloc) { reset(); }
+
+        // Forget everything fed so far and start decoding a new value.
+        void reset() {
+            state_ = status::NEED_MORE;
+            error_ = nullptr;
+            token_ = token::NONE;
+            digits_ = digits::NONE;
+            sign_ = +1;
+            int_value_ = int_type(0);
+            str_size_ = 0;
+            str_.clear();
+            stack_.clear();
+            result_.reset();
         }
 
-        template<typename Iterator>
-        static basic_data array_bdecode_loop(Iterator& it, const Iterator& end) {
-            if (it == end) {
-                throw errors::expecting_value_error.copy();
+        status state() const noexcept { return state_; }
+        bool done() const noexcept { return state_ == status::DONE; }
+
+        // The description of what was wrong with the data if `state()` is `status::ERROR`, otherwise nullptr.
+        const char* error() const noexcept { return error_; }
+
+        // The decoded value once `state()` is `status::DONE`, otherwise an uninitialised value.
+        const BasicData& result() const noexcept { return result_; }
+
+        feed_result feed(const char* const begin, const ::std::size_t size) {
+            if (state_ != status::NEED_MORE) {
+                return { state_, 0 };
             }
-            switch (static_cast<char>(*it)) {
-                case 'i':
-                    // int "ixxxe"
-                    ++it;
-                    return make_int(array_read_int<int_type, Iterator>(it, end, 'e', nullptr));
-                case 'l': {
-                    // list "lxxxe"
-                    ++it;
-                    list_type list;
-                    while (true) {
-                        if (it == end) {
-                            throw errors::expecting_value_error.copy();
+            ::std::size_t i = 0;
+            while (i < size) {
+                switch (token_) {
+                    case token::NONE: {
+                        const char c = begin[i];
+                        if ('0' <= c && c <= '9') {
+                            token_ = token::STR_SIZE;
+                            digits_ = digits::NONE;
+                            sign_ = +1;
+                            str_size_ = 0;
+                            continue;
                         }
-                        if (static_cast<char>(*it) == 'e') {
-                            break;
+                        if (c == 'e' && !stack_.empty()) {
+                            ++i;
+                            if (stack_.back().has_key) {
+                                return fail(errors::expecting_value_error, i);
+                            }
+                            BasicData container = ::std::move(stack_.back().container);
+                            stack_.pop_back();
+                            finish(::std::move(container));
+                            if (state_ == status::DONE) {
+                                return { state_, i };
+                            }
+                            continue;
                         }
-                        list.push_back(array_bdecode_loop<Iterator>(it, end));
-                    }
-                    ++it;
-                    return make_list(list);
-                }
-                case 'd': {
-                    // dict "dxxxe"
-                    ++it;
-                    dict_type dict;
-                    const char* last_key_begin = nullptr;
-                    ::std::size_t last_key_size;
-                    while (true) {
-                        if (it == end) {
-                            throw errors::expecting_value_error.copy();
+                        if (expecting_key()) {
+                            return fail(errors::expecting_value_error, i);
                         }
-                        if (static_cast<char>(*it) == 'e') {
-                            break;
+                        switch (c) {
+                            case 'i':
+                                // int "ixxxe"
+                                token_ = token::INT;
+                                digits_ = digits::NONE;
+                                sign_ = +1;
+                                int_value_ = int_type(0);
+                                break;
+                            case 'l':
+                                // list "lxxxe"
+                                stack_.push_back({
+                                    BasicData::template allocate<DataTag::LIST>(alloc_, helpers::detail::construct_with_allocator<list_type>(alloc_)),
+                                    false, ::std::string(), false
+                                });
+                                break;
+                            case 'd':
+                                // dict "dxxxe"
+                                stack_.push_back({
+                                    BasicData::template allocate<DataTag::DICT>(alloc_, helpers::detail::construct_with_allocator<dict_type>(alloc_)),
+                                    false, ::std::string(), false
+                                });
+                                break;
+                            default:
+                                return fail(errors::unknown_value_error, i);
                         }
-                        const char* key_begin;
-                        ::std::size_t key_size;
-                        ::std::string key;
-                        array_read_str<Iterator>(it, end, nullptr, key);
-                        key_begin = key.data();
-                        key_size = key.size();
-                        if (last_key_begin != nullptr) {
-                            if (!helpers::detail::key_less_than(last_key_begin, last_key_size, key_begin, key_size)) {
-                                throw errors::key_order_error.copy();
+                        ++i;
+                        continue;
+                    }
+                    case token::INT: {
+                        const char c = begin[i++];
+                        if (c == 'e' && (digits_ == digits::ZERO || digits_ == digits::SOME)) {
+                            token_ = token::NONE;
+                            finish(BasicData::template allocate<DataTag::INT>(alloc_, int_value_));
+                            if (state_ == status::DONE) {
+                                return { state_, i };
                             }
+                            continue;
                         }
-                        last_key_begin = key_begin;
-                        last_key_size = key_size;
-                        TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<str_type, ::std::string>::value) {
-                            dict[key] = array_bdecode_loop<Iterator>(it, end);
+                        if (c == '-' && digits_ == digits::NONE) {
+                            digits_ = digits::SIGN;
+                            sign_ = -1;
+                            continue;
+                        }
+                        const decoding_error* const error = read_digit(int_value_, c);
+                        if (error != nullptr) {
+                            return fail(*error, i);
+                        }
+                        digits_ = (c == '0' && digits_ == digits::NONE) ? digits::ZERO : digits::SOME;
+                        continue;
+                    }
+                    case token::STR_SIZE: {
+                        const char c = begin[i++];
+                        if (c == ':' && (digits_ == digits::ZERO || digits_ == digits::SOME)) {
+                            token_ = token::STR;
+                            str_.clear();
+                            // The size came from the peer, so only reserve what has arrived. `append` grows the rest.
+                            str_.reserve(str_size_ < size - i ? str_size_ : size - i);
+                            if (str_size_ != 0) {
+                                continue;
+                            }
                         } else {
-                            str_type real_key(key_begin, key_size);
-                            dict[real_key] = array_bdecode_loop<Iterator>(it, end);
+                            const decoding_error* const error = read_digit(str_size_, c);
+                            if (error != nullptr) {
+                                return fail(*error, i);
+                            }
+                            digits_ = (c == '0' && digits_ == digits::NONE) ? digits::ZERO : digits::SOME;
+                            continue;
                         }
+                        // An empty string is already finished
                     }
-                    ++it;
-                    return make_dict(dict);
-                }
-                case '1': case '2': case '3':
-                case '4': case '5': case '6':
-                case '7': case '8': case '9': {
-                    // str "yy:xxxx"
-                    ::std::string s;
-                    array_read_str<Iterator>(it, end, nullptr, s);
-                    TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<str_type, ::std::string>::value) {
-                        return make_str(s);
+                    // fall through
+                    case token::STR: {
+                        const ::std::size_t remaining = str_size_ - str_.size();
+                        const ::std::size_t available = size - i < remaining ? size - i : remaining;
+                        str_.append(begin + i, available);
+                        i += available;
+                        if (str_.size() == str_size_) {
+                            token_ = token::NONE;
+                            const decoding_error* const error = finish_str();
+                            if (error != nullptr) {
+                                return fail(*error, i);
+                            }
+                            if (state_ == status::DONE) {
+                                return { state_, i };
+                            }
+                        }
+                        continue;
                     }
-                    return make_str(str_type(s.data(), s.size()));
                 }
-                default:
-                    throw errors::unknown_value_error.copy();
             }
+            return { state_, i };
         }
 
-    public:
+        template<typename T>
+        feed_result feed(const T* const begin, const ::std::size_t size) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            return feed(reinterpret_cast<const char*>(begin), size);
+        }
 
-        template<typename Iterator>
-        static basic_data load(Iterator it, const Iterator& end) {
-            auto parsed = array_bdecode_loop<Iterator>(it, end);
-            if (it != end) {
-                throw errors::early_end_error.copy();
-            }
-            return parsed;
+        template<typename T, typename... Rest>
+        feed_result feed(const ::std::basic_string<T, Rest...>& s) {
+            return feed<T>(s.data(), s.size());
         }
+    };
+
+    using push_decoder = basic_push_decoder<>;
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_PUSH_DECODER_H_
+
+// Done expanding  #include "torrebis_bencode/push_decoder.h"
+
+// Expanding  #include "torrebis_bencode/cursor.h"
+#ifndef TORREBIS_BENCODE_CURSOR_H_
+#define TORREBIS_BENCODE_CURSOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
 
-        // Deserialisation of istreams
 
+namespace torrebis { namespace bencode {
+    /*
+     * A pull parser over a buffer of bencoded data. Tokens are read one at a time, and whole values can be skipped
+     * without being decoded. Strings borrow from the buffer, which must outlive the cursor.
+     *
+     * Only as much of the data as is read is checked. The cursor knows how deep it is, but not whether it is reading
+     * a key or a value, so key order and keys being strings are not checked.
+     */
+    template<typename IntType = ::std::intmax_t>
+    class basic_cursor final {
+    public:
+        using int_type = IntType;
+        using str_type = str_view;
+
+        enum class token : ::std::int8_t {
+            STR = 0,
+            INT = 1,
+            BEGIN_LIST = 2,
+            BEGIN_DICT = 3,
+            END = 4,  // The end of a list or dict
+            NONE = -1  // The end of the buffer
+        };
     private:
+        const char* begin_;
+        ::std::size_t size_;
+        ::std::size_t pos_;
+        ::std::size_t depth_;
+        int_type int_;
+        str_type str_;
 
-        template<typename IntType, class T, class Traits>
-        static IntType stream_read_int(::std::basic_istream<T, Traits>& is, const char end_char, const char* const first) {
-            T first_byte;
-            if (first == nullptr) {
-                if (!is.read(&first_byte, 1)) {
-                    throw errors::expecting_int_error.copy();
-                }
-            } else {
-                first_byte = static_cast<T>(*first);
+    public:
+        basic_cursor() noexcept : begin_(nullptr), size_(0), pos_(0), depth_(0), int_(0), str_() {}
+        basic_cursor(const char* const begin, const ::std::size_t size) noexcept :
+            begin_(begin), size_(size), pos_(0), depth_(0), int_(0), str_() {}
+
+        template<typename T>
+        basic_cursor(const T* const begin, const ::std::size_t size) noexcept :
+            basic_cursor(reinterpret_cast<const char*>(begin), size) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+        }
+
+        template<typename T, typename... Rest>
+        explicit basic_cursor(const ::std::basic_string<T, Rest...>& s) noexcept : basic_cursor(s.data(), s.size()) {}
+
+        template<typename T, typename... Rest>
+        explicit basic_cursor(const ::std::basic_string<T, Rest...>&& s) = delete;
+
+        template<typename T, typename... Rest>
+        explicit basic_cursor(const ::std::vector<T, Rest...>& v) noexcept : basic_cursor(v.data(), v.size()) {}
+
+        template<typename T, typename... Rest>
+        explicit basic_cursor(const ::std::vector<T, Rest...>&& v) = delete;
+
+        // How far into the buffer the cursor is.
+        ::std::size_t position() const noexcept { return pos_; }
+        // How many lists and dicts the cursor is inside of.
+        ::std::size_t depth() const noexcept { return depth_; }
+        bool at_end() const noexcept { return pos_ >= size_; }
+
+        // What the next token is, without reading it.
+        token peek() const noexcept {
+            if (pos_ >= size_) {
+                return token::NONE;
             }
-            if (first_byte == static_cast<T>('0')) {
-                if (!is.read(&first_byte, 1) || static_cast<char>(first_byte) != end_char) {
-                    throw errors::expecting_int_error.copy();
-                }
-                return IntType(0);
+            switch (begin_[pos_]) {
+                case 'i': return token::INT;
+                case 'l': return token::BEGIN_LIST;
+                case 'd': return token::BEGIN_DICT;
+                case 'e': return token::END;
+                default: return token::STR;
             }
-            int sign = +1;
-            if (first_byte == static_cast<T>('-')) {
-                sign = -1;
-                if (!is.read(&first_byte, 1)) {
-                    throw errors::expecting_int_error.copy();
+        }
+
+        // The type of the next value, or `DataTag::UNINITIALISED` at the end of a list, dict or the buffer.
+        DataTag peek_tag() const noexcept {
+            const token t = peek();
+            if (t == token::END || t == token::NONE) {
+                return DataTag::UNINITIALISED;
+            }
+            return static_cast<DataTag>(static_cast<::std::int8_t>(t));
+        }
+
+        /*
+         * Reads the next token. After `token::INT` or `token::STR` the value is available from `int_value()` or
+         * `str_value()`. Throws a `decoding_error` if the token is invalid.
+         */
+        token next_token() {
+            const token t = peek();
+            switch (t) {
+                case token::NONE:
+                    if (depth_ != 0) {
+                        throw errors::expecting_value_error.copy();
+                    }
+                    break;
+                case token::INT:
+                    ++pos_;
+                    int_ = helpers::detail::pointer_read_int<int_type, char>(begin_, pos_, size_, 'e', nullptr);
+                    break;
+                case token::STR: {
+                    const char c = begin_[pos_];
+                    if (!('0' <= c && c <= '9')) {
+                        throw errors::unknown_value_error.copy();
+                    }
+                    auto begin_size = helpers::detail::pointer_read_str_fast(begin_, pos_, size_, nullptr);
+                    str_ = str_type(begin_size.first, begin_size.second);
+                    break;
                 }
+                case token::BEGIN_LIST:
+                case token::BEGIN_DICT:
+                    ++pos_;
+                    ++depth_;
+                    break;
+                case token::END:
+                    if (depth_ == 0) {
+                        throw errors::expecting_value_error.copy();
+                    }
+                    ++pos_;
+                    --depth_;
+                    break;
             }
-            if (!(static_cast<T>('1') <= first_byte && first_byte <= static_cast<T>('9'))) {
+            return t;
+        }
+
+        // The last int read by `next_token()`.
+        int_type int_value() const noexcept { return int_; }
+        // The last string read by `next_token()`.
+        str_type str_value() const noexcept { return str_; }
+
+        // Reads an int, throwing a `decoding_error` if the next value is not one.
+        int_type read_int() {
+            if (peek() != token::INT) {
                 throw errors::expecting_int_error.copy();
             }
-            IntType res = IntType(static_cast<int>(static_cast<char>(first_byte) - '0'));
-            while (true) {
-                T next_byte;
-                if (!is.read(&next_byte, 1)) {
-                    throw errors::expecting_int_error.copy();
-                }
+            next_token();
+            return int_;
+        }
 
-                if (!(static_cast<T>('0') <= next_byte && next_byte <= static_cast<T>('9'))) {
-                    if (static_cast<char>(next_byte) == end_char) {
-                        break;
-                    }
-                    throw errors::expecting_int_error.copy();
+        // Reads a string, throwing a `decoding_error` if the next value is not one.
+        str_type read_string_view() {
+            if (peek() != token::STR) {
+                throw errors::expecting_value_error.copy();
+            }
+            next_token();
+            return str_;
+        }
+
+        /*
+         * Skips over the next value, including everything inside it if it is a list or dict.
+         * Strings are jumped over by their length, and ints are not decoded.
+         */
+        void skip_value() {
+            helpers::detail::pointer_skip_value(begin_, pos_, size_);
+        }
+
+        /*
+         * Skips the rest of the list or dict the cursor is in, including its 'e'.
+         */
+        void skip_container() {
+            if (depth_ == 0) {
+                throw errors::expecting_value_error.copy();
+            }
+            while (peek() != token::END) {
+                skip_value();
+            }
+            ++pos_;
+            --depth_;
+        }
+
+        /*
+         * Just after `token::BEGIN_DICT`, or after a value in that dict, moves to the value for `key` and returns true.
+         * Otherwise, skips the rest of the dict and returns false. Stops early if a later key is found, as keys are sorted.
+         */
+        bool find_key(const char* const key, const ::std::size_t key_size) {
+            while (peek() != token::END) {
+                const str_type current = read_string_view();
+                if (current.size() == key_size && ::std::memcmp(current.data(), key, key_size) == 0) {
+                    return true;
                 }
-                IntType previous_res = res;
-                res = res * IntType(static_cast<int>(sign * 10)) + IntType(static_cast<int>(sign * static_cast<int>(static_cast<char>(next_byte) - '0')));
-                if ((previous_res < res) != (sign > 0)) {
-                    throw errors::integer_overflow_error.copy();
+                if (helpers::detail::key_less_than(key, key_size, current.data(), current.size())) {
+                    skip_value();
+                    skip_container();
+                    return false;
                 }
+                skip_value();
             }
-            return res;
+            next_token();
+            return false;
         }
 
-        template<class T, class Traits>
-        static ::std::basic_string<T, Traits> stream_read_str(::std::basic_istream<T, Traits>& is, const char* first) {
-            ::std::size_t str_size = stream_read_int<::std::size_t, T, Traits>(is, ':', first);
-            ::std::basic_string<T, Traits> out_str(str_size, static_cast<T>('\0'));
-            if (!is.read(&out_str[0], static_cast<::std::streamsize>(str_size))) {
-                throw errors::cut_off_str_error.copy();
+        template<typename T, typename... Rest>
+        bool find_key(const ::std::basic_string<T, Rest...>& key) {
+            return find_key(reinterpret_cast<const char*>(key.data()), key.size());
+        }
+
+        bool find_key(const str_type key) {
+            return find_key(key.data(), key.size());
+        }
+
+        bool find_key(const char* const key) {
+            return find_key(key, ::std::strlen(key));
+        }
+    };
+
+    using cursor = basic_cursor<>;
+} }  // namespace torrebis::bencode
+
+#endif  // TORREBIS_BENCODE_CURSOR_H_
+
+// Done expanding  #include "torrebis_bencode/cursor.h"
+
+// Expanding  #include "torrebis_bencode/compact_data.h"
+#ifndef TORREBIS_BENCODE_COMPACT_DATA_H_
+#define TORREBIS_BENCODE_COMPACT_DATA_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+
+namespace torrebis { namespace bencode {
+    /*
+     * How `basic_compact_data` counts references to its heap nodes.
+     *
+     * `atomic_refcount` lets copies of a value be used from different threads, like copies of a `std::shared_ptr`.
+     * `local_refcount` uses a plain integer, so copying and destroying values is cheaper, but every copy of a value
+     * has to stay on the thread that made it.
+     */
+    struct atomic_refcount {
+        using count_type = ::std::atomic<::std::size_t>;
+
+        static void retain(count_type& count) noexcept { count.fetch_add(1, ::std::memory_order_relaxed); }
+        // Whether that was the last reference
+        static bool release(count_type& count) noexcept { return count.fetch_sub(1, ::std::memory_order_acq_rel) == 1; }
+    };
+
+    struct local_refcount {
+        using count_type = ::std::size_t;
+
+        static void retain(count_type& count) noexcept { ++count; }
+        static bool release(count_type& count) noexcept { return --count == 0; }
+    };
+
+    namespace helpers {
+        namespace detail {
+            // The heap part of a `basic_compact_data`, shared between copies of it.
+            template<class T, class RefCount>
+            struct compact_heap_node {
+                typename RefCount::count_type refcount;
+                T value;
+
+                template<class... Args>
+                explicit compact_heap_node(Args&&... args) : refcount(1), value(::std::forward<Args>(args)...) {}
+            };
+
+            // Orders the keys of a `basic_compact_data` dict, and lets them be found by a `str_view` without a copy.
+            struct compact_key_less {
+                using is_transparent = void;
+
+                bool operator()(const ::std::string& a, const ::std::string& b) const noexcept { return a < b; }
+                bool operator()(const ::std::string& a, const str_view b) const noexcept { return str_view(a) < b; }
+                bool operator()(const str_view a, const ::std::string& b) const noexcept { return a < str_view(b); }
+            };
+        }  // namespace torrebis::bencode::helpers::detail  (Private)
+    }  // namespace torrebis::bencode::helpers
+
+    /*
+     * Like `data`, but each value is a 16 byte node. Ints and strings of up to 15 bytes are stored in the node itself,
+     * and only longer strings, lists and dicts are on the heap (with a reference count in the same allocation).
+     *
+     * Copies share their heap part like copies of `data` do, but ints and short strings are copied. How the heap part
+     * is counted is up to `RefCount` (`atomic_refcount` or `local_refcount`).
+     */
+    template<class RefCount>
+    class basic_compact_data final {
+    public:
+        using refcount_policy = RefCount;
+        using int_type = ::std::int64_t;
+        using str_type = str_view;
+        using list_type = ::std::vector<basic_compact_data>;
+        using dict_type = ::std::map<::std::string, basic_compact_data, helpers::detail::compact_key_less>;
+
+        static constexpr ::std::size_t max_inline_str_size = 15;
+    private:
+        enum kind : ::std::uint8_t {
+            UNINITIALISED_KIND = 0,
+            INT_KIND = 1,
+            SHORT_STR_KIND = 2,
+            LONG_STR_KIND = 3,
+            LIST_KIND = 4,
+            DICT_KIND = 5
+        };
+
+        using long_str_node = helpers::detail::compact_heap_node<::std::string, RefCount>;
+        using list_node = helpers::detail::compact_heap_node<list_type, RefCount>;
+        using dict_node = helpers::detail::compact_heap_node<dict_type, RefCount>;
+
+        // An int, the characters of a short string or a pointer to a heap node, depending on the kind.
+        alignas(8) unsigned char storage_[15];
+        // The kind in the low 4 bits, and the size of a short string in the high 4 bits.
+        ::std::uint8_t meta_;
+
+        kind get_kind() const noexcept { return static_cast<kind>(meta_ & 0x0F); }
+        ::std::size_t short_size() const noexcept { return static_cast<::std::size_t>(meta_ >> 4); }
+        bool is_heap() const noexcept { return get_kind() >= LONG_STR_KIND; }
+
+        template<class Node>
+        Node* heap() const noexcept {
+            Node* node;
+            ::std::memcpy(&node, storage_, sizeof(node));
+            return node;
+        }
+
+        template<class Node>
+        void set_heap(const kind k, Node* const node) noexcept {
+            ::std::memcpy(storage_, &node, sizeof(node));
+            meta_ = static_cast<::std::uint8_t>(k);
+        }
+
+        void retain() const noexcept {
+            switch (get_kind()) {
+                case LONG_STR_KIND:
+                    RefCount::retain(heap<long_str_node>()->refcount);
+                    return;
+                case LIST_KIND:
+                    RefCount::retain(heap<list_node>()->refcount);
+                    return;
+                case DICT_KIND:
+                    RefCount::retain(heap<dict_node>()->refcount);
+                    return;
+                default:
+                    return;
             }
-            return out_str;
         }
 
-        template<class T, class Traits>
-        static basic_data stream_bdecode_loop(::std::basic_istream<T, Traits>& is, T* first) {
-            if (!is) {
-                throw errors::bad_stream_error.copy();
+        template<class Node>
+        void release_node() noexcept {
+            Node* const node = heap<Node>();
+            if (RefCount::release(node->refcount)) {
+                delete node;
             }
-            T start_byte;
-            if (first == nullptr) {
-                if (!is.read(&start_byte, 1)) {
-                    throw errors::expecting_value_error.copy();
-                }
-            } else {
-                start_byte = *first;
+        }
+
+        void release() noexcept {
+            switch (get_kind()) {
+                case LONG_STR_KIND:
+                    release_node<long_str_node>();
+                    break;
+                case LIST_KIND:
+                    release_node<list_node>();
+                    break;
+                case DICT_KIND:
+                    release_node<dict_node>();
+                    break;
+                default:
+                    break;
             }
-            switch (static_cast<char>(start_byte)) {
+            meta_ = UNINITIALISED_KIND;
+        }
+
+        static basic_compact_data pointer_bdecode_loop(const char* const begin, ::std::size_t& i, const ::std::size_t size) {
+            if (i >= size) {
+                throw errors::expecting_value_error.copy();
+            }
+            switch (begin[i]) {
                 case 'i':
                     // int "ixxxe"
-                    return make_int(stream_read_int<int_type, T, Traits>(is, 'e', nullptr));
+                    ++i;
+                    return make_int(helpers::detail::pointer_read_int<int_type, char>(begin, i, size, 'e', nullptr));
                 case 'l': {
                     // list "lxxxe"
-                    list_type list;
+                    ++i;
+                    basic_compact_data result = make_list();
+                    list_type& list = *result.get_list();
                     while (true) {
-                        T end_byte;
-                        if (!is.read(&end_byte, 1)) {
+                        if (i >= size) {
                             throw errors::expecting_value_error.copy();
                         }
-                        if (static_cast<char>(end_byte) == 'e') {
+                        if (begin[i] == 'e') {
                             break;
                         }
-                        list.push_back(stream_bdecode_loop<T, Traits>(is, &end_byte));
+                        list.push_back(pointer_bdecode_loop(begin, i, size));
                     }
-                    return make_list(list);
+                    ++i;
+                    return result;
                 }
                 case 'd': {
                     // dict "dxxxe"
-                    dict_type dict;
+                    ++i;
+                    basic_compact_data result = make_dict();
+                    dict_type& dict = *result.get_dict();
                     const char* last_key_begin = nullptr;
-                    ::std::size_t last_key_size;
+                    ::std::size_t last_key_size = 0;
                     while (true) {
-                        T end_byte;
-                        if (!is.read(&end_byte, 1)) {
+                        if (i >= size) {
                             throw errors::expecting_value_error.copy();
                         }
-                        if (static_cast<char>(end_byte) == 'e') {
+                        if (begin[i] == 'e') {
                             break;
                         }
-                        const char* key_begin;
-                        ::std::size_t key_size;
-                        ::std::basic_string<T, Traits> key = stream_read_str<T, Traits>(is, &end_byte);
-                        key_begin = key.data();
-                        key_size = key.size();
+                        auto key = helpers::detail::pointer_read_str_fast(begin, i, size, nullptr);
                         if (last_key_begin != nullptr) {
-                            if (!helpers::detail::key_less_than<T>(last_key_begin, last_key_size, key_begin, key_size)) {
+                            if (!helpers::detail::key_less_than(last_key_begin, last_key_size, key.first, key.second)) {
                                 throw errors::key_order_error.copy();
                             }
                         }
-                        last_key_begin = key_begin;
-                        last_key_size = key_size;
-                        TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<::std::basic_string<T, Traits>, str_type>::value) {
-                            dict[key] = stream_bdecode_loop<T, Traits>(is, nullptr);
-                        } else TORREBIS_CONSTEXPR_IF (helpers::detail::has_char_t<T, str_type>::value) {
-                            str_type real_key(key_begin, key_size);
-                            dict[real_key] = stream_bdecode_loop<T, Traits>(is, nullptr);
-                        } else {
-                            str_type real_key(key_begin, key_size);
-                            dict[real_key] = stream_bdecode_loop<T, Traits>(is, nullptr);
-                        }
+                        last_key_begin = key.first;
+                        last_key_size = key.second;
+                        // Keys are ascending, so each one goes at the end
+                        dict.emplace_hint(dict.end(), ::std::string(key.first, key.second), pointer_bdecode_loop(begin, i, size));
                     }
-                    return make_dict(dict);
+                    ++i;
+                    return result;
                 }
-                case '1': case '2': case '3':
-                case '4': case '5': case '6':
-                case '7': case '8': case '9': {
+                case '0': case '1': case '2':
+                case '3': case '4': case '5':
+                case '6': case '7': case '8':
+                case '9': {
                     // str "yy:xxxx"
-                    ::std::basic_string<T, Traits> s = stream_read_str<T, Traits>(is, &start_byte);
-                    TORREBIS_CONSTEXPR_IF (helpers::detail::is_same_decayed<str_type, ::std::basic_string<T, Traits>>::value) {
-                        return make_str(s);
-                    }
-                    return make_str(str_type(s.data(), s.size()));
+                    auto str = helpers::detail::pointer_read_str_fast(begin, i, size, nullptr);
+                    return make_str(str.first, str.second);
                 }
                 default:
                     throw errors::unknown_value_error.copy();
             }
         }
 
-    public:
-        template<class T = char, class Traits = ::std::char_traits<T>>
-        static basic_data load(::std::basic_istream<T, Traits>& is) {
-            auto parsed = stream_bdecode_loop<T, Traits>(is, nullptr);
-            if (!is) {
-                throw errors::bad_stream_error.copy();
-            }
-            if (is.peek() != Traits::eof()) {
-                throw errors::early_end_error.copy();
+        template<class OutputIt>
+        static OutputIt serialise_str(const str_view str, OutputIt out) {
+            out = helpers::detail::copy_int(str.size(), out);
+            *out = ':';
+            return helpers::detail::copy_chars(str, ++out);
+        }
+
+        template<class OutputIt>
+        OutputIt serialise_to_loop(OutputIt out) const {
+            switch (get_kind()) {
+                case INT_KIND:
+                    *out = 'i';
+                    out = helpers::detail::copy_int(get_int(), ++out);
+                    *out = 'e';
+                    return ++out;
+                case SHORT_STR_KIND:
+                case LONG_STR_KIND:
+                    return serialise_str(get_str(), out);
+                case LIST_KIND:
+                    *out = 'l';
+                    ++out;
+                    for (const basic_compact_data& i : *get_list()) {
+                        out = i.serialise_to_loop(out);
+                    }
+                    *out = 'e';
+                    return ++out;
+                case DICT_KIND:
+                    *out = 'd';
+                    ++out;
+                    for (const auto& i : *get_dict()) {
+                        out = serialise_str(str_view(i.first.data(), i.first.size()), out);
+                        out = i.second.serialise_to_loop(out);
+                    }
+                    *out = 'e';
+                    return ++out;
+                default:
+                    return out;
             }
-            return parsed;
         }
+    public:
+        basic_compact_data() noexcept : storage_(), meta_(UNINITIALISED_KIND) {}
 
-    };
+        basic_compact_data(const basic_compact_data& other) noexcept : meta_(other.meta_) {
+            ::std::memcpy(storage_, other.storage_, sizeof(storage_));
+            retain();
+        }
 
-    using data = basic_data<>;
+        basic_compact_data(basic_compact_data&& other) noexcept : meta_(other.meta_) {
+            ::std::memcpy(storage_, other.storage_, sizeof(storage_));
+            other.meta_ = UNINITIALISED_KIND;
+        }
 
-    namespace helpers { namespace detail {
-        template<class T>
-        struct is_basic_data_ : ::std::false_type {};
+        basic_compact_data& operator=(basic_compact_data other) noexcept {
+            swap(other);
+            return *this;
+        }
 
-        TORREBIS_BASIC_DATA_TEMPLATE
-        struct is_basic_data_<TORREBIS_BASIC_DATA_TEMPLATE_TYPE> : ::std::true_type {};
+        ~basic_compact_data() noexcept { release(); }
 
-        template<class T>
-        struct is_basic_data : is_basic_data_<typename remove_cv_ref<T>::type> {};
-    } }  // namespace torrebis::bencode::helpers::detail
+        void swap(basic_compact_data& other) noexcept {
+            unsigned char storage[sizeof(storage_)];
+            ::std::memcpy(storage, storage_, sizeof(storage_));
+            ::std::memcpy(storage_, other.storage_, sizeof(storage_));
+            ::std::memcpy(other.storage_, storage, sizeof(storage_));
+            ::std::swap(meta_, other.meta_);
+        }
 
-} }  // namespace torrebis::bencode
+        void reset() noexcept { release(); }
 
-#endif  // TORREBIS_BENCODE_DATA_CLASS_H_
+        explicit operator bool() const noexcept { return get_kind() != UNINITIALISED_KIND; }
+        bool operator!() const noexcept { return get_kind() == UNINITIALISED_KIND; }
 
-// Done expanding  #include "torrebis_bencode/data_class.h"
+        DataTag get_tag() const noexcept {
+            switch (get_kind()) {
+                case INT_KIND:
+                    return DataTag::INT;
+                case SHORT_STR_KIND:
+                case LONG_STR_KIND:
+                    return DataTag::STR;
+                case LIST_KIND:
+                    return DataTag::LIST;
+                case DICT_KIND:
+                    return DataTag::DICT;
+                default:
+                    return DataTag::UNINITIALISED;
+            }
+        }
 
-// Expanding  #include "torrebis_bencode/visitors.h"
-#ifndef TORREBIS_BENCODE_VISITORS_H_
-#define TORREBIS_BENCODE_VISITORS_H_
+        bool is_valid() const noexcept { return get_kind() != UNINITIALISED_KIND; }
+        bool is_str() const noexcept { return get_kind() == SHORT_STR_KIND || get_kind() == LONG_STR_KIND; }
+        bool is_int() const noexcept { return get_kind() == INT_KIND; }
+        bool is_list() const noexcept { return get_kind() == LIST_KIND; }
+        bool is_dict() const noexcept { return get_kind() == DICT_KIND; }
 
-#include <vector>
+        // Whether the value is stored in the node itself, so copying it doesn't touch the heap.
+        bool is_inline() const noexcept { return !is_heap(); }
 
-#include <torrebis_bencode/type_tags.h>
-#include <torrebis_bencode/data_class.h>
+        static basic_compact_data make_int(const int_type i) noexcept {
+            basic_compact_data result;
+            ::std::memcpy(result.storage_, &i, sizeof(i));
+            result.meta_ = INT_KIND;
+            return result;
+        }
 
-namespace torrebis { namespace bencode {
+        static basic_compact_data make_str(const char* const str, const ::std::size_t size) {
+            basic_compact_data result;
+            if (size <= max_inline_str_size) {
+                ::std::memcpy(result.storage_, str, size);
+                result.meta_ = static_cast<::std::uint8_t>(SHORT_STR_KIND | (size << 4));
+            } else {
+                result.set_heap(LONG_STR_KIND, new long_str_node(str, size));
+            }
+            return result;
+        }
 
-    template<typename BasicData = data>
-    class visitor {
-    public:
-        using data_t = const BasicData&;
-        using path_t = const ::std::vector<typename BasicData::path_el_type>&;
-        using str_type = const typename BasicData::const_str_ptr;
-        using int_type = const typename BasicData::const_int_ptr;
-        using list_type = const typename BasicData::const_list_ptr;
-        using dict_type = const typename BasicData::const_dict_ptr;
+        static basic_compact_data make_str(const char* const c_str) { return make_str(c_str, ::std::strlen(c_str)); }
+        static basic_compact_data make_str(const str_type s) { return make_str(s.data(), s.size()); }
+        static basic_compact_data make_str(const ::std::string& s) { return make_str(s.data(), s.size()); }
 
-        virtual void visit(const data_t dat) {
-            // Start the visit with an empty path.
-            typename ::std::remove_reference<path_t>::type path;
-            visit_any(dat, path);
-            return;
-        }
-    protected:
-        virtual void visit_any(data_t dat, const path_t path) {
-            switch (dat.get_tag()) {
-                case DataTag::STR:
-                    visit_str(dat.get_str(), path);
-                    return;
-                case DataTag::INT:
-                    visit_int(dat.get_int(), path);
-                    return;
-                case DataTag::LIST:
-                    visit_list(dat.get_list(), path);
-                    return;
-                case DataTag::DICT:
-                    visit_dict(dat.get_dict(), path);
-                    return;
-                default:
-                    return;
+        static basic_compact_data make_str(::std::string&& s) {
+            if (s.size() <= max_inline_str_size) {
+                return make_str(s.data(), s.size());
             }
+            basic_compact_data result;
+            result.set_heap(LONG_STR_KIND, new long_str_node(::std::move(s)));
+            return result;
         }
 
-        virtual void visit_str(const str_type str, const path_t path) {
-            // Do nothing.
-            // Note: By default, visit_key uses this function to visit dictionary keys
-            // with the final element of `path` set as a key, with a value of the index of the key.
+        static basic_compact_data make_list(list_type l = list_type()) {
+            basic_compact_data result;
+            result.set_heap(LIST_KIND, new list_node(::std::move(l)));
+            return result;
         }
 
+        static basic_compact_data make_dict(dict_type d = dict_type()) {
+            basic_compact_data result;
+            result.set_heap(DICT_KIND, new dict_node(::std::move(d)));
+            return result;
+        }
 
-        virtual void visit_int(const int_type i, const path_t path) {
-            // Do nothing.
+        // The value of an int, or 0 if this is not an int.
+        int_type get_int() const noexcept {
+            if (!is_int()) {
+                return 0;
+            }
+            int_type i;
+            ::std::memcpy(&i, storage_, sizeof(i));
+            return i;
         }
 
-        virtual void visit_list(const list_type list, const path_t path) {
-            // Visit all members with visit_item one level deeper.
-            typename ::std::remove_const<typename ::std::remove_reference<path_t>::type>::type new_path(path);
-            ::std::size_t i = 0;
-            new_path.push_back(0);
-            for (const data_t& el : *list) {
-                new_path[new_path.size() - 1] = i++;
-                visit_item(el, new_path);
+        // The value of a str, or an empty view if this is not a str. Only valid while this is.
+        str_type get_str() const noexcept {
+            switch (get_kind()) {
+                case SHORT_STR_KIND:
+                    return str_type(reinterpret_cast<const char*>(storage_), short_size());
+                case LONG_STR_KIND: {
+                    const ::std::string& s = heap<long_str_node>()->value;
+                    return str_type(s.data(), s.size());
+                }
+                default:
+                    return str_type();
             }
         }
 
-        virtual void visit_item(data_t item, const path_t path) {
-            // Just visit it with visit_any.
-            return visit_any(item, path);
+        list_type* get_list() noexcept { return is_list() ? &heap<list_node>()->value : nullptr; }
+        const list_type* get_list() const noexcept { return is_list() ? &heap<list_node>()->value : nullptr; }
+        dict_type* get_dict() noexcept { return is_dict() ? &heap<dict_node>()->value : nullptr; }
+        const dict_type* get_dict() const noexcept { return is_dict() ? &heap<dict_node>()->value : nullptr; }
+
+        // The value for `key` in a dict, or nullptr if there isn't one.
+        const basic_compact_data* find(const str_type key) const {
+            const dict_type* const dict = get_dict();
+            if (dict == nullptr) {
+                return nullptr;
+            }
+#ifdef TORREBIS_HAS_HETEROGENEOUS_LOOKUP
+            auto search = dict->find(key);
+#else
+            // Without heterogeneous lookup, reuse one string per thread so that only growing it allocates
+            static thread_local ::std::string scratch;
+            scratch.assign(key.data(), key.size());
+            auto search = dict->find(scratch);
+#endif
+            return search == dict->end() ? nullptr : &search->second;
         }
 
-        virtual void visit_dict(const dict_type dict, const path_t path) {
-            // Visit:
-            //    keys with nullptr at the end of the path.
-            //    values with the key at the end of the path.
-            typename ::std::remove_const<typename ::std::remove_reference<path_t>::type>::type new_path(path);
+        // The item at index `i` of a list, or nullptr if there isn't one.
+        const basic_compact_data* at(const ::std::size_t i) const noexcept {
+            const list_type* const list = get_list();
+            return list == nullptr || i >= list->size() ? nullptr : &(*list)[i];
+        }
+
+        static basic_compact_data load(const char* const begin, const ::std::size_t size) {
             ::std::size_t i = 0;
-            new_path.push_back(0);
-            for (const auto& el : *dict) {
-                data_t key = BasicData::make_str(el.first);
-                visit_key(key, new_path);
-                new_path[new_path.size() - 1] = key.get_str();
-                visit_value(el.second, new_path);
-                new_path[new_path.size() - 1] = ++i;
+            basic_compact_data parsed = pointer_bdecode_loop(begin, i, size);
+            if (i != size) {
+                throw errors::early_end_error.copy();
             }
+            return parsed;
         }
 
-        virtual void visit_key(data_t k, const path_t path) {
-            visit_any(k, path);
-            return;
+        template<typename T>
+        static basic_compact_data load(const T* const begin, const ::std::size_t size) {
+            static_assert(helpers::detail::is_byte<T>::value, "Must be a string of a byte-like value (char, unsigned char, signed char, std::uint8_t, std::int8_t)");
+            return load(reinterpret_cast<const char*>(begin), size);
         }
 
-        virtual void visit_value(data_t value, const path_t path) {
-            // Just visit it with visit_any.
-            visit_any(value, path);
-            return;
+        template<typename T, typename... Rest>
+        static basic_compact_data load(const ::std::basic_string<T, Rest...>& s) {
+            return load<T>(s.data(), s.size());
         }
-    };
 
-    /*
-     * Outputs some data to a stream.
-     */
-    template<typename BasicData = data>
-    class print_visitor : public visitor<BasicData> {
-    private:
-        ::std::ostream& os_;
-        const char indent_char_;
-        const ::std::size_t indent_width_;
-    public:
-        using data_t = typename visitor<BasicData>::data_t;
-        using path_t = typename visitor<BasicData>::path_t;
-        using str_type = typename visitor<BasicData>::str_type;
-        using int_type = typename visitor<BasicData>::int_type;
-        using list_type = typename visitor<BasicData>::list_type;
-        using dict_type = typename visitor<BasicData>::dict_type;
+        template<typename T, typename... Rest>
+        static basic_compact_data load(const ::std::vector<T, Rest...>& v) {
+            return load<T>(v.data(), v.size());
+        }
 
-        explicit print_visitor(
-            std::ostream& os,
-            const char indent_char = ' ',
-            const ::std::size_t indent_width = 4) :
-            os_(os), indent_char_(indent_char), indent_width_(indent_width) {}
-    protected:
-        virtual void visit_str(const str_type str, const path_t path) {
-            os_ << ::std::string("\"");
-            for (const char c : *str) {
-                if (' ' <= c && c <= '~') {
-                    if (c == '\\' || c == '"') os_ << ::std::string("\\");
-                    char s[2] = { c, '\0' };
-                    os_ << ::std::string(s);
-                } else {
-                    os_ << ::std::string("\\x");
-                    ::std::uint8_t x = static_cast<::std::uint8_t>(c);
-                    char s[3] = { static_cast<char>('0' + (x >> 4)), static_cast<char>('0' + (x & 0xF)), '\0' };
-                    os_ << ::std::string(s);
+        ::std::size_t serialised_size() const {
+            switch (get_kind()) {
+                case INT_KIND:
+                    return 2 + helpers::detail::int_size(get_int());
+                case SHORT_STR_KIND:
+                case LONG_STR_KIND: {
+                    const ::std::size_t str_size = get_str().size();
+                    return helpers::detail::int_size(str_size) + 1 + str_size;
+                }
+                case LIST_KIND: {
+                    ::std::size_t size = 2;
+                    for (const basic_compact_data& i : *get_list()) {
+                        size += i.serialised_size();
+                    }
+                    return size;
+                }
+                case DICT_KIND: {
+                    ::std::size_t size = 2;
+                    for (const auto& i : *get_dict()) {
+                        size += helpers::detail::int_size(i.first.size()) + 1 + i.first.size() + i.second.serialised_size();
+                    }
+                    return size;
                 }
+                default:
+                    return 0;
             }
-            os_ << ::std::string("\"");
         }
 
-        virtual void visit_int(const int_type i, const path_t path) {
-            os_ << *i;
+        void append_serialisation(::std::string& s) const {
+            const ::std::size_t old_size = s.size();
+            s.resize(old_size + serialised_size());
+            serialise_to_loop(&s[0] + old_size);
         }
 
-        virtual void visit_list(const list_type list, const path_t path) {
-            os_ << ::std::string("[");
-            visitor<BasicData>::visit_list(list, path);
-            os_ << ::std::string("\n") << ::std::string(indent_width_ * path.size(), indent_char_) << ::std::string("]");
+        ::std::string serialise() const {
+            ::std::string s;
+            append_serialisation(s);
+            return s;
         }
 
-        virtual void visit_item(const data_t item, const path_t path) {
-            os_ << ((path[path.size() - 1] == 0) ? ::std::string("\n") : ::std::string(",\n"));
-            os_ << ::std::string(indent_width_ * path.size(), indent_char_);
-            visitor<BasicData>::visit_item(item, path);
-        }
+        // Writes the encoding to `out`, like `basic_data::serialise_to`.
+        template<class OutputIt>
+        OutputIt serialise_to(OutputIt out) const { return serialise_to_loop(out); }
 
-        virtual void visit_dict(const dict_type dict, const path_t path) {
-            os_ << ::std::string("{");
-            visitor<BasicData>::visit_dict(dict, path);
-            os_ << ::std::string("\n") << ::std::string(indent_width_ * path.size(), indent_char_) << ::std::string("}");
+        // Writes the encoding to the `capacity` chars at `out`, returning how many were written (0 if it doesn't fit).
+        ::std::size_t serialise_to(char* const out, const ::std::size_t capacity) const {
+            const ::std::size_t size = serialised_size();
+            if (size > capacity) {
+                return 0;
+            }
+            serialise_to_loop(out);
+            return size;
         }
 
-        virtual void visit_key(const data_t k, const path_t path) {
-            os_ << ((path[path.size() - 1] == 0) ? ::std::string("\n") : ::std::string(",\n"));
-            os_ << ::std::string(indent_width_ * path.size(), indent_char_);
-            visitor<BasicData>::visit_key(k, path);
-            os_ << ::std::string(": ");
-        }
+#ifdef TORREBIS_HAS_SPAN
+        template<::std::size_t Extent>
+        ::std::size_t serialise_to(const ::std::span<char, Extent> out) const { return serialise_to(out.data(), out.size()); }
+#endif
     };
 
+    using compact_data = basic_compact_data<atomic_refcount>;
+    using local_compact_data = basic_compact_data<local_refcount>;
+
+    static_assert(sizeof(compact_data) == 16, "compact_data should be a 16 byte node");
+    static_assert(sizeof(local_compact_data) == 16, "local_compact_data should be a 16 byte node");
+
+    template<class RefCount>
+    void swap(basic_compact_data<RefCount>& a, basic_compact_data<RefCount>& b) noexcept { a.swap(b); }
 } }  // namespace torrebis::bencode
 
-#endif  // TORREBIS_BENCODE_VISITORS_H_
+#endif  // TORREBIS_BENCODE_COMPACT_DATA_H_
 
-// Done expanding  #include "torrebis_bencode/visitors.h"
+// Done expanding  #include "torrebis_bencode/compact_data.h"
 
 
 #endif  // TORREBIS_BENCODE_TORREBIS_BENCODE_H_